@@ -0,0 +1,163 @@
+#include "audiomixer.h"
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#include <immintrin.h>
+#define AUDIOMIXER_X86 1
+#endif
+
+// GCC/Clang 可以只為單一函式開啟 AVX，執行時再依 CPU 選擇；MSVC 只在整體以 /arch:AVX 編譯時提供
+#if defined(AUDIOMIXER_X86) && (defined(__GNUC__) || defined(__clang__))
+#define AUDIOMIXER_SSE 1
+#define AUDIOMIXER_AVX 1
+#define AUDIOMIXER_TARGET_SSE __attribute__((target("sse2")))
+#define AUDIOMIXER_TARGET_AVX __attribute__((target("avx")))
+#elif defined(AUDIOMIXER_X86)
+#if defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define AUDIOMIXER_SSE 1
+#endif
+#if defined(__AVX__)
+#define AUDIOMIXER_AVX 1
+#endif
+#define AUDIOMIXER_TARGET_SSE
+#define AUDIOMIXER_TARGET_AVX
+#endif
+
+namespace {
+
+// 增益由畫格編號直接算出（start + step × 畫格），長時間的斜坡也不會累積誤差
+// begin 一定落在畫格邊界上（向量版本處理的樣本數是聲道數的倍數）
+template <bool Accumulate>
+void rampScalar(float* dst, const float* src, qsizetype begin, qsizetype samples, int channels,
+                float gainStart, float step)
+{
+    for (qsizetype frame = begin / channels, i = begin; i < samples; frame++) {
+        const float gain = gainStart + step * float(frame);
+        for (int c = 0; c < channels; c++, i++) {
+            if (Accumulate) {
+                dst[i] += src[i] * gain;
+            } else {
+                dst[i] = src[i] * gain;
+            }
+        }
+    }
+}
+
+#ifdef AUDIOMIXER_SSE
+// 每次處理 4 個樣本；聲道數必須整除 4，一個向量內才能依畫格排列增益
+template <bool Accumulate>
+AUDIOMIXER_TARGET_SSE qsizetype rampSse(float* dst, const float* src, qsizetype samples, int channels,
+                                        float gainStart, float step)
+{
+    const __m128 start = _mm_set1_ps(gainStart);
+    const __m128 stepVec = _mm_set1_ps(step);
+    const __m128 advance = _mm_set1_ps(float(4 / channels));
+    __m128 frame = _mm_setr_ps(float(0 / channels), float(1 / channels),
+                               float(2 / channels), float(3 / channels));
+
+    qsizetype i = 0;
+    for (; i + 4 <= samples; i += 4) {
+        const __m128 gain = _mm_add_ps(start, _mm_mul_ps(stepVec, frame));
+        __m128 value = _mm_mul_ps(_mm_loadu_ps(src + i), gain);
+        if (Accumulate) {
+            value = _mm_add_ps(_mm_loadu_ps(dst + i), value);
+        }
+        _mm_storeu_ps(dst + i, value);
+        frame = _mm_add_ps(frame, advance);
+    }
+    return i;
+}
+#endif
+
+#ifdef AUDIOMIXER_AVX
+// 每次處理 8 個樣本；聲道數必須整除 8
+template <bool Accumulate>
+AUDIOMIXER_TARGET_AVX qsizetype rampAvx(float* dst, const float* src, qsizetype samples, int channels,
+                                        float gainStart, float step)
+{
+    const __m256 start = _mm256_set1_ps(gainStart);
+    const __m256 stepVec = _mm256_set1_ps(step);
+    const __m256 advance = _mm256_set1_ps(float(8 / channels));
+    __m256 frame = _mm256_setr_ps(float(0 / channels), float(1 / channels), float(2 / channels),
+                                  float(3 / channels), float(4 / channels), float(5 / channels),
+                                  float(6 / channels), float(7 / channels));
+
+    qsizetype i = 0;
+    for (; i + 8 <= samples; i += 8) {
+        const __m256 gain = _mm256_add_ps(start, _mm256_mul_ps(stepVec, frame));
+        __m256 value = _mm256_mul_ps(_mm256_loadu_ps(src + i), gain);
+        if (Accumulate) {
+            value = _mm256_add_ps(_mm256_loadu_ps(dst + i), value);
+        }
+        _mm256_storeu_ps(dst + i, value);
+        frame = _mm256_add_ps(frame, advance);
+    }
+    return i;
+}
+#endif
+
+template <bool Accumulate>
+void ramp(float* dst, const float* src, qsizetype frames, int channels,
+          float gainStart, float gainEnd, AudioMixer::Kernel kernel)
+{
+    if (frames <= 0 || channels <= 0) return;
+
+    const qsizetype samples = frames * channels;
+    const float step = (gainEnd - gainStart) / float(frames);
+    qsizetype done = 0;
+#ifdef AUDIOMIXER_AVX
+    if (kernel == AudioMixer::AVX && 8 % channels == 0) {
+        done = rampAvx<Accumulate>(dst, src, samples, channels, gainStart, step);
+    }
+#endif
+#ifdef AUDIOMIXER_SSE
+    if (done == 0 && kernel != AudioMixer::Scalar && 4 % channels == 0) {
+        done = rampSse<Accumulate>(dst, src, samples, channels, gainStart, step);
+    }
+#endif
+    Q_UNUSED(kernel);
+
+    // 向量處理不完的尾端，以及不整除向量寬度的聲道數（例如 5.1）
+    rampScalar<Accumulate>(dst, src, done, samples, channels, gainStart, step);
+}
+
+}
+
+AudioMixer::Kernel AudioMixer::bestKernel()
+{
+    static const Kernel best = []() {
+#if defined(AUDIOMIXER_AVX) && (defined(__GNUC__) || defined(__clang__))
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx")) return AVX;
+        return SSE;
+#elif defined(AUDIOMIXER_AVX)
+        return AVX;
+#elif defined(AUDIOMIXER_SSE)
+        return SSE;
+#else
+        return Scalar;
+#endif
+    }();
+    return best;
+}
+
+const char* AudioMixer::kernelName(Kernel kernel)
+{
+    switch (kernel) {
+    case SSE: return "sse";
+    case AVX: return "avx";
+    case Scalar: break;
+    }
+    return "scalar";
+}
+
+void AudioMixer::scaleRamp(float* dst, const float* src, qsizetype frames, int channels,
+                           float gainStart, float gainEnd, Kernel kernel)
+{
+    ramp<false>(dst, src, frames, channels, gainStart, gainEnd, kernel);
+}
+
+void AudioMixer::mixRamp(float* dst, const float* src, qsizetype frames, int channels,
+                         float gainStart, float gainEnd, Kernel kernel)
+{
+    ramp<true>(dst, src, frames, channels, gainStart, gainEnd, kernel);
+}
@@ -0,0 +1,26 @@
+#ifndef AUDIOMIXER_H
+#define AUDIOMIXER_H
+
+#include <QtGlobal>
+
+// 交錯 float 樣本的增益斜坡核心：交叉淡化時兩首歌各乘上一條線性增益後相加
+// 同一畫格的所有聲道使用相同增益；有 SSE/AVX 版本，其他平台或聲道數使用純量版本
+class AudioMixer
+{
+public:
+    enum Kernel { Scalar, SSE, AVX };
+
+    // 目前 CPU 可用的最快版本（只偵測一次）
+    static Kernel bestKernel();
+    static const char* kernelName(Kernel kernel);
+
+    // dst = src × 增益，增益在 frames 個畫格內由 gainStart 線性變化到 gainEnd（不含 gainEnd）
+    static void scaleRamp(float* dst, const float* src, qsizetype frames, int channels,
+                          float gainStart, float gainEnd, Kernel kernel = bestKernel());
+
+    // dst += src × 增益
+    static void mixRamp(float* dst, const float* src, qsizetype frames, int channels,
+                        float gainStart, float gainEnd, Kernel kernel = bestKernel());
+};
+
+#endif // AUDIOMIXER_H
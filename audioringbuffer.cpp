@@ -0,0 +1,95 @@
+#include "audioringbuffer.h"
+#include <algorithm>
+#include <cstring>
+
+AudioRingBuffer::AudioRingBuffer(qsizetype minimumCapacity)
+    : mask(0)
+    , writeIndex(0)
+    , readIndex(0)
+    , flushTarget(0)
+    , flushPending(false)
+{
+    reset(minimumCapacity);
+}
+
+void AudioRingBuffer::reset(qsizetype minimumCapacity)
+{
+    qsizetype size = 1;
+    while (size < minimumCapacity) {
+        size <<= 1;
+    }
+    buffer.fill(0.0f, size);
+    mask = quint64(size - 1);
+    writeIndex.store(0, std::memory_order_relaxed);
+    readIndex.store(0, std::memory_order_relaxed);
+    flushTarget.store(0, std::memory_order_relaxed);
+    flushPending.store(false, std::memory_order_release);
+}
+
+qsizetype AudioRingBuffer::availableToWrite() const
+{
+    const quint64 write = writeIndex.load(std::memory_order_relaxed);
+    const quint64 read = readIndex.load(std::memory_order_acquire);
+    return buffer.size() - qsizetype(write - read);
+}
+
+qsizetype AudioRingBuffer::write(const float* data, qsizetype count)
+{
+    const quint64 write = writeIndex.load(std::memory_order_relaxed);
+    const quint64 read = readIndex.load(std::memory_order_acquire);
+    count = std::min(count, buffer.size() - qsizetype(write - read));
+    if (count <= 0) return 0;
+
+    // 最多分成兩段：到陣列結尾，以及從開頭繞回
+    const qsizetype start = qsizetype(write & mask);
+    const qsizetype first = std::min(count, buffer.size() - start);
+    float* storage = buffer.data();
+    std::memcpy(storage + start, data, size_t(first) * sizeof(float));
+    std::memcpy(storage, data + first, size_t(count - first) * sizeof(float));
+
+    writeIndex.store(write + quint64(count), std::memory_order_release);
+    return count;
+}
+
+void AudioRingBuffer::flush()
+{
+    // 先記錄要丟棄到哪裡再設定旗標；之後寫入的新資料不受影響
+    flushTarget.store(writeIndex.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    flushPending.store(true, std::memory_order_release);
+}
+
+void AudioRingBuffer::applyFlush()
+{
+    if (flushPending.exchange(false, std::memory_order_acquire)) {
+        const quint64 target = flushTarget.load(std::memory_order_relaxed);
+        if (target > readIndex.load(std::memory_order_relaxed)) {
+            readIndex.store(target, std::memory_order_release);
+        }
+    }
+}
+
+qsizetype AudioRingBuffer::availableToRead() const
+{
+    const quint64 read = readIndex.load(std::memory_order_relaxed);
+    const quint64 write = writeIndex.load(std::memory_order_acquire);
+    return qsizetype(write - read);
+}
+
+qsizetype AudioRingBuffer::read(float* data, qsizetype count)
+{
+    applyFlush();
+
+    const quint64 read = readIndex.load(std::memory_order_relaxed);
+    const quint64 write = writeIndex.load(std::memory_order_acquire);
+    count = std::min(count, qsizetype(write - read));
+    if (count <= 0) return 0;
+
+    const qsizetype start = qsizetype(read & mask);
+    const qsizetype first = std::min(count, buffer.size() - start);
+    const float* storage = buffer.constData();
+    std::memcpy(data, storage + start, size_t(first) * sizeof(float));
+    std::memcpy(data + first, storage, size_t(count - first) * sizeof(float));
+
+    readIndex.store(read + quint64(count), std::memory_order_release);
+    return count;
+}
@@ -0,0 +1,46 @@
+#ifndef AUDIORINGBUFFER_H
+#define AUDIORINGBUFFER_H
+
+#include <QtGlobal>
+#include <QList>
+#include <atomic>
+
+// 單一生產者/單一消費者的無鎖環形緩衝（float 樣本）
+// 生產者（解碼執行緒）只呼叫 write()/flush()，消費者（輸出執行緒）只呼叫 read()；查詢可用量與位置的函式任何執行緒都可以呼叫
+// 索引只增不減，容量為 2 的次方，以遮罩取位置；兩個索引放在不同的快取行，避免互相干擾
+class AudioRingBuffer
+{
+public:
+    explicit AudioRingBuffer(qsizetype minimumCapacity = 0);
+
+    // 重新配置容量（兩端都停止時才能呼叫）
+    void reset(qsizetype minimumCapacity);
+    qsizetype capacity() const { return buffer.size(); }
+
+    // 生產者：寫入最多 count 個樣本，回傳實際寫入的數量
+    qsizetype write(const float* data, qsizetype count);
+    qsizetype availableToWrite() const;
+
+    // 生產者：丟棄目前已寫入的所有樣本（跳轉、換曲），消費者下次讀取時生效
+    void flush();
+
+    // 消費者：讀出最多 count 個樣本，回傳實際讀出的數量
+    qsizetype read(float* data, qsizetype count);
+    qsizetype availableToRead() const;
+
+    // 從開始以來寫入/讀出（含丟棄）的樣本總數，任何執行緒都可以讀取，用來換算播放位置
+    quint64 writePosition() const { return writeIndex.load(std::memory_order_acquire); }
+    quint64 readPosition() const { return readIndex.load(std::memory_order_acquire); }
+
+private:
+    void applyFlush();
+
+    QList<float> buffer;
+    quint64 mask;
+    alignas(64) std::atomic<quint64> writeIndex;
+    alignas(64) std::atomic<quint64> readIndex;
+    alignas(64) std::atomic<quint64> flushTarget;
+    std::atomic<bool> flushPending;
+};
+
+#endif // AUDIORINGBUFFER_H
@@ -0,0 +1,580 @@
+// last-report-bench：播放清單核心的效能測試
+//
+// 以合成的音樂庫（1k 到 1M 首）量測主視窗依賴的熱點路徑：
+// JSON 序列化、PlaylistStore 讀寫、模型重置、隨機播放、最愛切換、
+// YouTube 連結解析、M3U 匯入匯出與音樂庫搜尋；另外量測與曲目數無關的音訊處理核心
+// （EBU R128 響度量測、交叉淡化混音）。結果以 JSON 輸出，方便比較不同版本。
+//
+// 用法：
+//   last-report-bench [--sizes 1000,10000,100000] [--repeat 5] [--seed 1]
+//                     [--filter shuffle] [--output results.json]
+
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+#include <QTemporaryDir>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QJsonArray>
+#include <QDateTime>
+#include <QRandomGenerator>
+#include <QSet>
+#include <QFile>
+#include <QBuffer>
+#include <algorithm>
+#include <functional>
+#include <utility>
+#include <cstdio>
+#include <cmath>
+#include <thread>
+
+#include "playlist.h"
+#include "playlistmodel.h"
+#include "playliststore.h"
+#include "shuffleengine.h"
+#include "librarysearch.h"
+#include "youtubelink.h"
+#include "playlistfileio.h"
+#include "loudnessmeter.h"
+#include "audiomixer.h"
+#include "audioringbuffer.h"
+#include "equalizer.h"
+#include "spectrumanalyzer.h"
+
+namespace {
+
+const int kMaxTracks = 1000000;
+const int kVisibleRows = 40;          // 播放清單一個畫面大約可見的列數
+const int kMaxPicks = 100000;
+const int kMaxToggles = 100000;
+
+const QStringList kEnglishWords = {
+    "love", "night", "blue", "summer", "dream", "river", "light", "heart", "city", "rain",
+    "fire", "moon", "dance", "shadow", "golden", "wild", "home", "echo", "midnight", "ocean"
+};
+const QStringList kChineseWords = {
+    "夜空", "星光", "回憶", "城市", "海邊", "下雨天", "晴天", "告白", "青春", "夢想",
+    "月亮", "溫柔", "遠方", "時間", "思念", "旅行", "風景", "再見", "愛情", "孤單"
+};
+const char kVideoIdChars[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789-_";
+
+// 防止編譯器把量測的結果最佳化掉
+quint64 sink = 0;
+
+QString randomTitle(QRandomGenerator& rng)
+{
+    const bool chinese = rng.bounded(100) < 35;
+    const QStringList& words = chinese ? kChineseWords : kEnglishWords;
+    const int count = 1 + rng.bounded(3);
+    QStringList parts;
+    for (int i = 0; i < count; i++) {
+        parts.append(words.at(rng.bounded(words.size())));
+    }
+    return parts.join(chinese ? QString() : QStringLiteral(" "));
+}
+
+QString randomVideoId(QRandomGenerator& rng)
+{
+    QString id(11, Qt::Uninitialized);
+    for (int i = 0; i < id.size(); i++) {
+        id[i] = QLatin1Char(kVideoIdChars[rng.bounded(int(sizeof(kVideoIdChars) - 1))]);
+    }
+    return id;
+}
+
+// 合成音樂庫：一個包含所有曲目的大清單，以及約 2% 曲目的「我的最愛」
+// 六成為本地檔案、四成為 YouTube 影片，藝人數量隨曲目數成長
+QList<Playlist> generateLibrary(int trackCount, quint32 seed)
+{
+    QRandomGenerator rng(seed);
+    const int artistCount = qMax(10, trackCount / 50);
+
+    Playlist all;
+    all.name = "全部歌曲";
+    all.videos.reserve(trackCount);
+    for (int i = 0; i < trackCount; i++) {
+        const int artist = rng.bounded(artistCount);
+        VideoInfo video;
+        video.setTitle(randomTitle(rng));
+        video.setChannelTitle(QString("Artist %1").arg(artist));
+        video.setLocalFile(rng.bounded(100) < 60);
+        if (video.isLocalFile()) {
+            video.setFilePath(QString("/music/Artist %1/Album %2/%3 - %4.flac")
+                .arg(artist).arg(rng.bounded(8)).arg(i % 20 + 1, 2, 10, QLatin1Char('0')).arg(video.title()));
+            video.setDescription("本地音樂檔案");
+        } else {
+            video.setVideoId(randomVideoId(rng));
+            video.setThumbnailUrl(QString("https://img.youtube.com/vi/%1/maxresdefault.jpg").arg(video.videoId()));
+            video.setDescription("YouTube 影片");
+        }
+        all.videos.append(video);
+    }
+
+    Playlist favorites;
+    favorites.name = "我的最愛";
+    for (int i = 0; i < trackCount; i += 50) {
+        VideoInfo video = all.videos.at(i);
+        video.setFavorite(true);
+        favorites.videos.append(video);
+    }
+
+    return { all, favorites };
+}
+
+// 大量連結：各種 YouTube 格式混合一般網址
+QStringList generateLinks(int count, quint32 seed)
+{
+    QRandomGenerator rng(seed);
+    QStringList links;
+    links.reserve(count);
+    for (int i = 0; i < count; i++) {
+        const QString id = randomVideoId(rng);
+        switch (rng.bounded(5)) {
+        case 0: links.append("https://www.youtube.com/watch?v=" + id); break;
+        case 1: links.append("https://www.youtube.com/watch?v=" + id + "&list=PL" + id + "&index=3"); break;
+        case 2: links.append("https://youtu.be/" + id + "?t=42"); break;
+        case 3: links.append("https://www.youtube.com/embed/" + id); break;
+        default: links.append("https://example.com/music/" + id + ".mp3"); break;
+        }
+    }
+    return links;
+}
+
+struct Result {
+    QString name;
+    int tracks;
+    qint64 ops;
+    double medianMs;
+    double minMs;
+};
+
+class Bench
+{
+public:
+    Bench(int repeat, const QString& filter)
+        : repeat(repeat)
+        , filter(filter)
+    {
+    }
+
+    // setup 在每一輪量測前執行，不計入時間
+    void run(const QString& name, int tracks, qint64 ops,
+             const std::function<void()>& body,
+             const std::function<void()>& setup = nullptr)
+    {
+        if (!filter.isEmpty() && !name.contains(filter)) return;
+
+        QList<qint64> samples;
+        for (int i = 0; i < repeat; i++) {
+            if (setup) setup();
+            QElapsedTimer timer;
+            timer.start();
+            body();
+            samples.append(timer.nsecsElapsed());
+        }
+        std::sort(samples.begin(), samples.end());
+
+        Result result{ name, tracks, ops, samples.at(samples.size() / 2) / 1e6, samples.first() / 1e6 };
+        results.append(result);
+
+        std::fprintf(stderr, "%-24s %8d tracks %12.3f ms %12.1f ns/op\n",
+                     qPrintable(name), tracks, result.medianMs,
+                     ops > 0 ? result.medianMs * 1e6 / ops : 0.0);
+    }
+
+    QJsonArray toJson() const
+    {
+        QJsonArray array;
+        for (const Result& result : results) {
+            QJsonObject obj;
+            obj["name"] = result.name;
+            obj["tracks"] = result.tracks;
+            obj["ops"] = result.ops;
+            obj["medianMs"] = result.medianMs;
+            obj["minMs"] = result.minMs;
+            obj["nsPerOp"] = result.ops > 0 ? result.medianMs * 1e6 / result.ops : 0.0;
+            array.append(obj);
+        }
+        return array;
+    }
+
+private:
+    int repeat;
+    QString filter;
+    QList<Result> results;
+};
+
+void benchSize(Bench& bench, int trackCount, quint32 seed, const QString& tempRoot)
+{
+    QList<Playlist> library = generateLibrary(trackCount, seed);
+    const Playlist& all = library.at(0);
+    const Playlist& favorites = library.at(1);
+    const QStringList order = { all.name, favorites.name };
+
+    // --- JSON 序列化（與分片檔/舊版 JSON 相同的格式） ---
+    QByteArray json;
+    bench.run("json_serialize", trackCount, trackCount, [&]() {
+        json = QJsonDocument(playlistToJson(all)).toJson(QJsonDocument::Compact);
+        sink += json.size();
+    });
+    if (json.isEmpty()) {
+        json = QJsonDocument(playlistToJson(all)).toJson(QJsonDocument::Compact);
+    }
+    bench.run("json_parse", trackCount, trackCount, [&]() {
+        Playlist parsed = playlistFromJson(QJsonDocument::fromJson(json).object());
+        sink += parsed.videos.size();
+    });
+
+    // --- PlaylistStore：量測實際設定的後端（SQLite 或 JSON 分片） ---
+    int saveRound = 0;
+    QString storeDir;
+    PlaylistStore* store = nullptr;
+    auto openStore = [&]() {
+        delete store;
+        storeDir = QString("%1/store-%2-%3").arg(tempRoot).arg(trackCount).arg(saveRound++);
+        store = new PlaylistStore(storeDir);
+        QList<Playlist> empty;
+        QString lastName;
+        bool needsFullSave = false;
+        store->load(empty, lastName, needsFullSave, false);
+    };
+    bench.run("store_save_full", trackCount, trackCount, [&]() {
+        store->save(library, order, favorites.name);
+    }, openStore);
+    if (!store) {
+        openStore();
+        store->save(library, order, favorites.name);
+    }
+
+    Playlist changedFavorites = favorites;
+    bench.run("store_save_incremental", trackCount, changedFavorites.videos.size(), [&]() {
+        changedFavorites.videos.swapItemsAt(0, changedFavorites.videos.size() - 1);
+        store->save({ changedFavorites }, order, favorites.name);
+    });
+    delete store;
+    store = nullptr;
+
+    for (bool lazy : { false, true }) {
+        bench.run(lazy ? "store_load_lazy" : "store_load_full", trackCount, trackCount, [&]() {
+            PlaylistStore loader(storeDir);
+            QList<Playlist> loaded;
+            QString lastName;
+            bool needsFullSave = false;
+            loader.load(loaded, lastName, needsFullSave, lazy);
+            for (const Playlist& playlist : std::as_const(loaded)) {
+                sink += playlist.videos.size();
+            }
+        });
+    }
+
+    // --- 模型：切換播放清單並取出一個畫面的資料（updatePlaylistDisplay 的工作） ---
+    QSet<QString> favoriteKeys;
+    for (const VideoInfo& video : favorites.videos) {
+        favoriteKeys.insert(trackKey(video));
+    }
+    PlaylistModel model(&library);
+    model.setFavoriteKeys(&favoriteKeys);
+    auto readRows = [&](int first, int count) {
+        const int last = qMin(model.rowCount(), first + count);
+        for (int row = first; row < last; row++) {
+            const QModelIndex index = model.index(row);
+            sink += model.data(index, Qt::DisplayRole).toString().size();
+            sink += model.data(index, PlaylistModel::IsFavoriteRole).toBool();
+            sink += model.data(index, PlaylistModel::IsCurrentRole).toBool();
+        }
+    };
+    const int switches = 1000;
+    bench.run("model_switch", trackCount, switches, [&]() {
+        for (int i = 0; i < switches; i++) {
+            model.setPlaylistIndex(i & 1);
+            readRows(0, kVisibleRows);
+        }
+    });
+    model.setPlaylistIndex(0);
+    bench.run("model_scroll", trackCount, trackCount, [&]() {
+        readRows(0, trackCount);
+    });
+
+    // --- 隨機播放 ---
+    ShuffleEngine shuffle;
+    shuffle.setSeed(seed);
+    bench.run("shuffle_reset", trackCount, trackCount, [&]() {
+        shuffle.reset(trackCount, 0);
+    });
+    const int picks = qMin(trackCount, kMaxPicks);
+    bench.run("shuffle_pick", trackCount, picks, [&]() {
+        for (int i = 0; i < picks; i++) {
+            const int track = shuffle.upcoming(true);
+            shuffle.select(track);
+            sink += track;
+        }
+    }, [&]() { shuffle.reset(trackCount, 0); });
+
+    // --- 最愛切換：trackKey 集合的加入/移除 ---
+    const int toggles = qMin(trackCount, kMaxToggles);
+    QList<int> toggleRows;
+    toggleRows.reserve(toggles);
+    QRandomGenerator rng(seed ^ 0x5A5A5A5A);
+    for (int i = 0; i < toggles; i++) {
+        toggleRows.append(rng.bounded(trackCount));
+    }
+    bench.run("favorite_toggle", trackCount, toggles, [&]() {
+        for (int row : std::as_const(toggleRows)) {
+            const QString key = trackKey(all.videos.at(row));
+            if (!favoriteKeys.remove(key)) {
+                favoriteKeys.insert(key);
+            }
+        }
+        sink += favoriteKeys.size();
+    });
+
+    // --- YouTube 連結解析 ---
+    const QStringList links = generateLinks(trackCount, seed);
+    bench.run("extract_video_id", trackCount, links.size(), [&]() {
+        for (const QString& link : links) {
+            sink += extractYouTubeVideoId(link).size();
+        }
+    });
+
+    // --- M3U8 匯出與串流匯入（在記憶體中，不含磁碟 I/O） ---
+    const std::atomic<bool> notCancelled(false);
+    QByteArray m3u;
+    bench.run("m3u_write", trackCount, trackCount, [&]() {
+        QBuffer buffer(&m3u);
+        buffer.open(QIODevice::WriteOnly);
+        PlaylistFileIO::write(buffer, PlaylistFileIO::M3U, "/music", all.videos, notCancelled);
+    }, [&]() { m3u.clear(); });
+    bench.run("m3u_parse", trackCount, trackCount, [&]() {
+        QBuffer buffer(&m3u);
+        buffer.open(QIODevice::ReadOnly);
+        PlaylistFileIO::parse(buffer, PlaylistFileIO::M3U, true, "/music", notCancelled,
+                              [](const QList<VideoInfo>& videos) { sink += videos.size(); });
+    });
+
+    // --- 音樂庫搜尋：建立索引與逐字輸入 ---
+    LibrarySearch search;
+    bench.run("search_index_build", trackCount, trackCount, [&]() {
+        search.updatePlaylist(all.name, all.videos);
+    }, [&]() { search = LibrarySearch(); });
+    if (!search.hasPlaylist(all.name)) {
+        search.updatePlaylist(all.name, all.videos);
+    }
+    const QStringList typing = { "m", "mi", "mid", "midn", "midni", "midnight", "midnight l",
+                                 "夜", "夜空", "artist 1", "artist 12" };
+    bench.run("search_typing", trackCount, typing.size(), [&]() {
+        for (const QString& query : typing) {
+            sink += search.search(query).size();
+        }
+    });
+}
+
+// 音訊處理核心：與曲目數無關，只執行一次；ops 為畫格數，ns/op 即每個畫格的成本
+void benchAudio(Bench& bench, quint32 seed)
+{
+    const int sampleRate = 44100;
+    const int channels = 2;
+    const int frames = sampleRate * 60;
+    QRandomGenerator rng(seed);
+    QList<float> noise(qsizetype(frames) * channels);
+    for (float& sample : noise) {
+        sample = float(rng.generateDouble() * 0.5 - 0.25);
+    }
+
+    // --- 響度量測：K 加權濾波、區塊能量與閘控 ---
+    LoudnessMeter meter;
+    bench.run("loudness_measure", 0, frames, [&]() {
+        meter.process(noise.constData(), frames);
+        double lufs = 0.0;
+        if (meter.integratedLoudness(lufs)) {
+            sink += quint64(std::fabs(lufs) * 100.0);
+        }
+    }, [&]() { meter.reset(sampleRate, channels); });
+
+    // --- 交叉淡化混音：與 CrossfadePlayer 相同，每 256 個畫格一段增益斜坡 ---
+    // ops 為混音的秒數，ns/op 即每混音一秒的 CPU 成本；各向量版本分別量測
+    QList<float> incoming(noise.size());
+    for (float& sample : incoming) {
+        sample = float(rng.generateDouble() * 0.5 - 0.25);
+    }
+    QList<float> mixed(noise.size());
+    const int segmentFrames = 256;
+    for (int kernel = AudioMixer::Scalar; kernel <= AudioMixer::bestKernel(); kernel++) {
+        const AudioMixer::Kernel selected = AudioMixer::Kernel(kernel);
+        bench.run(QString("crossfade_mix_%1").arg(AudioMixer::kernelName(selected)), 0, frames / sampleRate, [&]() {
+            for (int frame = 0; frame < frames; frame += segmentFrames) {
+                const int length = qMin(segmentFrames, frames - frame);
+                const float start = float(frame) / frames;
+                const float end = float(frame + length) / frames;
+                const qsizetype offset = qsizetype(frame) * channels;
+                AudioMixer::scaleRamp(mixed.data() + offset, noise.constData() + offset, length, channels,
+                                      1.0f - start, 1.0f - end, selected);
+                AudioMixer::mixRamp(mixed.data() + offset, incoming.constData() + offset, length, channels,
+                                    start, end, selected);
+            }
+            sink += quint64(std::fabs(mixed[frames]) * 1000.0f);
+        });
+    }
+
+    // --- 環形緩衝：解碼端以 1024 畫格寫入，輸出端以 10 ms 讀出，兩個執行緒同時進行 ---
+    // ops 為傳遞的秒數；容量與 CrossfadePlayer 預設的 200 ms 相同
+    AudioRingBuffer ring(qsizetype(sampleRate) * channels / 5);
+    QList<float> received(noise.size());
+    bench.run("ring_spsc", 0, frames / sampleRate, [&]() {
+        std::thread producer([&]() {
+            const qsizetype total = noise.size();
+            qsizetype written = 0;
+            while (written < total) {
+                const qsizetype count = ring.write(noise.constData() + written, qMin<qsizetype>(1024 * channels, total - written));
+                written += count;
+                if (count == 0) std::this_thread::yield();
+            }
+        });
+        const qsizetype period = qsizetype(sampleRate / 100) * channels;
+        qsizetype read = 0;
+        while (read < received.size()) {
+            const qsizetype count = ring.read(received.data() + read, qMin(period, received.size() - read));
+            read += count;
+            if (count == 0) std::this_thread::yield();
+        }
+        producer.join();
+        sink += quint64(std::fabs(received[frames]) * 1000.0f);
+    });
+
+    // --- 等化器：96 kHz 立體聲，10 段全部啟用，與 CrossfadePlayer 相同以 1024 畫格為一段 ---
+    // ops 為處理的秒數；每次執行前還原輸入並清除濾波器狀態
+    const int eqSampleRate = 96000;
+    const int eqFrames = eqSampleRate * 60;
+    QList<float> eqInput(qsizetype(eqFrames) * channels);
+    for (float& sample : eqInput) {
+        sample = float(rng.generateDouble() * 0.5 - 0.25);
+    }
+    QList<float> eqBuffer(eqInput.size());
+    EqualizerSettings eqSettings;
+    eqSettings.enabled = true;
+    eqSettings.preampDb = -3.0f;
+    for (int b = 0; b < EqualizerSettings::kBands; b++) {
+        eqSettings.bands[b].gainDb = (b % 2 == 0) ? 6.0f : -6.0f;
+    }
+    Equalizer equalizer;
+    for (int kernel = Equalizer::Scalar; kernel <= Equalizer::bestKernel(); kernel++) {
+        const Equalizer::Kernel selected = Equalizer::Kernel(kernel);
+        bench.run(QString("equalizer_96k_%1").arg(Equalizer::kernelName(selected)), 0, eqFrames / eqSampleRate, [&]() {
+            for (int frame = 0; frame < eqFrames; frame += 1024) {
+                const int length = qMin(1024, eqFrames - frame);
+                equalizer.process(eqBuffer.data() + qsizetype(frame) * channels, length, selected);
+            }
+            sink += quint64(std::fabs(eqBuffer[eqFrames]) * 1000.0f);
+        }, [&]() {
+            std::copy(eqInput.cbegin(), eqInput.cend(), eqBuffer.begin());
+            equalizer.reset(eqSampleRate);
+            equalizer.setSettings(eqSettings);
+        });
+    }
+
+    // --- 頻譜分析：與 SpectrumView 相同，每 1/30 秒送入一段樣本並計算一次 FFT 與長條 ---
+    // ops 為計算的次數，ns/op 即每個畫面的分析成本
+    const int analysisFrames = sampleRate / 30;
+    const int analyses = frames / analysisFrames;
+    SpectrumAnalyzer analyzer;
+    bench.run("spectrum_analyze", 0, analyses, [&]() {
+        for (int i = 0; i < analyses; i++) {
+            analyzer.push(noise.constData() + qsizetype(i) * analysisFrames * channels, analysisFrames, channels);
+            analyzer.analyze(1.0 / 30.0);
+        }
+        sink += quint64(analyzer.bars()[0] * 1000.0f);
+    }, [&]() { analyzer.reset(sampleRate, 48); });
+}
+
+QList<int> parseSizes(const QString& text, bool& ok)
+{
+    QList<int> sizes;
+    ok = true;
+    const QStringList parts = text.split(',', Qt::SkipEmptyParts);
+    for (const QString& part : parts) {
+        QString value = part.trimmed().toLower();
+        int multiplier = 1;
+        if (value.endsWith('k')) {
+            multiplier = 1000;
+            value.chop(1);
+        } else if (value.endsWith('m')) {
+            multiplier = 1000000;
+            value.chop(1);
+        }
+        bool numberOk = false;
+        const qint64 size = qint64(value.toInt(&numberOk)) * multiplier;
+        if (!numberOk || size <= 0 || size > kMaxTracks) {
+            ok = false;
+            return {};
+        }
+        sizes.append(int(size));
+    }
+    ok = !sizes.isEmpty();
+    return sizes;
+}
+
+}
+
+int main(int argc, char* argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("last-report-bench");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("last-report 播放清單核心效能測試");
+    parser.addHelpOption();
+    QCommandLineOption sizesOption("sizes", "曲目數量，以逗號分隔，可用 k/m 後綴（最多 1m）", "list", "1k,10k,100k");
+    QCommandLineOption repeatOption("repeat", "每個項目重複次數，取中位數", "n", "5");
+    QCommandLineOption seedOption("seed", "合成資料的亂數種子", "seed", "1");
+    QCommandLineOption filterOption("filter", "只執行名稱包含此字串的項目", "text");
+    QCommandLineOption outputOption("output", "JSON 輸出檔（預設為標準輸出）", "file");
+    parser.addOptions({ sizesOption, repeatOption, seedOption, filterOption, outputOption });
+    parser.process(app);
+
+    bool sizesOk = false;
+    const QList<int> sizes = parseSizes(parser.value(sizesOption), sizesOk);
+    const int repeat = parser.value(repeatOption).toInt();
+    const quint32 seed = parser.value(seedOption).toUInt();
+    if (!sizesOk || repeat <= 0) {
+        std::fprintf(stderr, "invalid --sizes or --repeat\n");
+        return 2;
+    }
+
+    QTemporaryDir tempDir;
+    if (!tempDir.isValid()) {
+        std::fprintf(stderr, "cannot create a temporary directory\n");
+        return 1;
+    }
+
+    Bench bench(repeat, parser.value(filterOption));
+    for (int size : sizes) {
+        benchSize(bench, size, seed, tempDir.path());
+    }
+    benchAudio(bench, seed);
+
+    QJsonObject report;
+    report["tool"] = "last-report-bench";
+    report["formatVersion"] = 1;
+    report["qtVersion"] = QString::fromLatin1(qVersion());
+#ifdef HAVE_SQLITE_STORE
+    report["storeBackend"] = "sqlite";
+#else
+    report["storeBackend"] = "json";
+#endif
+    report["seed"] = qint64(seed);
+    report["repeat"] = repeat;
+    report["timestamp"] = QDateTime::currentDateTimeUtc().toString(Qt::ISODate);
+    report["results"] = bench.toJson();
+    report["checksum"] = QString::number(sink);
+
+    const QByteArray output = QJsonDocument(report).toJson(QJsonDocument::Indented);
+    if (parser.isSet(outputOption)) {
+        QFile file(parser.value(outputOption));
+        if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate) || file.write(output) != output.size()) {
+            std::fprintf(stderr, "cannot write %s\n", qPrintable(parser.value(outputOption)));
+            return 1;
+        }
+    } else {
+        std::fwrite(output.constData(), 1, size_t(output.size()), stdout);
+    }
+    return 0;
+}
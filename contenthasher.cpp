@@ -0,0 +1,328 @@
+#include "contenthasher.h"
+#include <QThread>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QDataStream>
+#include <QDateTime>
+#include <QMutexLocker>
+#include <QtEndian>
+#include <cstring>
+
+namespace {
+const quint32 kCacheMagic = 0x4C524348;   // "LRCH"
+const quint32 kCacheVersion = 1;
+const qint64 kChunkBytes = 16 * 1024;
+
+// XXH64（串流版本），與參考實作的輸出相同
+class XXHash64
+{
+public:
+    explicit XXHash64(quint64 seed = 0)
+        : v1(seed + kPrime1 + kPrime2)
+        , v2(seed + kPrime2)
+        , v3(seed)
+        , v4(seed - kPrime1)
+        , seed(seed)
+        , totalLength(0)
+        , bufferSize(0)
+    {
+    }
+
+    void update(const uchar* data, qint64 length)
+    {
+        totalLength += quint64(length);
+
+        if (bufferSize + length < 32) {
+            std::memcpy(buffer + bufferSize, data, size_t(length));
+            bufferSize += int(length);
+            return;
+        }
+
+        const uchar* end = data + length;
+        if (bufferSize > 0) {
+            const int fill = 32 - bufferSize;
+            std::memcpy(buffer + bufferSize, data, size_t(fill));
+            consumeStripe(buffer);
+            data += fill;
+            bufferSize = 0;
+        }
+        while (end - data >= 32) {
+            consumeStripe(data);
+            data += 32;
+        }
+        bufferSize = int(end - data);
+        std::memcpy(buffer, data, size_t(bufferSize));
+    }
+
+    quint64 digest() const
+    {
+        quint64 h;
+        if (totalLength >= 32) {
+            h = rotl(v1, 1) + rotl(v2, 7) + rotl(v3, 12) + rotl(v4, 18);
+            h = mergeRound(h, v1);
+            h = mergeRound(h, v2);
+            h = mergeRound(h, v3);
+            h = mergeRound(h, v4);
+        } else {
+            h = seed + kPrime5;
+        }
+        h += totalLength;
+
+        const uchar* p = buffer;
+        const uchar* end = buffer + bufferSize;
+        while (end - p >= 8) {
+            h ^= round(0, qFromLittleEndian<quint64>(p));
+            h = rotl(h, 27) * kPrime1 + kPrime4;
+            p += 8;
+        }
+        if (end - p >= 4) {
+            h ^= quint64(qFromLittleEndian<quint32>(p)) * kPrime1;
+            h = rotl(h, 23) * kPrime2 + kPrime3;
+            p += 4;
+        }
+        while (p < end) {
+            h ^= quint64(*p) * kPrime5;
+            h = rotl(h, 11) * kPrime1;
+            p++;
+        }
+
+        h ^= h >> 33;
+        h *= kPrime2;
+        h ^= h >> 29;
+        h *= kPrime3;
+        h ^= h >> 32;
+        return h;
+    }
+
+private:
+    static constexpr quint64 kPrime1 = 11400714785074694791ULL;
+    static constexpr quint64 kPrime2 = 14029467366897019727ULL;
+    static constexpr quint64 kPrime3 = 1609587929392839161ULL;
+    static constexpr quint64 kPrime4 = 9650029242287828579ULL;
+    static constexpr quint64 kPrime5 = 2870177450012600261ULL;
+
+    static quint64 rotl(quint64 x, int r) { return (x << r) | (x >> (64 - r)); }
+
+    static quint64 round(quint64 acc, quint64 input)
+    {
+        acc += input * kPrime2;
+        acc = rotl(acc, 31);
+        return acc * kPrime1;
+    }
+
+    static quint64 mergeRound(quint64 acc, quint64 value)
+    {
+        acc ^= round(0, value);
+        return acc * kPrime1 + kPrime4;
+    }
+
+    void consumeStripe(const uchar* p)
+    {
+        v1 = round(v1, qFromLittleEndian<quint64>(p));
+        v2 = round(v2, qFromLittleEndian<quint64>(p + 8));
+        v3 = round(v3, qFromLittleEndian<quint64>(p + 16));
+        v4 = round(v4, qFromLittleEndian<quint64>(p + 24));
+    }
+
+    quint64 v1, v2, v3, v4;
+    quint64 seed;
+    quint64 totalLength;
+    uchar buffer[32];
+    int bufferSize;
+};
+
+// 從 offset 起分塊讀取 length 個位元組送進雜湊
+bool hashRange(QFile& file, qint64 offset, qint64 length, XXHash64& hasher)
+{
+    if (!file.seek(offset)) return false;
+
+    uchar chunk[kChunkBytes];
+    while (length > 0) {
+        qint64 bytesRead = file.read(reinterpret_cast<char*>(chunk), qMin(length, kChunkBytes));
+        if (bytesRead <= 0) return false;
+        hasher.update(chunk, bytesRead);
+        length -= bytesRead;
+    }
+    return true;
+}
+}
+
+ContentHasher::ContentHasher(const QString& cacheDir, QObject* parent)
+    : QObject(parent)
+    , cacheDir(cacheDir)
+    , cacheDirty(false)
+    , nextBatchId(0)
+    , cancelled(false)
+{
+    // 每個檔案只讀兩小段，時間幾乎都花在開檔與尋軌上（網路磁碟尤其如此）
+    pool.setMaxThreadCount(qBound(2, QThread::idealThreadCount(), 8));
+    loadCache();
+}
+
+ContentHasher::~ContentHasher()
+{
+    cancelled = true;
+    pool.clear();
+    pool.waitForDone();
+    if (cacheDirty) {
+        saveCache();
+    }
+}
+
+quint64 ContentHasher::hashFile(const QString& filePath, bool* ok)
+{
+    if (ok) *ok = false;
+
+    QFile file(filePath);
+    if (!file.open(QIODevice::ReadOnly)) return 0;
+
+    // 小檔案整個讀取；大檔案只取檔頭與檔尾，中間的內容由檔案大小代表
+    const qint64 size = file.size();
+    XXHash64 hasher;
+    if (size <= kSampleBytes * 2) {
+        if (!hashRange(file, 0, size, hasher)) return 0;
+    } else {
+        if (!hashRange(file, 0, kSampleBytes, hasher) ||
+            !hashRange(file, size - kSampleBytes, kSampleBytes, hasher)) {
+            return 0;
+        }
+    }
+    uchar sizeBytes[8];
+    qToLittleEndian<quint64>(quint64(size), sizeBytes);
+    hasher.update(sizeBytes, sizeof(sizeBytes));
+
+    if (ok) *ok = true;
+    return hasher.digest();
+}
+
+int ContentHasher::hashFiles(const QStringList& filePaths)
+{
+    int batchId;
+    {
+        QMutexLocker locker(&mutex);
+        batchId = nextBatchId++;
+        batches[batchId].remaining = filePaths.size();
+    }
+
+    if (filePaths.isEmpty()) {
+        // 空批次也要回報，呼叫端才能結束等待
+        QMetaObject::invokeMethod(this, [this, batchId]() {
+            {
+                QMutexLocker locker(&mutex);
+                batches.remove(batchId);
+            }
+            emit hashesReady(batchId, QHash<QString, quint64>());
+        }, Qt::QueuedConnection);
+        return batchId;
+    }
+
+    for (const QString& filePath : filePaths) {
+        pool.start([this, batchId, filePath]() {
+            hashJob(batchId, filePath);
+        });
+    }
+    return batchId;
+}
+
+void ContentHasher::hashJob(int batchId, const QString& filePath)
+{
+    if (cancelled) {
+        finishJob(batchId, filePath, false, 0);
+        return;
+    }
+
+    QFileInfo fileInfo(filePath);
+    if (!fileInfo.isFile()) {
+        finishJob(batchId, filePath, false, 0);
+        return;
+    }
+
+    // 快取命中：大小與修改時間都相同時不必讀取檔案
+    const qint64 size = fileInfo.size();
+    const qint64 modified = fileInfo.lastModified().toMSecsSinceEpoch();
+    {
+        QMutexLocker locker(&mutex);
+        auto it = cache.constFind(filePath);
+        if (it != cache.constEnd() && it->size == size && it->modified == modified) {
+            const quint64 hash = it->hash;
+            locker.unlock();
+            finishJob(batchId, filePath, true, hash);
+            return;
+        }
+    }
+
+    bool ok = false;
+    const quint64 hash = hashFile(filePath, &ok);
+    if (ok) {
+        QMutexLocker locker(&mutex);
+        cache.insert(filePath, CacheEntry{ size, modified, hash });
+        cacheDirty = true;
+    }
+    finishJob(batchId, filePath, ok, hash);
+}
+
+void ContentHasher::finishJob(int batchId, const QString& filePath, bool ok, quint64 hash)
+{
+    QMutexLocker locker(&mutex);
+    auto it = batches.find(batchId);
+    if (it == batches.end()) return;
+
+    if (ok) {
+        it->hashes.insert(filePath, hash);
+    }
+    if (--it->remaining > 0) return;
+
+    // 整批完成：回到 GUI 執行緒回報，沒有其他批次時寫入快取
+    QHash<QString, quint64> hashes = std::move(it->hashes);
+    batches.erase(it);
+    const bool save = batches.isEmpty() && cacheDirty;
+    locker.unlock();
+
+    QMetaObject::invokeMethod(this, [this, batchId, hashes, save]() {
+        if (save) {
+            saveCache();
+        }
+        emit hashesReady(batchId, hashes);
+    }, Qt::QueuedConnection);
+}
+
+void ContentHasher::loadCache()
+{
+    QFile file(cacheDir + "/content_hashes.dat");
+    if (!file.open(QIODevice::ReadOnly)) return;
+
+    QDataStream in(&file);
+    in.setVersion(QDataStream::Qt_6_0);
+    quint32 magic = 0;
+    quint32 version = 0;
+    qint32 count = 0;
+    in >> magic >> version >> count;
+    if (magic != kCacheMagic || version != kCacheVersion || count < 0) return;
+
+    cache.reserve(count);
+    for (qint32 i = 0; i < count && in.status() == QDataStream::Ok; i++) {
+        QString filePath;
+        CacheEntry entry;
+        in >> filePath >> entry.size >> entry.modified >> entry.hash;
+        cache.insert(filePath, entry);
+    }
+}
+
+void ContentHasher::saveCache()
+{
+    QMutexLocker locker(&mutex);
+
+    QSaveFile file(cacheDir + "/content_hashes.dat");
+    if (!file.open(QIODevice::WriteOnly)) return;
+
+    QDataStream out(&file);
+    out.setVersion(QDataStream::Qt_6_0);
+    out << kCacheMagic << kCacheVersion << qint32(cache.size());
+    for (auto it = cache.cbegin(); it != cache.cend(); ++it) {
+        out << it.key() << it->size << it->modified << it->hash;
+    }
+    if (file.commit()) {
+        cacheDirty = false;
+    }
+}
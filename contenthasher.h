@@ -0,0 +1,65 @@
+#ifndef CONTENTHASHER_H
+#define CONTENTHASHER_H
+
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QHash>
+#include <QMutex>
+#include <QThreadPool>
+#include <atomic>
+
+// 本地檔案的內容雜湊：同一個檔案經由不同路徑（符號連結、重新掛載的網路磁碟）仍得到相同的值
+// 以 XXH64 計算檔頭與檔尾各 64 KB 再加上檔案大小，分塊讀取，不會把整個檔案讀進記憶體
+// 結果以 路徑/大小/修改時間 為鍵快取在磁碟上，檔案未變更時不再讀取
+class ContentHasher : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit ContentHasher(const QString& cacheDir, QObject* parent = nullptr);
+    ~ContentHasher();
+
+    // 在執行緒池上計算一批檔案，全部完成後以 hashesReady 回報；回傳批次編號
+    int hashFiles(const QStringList& filePaths);
+
+    // 直接計算單一檔案（在呼叫的執行緒上），無法讀取時 ok 為 false
+    static quint64 hashFile(const QString& filePath, bool* ok = nullptr);
+
+    static const qint64 kSampleBytes = 64 * 1024;
+
+signals:
+    // 無法讀取的檔案不在 hashes 中
+    void hashesReady(int batchId, const QHash<QString, quint64>& hashes);
+
+private:
+    struct CacheEntry {
+        qint64 size;
+        qint64 modified;
+        quint64 hash;
+    };
+
+    struct Batch {
+        int remaining = 0;
+        QHash<QString, quint64> hashes;
+    };
+
+    // 在執行緒池上執行
+    void hashJob(int batchId, const QString& filePath);
+    void finishJob(int batchId, const QString& filePath, bool ok, quint64 hash);
+
+    void loadCache();
+    void saveCache();
+
+    QString cacheDir;
+    QMutex mutex;
+    QHash<QString, CacheEntry> cache;
+    QHash<int, Batch> batches;
+    bool cacheDirty;
+    int nextBatchId;
+    std::atomic<bool> cancelled;
+
+    QThreadPool pool;
+};
+
+#endif // CONTENTHASHER_H
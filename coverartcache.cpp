@@ -0,0 +1,210 @@
+#include "coverartcache.h"
+#include <QThread>
+#include <QTimer>
+#include <QDir>
+#include <QFileInfo>
+#include <QDateTime>
+#include <QUrl>
+#include <QImageReader>
+#include <QSaveFile>
+#include <QGuiApplication>
+#include <QMutexLocker>
+#include <cmath>
+
+namespace {
+const int kListLogicalSize = 48;
+const int kPanelLogicalSize = 128;
+const int kMaxPendingJobs = 128;       // 快速捲動時只保留最近排入的，捲走的列之後重繪時會再排入
+const int kFlushIntervalMs = 50;
+const qint64 kDefaultMemoryLimit = 32 * 1024 * 1024;
+}
+
+// === CoverArtWorker ===
+
+CoverArtWorker::CoverArtWorker(CoverArtCache* owner)
+    : owner(owner)
+{
+}
+
+void CoverArtWorker::wake()
+{
+    CoverArtCache::Job job;
+    while (owner->takeJob(job)) {
+        owner->deliver(job, load(job.coverUrl, owner->pixelSize(job.size)));
+    }
+}
+
+QImage CoverArtWorker::load(const QString& coverUrl, int pixels)
+{
+    const QUrl url(coverUrl);
+    if (!url.isLocalFile()) return QImage();
+    const QFileInfo source(url.toLocalFile());
+    if (!source.exists()) return QImage();
+
+    // 縮圖比原始封面新時直接讀取
+    const QString thumbnailPath = owner->thumbnailDir() + "/" + source.completeBaseName()
+                                  + QString("_%1.jpg").arg(pixels);
+    const QFileInfo thumbnail(thumbnailPath);
+    if (thumbnail.exists() && thumbnail.lastModified() >= source.lastModified()) {
+        QImage image(thumbnailPath);
+        if (!image.isNull()) return image;
+    }
+
+    // JPEG 可以在解碼時直接縮小，不必先解出整張圖
+    QImageReader reader(source.filePath());
+    const QSize original = reader.size();
+    if (original.isValid() && (original.width() > pixels || original.height() > pixels)) {
+        reader.setScaledSize(original.scaled(pixels, pixels, Qt::KeepAspectRatio));
+    }
+    QImage image = reader.read();
+    if (image.isNull()) return QImage();
+    if (image.width() > pixels || image.height() > pixels) {
+        image = image.scaled(pixels, pixels, Qt::KeepAspectRatio, Qt::SmoothTransformation);
+    }
+
+    // 多個尺寸可能同時寫入同一個目錄：寫完再換名
+    QSaveFile file(thumbnailPath);
+    if (file.open(QIODevice::WriteOnly) && image.save(&file, "JPG", 90)) {
+        file.commit();
+    }
+    return image;
+}
+
+// === CoverArtCache ===
+
+int CoverArtCache::logicalSize(Size size)
+{
+    return size == ListSize ? kListLogicalSize : kPanelLogicalSize;
+}
+
+CoverArtCache::CoverArtCache(const QString& cacheDir, QObject* parent)
+    : QObject(parent)
+    , cacheDir(cacheDir)
+    , pixelRatio(qBound(1, int(std::ceil(qGuiApp->devicePixelRatio())), 3))
+    , memory(kDefaultMemoryLimit)
+    , workerAwake(false)
+{
+    QDir().mkpath(thumbnailDir());
+
+    flushTimer = new QTimer(this);
+    flushTimer->setInterval(kFlushIntervalMs);
+    connect(flushTimer, &QTimer::timeout, this, &CoverArtCache::flushResults);
+
+    // 小圖解碼很快，一個低優先權的執行緒就夠了
+    thread = new QThread(this);
+    thread->setObjectName("coverart");
+    worker = new CoverArtWorker(this);
+    worker->moveToThread(thread);
+    connect(thread, &QThread::finished, worker, &QObject::deleteLater);
+    thread->start(QThread::LowPriority);
+}
+
+CoverArtCache::~CoverArtCache()
+{
+    {
+        QMutexLocker locker(&mutex);
+        jobs.clear();
+    }
+    thread->quit();
+    thread->wait();
+}
+
+void CoverArtCache::setMemoryLimit(qint64 bytes)
+{
+    memory.setMaxCost(qsizetype(qMax<qint64>(0, bytes)));
+}
+
+QString CoverArtCache::memoryKey(const QString& coverUrl, Size size)
+{
+    return coverUrl + (size == ListSize ? "#list" : "#panel");
+}
+
+QPixmap CoverArtCache::cover(const QString& coverUrl, Size size)
+{
+    if (coverUrl.isEmpty()) return QPixmap();
+
+    const QString key = memoryKey(coverUrl, size);
+    if (const QPixmap* pixmap = memory.object(key)) {
+        return *pixmap;
+    }
+    if (failed.contains(key)) return QPixmap();
+
+    bool wakeWorker = false;
+    {
+        QMutexLocker locker(&mutex);
+        if (!pending.contains(key)) {
+            pending.insert(key);
+            jobs.append(Job{ coverUrl, size });
+            if (jobs.size() > kMaxPendingJobs) {
+                pending.remove(memoryKey(jobs.first().coverUrl, jobs.first().size));
+                jobs.removeFirst();
+            }
+        }
+        if (!workerAwake) {
+            workerAwake = true;
+            wakeWorker = true;
+        }
+    }
+    if (wakeWorker) {
+        QMetaObject::invokeMethod(worker, [worker = worker]() { worker->wake(); }, Qt::QueuedConnection);
+    }
+    if (!flushTimer->isActive()) {
+        flushTimer->start();
+    }
+    return QPixmap();
+}
+
+bool CoverArtCache::takeJob(Job& job)
+{
+    QMutexLocker locker(&mutex);
+    if (jobs.isEmpty()) {
+        workerAwake = false;
+        return false;
+    }
+    job = jobs.takeLast();
+    return true;
+}
+
+void CoverArtCache::deliver(const Job& job, const QImage& image)
+{
+    QMutexLocker locker(&mutex);
+    results.append(Result{ job.coverUrl, job.size, image });
+}
+
+void CoverArtCache::flushResults()
+{
+    QList<Result> ready;
+    bool idle = false;
+    {
+        QMutexLocker locker(&mutex);
+        ready.swap(results);
+        for (const Result& result : std::as_const(ready)) {
+            pending.remove(memoryKey(result.coverUrl, result.size));
+        }
+        idle = pending.isEmpty();
+    }
+
+    // QPixmap 只能在 GUI 執行緒上建立；圖都很小，轉換很便宜
+    QStringList coverUrls;
+    for (const Result& result : std::as_const(ready)) {
+        const QString key = memoryKey(result.coverUrl, result.size);
+        if (result.image.isNull()) {
+            failed.insert(key);
+            continue;
+        }
+        QPixmap* pixmap = new QPixmap(QPixmap::fromImage(result.image));
+        pixmap->setDevicePixelRatio(pixelRatio);
+        const qsizetype cost = qsizetype(result.image.width()) * result.image.height() * 4;
+        memory.insert(key, pixmap, cost);
+        if (!coverUrls.contains(result.coverUrl)) {
+            coverUrls.append(result.coverUrl);
+        }
+    }
+
+    if (!coverUrls.isEmpty()) {
+        emit coversReady(coverUrls);
+    }
+    if (idle) {
+        flushTimer->stop();
+    }
+}
@@ -0,0 +1,104 @@
+#ifndef COVERARTCACHE_H
+#define COVERARTCACHE_H
+
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QList>
+#include <QSet>
+#include <QCache>
+#include <QPixmap>
+#include <QImage>
+#include <QMutex>
+
+class QThread;
+class QTimer;
+
+class CoverArtCache;
+
+// 工作執行緒：讀取縮圖檔；還沒有縮圖時由原始封面縮小一次並寫入磁碟
+class CoverArtWorker : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit CoverArtWorker(CoverArtCache* owner);
+
+    // 在工作執行緒上呼叫：處理佇列直到清空
+    void wake();
+
+private:
+    QImage load(const QString& coverUrl, int pixels);
+
+    CoverArtCache* owner;
+};
+
+// 封面縮圖的兩層快取
+// 記憶體：GUI 執行緒上的 QCache（LRU，以位元組計算成本）；磁碟：每個封面每種尺寸只縮小一次，存成小圖
+// 原始封面由 MetadataExtractor 以圖片內容的雜湊命名，同一張專輯的曲目共用同一組檔案
+// cover() 不讀檔也不解碼：沒有命中時排入背景載入並回傳空的 QPixmap，完成後以 coversReady 通知
+class CoverArtCache : public QObject
+{
+    Q_OBJECT
+
+public:
+    enum Size { ListSize, PanelSize };
+
+    // 顯示的邊長（裝置無關像素）；縮圖依螢幕倍率存放
+    static int logicalSize(Size size);
+
+    explicit CoverArtCache(const QString& cacheDir, QObject* parent = nullptr);
+    ~CoverArtCache();
+
+    // GUI 執行緒：coverUrl 為 VideoInfo::thumbnailUrl（本地圖片的 file: URL）
+    QPixmap cover(const QString& coverUrl, Size size);
+
+    // 記憶體層的上限（位元組）
+    void setMemoryLimit(qint64 bytes);
+
+signals:
+    void coversReady(const QStringList& coverUrls);
+
+private:
+    friend class CoverArtWorker;
+
+    struct Job {
+        QString coverUrl;
+        Size size;
+    };
+
+    struct Result {
+        QString coverUrl;
+        Size size;
+        QImage image;                 // 無法讀取時為空
+    };
+
+    // 以下函式由工作執行緒呼叫，受 mutex 保護
+    bool takeJob(Job& job);
+    void deliver(const Job& job, const QImage& image);
+    int pixelSize(Size size) const { return logicalSize(size) * pixelRatio; }
+    QString thumbnailDir() const { return cacheDir + "/covers/thumbs"; }
+
+    void flushResults();
+    static QString memoryKey(const QString& coverUrl, Size size);
+
+    QString cacheDir;
+    int pixelRatio;
+
+    // GUI 執行緒上的狀態
+    QCache<QString, QPixmap> memory;
+    QSet<QString> failed;             // 無法讀取的封面，本次執行中不再嘗試
+
+    // 與工作執行緒共用
+    QMutex mutex;
+    QList<Job> jobs;                  // 最後排入的先處理（通常是目前看得到的列），超過上限時丟棄最舊的
+    QSet<QString> pending;            // 已排入或處理中的 memoryKey
+    QList<Result> results;
+    bool workerAwake;
+
+    QThread* thread;
+    CoverArtWorker* worker;
+    QTimer* flushTimer;
+};
+
+#endif // COVERARTCACHE_H
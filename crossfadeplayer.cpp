@@ -0,0 +1,948 @@
+#include "crossfadeplayer.h"
+#include "audiomixer.h"
+#include <QAudioDecoder>
+#include <QAudioBuffer>
+#include <QAudioSink>
+#include <QAudioDevice>
+#include <QMediaDevices>
+#include <QThread>
+#include <QTimer>
+#include <QUrl>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+namespace {
+const int kMinLatencyMs = 40;
+const int kFillIntervalMs = 5;         // 解碼執行緒補滿環形緩衝的間隔
+const int kFillFrames = 1024;          // 每次寫入環形緩衝的最大畫格數
+const int kPollIntervalMs = 50;        // GUI 執行緒更新位置、檢查是否播完的間隔
+const int kDecodeAheadMs = 2000;       // 淡化長度之外再多解碼的量，確保淡化開始前已知道確切的結尾
+const int kStartMs = 100;              // 新曲目至少解碼這麼多才開始發聲
+const int kSegmentFrames = 256;        // 每段重新計算包絡，段內以線性斜坡近似
+const int kDeclickFrames = 256;        // 沒有淡化時的最短淡出，避免爆音
+const int kAnalysisTapFrames = 8192;   // 頻譜分析取樣的容量，分析端約每 33 ms 取走一次
+const float kHalfPi = 1.57079632679489661923f;
+const qint64 kNoOrigin = std::numeric_limits<qint64>::min();
+}
+
+CrossfadeRenderer::CrossfadeRenderer(CrossfadePlayer* owner, const QAudioFormat& decodeFormat)
+    : QObject(nullptr)
+    , owner(owner)
+    , decodeFormat(decodeFormat)
+    , fillTimer(nullptr)
+    , session(0)
+    , fadeMsValue(6000)
+    , next(nullptr)
+{
+}
+
+CrossfadeRenderer::~CrossfadeRenderer()
+{
+    destroyAll();
+}
+
+void CrossfadeRenderer::start(int id, const QString& filePath, float volume)
+{
+    session = id;
+    destroyAll();
+    discardOutput();
+
+    // 沒有在發聲：直接開始，不需要淡入
+    Voice* voice = createVoice(filePath, volume, 0);
+    voice->started = true;
+    voice->lastGain = volume;
+    voices.append(voice);
+    publishOrigin(voice, streamFrame());
+
+    ensureTimer();
+    fillTimer->start();
+
+    CrossfadeOutput* output = owner->output;
+    QMetaObject::invokeMethod(output, [output, id]() { output->start(id); });
+}
+
+void CrossfadeRenderer::crossfadeTo(int id, const QString& filePath, float volume)
+{
+    if (!fillTimer || !fillTimer->isActive()) {
+        // 解碼失敗而自行停止（通知還在路上）：重新開始
+        start(id, filePath, volume);
+        return;
+    }
+
+    session = id;
+    clearNext();
+    if (voices.isEmpty()) {
+        // 上一首剛寫完最後一段（通知還在路上）：接在後面直接開始
+        Voice* voice = createVoice(filePath, volume, 0);
+        voice->started = true;
+        voice->lastGain = volume;
+        voices.append(voice);
+        owner->streamEnded.store(false, std::memory_order_relaxed);
+        publishOrigin(voice, streamFrame());
+        return;
+    }
+
+    // 連續切歌時，還沒開始發聲的曲目直接丟棄；新曲目可以發聲前位置為 0
+    if (!voices.last()->started) {
+        destroyVoice(voices.takeLast());
+    }
+    voices.append(createVoice(filePath, volume, 0));
+    owner->voiceOrigin.store(kNoOrigin, std::memory_order_relaxed);
+}
+
+void CrossfadeRenderer::queueNext(const QString& filePath, float volume)
+{
+    if (next && next->filePath == filePath) {
+        next->volume = volume;
+        return;
+    }
+    clearNext();
+    next = createVoice(filePath, volume, 0);
+}
+
+void CrossfadeRenderer::clearNext()
+{
+    if (next) {
+        destroyVoice(next);
+        next = nullptr;
+    }
+}
+
+void CrossfadeRenderer::pause()
+{
+    // 環形緩衝補滿後解碼自然停下
+    CrossfadeOutput* output = owner->output;
+    QMetaObject::invokeMethod(output, [output]() { output->suspend(); });
+}
+
+void CrossfadeRenderer::resume()
+{
+    CrossfadeOutput* output = owner->output;
+    QMetaObject::invokeMethod(output, [output]() { output->resume(); });
+}
+
+void CrossfadeRenderer::stop(int id)
+{
+    session = id;
+    if (fillTimer) {
+        fillTimer->stop();
+    }
+    destroyAll();
+    discardOutput();
+    owner->voiceOrigin.store(kNoOrigin, std::memory_order_relaxed);
+
+    CrossfadeOutput* output = owner->output;
+    QMetaObject::invokeMethod(output, [output]() { output->stop(); });
+}
+
+void CrossfadeRenderer::seek(int id, qint64 frame)
+{
+    session = id;
+    if (voices.isEmpty()) {
+        // 已經寫完最後一段：跳轉前的結尾通知作廢了，重新通知
+        CrossfadePlayer* player = owner;
+        QMetaObject::invokeMethod(player, [player, id]() { player->rendererFinished(id); });
+        return;
+    }
+
+    // QAudioDecoder 不能跳轉：從頭重新解碼並丟棄目標位置之前的畫格，正在淡出的曲目一併停止
+    Voice* current = voices.takeLast();
+    for (Voice* voice : std::as_const(voices)) {
+        destroyVoice(voice);
+    }
+    voices.clear();
+    voices.append(current);
+
+    current->pcm.clear();
+    current->readPos = 0;
+    current->framesDecoded = 0;
+    current->framesPlayed = frame;
+    current->skipFrames = frame;
+    current->finished = false;
+    current->started = true;
+    current->fade = NoFade;
+    current->lastGain = 0.0f;          // 從靜音斜坡回到原音量
+    startDecoder(current);
+
+    // 已寫入環形緩衝、還沒播出的舊位置一併丟棄
+    discardOutput();
+    publishOrigin(current, streamFrame());
+}
+
+void CrossfadeRenderer::setVolume(float volume)
+{
+    if (!voices.isEmpty()) {
+        voices.last()->volume = volume;
+    }
+}
+
+void CrossfadeRenderer::setFadeMs(int ms)
+{
+    fadeMsValue = ms;
+}
+
+CrossfadeRenderer::Voice* CrossfadeRenderer::createVoice(const QString& filePath, float volume, qint64 startFrame)
+{
+    Voice* voice = new Voice;
+    voice->filePath = filePath;
+    voice->volume = volume;
+    voice->framesPlayed = startFrame;
+    voice->skipFrames = startFrame;
+    startDecoder(voice);
+    return voice;
+}
+
+void CrossfadeRenderer::startDecoder(Voice* voice)
+{
+    if (voice->decoder) {
+        voice->decoder->disconnect(this);
+        voice->decoder->stop();
+        voice->decoder->deleteLater();
+    }
+
+    // 解碼器的信號回到解碼執行緒；讀取速度決定解碼進度
+    QAudioDecoder* decoder = new QAudioDecoder(this);
+    decoder->setAudioFormat(decodeFormat);
+    connect(decoder, &QAudioDecoder::bufferReady, this, [this, voice]() {
+        readDecoder(voice);
+        fill();
+    });
+    connect(decoder, &QAudioDecoder::finished, this, [this, voice]() {
+        voice->finished = true;
+        fill();
+    });
+    connect(decoder, QOverload<QAudioDecoder::Error>::of(&QAudioDecoder::error), this, [this, voice]() {
+        failVoice(voice);
+    });
+    connect(decoder, &QAudioDecoder::durationChanged, this, [this, voice](qint64 duration) {
+        if (!voices.isEmpty() && voices.last() == voice) {
+            CrossfadePlayer* player = owner;
+            const int id = session;
+            QMetaObject::invokeMethod(player, [player, id, duration]() { player->rendererDuration(id, duration); });
+        }
+    });
+    voice->decoder = decoder;
+    decoder->setSource(QUrl::fromLocalFile(voice->filePath));
+    decoder->start();
+}
+
+void CrossfadeRenderer::destroyVoice(Voice* voice)
+{
+    // 可能在解碼器自己的信號中被呼叫，延後刪除
+    voice->decoder->disconnect(this);
+    voice->decoder->stop();
+    voice->decoder->deleteLater();
+    delete voice;
+}
+
+void CrossfadeRenderer::destroyAll()
+{
+    clearNext();
+    for (Voice* voice : std::as_const(voices)) {
+        destroyVoice(voice);
+    }
+    voices.clear();
+}
+
+void CrossfadeRenderer::readDecoder(Voice* voice)
+{
+    const qint64 target = targetFrames();
+    while (voice->decoder->bufferAvailable() && voice->bufferedFrames() < target) {
+        if (!appendBuffer(voice, voice->decoder->read())) {
+            failVoice(voice);
+            return;
+        }
+    }
+}
+
+bool CrossfadeRenderer::appendBuffer(Voice* voice, const QAudioBuffer& buffer)
+{
+    if (!buffer.isValid()) return true;
+
+    const QAudioFormat format = buffer.format();
+    const int channels = format.channelCount();
+    const qsizetype frames = buffer.frameCount();
+    if (channels <= 0 || frames <= 0) return true;
+
+    // 後端沒有照要求重新取樣時無法混音，交給呼叫端改用 QMediaPlayer
+    if (format.sampleRate() != decodeFormat.sampleRate()) return false;
+
+    // 跳轉時丟棄目標位置之前的畫格
+    qsizetype first = 0;
+    if (voice->skipFrames > 0) {
+        first = qsizetype(qMin<qint64>(voice->skipFrames, frames));
+        voice->skipFrames -= first;
+    }
+    voice->framesDecoded += frames;
+    if (first == frames) return true;
+
+    // 壓縮已輸出的部分，避免佇列無限成長
+    if (voice->readPos > 0 && voice->readPos >= voice->pcm.size() / 2) {
+        voice->pcm.remove(0, voice->readPos);
+        voice->readPos = 0;
+    }
+
+    const qsizetype base = voice->pcm.size();
+    voice->pcm.resize(base + (frames - first) * kChannels);
+    float* out = voice->pcm.data() + base;
+    for (qsizetype frame = first; frame < frames; frame++) {
+        float left = 0.0f;
+        float right = 0.0f;
+        const qsizetype index = frame * channels;
+        switch (format.sampleFormat()) {
+        case QAudioFormat::UInt8:
+            left = (buffer.constData<quint8>()[index] - 128) / 128.0f;
+            right = channels > 1 ? (buffer.constData<quint8>()[index + 1] - 128) / 128.0f : left;
+            break;
+        case QAudioFormat::Int16:
+            left = buffer.constData<qint16>()[index] / 32768.0f;
+            right = channels > 1 ? buffer.constData<qint16>()[index + 1] / 32768.0f : left;
+            break;
+        case QAudioFormat::Int32:
+            left = buffer.constData<qint32>()[index] / 2147483648.0f;
+            right = channels > 1 ? buffer.constData<qint32>()[index + 1] / 2147483648.0f : left;
+            break;
+        case QAudioFormat::Float:
+            left = buffer.constData<float>()[index];
+            right = channels > 1 ? buffer.constData<float>()[index + 1] : left;
+            break;
+        default:
+            return false;
+        }
+        *out++ = left;
+        *out++ = right;
+    }
+    return true;
+}
+
+void CrossfadeRenderer::failVoice(Voice* voice)
+{
+    CrossfadePlayer* player = owner;
+    const int id = session;
+    const QString filePath = voice->filePath;
+    if (voice == next) {
+        // 排入的下一首無法解碼：目前的曲目播完時由呼叫端處理
+        clearNext();
+        QMetaObject::invokeMethod(player, [player, id, filePath]() { player->rendererFailed(id, filePath, false); });
+        return;
+    }
+
+    if (!voices.isEmpty() && voices.last() == voice) {
+        stop(id);
+        QMetaObject::invokeMethod(player, [player, id, filePath]() { player->rendererFailed(id, filePath, true); });
+    } else if (voices.removeOne(voice)) {
+        destroyVoice(voice);
+    }
+}
+
+bool CrossfadeRenderer::decodeComplete(const Voice* voice) const
+{
+    return voice->finished && !voice->decoder->bufferAvailable();
+}
+
+bool CrossfadeRenderer::isReady(const Voice* voice) const
+{
+    return decodeComplete(voice) ||
+           voice->bufferedFrames() >= qsizetype(decodeFormat.sampleRate()) * kStartMs / 1000;
+}
+
+qint64 CrossfadeRenderer::targetFrames() const
+{
+    return qint64(decodeFormat.sampleRate()) * (fadeMsValue + kDecodeAheadMs) / 1000;
+}
+
+qint64 CrossfadeRenderer::durationOf(const Voice* voice) const
+{
+    // 解碼完畢後以確切的畫格數為準
+    if (decodeComplete(voice)) {
+        return voice->framesDecoded * 1000 / decodeFormat.sampleRate();
+    }
+    return qMax<qint64>(0, voice->decoder->duration());
+}
+
+void CrossfadeRenderer::ensureTimer()
+{
+    // 計時器要在解碼執行緒上建立
+    if (fillTimer) return;
+    fillTimer = new QTimer(this);
+    fillTimer->setTimerType(Qt::PreciseTimer);
+    fillTimer->setInterval(kFillIntervalMs);
+    connect(fillTimer, &QTimer::timeout, this, &CrossfadeRenderer::fill);
+}
+
+void CrossfadeRenderer::discardOutput()
+{
+    // 先丟棄再重設，輸出端之後讀到的一定是新的資料
+    owner->ring.flush();
+    owner->equalizer.clearState();
+    owner->outputPrimed.store(false, std::memory_order_relaxed);
+    owner->streamEnded.store(false, std::memory_order_relaxed);
+}
+
+void CrossfadeRenderer::fill()
+{
+    if (voices.isEmpty()) return;
+
+    // 環形緩衝中保持 latencyFrames 的資料；解碼跟不上時先停下，不預先填入靜音
+    AudioRingBuffer& ring = owner->ring;
+    const qsizetype limit = owner->latencyFrames * kChannels;
+    for (;;) {
+        const qsizetype queued = qsizetype(ring.writePosition() - ring.readPosition());
+        const qsizetype frames = qMin<qsizetype>(qMin(limit - queued, ring.availableToWrite()) / kChannels, kFillFrames);
+        if (frames <= 0) break;
+
+        mixBuffer.resize(frames * kChannels);
+        const qsizetype rendered = render(mixBuffer.data(), frames);
+        owner->equalizer.process(mixBuffer.data(), rendered);
+        if (rendered > 0 && ring.write(mixBuffer.constData(), rendered * kChannels) < rendered * kChannels) {
+            owner->overrunCount.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        if (voices.isEmpty()) {
+            // 最後一段已寫入：輸出端讀完後由 GUI 執行緒結束播放
+            owner->streamEnded.store(true, std::memory_order_relaxed);
+            CrossfadePlayer* player = owner;
+            const int id = session;
+            QMetaObject::invokeMethod(player, [player, id]() { player->rendererFinished(id); });
+            return;
+        }
+        if (rendered < frames) break;
+    }
+
+    // 消耗之後再繼續解碼（讀取決定解碼器的進度）；解碼失敗可能移除曲目，以索引走訪
+    for (qsizetype i = 0; i < voices.size(); i++) {
+        readDecoder(voices[i]);
+    }
+    if (next) {
+        readDecoder(next);
+    }
+}
+
+qsizetype CrossfadeRenderer::render(float* out, qsizetype frames)
+{
+    const qint64 fadeFrames = qint64(decodeFormat.sampleRate()) * fadeMsValue / 1000;
+    const qint64 streamBase = streamFrame();
+    qsizetype done = 0;
+    while (done < frames && !voices.isEmpty()) {
+        Voice* current = voices.last();
+        qsizetype length = qMin<qsizetype>(frames - done, kSegmentFrames);
+
+        // 手動切歌：新曲目可以發聲後，其他曲目一起淡出
+        if (!current->started && isReady(current)) {
+            for (Voice* voice : std::as_const(voices)) {
+                if (voice != current) beginFadeOut(voice, fadeFrames);
+            }
+            current->started = true;
+            current->fade = fadeFrames > 0 ? FadeIn : NoFade;
+            current->fadePos = 0;
+            current->fadeLength = fadeFrames;
+            current->lastGain = current->fade == FadeIn ? 0.0f : current->volume;
+            publishOrigin(current, streamBase + done);
+        }
+
+        // 自動換曲：在目前曲目剩下 fadeFrames 的那個畫格開始
+        if (next && current->started && decodeComplete(current)) {
+            const qint64 remaining = current->bufferedFrames();
+            if (remaining > fadeFrames) {
+                length = qsizetype(qMin<qint64>(length, remaining - fadeFrames));
+            } else if (isReady(next)) {
+                beginFadeOut(current, remaining);
+                Voice* incoming = next;
+                next = nullptr;
+                incoming->started = true;
+                incoming->fade = remaining > 0 ? FadeIn : NoFade;
+                incoming->fadePos = 0;
+                incoming->fadeLength = remaining;
+                incoming->lastGain = incoming->fade == FadeIn ? 0.0f : incoming->volume;
+                voices.append(incoming);
+                current = incoming;
+                publishOrigin(incoming, streamBase + done);
+
+                CrossfadePlayer* player = owner;
+                const int id = session;
+                const QString filePath = incoming->filePath;
+                const qint64 duration = durationOf(incoming);
+                QMetaObject::invokeMethod(player, [player, id, filePath, duration]() {
+                    player->rendererAdvanced(id, filePath, duration);
+                });
+            }
+        }
+
+        // 發聲中、還在解碼的曲目決定這一段能混音多少
+        bool audible = false;
+        for (const Voice* voice : std::as_const(voices)) {
+            if (!voice->started) continue;
+            audible = true;
+            if (!decodeComplete(voice)) {
+                length = qMin(length, voice->bufferedFrames());
+            }
+        }
+        if (!audible || length <= 0) break;
+
+        // 各曲目依包絡與音量混音；第一個有資料的曲目覆寫輸出，其餘累加
+        float* segment = out + done * kChannels;
+        bool written = false;
+        for (Voice* voice : std::as_const(voices)) {
+            if (!voice->started) continue;
+
+            const float gainStart = voice->lastGain;
+            if (voice->fade != NoFade) {
+                voice->fadePos = qMin(voice->fadePos + length, voice->fadeLength);
+            }
+            const float gainEnd = voice->volume * envelope(voice);
+            if (voice->fade == FadeIn && voice->fadePos >= voice->fadeLength) {
+                voice->fade = NoFade;
+            }
+            voice->lastGain = gainEnd;
+
+            const qsizetype available = qMin<qsizetype>(length, voice->bufferedFrames());
+            if (available <= 0) continue;
+
+            // 解碼完畢的曲目在結尾只混音剩下的部分，斜坡依比例截短
+            const float rampEnd = gainStart + (gainEnd - gainStart) * float(available) / float(length);
+            const float* source = voice->pcm.constData() + voice->readPos;
+            if (!written) {
+                AudioMixer::scaleRamp(segment, source, available, kChannels, gainStart, rampEnd);
+                if (available < length) {
+                    std::memset(segment + available * kChannels, 0, size_t(length - available) * kChannels * sizeof(float));
+                }
+                written = true;
+            } else {
+                AudioMixer::mixRamp(segment, source, available, kChannels, gainStart, rampEnd);
+            }
+            voice->readPos += available * kChannels;
+            voice->framesPlayed += available;
+        }
+        if (!written) {
+            std::memset(segment, 0, size_t(length) * kChannels * sizeof(float));
+        }
+        done += length;
+
+        // 淡出完成或播完的曲目移除；目前的曲目播完且沒有下一首時結束播放
+        for (qsizetype i = voices.size() - 2; i >= 0; i--) {
+            Voice* voice = voices[i];
+            const bool faded = voice->fade == FadeOut && voice->fadePos >= voice->fadeLength;
+            const bool drained = decodeComplete(voice) && voice->bufferedFrames() == 0;
+            if (faded || drained) {
+                destroyVoice(voices.takeAt(i));
+            }
+        }
+        current = voices.last();
+        if (current->started && decodeComplete(current) && current->bufferedFrames() == 0) {
+            if (!next) {
+                destroyAll();
+                break;
+            }
+            if (!isReady(next)) {
+                // 下一首還沒準備好：先停下，準備好後直接開始
+                break;
+            }
+        }
+    }
+    return done;
+}
+
+void CrossfadeRenderer::beginFadeOut(Voice* voice, qint64 length)
+{
+    if (voice->fade == FadeOut) return;
+
+    // 沒有淡化長度時仍以極短的淡出結束，避免爆音
+    voice->fadeFrom = envelope(voice);
+    voice->fade = FadeOut;
+    voice->fadePos = 0;
+    voice->fadeLength = qMax<qint64>(length, kDeclickFrames);
+}
+
+float CrossfadeRenderer::envelope(const Voice* voice) const
+{
+    if (voice->fade == NoFade || voice->fadeLength <= 0) {
+        return voice->fade == FadeOut ? 0.0f : 1.0f;
+    }
+    const float progress = float(voice->fadePos) / float(voice->fadeLength);
+    if (voice->fade == FadeIn) {
+        return std::sin(progress * kHalfPi);
+    }
+    return voice->fadeFrom * std::cos(progress * kHalfPi);
+}
+
+void CrossfadeRenderer::publishOrigin(const Voice* voice, qint64 streamFrame)
+{
+    // GUI 執行緒以輸出端讀到的串流位置換算目前曲目的位置
+    owner->voiceStart.store(streamFrame, std::memory_order_relaxed);
+    owner->voiceOrigin.store(streamFrame - voice->framesPlayed, std::memory_order_relaxed);
+}
+
+qint64 CrossfadeRenderer::streamFrame() const
+{
+    return qint64(owner->ring.writePosition() / kChannels);
+}
+
+CrossfadeOutput::CrossfadeOutput(CrossfadePlayer* owner, const QAudioFormat& format, qsizetype bufferBytes)
+    : QIODevice(nullptr)
+    , owner(owner)
+    , format(format)
+    , bufferBytes(bufferBytes)
+    , sink(nullptr)
+{
+}
+
+CrossfadeOutput::~CrossfadeOutput()
+{
+    if (sink) {
+        sink->stop();
+    }
+}
+
+void CrossfadeOutput::start(int session)
+{
+    // QAudioSink 在輸出執行緒上建立，之後重複使用
+    if (!sink) {
+        sink = new QAudioSink(QMediaDevices::defaultAudioOutput(), format, this);
+        sink->setBufferSize(bufferBytes);
+    }
+    sink->stop();
+    if (!isOpen()) {
+        open(QIODevice::ReadOnly | QIODevice::Unbuffered);
+    }
+    sink->start(this);
+    if (sink->error() != QAudio::NoError) {
+        CrossfadePlayer* player = owner;
+        QMetaObject::invokeMethod(player, [player, session]() { player->outputFailed(session); });
+    }
+}
+
+void CrossfadeOutput::suspend()
+{
+    if (sink && sink->state() != QAudio::StoppedState) {
+        sink->suspend();
+    }
+}
+
+void CrossfadeOutput::resume()
+{
+    if (sink && sink->state() == QAudio::SuspendedState) {
+        sink->resume();
+    }
+}
+
+void CrossfadeOutput::stop()
+{
+    if (sink) {
+        sink->stop();
+    }
+}
+
+qint64 CrossfadeOutput::bytesAvailable() const
+{
+    // 見底時以靜音補上，隨時都能交出一整個緩衝
+    return bufferBytes + QIODevice::bytesAvailable();
+}
+
+qint64 CrossfadeOutput::readData(char* data, qint64 maxSize)
+{
+    const int bytesPerFrame = format.bytesPerFrame();
+    const qsizetype frames = qsizetype(maxSize / bytesPerFrame);
+    if (frames <= 0) return 0;
+
+    // Float 直接讀進 QAudioSink 的緩衝；Int16 先讀到暫存再轉換
+    const qsizetype samples = frames * format.channelCount();
+    const bool isFloat = format.sampleFormat() == QAudioFormat::Float;
+    if (!isFloat) {
+        scratch.resize(samples);
+    }
+    float* out = isFloat ? reinterpret_cast<float*>(data) : scratch.data();
+
+    const qsizetype got = owner->ring.read(out, samples);
+    if (got > 0) {
+        owner->outputPrimed.store(true, std::memory_order_relaxed);
+    }
+    if (got < samples) {
+        std::memset(out + got, 0, size_t(samples - got) * sizeof(float));
+        if (owner->outputPrimed.load(std::memory_order_relaxed) &&
+            !owner->streamEnded.load(std::memory_order_relaxed)) {
+            owner->underrunCount.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    // 只複製完整的一段，放不下就整段丟棄，分析端讀到的畫格永遠對齊聲道
+    if (got > 0 && owner->analysisTapEnabled.load(std::memory_order_relaxed) &&
+        owner->analysisTap.availableToWrite() >= got) {
+        owner->analysisTap.write(out, got);
+    }
+
+    if (!isFloat) {
+        qint16* samples16 = reinterpret_cast<qint16*>(data);
+        for (qsizetype i = 0; i < samples; i++) {
+            samples16[i] = qint16(qBound(-32768, int(std::lrint(scratch[i] * 32767.0f)), 32767));
+        }
+    }
+    return frames * bytesPerFrame;
+}
+
+qint64 CrossfadeOutput::writeData(const char* data, qint64 maxSize)
+{
+    Q_UNUSED(data);
+    Q_UNUSED(maxSize);
+    return -1;
+}
+
+CrossfadePlayer::CrossfadePlayer(int latencyMs, QObject* parent)
+    : QObject(parent)
+    , analysisTapEnabled(false)
+    , voiceOrigin(kNoOrigin)
+    , voiceStart(0)
+    , outputPrimed(false)
+    , streamEnded(false)
+    , underrunCount(0)
+    , overrunCount(0)
+    , latencyMsValue(qMax(kMinLatencyMs, latencyMs))
+    , playbackState(StoppedState)
+    , session(0)
+    , fadeMsValue(6000)
+    , durationValue(0)
+    , draining(false)
+    , lastReportedPosition(-1)
+{
+    // 輸出固定為立體聲；優先使用 Float，省去混音後的轉換
+    const QAudioDevice device = QMediaDevices::defaultAudioOutput();
+    outputFormat = device.preferredFormat();
+    if (outputFormat.sampleRate() <= 0) {
+        outputFormat.setSampleRate(48000);
+    }
+    outputFormat.setChannelCount(kChannels);
+    outputFormat.setSampleFormat(QAudioFormat::Float);
+    if (!device.isFormatSupported(outputFormat)) {
+        outputFormat.setSampleFormat(QAudioFormat::Int16);
+    }
+    QAudioFormat decodeFormat = outputFormat;
+    decodeFormat.setSampleFormat(QAudioFormat::Float);
+
+    latencyFrames = qsizetype(outputFormat.sampleRate()) * latencyMsValue / 1000;
+    sinkFrames = latencyFrames / 4;
+    ring.reset(latencyFrames * kChannels);
+    analysisTap.reset(qsizetype(kAnalysisTapFrames) * kChannels);
+    equalizer.reset(outputFormat.sampleRate());
+
+    // 解碼與輸出各用一個執行緒：輸出端只做複製，以最高優先權執行
+    decodeThread = new QThread(this);
+    renderer = new CrossfadeRenderer(this, decodeFormat);
+    renderer->moveToThread(decodeThread);
+    connect(decodeThread, &QThread::finished, renderer, &QObject::deleteLater);
+    decodeThread->start(QThread::HighPriority);
+
+    outputThread = new QThread(this);
+    output = new CrossfadeOutput(this, outputFormat, outputFormat.bytesForFrames(int(sinkFrames)));
+    output->moveToThread(outputThread);
+    connect(outputThread, &QThread::finished, output, &QObject::deleteLater);
+    outputThread->start(QThread::TimeCriticalPriority);
+
+    pollTimer = new QTimer(this);
+    pollTimer->setInterval(kPollIntervalMs);
+    connect(pollTimer, &QTimer::timeout, this, &CrossfadePlayer::poll);
+}
+
+CrossfadePlayer::~CrossfadePlayer()
+{
+    // 解碼器與 QAudioSink 在各自的執行緒結束時刪除
+    decodeThread->quit();
+    outputThread->quit();
+    decodeThread->wait();
+    outputThread->wait();
+}
+
+void CrossfadePlayer::setFadeMs(int ms)
+{
+    fadeMsValue = qMax(0, ms);
+    const int value = fadeMsValue;
+    QMetaObject::invokeMethod(renderer, [this, value]() { renderer->setFadeMs(value); });
+}
+
+void CrossfadePlayer::play(const QString& filePath, float volume)
+{
+    const int id = ++session;
+    currentPath = filePath;
+    nextPath.clear();
+    durationValue = 0;
+    draining = false;
+    lastReportedPosition = -1;
+
+    if (playbackState == PlayingState) {
+        QMetaObject::invokeMethod(renderer, [this, id, filePath, volume]() {
+            renderer->crossfadeTo(id, filePath, volume);
+        });
+    } else {
+        QMetaObject::invokeMethod(renderer, [this, id, filePath, volume]() {
+            renderer->start(id, filePath, volume);
+        });
+        pollTimer->start();
+        setState(PlayingState);
+    }
+    emit durationChanged(0);
+    emit positionChanged(0);
+}
+
+void CrossfadePlayer::queueNext(const QString& filePath, float volume)
+{
+    nextPath = filePath;
+    QMetaObject::invokeMethod(renderer, [this, filePath, volume]() { renderer->queueNext(filePath, volume); });
+}
+
+void CrossfadePlayer::clearNext()
+{
+    if (nextPath.isEmpty()) return;
+    nextPath.clear();
+    QMetaObject::invokeMethod(renderer, [this]() { renderer->clearNext(); });
+}
+
+void CrossfadePlayer::pause()
+{
+    if (playbackState != PlayingState) return;
+    QMetaObject::invokeMethod(renderer, [this]() { renderer->pause(); });
+    setState(PausedState);
+}
+
+void CrossfadePlayer::resume()
+{
+    if (playbackState != PausedState) return;
+    QMetaObject::invokeMethod(renderer, [this]() { renderer->resume(); });
+    setState(PlayingState);
+}
+
+void CrossfadePlayer::stop()
+{
+    if (playbackState == StoppedState && currentPath.isEmpty()) return;
+
+    const int id = ++session;
+    pollTimer->stop();
+    currentPath.clear();
+    nextPath.clear();
+    durationValue = 0;
+    draining = false;
+    lastReportedPosition = -1;
+    QMetaObject::invokeMethod(renderer, [this, id]() { renderer->stop(id); });
+    setState(StoppedState);
+}
+
+void CrossfadePlayer::setPosition(qint64 ms)
+{
+    if (playbackState == StoppedState) return;
+
+    const int id = ++session;
+    const qint64 frame = qMax<qint64>(0, ms) * outputFormat.sampleRate() / 1000;
+    draining = false;
+    QMetaObject::invokeMethod(renderer, [this, id, frame]() { renderer->seek(id, frame); });
+
+    lastReportedPosition = -1;
+    emit positionChanged(qMax<qint64>(0, ms));
+}
+
+void CrossfadePlayer::setVolume(float volume)
+{
+    QMetaObject::invokeMethod(renderer, [this, volume]() { renderer->setVolume(volume); });
+}
+
+void CrossfadePlayer::setEqualizer(const EqualizerSettings& settings)
+{
+    equalizer.setSettings(settings);
+}
+
+void CrossfadePlayer::setAnalysisTapEnabled(bool enabled)
+{
+    analysisTapEnabled.store(enabled, std::memory_order_relaxed);
+}
+
+qsizetype CrossfadePlayer::readAnalysisTap(float* interleaved, qsizetype frames)
+{
+    return analysisTap.read(interleaved, frames * kChannels) / kChannels;
+}
+
+qint64 CrossfadePlayer::position() const
+{
+    const qint64 origin = voiceOrigin.load(std::memory_order_relaxed);
+    if (origin == kNoOrigin || outputFormat.sampleRate() <= 0) return 0;
+
+    // 輸出端讀到的位置減去還在 QAudioSink 緩衝中、尚未聽到的部分；曲目（或跳轉後）的第一個畫格還沒聽到時停在起點
+    const qint64 heard = qint64(ring.readPosition() / kChannels) - sinkFrames;
+    const qint64 frame = qMax(heard, voiceStart.load(std::memory_order_relaxed)) - origin;
+    return qMax<qint64>(0, frame) * 1000 / outputFormat.sampleRate();
+}
+
+void CrossfadePlayer::rendererAdvanced(int id, const QString& filePath, qint64 duration)
+{
+    if (id != session) return;
+    currentPath = filePath;
+    nextPath.clear();
+    durationValue = duration;
+    lastReportedPosition = -1;
+    emit advanced();
+    emit durationChanged(duration);
+}
+
+void CrossfadePlayer::rendererDuration(int id, qint64 duration)
+{
+    if (id != session || duration == durationValue) return;
+    durationValue = duration;
+    emit durationChanged(duration);
+}
+
+void CrossfadePlayer::rendererFinished(int id)
+{
+    if (id != session) return;
+    draining = true;
+}
+
+void CrossfadePlayer::rendererFailed(int id, const QString& filePath, bool current)
+{
+    if (id != session) return;
+    if (current) {
+        fail(filePath);
+    } else if (nextPath == filePath) {
+        nextPath.clear();
+    }
+}
+
+void CrossfadePlayer::outputFailed(int id)
+{
+    if (id != session) return;
+    fail(currentPath);
+}
+
+void CrossfadePlayer::poll()
+{
+    if (playbackState != PlayingState) return;
+
+    // 最後一段已全部交給 QAudioSink：等它播完再停止；暫停時不檢查，繼續後再等
+    if (draining && ring.availableToRead() == 0) {
+        draining = false;
+        const int id = session;
+        QTimer::singleShot(outputFormat.durationForFrames(int(sinkFrames)) / 1000, this, [this, id]() {
+            if (id != session) return;
+            if (playbackState != PlayingState) {
+                draining = true;
+                return;
+            }
+            stop();
+            emit endOfMedia();
+        });
+    }
+
+    const qint64 currentPosition = position();
+    if (currentPosition / 100 != lastReportedPosition / 100) {
+        lastReportedPosition = currentPosition;
+        emit positionChanged(currentPosition);
+    }
+}
+
+void CrossfadePlayer::fail(const QString& filePath)
+{
+    stop();
+    emit errorOccurred(filePath);
+}
+
+void CrossfadePlayer::setState(State state)
+{
+    if (playbackState == state) return;
+    playbackState = state;
+    emit stateChanged(state);
+}
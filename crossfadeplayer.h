@@ -0,0 +1,240 @@
+#ifndef CROSSFADEPLAYER_H
+#define CROSSFADEPLAYER_H
+
+#include <QObject>
+#include <QString>
+#include <QList>
+#include <QIODevice>
+#include <QAudioFormat>
+#include <atomic>
+#include "audioringbuffer.h"
+#include "equalizer.h"
+
+class QAudioDecoder;
+class QAudioBuffer;
+class QAudioSink;
+class QThread;
+class QTimer;
+
+class CrossfadePlayer;
+
+// 解碼執行緒：擁有所有 QAudioDecoder，混音後寫入環形緩衝（唯一的生產者）
+// 淡化以畫格為單位：自動換曲時從上一首最後 fadeMs 的第一個畫格開始，曲線為等功率（分段線性）
+class CrossfadeRenderer : public QObject
+{
+    Q_OBJECT
+
+public:
+    CrossfadeRenderer(CrossfadePlayer* owner, const QAudioFormat& decodeFormat);
+    ~CrossfadeRenderer();
+
+    // 以下都在解碼執行緒上呼叫（由 CrossfadePlayer 排入），輸出端的控制也由這裡轉發，確保先後順序
+    void start(int session, const QString& filePath, float volume);
+    void crossfadeTo(int session, const QString& filePath, float volume);
+    void queueNext(const QString& filePath, float volume);
+    void clearNext();
+    void pause();
+    void resume();
+    void stop(int session);
+    void seek(int session, qint64 frame);
+    void setVolume(float volume);
+    void setFadeMs(int ms);
+
+private:
+    enum Fade { NoFade, FadeIn, FadeOut };
+
+    // 一首正在解碼或發聲的曲目
+    struct Voice {
+        QAudioDecoder* decoder = nullptr;
+        QString filePath;
+        float volume = 1.0f;
+        QList<float> pcm;              // 已解碼、尚未輸出的交錯樣本（輸出格式）
+        qsizetype readPos = 0;         // pcm 中下一個要輸出的樣本
+        qint64 framesDecoded = 0;      // 含跳轉時丟棄的畫格
+        qint64 framesPlayed = 0;       // 已寫入環形緩衝的位置
+        qint64 skipFrames = 0;         // 跳轉：開頭還要丟棄的畫格
+        bool finished = false;         // 解碼器已送出 finished
+        bool started = false;          // 已開始發聲
+        Fade fade = NoFade;
+        qint64 fadePos = 0;
+        qint64 fadeLength = 0;
+        float fadeFrom = 1.0f;         // 淡出開始時的包絡值（可能正在淡入）
+        float lastGain = 0.0f;         // 上一段結束時的增益，下一段由此開始，避免爆音
+
+        qsizetype bufferedFrames() const { return (pcm.size() - readPos) / kChannels; }
+    };
+
+    Voice* createVoice(const QString& filePath, float volume, qint64 startFrame);
+    void startDecoder(Voice* voice);
+    void destroyVoice(Voice* voice);
+    void destroyAll();
+    void readDecoder(Voice* voice);
+    bool appendBuffer(Voice* voice, const QAudioBuffer& buffer);
+    void failVoice(Voice* voice);
+    bool decodeComplete(const Voice* voice) const;
+    bool isReady(const Voice* voice) const;
+    qint64 targetFrames() const;
+    qint64 durationOf(const Voice* voice) const;
+
+    void ensureTimer();
+    void discardOutput();
+    void fill();
+    qsizetype render(float* out, qsizetype frames);
+    void beginFadeOut(Voice* voice, qint64 length);
+    float envelope(const Voice* voice) const;
+    void publishOrigin(const Voice* voice, qint64 streamFrame);
+    qint64 streamFrame() const;
+
+    static const int kChannels = 2;
+
+    CrossfadePlayer* owner;
+    QAudioFormat decodeFormat;         // 要求解碼器輸出的格式：Float，與輸出相同的取樣率與聲道數
+    QTimer* fillTimer;
+    int session;
+    int fadeMsValue;
+    QList<Voice*> voices;              // 最後一個是目前的曲目，其他的正在淡出
+    Voice* next;                       // 排入的下一首，尚未發聲
+    QList<float> mixBuffer;
+};
+
+// 輸出執行緒：QAudioSink 以 pull 模式從這裡讀取（唯一的消費者）
+// 環形緩衝見底時補靜音，不讓 QAudioSink 進入閒置
+class CrossfadeOutput : public QIODevice
+{
+    Q_OBJECT
+
+public:
+    CrossfadeOutput(CrossfadePlayer* owner, const QAudioFormat& format, qsizetype bufferBytes);
+    ~CrossfadeOutput();
+
+    // 以下都在輸出執行緒上呼叫
+    void start(int session);
+    void suspend();
+    void resume();
+    void stop();
+
+    bool isSequential() const override { return true; }
+    qint64 bytesAvailable() const override;
+
+protected:
+    qint64 readData(char* data, qint64 maxSize) override;
+    qint64 writeData(const char* data, qint64 maxSize) override;
+
+private:
+    CrossfadePlayer* owner;
+    QAudioFormat format;
+    qsizetype bufferBytes;
+    QAudioSink* sink;
+    QList<float> scratch;
+};
+
+// 自有的解碼到輸出管線：本地檔案在解碼執行緒以 QAudioDecoder 解碼並混音（交叉淡化時以 AudioMixer 的增益斜坡疊加），
+// 經由無鎖的 AudioRingBuffer 交給輸出執行緒上以 pull 模式讀取的 QAudioSink
+// 淡化長度為 0 時就是無縫播放；GUI 執行緒只送出指令並讀取原子計數，忙碌時不會斷音
+class CrossfadePlayer : public QObject
+{
+    Q_OBJECT
+
+public:
+    enum State { StoppedState, PlayingState, PausedState };
+    Q_ENUM(State)
+
+    // latencyMs：環形緩衝能容納的長度；QAudioSink 自己的緩衝另取其四分之一
+    explicit CrossfadePlayer(int latencyMs = 200, QObject* parent = nullptr);
+    ~CrossfadePlayer();
+
+    int latencyMs() const { return latencyMsValue; }
+    void setFadeMs(int ms);
+    int fadeMs() const { return fadeMsValue; }
+
+    // 開始播放；正在播放時，新曲目解碼到可以發聲後，目前的曲目淡出、新曲目同時淡入
+    void play(const QString& filePath, float volume);
+
+    // 預先排入下一首：目前的曲目只剩 fadeMs 時自動交叉淡化，並發出 advanced()
+    void queueNext(const QString& filePath, float volume);
+    void clearNext();
+    QString nextFile() const { return nextPath; }
+
+    void pause();
+    void resume();
+    void stop();
+    void setPosition(qint64 ms);
+    void setVolume(float volume);      // 目前的曲目；變化會平滑套用
+
+    // 等化器、前級增益與限幅器：套用在混音之後，參數無鎖交付給解碼執行緒，約 20 ms 內平滑過渡
+    void setEqualizer(const EqualizerSettings& settings);
+
+    // 頻譜分析的取樣：開啟時輸出端把送進 QAudioSink 的樣本另外複製一份（來不及取走時整段丟棄）
+    // readAnalysisTap 只能由單一執行緒呼叫；回傳讀到的畫格數（交錯的立體聲 float）
+    void setAnalysisTapEnabled(bool enabled);
+    qsizetype readAnalysisTap(float* interleaved, qsizetype frames);
+    int sampleRate() const { return outputFormat.sampleRate(); }
+
+    State state() const { return playbackState; }
+    QString currentFile() const { return currentPath; }
+    qint64 position() const;
+    qint64 duration() const { return durationValue; }
+
+    // 輸出端緩衝見底、以靜音補上的次數（不含開始與結尾），以及生產端寫入被拒絕的次數（正常應為 0）
+    quint64 underruns() const { return underrunCount.load(std::memory_order_relaxed); }
+    quint64 overruns() const { return overrunCount.load(std::memory_order_relaxed); }
+
+signals:
+    void stateChanged(CrossfadePlayer::State state);
+    void positionChanged(qint64 position);
+    void durationChanged(qint64 duration);
+    void advanced();                   // 排入的下一首開始淡入，之後的位置與長度都屬於它
+    void endOfMedia();                 // 目前的曲目播完，沒有排入下一首
+    void errorOccurred(const QString& filePath);  // 無法解碼或開啟輸出（呼叫端可改用 QMediaPlayer 播放）
+
+private:
+    friend class CrossfadeRenderer;
+    friend class CrossfadeOutput;
+
+    // 以下由其他執行緒排入，在 GUI 執行緒上執行；session 不符的是過時的通知
+    void rendererAdvanced(int session, const QString& filePath, qint64 duration);
+    void rendererDuration(int session, qint64 duration);
+    void rendererFinished(int session);
+    void rendererFailed(int session, const QString& filePath, bool current);
+    void outputFailed(int session);
+
+    void poll();
+    void fail(const QString& filePath);
+    void setState(State state);
+
+    static const int kChannels = 2;
+
+    // 執行緒之間共用：環形緩衝、等化器參數與原子狀態
+    AudioRingBuffer ring;
+    AudioRingBuffer analysisTap;       // 輸出執行緒寫入、分析執行緒讀出
+    std::atomic<bool> analysisTapEnabled;
+    Equalizer equalizer;
+    std::atomic<qint64> voiceOrigin;   // 目前曲目第 0 個畫格在串流中的位置；沒有發聲中的曲目時為 kNoOrigin
+    std::atomic<qint64> voiceStart;    // 目前曲目（或跳轉後）第一個寫入的畫格在串流中的位置
+    std::atomic<bool> outputPrimed;    // 這次開始後已讀到資料，之後見底才算欠載
+    std::atomic<bool> streamEnded;     // 最後一段已寫入，見底是正常的結尾
+    std::atomic<quint64> underrunCount;
+    std::atomic<quint64> overrunCount;
+
+    QAudioFormat outputFormat;         // QAudioSink 的格式：Float，不支援時改用 Int16
+    int latencyMsValue;
+    qsizetype latencyFrames;           // 解碼端最多領先輸出端的畫格數（環形緩衝的容量取 2 的次方，可能更大）
+    qsizetype sinkFrames;
+    QThread* decodeThread;
+    QThread* outputThread;
+    CrossfadeRenderer* renderer;
+    CrossfadeOutput* output;
+    QTimer* pollTimer;
+
+    // GUI 執行緒上的狀態
+    State playbackState;
+    int session;
+    int fadeMsValue;
+    QString currentPath;
+    QString nextPath;
+    qint64 durationValue;
+    bool draining;
+    qint64 lastReportedPosition;
+};
+
+#endif // CROSSFADEPLAYER_H
@@ -0,0 +1,291 @@
+#include "equalizer.h"
+#include <algorithm>
+#include <cmath>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#include <emmintrin.h>
+#define EQUALIZER_X86 1
+#endif
+
+// x86-64 一定有 SSE2；32 位元的 GCC/Clang 只為濾波器函式開啟
+#if defined(EQUALIZER_X86) && (defined(__GNUC__) || defined(__clang__))
+#define EQUALIZER_SSE 1
+#define EQUALIZER_TARGET_SSE __attribute__((target("sse2")))
+#elif defined(EQUALIZER_X86) && (defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#define EQUALIZER_SSE 1
+#define EQUALIZER_TARGET_SSE
+#endif
+
+namespace {
+const float kIsoFrequencies[EqualizerSettings::kBands] = {
+    31.25f, 62.5f, 125.0f, 250.0f, 500.0f, 1000.0f, 2000.0f, 4000.0f, 8000.0f, 16000.0f
+};
+const float kMaxGainDb = 24.0f;
+const int kTransitionMs = 20;
+const double kLimiterThreshold = 0.891250938;   // -1 dBFS
+const double kLimiterReleaseMs = 80.0;
+const int kFresh = 4;                 // middle 中表示有新參數的位元
+const int kSlotMask = 3;
+
+// 轉置直接 II 型；work 是交錯的立體聲 double，s1/s2 是兩個聲道的狀態
+void biquadScalar(double* work, int frames, double b0, double b1, double b2, double a1, double a2,
+                  double* s1, double* s2)
+{
+    for (int c = 0; c < 2; c++) {
+        double z1 = s1[c];
+        double z2 = s2[c];
+        for (int i = 0; i < frames; i++) {
+            const double x = work[i * 2 + c];
+            const double y = b0 * x + z1;
+            z1 = b1 * x - a1 * y + z2;
+            z2 = b2 * x - a2 * y;
+            work[i * 2 + c] = y;
+        }
+        s1[c] = z1;
+        s2[c] = z2;
+    }
+}
+
+#ifdef EQUALIZER_SSE
+// 左右聲道在同一個向量中：一個畫格的兩個聲道一次算完
+EQUALIZER_TARGET_SSE void biquadSse(double* work, int frames, double b0, double b1, double b2, double a1, double a2,
+                                    double* s1, double* s2)
+{
+    const __m128d vb0 = _mm_set1_pd(b0);
+    const __m128d vb1 = _mm_set1_pd(b1);
+    const __m128d vb2 = _mm_set1_pd(b2);
+    const __m128d va1 = _mm_set1_pd(a1);
+    const __m128d va2 = _mm_set1_pd(a2);
+    __m128d z1 = _mm_load_pd(s1);
+    __m128d z2 = _mm_load_pd(s2);
+    for (int i = 0; i < frames; i++) {
+        const __m128d x = _mm_load_pd(work + i * 2);
+        const __m128d y = _mm_add_pd(_mm_mul_pd(vb0, x), z1);
+        z1 = _mm_add_pd(_mm_sub_pd(_mm_mul_pd(vb1, x), _mm_mul_pd(va1, y)), z2);
+        z2 = _mm_sub_pd(_mm_mul_pd(vb2, x), _mm_mul_pd(va2, y));
+        _mm_store_pd(work + i * 2, y);
+    }
+    _mm_store_pd(s1, z1);
+    _mm_store_pd(s2, z2);
+}
+#endif
+
+}
+
+EqualizerSettings::EqualizerSettings()
+{
+    for (int i = 0; i < kBands; i++) {
+        bands[i].frequency = kIsoFrequencies[i];
+    }
+}
+
+Equalizer::Kernel Equalizer::bestKernel()
+{
+#ifdef EQUALIZER_SSE
+    return SSE;
+#else
+    return Scalar;
+#endif
+}
+
+const char* Equalizer::kernelName(Kernel kernel)
+{
+    return kernel == SSE ? "sse" : "scalar";
+}
+
+Equalizer::Equalizer()
+    : sampleRate(48000)
+    , middle(1)
+    , writeSlot(0)
+    , readSlot(2)
+    , transitionBlocks(1)
+    , transitionPos(1)
+    , limiterOn(false)
+    , limiterGain(1.0)
+    , limiterRelease(0.0)
+{
+    reset(sampleRate);
+}
+
+void Equalizer::reset(int newSampleRate)
+{
+    sampleRate = qMax(1, newSampleRate);
+    for (Snapshot& slot : slots) {
+        slot = Snapshot();
+    }
+    middle.store(1, std::memory_order_release);
+    writeSlot = 0;
+    readSlot = 2;
+
+    current = Snapshot();
+    from = current;
+    target = current;
+    transitionBlocks = qMax(1, sampleRate * kTransitionMs / 1000 / kBlockFrames);
+    transitionPos = transitionBlocks;
+    limiterOn = false;
+    limiterRelease = 1.0 - std::exp(-1000.0 / (kLimiterReleaseMs * sampleRate));
+    clearState();
+}
+
+void Equalizer::setSettings(const EqualizerSettings& settings)
+{
+    Snapshot& snapshot = slots[writeSlot];
+    snapshot = Snapshot();
+
+    // 關閉時交付一組全通的參數：處理端內插過去後就完全略過
+    if (settings.enabled) {
+        const double pi = 3.14159265358979323846;
+        snapshot.limiter = settings.limiter;
+        snapshot.preamp = std::pow(10.0, qBound(-kMaxGainDb, settings.preampDb, kMaxGainDb) / 20.0);
+        for (int b = 0; b < EqualizerSettings::kBands; b++) {
+            const EqualizerSettings::Band& band = settings.bands[b];
+            const double gainDb = qBound(-kMaxGainDb, band.gainDb, kMaxGainDb);
+            if (gainDb == 0.0 || band.frequency <= 0.0f || band.frequency >= 0.45f * sampleRate) continue;
+
+            // RBJ 峰值濾波器；增益為 0 dB 時分子分母相同，就是全通
+            const double a = std::pow(10.0, gainDb / 40.0);
+            const double w0 = 2.0 * pi * band.frequency / sampleRate;
+            const double alpha = std::sin(w0) / (2.0 * qMax(0.1, double(band.q)));
+            const double cosW0 = std::cos(w0);
+            const double a0 = 1.0 + alpha / a;
+            Coefficients& c = snapshot.bands[b];
+            c.b0 = (1.0 + alpha * a) / a0;
+            c.b1 = -2.0 * cosW0 / a0;
+            c.b2 = (1.0 - alpha * a) / a0;
+            c.a1 = -2.0 * cosW0 / a0;
+            c.a2 = (1.0 - alpha / a) / a0;
+        }
+    }
+
+    // 把寫好的槽位換到中間並標記為新的，拿回處理端還沒取走的那一個
+    writeSlot = middle.exchange(writeSlot | kFresh, std::memory_order_acq_rel) & kSlotMask;
+}
+
+void Equalizer::acceptSnapshot()
+{
+    if (!(middle.load(std::memory_order_relaxed) & kFresh)) return;
+    readSlot = middle.exchange(readSlot, std::memory_order_acq_rel) & kSlotMask;
+    target = slots[readSlot];
+    from = current;
+    transitionPos = 0;
+
+    // 關閉限幅器時不會立即跳回原音量，而是依釋放時間回復
+    limiterOn = target.limiter;
+}
+
+void Equalizer::advanceTransition()
+{
+    if (transitionPos >= transitionBlocks) return;
+    transitionPos++;
+    if (transitionPos == transitionBlocks) {
+        current = target;
+        return;
+    }
+
+    const double t = double(transitionPos) / transitionBlocks;
+    current.preamp = from.preamp + (target.preamp - from.preamp) * t;
+    for (int b = 0; b < EqualizerSettings::kBands; b++) {
+        const Coefficients& start = from.bands[b];
+        const Coefficients& end = target.bands[b];
+        Coefficients& c = current.bands[b];
+        c.b0 = start.b0 + (end.b0 - start.b0) * t;
+        c.b1 = start.b1 + (end.b1 - start.b1) * t;
+        c.b2 = start.b2 + (end.b2 - start.b2) * t;
+        c.a1 = start.a1 + (end.a1 - start.a1) * t;
+        c.a2 = start.a2 + (end.a2 - start.a2) * t;
+    }
+}
+
+void Equalizer::process(float* interleaved, qsizetype frames, Kernel kernel)
+{
+    acceptSnapshot();
+
+    // 全通、沒有在內插、限幅器也已回復時完全略過
+    bool bypass[EqualizerSettings::kBands];
+    bool allBypassed = true;
+    for (int b = 0; b < EqualizerSettings::kBands; b++) {
+        const Coefficients& c = current.bands[b];
+        bypass[b] = c.b0 == 1.0 && c.b1 == c.a1 && c.b2 == c.a2 &&
+                    state1[b][0] == 0.0 && state1[b][1] == 0.0 && state2[b][0] == 0.0 && state2[b][1] == 0.0;
+        allBypassed = allBypassed && bypass[b];
+    }
+    if (allBypassed && transitionPos >= transitionBlocks && current.preamp == 1.0 &&
+        !limiterOn && limiterGain >= 1.0) return;
+
+    while (frames > 0) {
+        const int length = int(std::min<qsizetype>(frames, kBlockFrames));
+        const double preampStart = current.preamp;
+        advanceTransition();
+        const double preampStep = (current.preamp - preampStart) / length;
+
+        // 轉成 double 並套用前級增益（內插時逐畫格斜坡）
+        for (int i = 0; i < length; i++) {
+            const double gain = preampStart + preampStep * (i + 1);
+            work[i * 2] = interleaved[i * 2] * gain;
+            work[i * 2 + 1] = interleaved[i * 2 + 1] * gain;
+        }
+
+        // 逐段濾波：一段處理完整個區塊再換下一段，狀態與係數都留在暫存器中
+        for (int b = 0; b < EqualizerSettings::kBands; b++) {
+            const Coefficients& c = current.bands[b];
+            if (bypass[b] && c.b0 == 1.0 && c.b1 == c.a1 && c.b2 == c.a2) continue;
+            bypass[b] = false;
+#ifdef EQUALIZER_SSE
+            if (kernel == SSE) {
+                biquadSse(work, length, c.b0, c.b1, c.b2, c.a1, c.a2, state1[b], state2[b]);
+                continue;
+            }
+#endif
+            biquadScalar(work, length, c.b0, c.b1, c.b2, c.a1, c.a2, state1[b], state2[b]);
+        }
+        Q_UNUSED(kernel);
+
+        // 限幅：超過門檻時立即壓下，之後依釋放時間回復
+        if (limiterOn || limiterGain < 1.0) {
+            for (int i = 0; i < length; i++) {
+                const double peak = std::max(std::fabs(work[i * 2]), std::fabs(work[i * 2 + 1]));
+                if (limiterOn && peak * limiterGain > kLimiterThreshold) {
+                    limiterGain = kLimiterThreshold / peak;
+                }
+                work[i * 2] *= limiterGain;
+                work[i * 2 + 1] *= limiterGain;
+                limiterGain += (1.0 - limiterGain) * limiterRelease;
+            }
+            if (limiterGain > 0.99999) {
+                limiterGain = 1.0;
+            }
+        }
+
+        for (int i = 0; i < length * kChannels; i++) {
+            interleaved[i] = float(work[i]);
+        }
+        interleaved += length * kChannels;
+        frames -= length;
+    }
+    flushDenormals();
+}
+
+void Equalizer::clearState()
+{
+    for (int b = 0; b < EqualizerSettings::kBands; b++) {
+        for (int c = 0; c < kChannels; c++) {
+            state1[b][c] = 0.0;
+            state2[b][c] = 0.0;
+        }
+    }
+    limiterGain = 1.0;
+}
+
+void Equalizer::flushDenormals()
+{
+    // 靜音時狀態會衰減成次正規數，計算非常慢；全通的段只剩下衰減中的尾巴，小到聽不見就歸零以便略過
+    for (int b = 0; b < EqualizerSettings::kBands; b++) {
+        const Coefficients& c = current.bands[b];
+        const bool identity = c.b0 == 1.0 && c.b1 == c.a1 && c.b2 == c.a2;
+        const double threshold = identity ? 1e-9 : 1e-30;
+        for (int ch = 0; ch < kChannels; ch++) {
+            if (std::fabs(state1[b][ch]) < threshold) state1[b][ch] = 0.0;
+            if (std::fabs(state2[b][ch]) < threshold) state2[b][ch] = 0.0;
+        }
+    }
+}
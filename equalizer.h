@@ -0,0 +1,91 @@
+#ifndef EQUALIZER_H
+#define EQUALIZER_H
+
+#include <QtGlobal>
+#include <atomic>
+
+// 等化器的參數：10 段峰值濾波器（中心頻率、增益、Q）、前級增益與限幅器
+struct EqualizerSettings {
+    static const int kBands = 10;
+
+    struct Band {
+        float frequency = 1000.0f;
+        float gainDb = 0.0f;
+        float q = 1.41f;
+    };
+
+    EqualizerSettings();              // ISO 標準的 31 Hz–16 kHz 中心頻率，全部 0 dB
+
+    bool enabled = false;
+    float preampDb = 0.0f;
+    bool limiter = true;
+    Band bands[kBands];
+};
+
+// 立體聲 PCM 的處理鏈：前級增益 → 10 段雙二階濾波器串接 → 峰值限幅器
+// 兩個聲道放在同一個 SSE2 double 向量中一起計算，低頻段在高取樣率下也不會因精度不足而失真
+// 參數由控制端以三重緩衝無鎖交付，處理端在約 20 ms 內分段內插到新的係數，調整時不會爆音
+class Equalizer
+{
+public:
+    enum Kernel { Scalar, SSE };
+
+    static Kernel bestKernel();
+    static const char* kernelName(Kernel kernel);
+
+    Equalizer();
+
+    // 設定取樣率並清除所有狀態（兩端都停止時才能呼叫）
+    void reset(int sampleRate);
+
+    // 控制端（單一執行緒）：計算係數後交付給處理端，不會等待
+    void setSettings(const EqualizerSettings& settings);
+
+    // 處理端（單一執行緒）：就地處理交錯的立體聲 float 樣本
+    void process(float* interleaved, qsizetype frames, Kernel kernel = bestKernel());
+
+    // 處理端：清除濾波器與限幅器的狀態（跳轉、換曲時不帶入上一段的殘響）
+    void clearState();
+
+private:
+    static const int kChannels = 2;
+    static const int kBlockFrames = 32;  // 係數在區塊之間內插，區塊內固定
+
+    struct Coefficients {
+        double b0 = 1.0, b1 = 0.0, b2 = 0.0, a1 = 0.0, a2 = 0.0;
+    };
+
+    // 交付給處理端的一組參數
+    struct Snapshot {
+        bool limiter = false;
+        double preamp = 1.0;
+        Coefficients bands[EqualizerSettings::kBands];
+    };
+
+    void acceptSnapshot();
+    void advanceTransition();
+    void flushDenormals();
+
+    int sampleRate;
+
+    // 三重緩衝：控制端寫 slots[writeSlot]，處理端讀 slots[readSlot]，第三個槽位在 middle 中交換
+    Snapshot slots[3];
+    std::atomic<int> middle;
+    int writeSlot;
+    int readSlot;
+
+    // 以下只屬於處理端
+    Snapshot current;                 // 目前使用的係數（內插中）
+    Snapshot from;
+    Snapshot target;
+    int transitionBlocks;             // 內插總共的區塊數
+    int transitionPos;                // 已完成的區塊數；等於 transitionBlocks 時沒有在內插
+    bool limiterOn;
+    double limiterGain;
+    double limiterRelease;            // 每個畫格回復的比例
+    alignas(16) double state1[EqualizerSettings::kBands][kChannels];
+    alignas(16) double state2[EqualizerSettings::kBands][kChannels];
+    alignas(16) double work[kBlockFrames * kChannels];
+};
+
+#endif // EQUALIZER_H
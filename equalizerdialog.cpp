@@ -0,0 +1,138 @@
+#include "equalizerdialog.h"
+#include <QSlider>
+#include <QLabel>
+#include <QCheckBox>
+#include <QSpinBox>
+#include <QDoubleSpinBox>
+#include <QPushButton>
+#include <QGridLayout>
+#include <QHBoxLayout>
+#include <QVBoxLayout>
+
+namespace {
+const int kSliderSteps = 2;           // 滑桿每格 0.5 dB
+const int kMaxSliderDb = 12;
+
+QString formatGain(float gainDb)
+{
+    return QString("%1%2 dB").arg(gainDb > 0.0f ? "+" : "").arg(gainDb, 0, 'f', 1);
+}
+}
+
+EqualizerDialog::EqualizerDialog(const EqualizerSettings& settings, QWidget* parent)
+    : QDialog(parent)
+    , current(settings)
+    , loading(false)
+{
+    setWindowTitle("等化器");
+
+    QVBoxLayout* mainLayout = new QVBoxLayout(this);
+
+    // 前級增益與限幅器
+    QHBoxLayout* preampLayout = new QHBoxLayout();
+    preampLayout->addWidget(new QLabel("前級增益", this));
+    preampSlider = new QSlider(Qt::Horizontal, this);
+    preampSlider->setRange(-kMaxSliderDb * kSliderSteps, kMaxSliderDb * kSliderSteps);
+    preampLayout->addWidget(preampSlider, 1);
+    preampLabel = new QLabel(this);
+    preampLabel->setMinimumWidth(64);
+    preampLayout->addWidget(preampLabel);
+    limiterCheck = new QCheckBox("限幅器（-1 dBFS）", this);
+    preampLayout->addWidget(limiterCheck);
+    mainLayout->addLayout(preampLayout);
+
+    // 每段一欄：頻率、增益滑桿、增益數值、Q
+    QGridLayout* bandLayout = new QGridLayout();
+    for (int b = 0; b < EqualizerSettings::kBands; b++) {
+        frequencyBoxes[b] = new QSpinBox(this);
+        frequencyBoxes[b]->setRange(20, 20000);
+        frequencyBoxes[b]->setSuffix(" Hz");
+        frequencyBoxes[b]->setToolTip("中心頻率");
+        bandLayout->addWidget(frequencyBoxes[b], 0, b, Qt::AlignHCenter);
+
+        gainSliders[b] = new QSlider(Qt::Vertical, this);
+        gainSliders[b]->setRange(-kMaxSliderDb * kSliderSteps, kMaxSliderDb * kSliderSteps);
+        gainSliders[b]->setMinimumHeight(160);
+        bandLayout->addWidget(gainSliders[b], 1, b, Qt::AlignHCenter);
+
+        gainLabels[b] = new QLabel(this);
+        bandLayout->addWidget(gainLabels[b], 2, b, Qt::AlignHCenter);
+
+        qBoxes[b] = new QDoubleSpinBox(this);
+        qBoxes[b]->setRange(0.1, 10.0);
+        qBoxes[b]->setSingleStep(0.1);
+        qBoxes[b]->setDecimals(2);
+        qBoxes[b]->setPrefix("Q ");
+        bandLayout->addWidget(qBoxes[b], 3, b, Qt::AlignHCenter);
+
+        connect(frequencyBoxes[b], QOverload<int>::of(&QSpinBox::valueChanged), this, &EqualizerDialog::onControlChanged);
+        connect(gainSliders[b], &QSlider::valueChanged, this, &EqualizerDialog::onControlChanged);
+        connect(qBoxes[b], QOverload<double>::of(&QDoubleSpinBox::valueChanged), this, &EqualizerDialog::onControlChanged);
+    }
+    mainLayout->addLayout(bandLayout);
+
+    QHBoxLayout* buttonLayout = new QHBoxLayout();
+    buttonLayout->addStretch();
+    QPushButton* resetButton = new QPushButton("重設", this);
+    buttonLayout->addWidget(resetButton);
+    QPushButton* closeButton = new QPushButton("關閉", this);
+    buttonLayout->addWidget(closeButton);
+    mainLayout->addLayout(buttonLayout);
+
+    connect(preampSlider, &QSlider::valueChanged, this, &EqualizerDialog::onControlChanged);
+    connect(limiterCheck, &QCheckBox::toggled, this, &EqualizerDialog::onControlChanged);
+    connect(resetButton, &QPushButton::clicked, this, &EqualizerDialog::onResetClicked);
+    connect(closeButton, &QPushButton::clicked, this, &QDialog::close);
+
+    loadControls();
+}
+
+void EqualizerDialog::setSettings(const EqualizerSettings& settings)
+{
+    current = settings;
+    loadControls();
+}
+
+void EqualizerDialog::loadControls()
+{
+    loading = true;
+    preampSlider->setValue(qRound(current.preampDb * kSliderSteps));
+    preampLabel->setText(formatGain(current.preampDb));
+    limiterCheck->setChecked(current.limiter);
+    for (int b = 0; b < EqualizerSettings::kBands; b++) {
+        const EqualizerSettings::Band& band = current.bands[b];
+        frequencyBoxes[b]->setValue(qRound(band.frequency));
+        gainSliders[b]->setValue(qRound(band.gainDb * kSliderSteps));
+        gainLabels[b]->setText(formatGain(band.gainDb));
+        qBoxes[b]->setValue(band.q);
+    }
+    loading = false;
+}
+
+void EqualizerDialog::onControlChanged()
+{
+    if (loading) return;
+
+    // 拖曳滑桿時每一步都送出；處理端會平滑內插，不需要節流
+    current.preampDb = float(preampSlider->value()) / kSliderSteps;
+    current.limiter = limiterCheck->isChecked();
+    preampLabel->setText(formatGain(current.preampDb));
+    for (int b = 0; b < EqualizerSettings::kBands; b++) {
+        EqualizerSettings::Band& band = current.bands[b];
+        band.frequency = float(frequencyBoxes[b]->value());
+        band.gainDb = float(gainSliders[b]->value()) / kSliderSteps;
+        band.q = float(qBoxes[b]->value());
+        gainLabels[b]->setText(formatGain(band.gainDb));
+    }
+    emit settingsChanged(current);
+}
+
+void EqualizerDialog::onResetClicked()
+{
+    // 回到 ISO 中心頻率、全部 0 dB；開關不變
+    const bool enabled = current.enabled;
+    current = EqualizerSettings();
+    current.enabled = enabled;
+    loadControls();
+    emit settingsChanged(current);
+}
@@ -0,0 +1,45 @@
+#ifndef EQUALIZERDIALOG_H
+#define EQUALIZERDIALOG_H
+
+#include <QDialog>
+#include "equalizer.h"
+
+class QSlider;
+class QLabel;
+class QCheckBox;
+class QSpinBox;
+class QDoubleSpinBox;
+
+// 等化器設定視窗：每段的中心頻率、增益與 Q，以及前級增益與限幅器；調整時立即送出
+// 開關由主視窗的按鈕控制，這裡保留 enabled 原本的值
+class EqualizerDialog : public QDialog
+{
+    Q_OBJECT
+
+public:
+    explicit EqualizerDialog(const EqualizerSettings& settings, QWidget* parent = nullptr);
+
+    void setSettings(const EqualizerSettings& settings);
+    EqualizerSettings settings() const { return current; }
+
+signals:
+    void settingsChanged(const EqualizerSettings& settings);
+
+private:
+    void loadControls();
+    void onControlChanged();
+    void onResetClicked();
+
+    EqualizerSettings current;
+    bool loading;                     // 載入數值時不送出變更
+
+    QSlider* preampSlider;
+    QLabel* preampLabel;
+    QCheckBox* limiterCheck;
+    QSlider* gainSliders[EqualizerSettings::kBands];
+    QLabel* gainLabels[EqualizerSettings::kBands];
+    QSpinBox* frequencyBoxes[EqualizerSettings::kBands];
+    QDoubleSpinBox* qBoxes[EqualizerSettings::kBands];
+};
+
+#endif // EQUALIZERDIALOG_H
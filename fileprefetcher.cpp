@@ -0,0 +1,55 @@
+#include "fileprefetcher.h"
+#include "tracing.h"
+#include <QFile>
+#include <QByteArray>
+#ifdef Q_OS_LINUX
+#include <fcntl.h>
+#endif
+
+namespace {
+const qint64 kChunkBytes = 256 * 1024;
+}
+
+FilePrefetcher::FilePrefetcher()
+{
+    pool.setMaxThreadCount(1);
+}
+
+FilePrefetcher::~FilePrefetcher()
+{
+    pool.clear();
+    pool.waitForDone();
+}
+
+void FilePrefetcher::prefetch(const QString& filePath)
+{
+    if (filePath.isEmpty() || filePath == lastPath) return;
+    lastPath = filePath;
+
+    // 尚未開始的舊要求已經過時
+    pool.clear();
+    pool.start([filePath]() {
+        warm(filePath);
+    });
+}
+
+void FilePrefetcher::warm(const QString& filePath)
+{
+    TRACE_SCOPE("FilePrefetcher::warm", "io");
+
+    QFile file(filePath);
+    if (!file.open(QIODevice::ReadOnly)) return;
+
+#ifdef Q_OS_LINUX
+    // 非同步預讀整個檔案；核心可能只讀取一部分，因此下面仍讀取開頭
+    ::posix_fadvise(file.handle(), 0, 0, POSIX_FADV_WILLNEED);
+#endif
+
+    QByteArray buffer(kChunkBytes, Qt::Uninitialized);
+    qint64 remaining = qMin(file.size(), kWarmBytes);
+    while (remaining > 0) {
+        qint64 bytesRead = file.read(buffer.data(), qMin(remaining, kChunkBytes));
+        if (bytesRead <= 0) break;
+        remaining -= bytesRead;
+    }
+}
@@ -0,0 +1,28 @@
+#ifndef FILEPREFETCHER_H
+#define FILEPREFETCHER_H
+
+#include <QString>
+#include <QThreadPool>
+
+// 預讀下一首：在背景把檔案讀進作業系統的頁面快取，NAS 上的檔案開始播放時不必等待網路
+// - Linux 以 posix_fadvise(WILLNEED) 要求核心預讀整個檔案
+// - 所有平台都同步讀取檔案開頭，確保解碼器最先需要的標頭與第一批音訊已在快取中
+// 只有一個工作執行緒；新的要求會取代尚未開始的舊要求
+class FilePrefetcher
+{
+public:
+    FilePrefetcher();
+    ~FilePrefetcher();
+
+    void prefetch(const QString& filePath);
+
+    static const qint64 kWarmBytes = 2 * 1024 * 1024;
+
+private:
+    static void warm(const QString& filePath);
+
+    QThreadPool pool;
+    QString lastPath;      // 同一個檔案不重複預讀
+};
+
+#endif // FILEPREFETCHER_H
@@ -0,0 +1,387 @@
+#include "folderimporter.h"
+#include <QThread>
+#include <QTimer>
+#include <QDir>
+#include <QDirIterator>
+#include <QFileInfo>
+#include <QFile>
+#include <QSaveFile>
+#include <QDataStream>
+#include <QDateTime>
+#include <QFileSystemWatcher>
+#include <QMutexLocker>
+#include <algorithm>
+#include <utility>
+
+namespace {
+const quint32 kStateMagic = 0x4C524649;   // "LRFI"
+const quint32 kStateVersion = 1;
+}
+
+FolderImporter::FolderImporter(const QString& stateFile, QObject* parent)
+    : QObject(parent)
+    , stateFile(stateFile)
+    , nextRootId(0)
+    , stateDirty(false)
+    , activeScans(0)
+    , cancelled(false)
+{
+    // 掃描以 I/O 為主（網路磁碟尤其如此），執行緒可以比核心數多
+    pool.setMaxThreadCount(qBound(4, QThread::idealThreadCount() * 2, 16));
+
+    watcher = new QFileSystemWatcher(this);
+    connect(watcher, &QFileSystemWatcher::directoryChanged, this, &FolderImporter::onDirectoryChanged);
+
+    rescanTimer = new QTimer(this);
+    rescanTimer->setSingleShot(true);
+    rescanTimer->setInterval(300);
+    connect(rescanTimer, &QTimer::timeout, this, &FolderImporter::rescanChangedDirectories);
+
+    flushTimer = new QTimer(this);
+    flushTimer->setInterval(200);
+    connect(flushTimer, &QTimer::timeout, this, &FolderImporter::flushResults);
+}
+
+FolderImporter::~FolderImporter()
+{
+    cancelled = true;
+    pool.clear();
+    pool.waitForDone();
+    if (stateDirty) {
+        saveState();
+    }
+}
+
+bool FolderImporter::isAudioFile(const QString& fileName)
+{
+    static const QSet<QString> extensions = { "mp3", "wav", "flac", "m4a", "ogg", "aac" };
+    int dot = fileName.lastIndexOf('.');
+    return dot >= 0 && extensions.contains(fileName.mid(dot + 1).toLower());
+}
+
+QString FolderImporter::childPath(const QString& dirPath, const QString& name)
+{
+    return dirPath.endsWith('/') ? dirPath + name : dirPath + "/" + name;
+}
+
+void FolderImporter::addRoot(const QString& rootPath, const QString& playlistName)
+{
+    QString path = QDir::cleanPath(rootPath);
+    for (auto it = roots.cbegin(); it != roots.cend(); ++it) {
+        if (it->path == path && it->playlistName == playlistName) {
+            // 已匯入過：只檢查變更
+            scan(it.key(), path, true, false);
+            return;
+        }
+    }
+
+    Root root;
+    root.path = path;
+    root.playlistName = playlistName;
+    int rootId = nextRootId++;
+    roots.insert(rootId, root);
+    stateDirty = true;
+    scan(rootId, path, false, false);
+}
+
+void FolderImporter::removeRootsFor(const QString& playlistName)
+{
+    for (auto it = roots.begin(); it != roots.end();) {
+        if (it->playlistName != playlistName) {
+            ++it;
+            continue;
+        }
+
+        QStringList unwatched;
+        for (auto dir = it->dirs.cbegin(); dir != it->dirs.cend(); ++dir) {
+            if (!isWatchedByOtherRoot(it.key(), dir.key())) {
+                unwatched.append(dir.key());
+            }
+        }
+        if (!unwatched.isEmpty()) {
+            watcher->removePaths(unwatched);
+        }
+        it = roots.erase(it);
+        stateDirty = true;
+    }
+
+    if (stateDirty) {
+        saveState();
+    }
+}
+
+void FolderImporter::restore()
+{
+    loadState();
+
+    for (auto it = roots.cbegin(); it != roots.cend(); ++it) {
+        QStringList dirs = it->dirs.keys();
+        if (!dirs.isEmpty()) {
+            watcher->addPaths(dirs);
+        }
+        scan(it.key(), it->path, true, false);
+    }
+}
+
+void FolderImporter::scan(int rootId, const QString& dirPath, bool verifyKnown, bool forceList)
+{
+    // 工作執行緒讀取快照的複本（隱式共享，不會複製資料）
+    startScan(rootId, dirPath, roots.value(rootId).dirs, verifyKnown, forceList);
+    if (!flushTimer->isActive()) {
+        flushTimer->start();
+    }
+}
+
+void FolderImporter::startScan(int rootId, const QString& dirPath, const Snapshot& snapshot,
+                               bool verifyKnown, bool forceList)
+{
+    {
+        QMutexLocker locker(&mutex);
+        activeScans++;
+    }
+    pool.start([this, rootId, dirPath, snapshot, verifyKnown, forceList]() {
+        scanDirectory(rootId, dirPath, snapshot, verifyKnown, forceList);
+    });
+}
+
+void FolderImporter::scanDirectory(int rootId, const QString& dirPath, const Snapshot& snapshot,
+                                   bool verifyKnown, bool forceList)
+{
+    // 在執行緒池上執行：每個資料夾一個工作，子資料夾各自成為新的工作
+    if (!cancelled) {
+        ScanResult result;
+        result.rootId = rootId;
+        result.dirPath = dirPath;
+
+        QFileInfo dirInfo(dirPath);
+        result.exists = dirInfo.isDir();
+        bool report = true;
+
+        if (result.exists) {
+            qint64 modified = dirInfo.lastModified().toMSecsSinceEpoch();
+            auto known = snapshot.constFind(dirPath);
+            if (known != snapshot.constEnd() && known->modified == modified && !forceList) {
+                // 內容未變更：不必列出，驗證模式下繼續檢查子資料夾
+                report = false;
+                if (verifyKnown) {
+                    for (const QString& subdir : known->subdirs) {
+                        startScan(rootId, childPath(dirPath, subdir), snapshot, true, false);
+                    }
+                }
+            } else {
+                result.entry.modified = modified;
+                QDirIterator it(dirPath, QDir::Files | QDir::Dirs | QDir::NoDotAndDotDot);
+                while (it.hasNext()) {
+                    it.next();
+                    QFileInfo info = it.fileInfo();
+                    if (info.isDir()) {
+                        // 不跟隨資料夾的符號連結，避免循環
+                        if (!info.isSymLink()) {
+                            result.entry.subdirs.append(info.fileName());
+                        }
+                    } else if (isAudioFile(info.fileName())) {
+                        result.entry.files.append(info.fileName());
+                    }
+                }
+                result.entry.files.sort();
+                result.entry.subdirs.sort();
+
+                for (const QString& subdir : std::as_const(result.entry.subdirs)) {
+                    QString subdirPath = childPath(dirPath, subdir);
+                    if (verifyKnown || !snapshot.contains(subdirPath)) {
+                        startScan(rootId, subdirPath, snapshot, verifyKnown, false);
+                    }
+                }
+            }
+        }
+
+        if (report) {
+            QMutexLocker locker(&mutex);
+            pendingResults.append(result);
+        }
+    }
+
+    QMutexLocker locker(&mutex);
+    activeScans--;
+}
+
+void FolderImporter::onDirectoryChanged(const QString& dirPath)
+{
+    changedDirs.insert(dirPath);
+    rescanTimer->start();
+}
+
+void FolderImporter::rescanChangedDirectories()
+{
+    const QSet<QString> dirs = std::exchange(changedDirs, QSet<QString>());
+    for (const QString& dirPath : dirs) {
+        for (auto it = roots.cbegin(); it != roots.cend(); ++it) {
+            if (it->dirs.contains(dirPath)) {
+                scan(it.key(), dirPath, false, true);
+            }
+        }
+    }
+}
+
+void FolderImporter::flushResults()
+{
+    QList<ScanResult> results;
+    bool idle = false;
+    {
+        QMutexLocker locker(&mutex);
+        results.swap(pendingResults);
+        idle = activeScans == 0;
+    }
+
+    QHash<QString, QStringList> added;
+    QHash<QString, QStringList> removed;
+    QStringList newDirs;
+    for (const ScanResult& result : std::as_const(results)) {
+        applyResult(result, added, removed, newDirs);
+    }
+    if (!newDirs.isEmpty()) {
+        watcher->addPaths(newDirs);
+    }
+
+    for (auto it = removed.begin(); it != removed.end(); ++it) {
+        emit filesRemoved(it.key(), it.value());
+    }
+    for (auto it = added.begin(); it != added.end(); ++it) {
+        std::sort(it->begin(), it->end());
+        emit filesAdded(it.key(), it.value());
+    }
+
+    // 沒有進行中的掃描：停止輪詢並寫入快照
+    if (idle) {
+        flushTimer->stop();
+        if (stateDirty) {
+            saveState();
+        }
+    }
+}
+
+void FolderImporter::applyResult(const ScanResult& result, QHash<QString, QStringList>& added,
+                                 QHash<QString, QStringList>& removed, QStringList& newDirs)
+{
+    auto rootIt = roots.find(result.rootId);
+    if (rootIt == roots.end()) return;   // 掃描期間已移除
+    Root& root = *rootIt;
+
+    if (!result.exists) {
+        dropDirectory(root, result.dirPath, removed[root.playlistName]);
+        stateDirty = true;
+        return;
+    }
+
+    auto known = root.dirs.constFind(result.dirPath);
+    if (known == root.dirs.constEnd()) {
+        newDirs.append(result.dirPath);
+        QStringList& addedFiles = added[root.playlistName];
+        for (const QString& file : result.entry.files) {
+            addedFiles.append(childPath(result.dirPath, file));
+        }
+    } else {
+        // 只回報與上次列出時的差異
+        const QSet<QString> oldFiles(known->files.cbegin(), known->files.cend());
+        const QSet<QString> newFiles(result.entry.files.cbegin(), result.entry.files.cend());
+        for (const QString& file : result.entry.files) {
+            if (!oldFiles.contains(file)) {
+                added[root.playlistName].append(childPath(result.dirPath, file));
+            }
+        }
+        for (const QString& file : known->files) {
+            if (!newFiles.contains(file)) {
+                removed[root.playlistName].append(childPath(result.dirPath, file));
+            }
+        }
+
+        const QSet<QString> newSubdirs(result.entry.subdirs.cbegin(), result.entry.subdirs.cend());
+        const QStringList oldSubdirs = known->subdirs;
+        for (const QString& subdir : oldSubdirs) {
+            if (!newSubdirs.contains(subdir)) {
+                dropDirectory(root, childPath(result.dirPath, subdir), removed[root.playlistName]);
+            }
+        }
+    }
+
+    root.dirs.insert(result.dirPath, result.entry);
+    stateDirty = true;
+}
+
+void FolderImporter::dropDirectory(Root& root, const QString& dirPath, QStringList& removedFiles)
+{
+    auto it = root.dirs.find(dirPath);
+    if (it == root.dirs.end()) return;
+
+    DirEntry entry = *it;
+    root.dirs.erase(it);
+    for (const QString& file : std::as_const(entry.files)) {
+        removedFiles.append(childPath(dirPath, file));
+    }
+    for (const QString& subdir : std::as_const(entry.subdirs)) {
+        dropDirectory(root, childPath(dirPath, subdir), removedFiles);
+    }
+
+    if (!isWatchedByOtherRoot(-1, dirPath)) {
+        watcher->removePath(dirPath);
+    }
+}
+
+bool FolderImporter::isWatchedByOtherRoot(int rootId, const QString& dirPath) const
+{
+    for (auto it = roots.cbegin(); it != roots.cend(); ++it) {
+        if (it.key() != rootId && it->dirs.contains(dirPath)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void FolderImporter::loadState()
+{
+    QFile file(stateFile);
+    if (!file.open(QIODevice::ReadOnly)) return;
+
+    QDataStream in(&file);
+    in.setVersion(QDataStream::Qt_6_0);
+    quint32 magic = 0;
+    quint32 version = 0;
+    qint32 rootCount = 0;
+    in >> magic >> version >> rootCount;
+    if (magic != kStateMagic || version != kStateVersion || rootCount < 0) return;
+
+    for (qint32 i = 0; i < rootCount && in.status() == QDataStream::Ok; i++) {
+        Root root;
+        qint32 dirCount = 0;
+        in >> root.path >> root.playlistName >> dirCount;
+        root.dirs.reserve(qMax(dirCount, 0));
+        for (qint32 j = 0; j < dirCount && in.status() == QDataStream::Ok; j++) {
+            QString dirPath;
+            DirEntry entry;
+            in >> dirPath >> entry.modified >> entry.files >> entry.subdirs;
+            root.dirs.insert(dirPath, entry);
+        }
+        if (in.status() == QDataStream::Ok) {
+            roots.insert(nextRootId++, root);
+        }
+    }
+}
+
+void FolderImporter::saveState()
+{
+    QSaveFile file(stateFile);
+    if (!file.open(QIODevice::WriteOnly)) return;
+
+    QDataStream out(&file);
+    out.setVersion(QDataStream::Qt_6_0);
+    out << kStateMagic << kStateVersion << qint32(roots.size());
+    for (const Root& root : std::as_const(roots)) {
+        out << root.path << root.playlistName << qint32(root.dirs.size());
+        for (auto it = root.dirs.cbegin(); it != root.dirs.cend(); ++it) {
+            out << it.key() << it->modified << it->files << it->subdirs;
+        }
+    }
+    if (file.commit()) {
+        stateDirty = false;
+    }
+}
@@ -0,0 +1,99 @@
+#ifndef FOLDERIMPORTER_H
+#define FOLDERIMPORTER_H
+
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QList>
+#include <QHash>
+#include <QSet>
+#include <QMutex>
+#include <QThreadPool>
+#include <atomic>
+
+class QFileSystemWatcher;
+class QTimer;
+
+// 資料夾匯入：以執行緒池平行遞迴掃描，並監看已匯入的資料夾
+// 每個資料夾的內容記錄在快照中，之後只重新列出有變更的資料夾
+class FolderImporter : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit FolderImporter(const QString& stateFile, QObject* parent = nullptr);
+    ~FolderImporter();
+
+    // 支援的音樂副檔名（與開啟檔案對話框一致）
+    static bool isAudioFile(const QString& fileName);
+
+    // 匯入資料夾到指定的播放清單，完成後持續監看
+    void addRoot(const QString& rootPath, const QString& playlistName);
+    // 播放清單刪除時停止監看對應的資料夾
+    void removeRootsFor(const QString& playlistName);
+    // 恢復上次匯入的資料夾：重新監看，並只列出修改時間改變的資料夾
+    void restore();
+
+signals:
+    // 成批回報，同一批內依路徑排序
+    void filesAdded(const QString& playlistName, const QStringList& filePaths);
+    void filesRemoved(const QString& playlistName, const QStringList& filePaths);
+
+private:
+    struct DirEntry {
+        qint64 modified = 0;
+        QStringList files;     // 音樂檔名（不含路徑）
+        QStringList subdirs;   // 子資料夾名稱
+    };
+    using Snapshot = QHash<QString, DirEntry>;
+
+    struct Root {
+        QString path;
+        QString playlistName;
+        Snapshot dirs;         // 資料夾路徑 -> 上次列出的內容
+    };
+
+    struct ScanResult {
+        int rootId;
+        QString dirPath;
+        bool exists;
+        DirEntry entry;
+    };
+
+    // verifyKnown：連快照中已知的子資料夾也檢查修改時間（啟動時使用）
+    // forceList：即使修改時間相同也重新列出（監看器通知時使用）
+    void scan(int rootId, const QString& dirPath, bool verifyKnown, bool forceList);
+    void startScan(int rootId, const QString& dirPath, const Snapshot& snapshot, bool verifyKnown, bool forceList);
+    void scanDirectory(int rootId, const QString& dirPath, const Snapshot& snapshot, bool verifyKnown, bool forceList);
+
+    void onDirectoryChanged(const QString& dirPath);
+    void rescanChangedDirectories();
+    void flushResults();
+    void applyResult(const ScanResult& result, QHash<QString, QStringList>& added,
+                     QHash<QString, QStringList>& removed, QStringList& newDirs);
+    void dropDirectory(Root& root, const QString& dirPath, QStringList& removedFiles);
+    bool isWatchedByOtherRoot(int rootId, const QString& dirPath) const;
+    static QString childPath(const QString& dirPath, const QString& name);
+
+    void loadState();
+    void saveState();
+
+    QString stateFile;
+    QHash<int, Root> roots;
+    int nextRootId;
+    bool stateDirty;
+
+    // 工作執行緒與 GUI 執行緒共用，受 mutex 保護
+    QMutex mutex;
+    QList<ScanResult> pendingResults;
+    int activeScans;
+    std::atomic<bool> cancelled;
+
+    QThreadPool pool;
+    QFileSystemWatcher* watcher;
+    QSet<QString> changedDirs;     // 等待重新掃描的資料夾（合併短時間內的大量通知）
+    QTimer* rescanTimer;
+    QTimer* flushTimer;
+};
+
+#endif // FOLDERIMPORTER_H
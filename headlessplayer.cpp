@@ -0,0 +1,520 @@
+#include "headlessplayer.h"
+#include "playliststore.h"
+#include "tracing.h"
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QAudioOutput>
+#include <QStandardPaths>
+#include <QRandomGenerator>
+#include <QThread>
+#include <QFile>
+#include <QJsonDocument>
+#include <QTime>
+#include <QTimer>
+#include <QUrl>
+#include <QMetaEnum>
+#include <cstdio>
+
+namespace {
+QString formatDuration(qint64 ms)
+{
+    QString format = ms >= 3600000 ? "h:mm:ss" : "m:ss";
+    return QTime(0, 0).addMSecs(ms).toString(format);
+}
+
+bool parseSwitch(const QString& argument, bool current)
+{
+    // 沒有參數時切換，on/off 時直接設定
+    if (argument == "on" || argument == "1") return true;
+    if (argument == "off" || argument == "0") return false;
+    return !current;
+}
+
+const char* kHelpText =
+    "指令：\n"
+    "  play [n]            播放（指定從 1 起算的第 n 首）\n"
+    "  pause | toggle      暫停 / 切換播放與暫停\n"
+    "  stop                停止\n"
+    "  next | prev         下一首 / 上一首\n"
+    "  seek <秒>           跳到指定位置\n"
+    "  volume <0-100>      音量\n"
+    "  shuffle [on|off]    隨機播放\n"
+    "  repeat [on|off]     循環播放\n"
+    "  playlist <名稱>     切換播放清單\n"
+    "  playlists | tracks  列出播放清單 / 目前播放清單的曲目\n"
+    "  status              目前狀態\n"
+    "  stats [json]        開始播放延遲的統計\n"
+    "  quit                結束\n";
+}
+
+HeadlessPlayer::HeadlessPlayer(QObject* parent)
+    : QObject(parent)
+    , mediaPlayer(new QMediaPlayer(this))
+    , audioOutput(new QAudioOutput(this))
+    , playlistStore(new PlaylistStore(QStandardPaths::writableLocation(QStandardPaths::AppDataLocation), this))
+    , stdinThread(nullptr)
+    , currentPlaylistIndex(-1)
+    , currentVideoIndex(-1)
+    , isShuffleMode(false)
+    , isRepeatMode(false)
+    , consecutiveErrors(0)
+{
+    mediaPlayer->setAudioOutput(audioOutput);
+    audioOutput->setVolume(0.5);
+
+    connect(mediaPlayer, &QMediaPlayer::mediaStatusChanged, this, &HeadlessPlayer::onMediaStatusChanged);
+    connect(mediaPlayer, &QMediaPlayer::errorOccurred, this, &HeadlessPlayer::onErrorOccurred);
+    connect(mediaPlayer, &QMediaPlayer::positionChanged, this, &HeadlessPlayer::onPositionChanged);
+}
+
+HeadlessPlayer::~HeadlessPlayer()
+{
+    mediaPlayer->stop();
+
+    // 讀取執行緒可能正阻塞在標準輸入上，無法等待它結束；行程結束時一併回收
+    if (stdinThread && stdinThread->isFinished()) {
+        delete stdinThread;
+    }
+}
+
+bool HeadlessPlayer::start(const QStringList& arguments)
+{
+    TRACE_SCOPE("HeadlessPlayer::start");
+    QCommandLineParser parser;
+    parser.setApplicationDescription(QString("音樂播放器（無介面模式）\n\n") + kHelpText);
+    parser.addHelpOption();
+    QCommandLineOption headlessOption("headless", "不建立視窗，以命令列參數與標準輸入控制。");
+    QCommandLineOption playlistOption(QStringList{ "p", "playlist" }, "播放的播放清單（預設為上次使用的）。", "name");
+    QCommandLineOption trackOption(QStringList{ "t", "track" }, "從第幾首開始（從 1 起算）。", "n");
+    QCommandLineOption shuffleOption("shuffle", "隨機播放。");
+    QCommandLineOption repeatOption("repeat", "循環播放。");
+    QCommandLineOption volumeOption("volume", "音量 0-100。", "percent", "50");
+    QCommandLineOption listOption("list", "列出播放清單後結束。");
+    QCommandLineOption noStdinOption("no-stdin", "不從標準輸入讀取指令。");
+    parser.addOptions({ headlessOption, playlistOption, trackOption, shuffleOption, repeatOption,
+                        volumeOption, listOption, noStdinOption });
+    parser.process(arguments);
+
+    // 只讀取播放清單名稱與要播放的那一份
+    bool needsFullSave = false;
+    playlistStore->load(playlists, lastPlaylistName, needsFullSave, true);
+    if (playlists.isEmpty()) {
+        print("沒有任何播放清單。");
+        return false;
+    }
+
+    if (parser.isSet(listOption)) {
+        printPlaylists();
+        QTimer::singleShot(0, qApp, &QCoreApplication::quit);
+        return true;
+    }
+
+    bool volumeOk = false;
+    int volume = parser.value(volumeOption).toInt(&volumeOk);
+    if (!volumeOk || volume < 0 || volume > 100) {
+        print("音量必須是 0 到 100。");
+        return false;
+    }
+    audioOutput->setVolume(volume / 100.0);
+
+    if (parser.isSet(playlistOption)) {
+        if (!selectPlaylist(parser.value(playlistOption))) {
+            print(QString("找不到播放清單：%1").arg(parser.value(playlistOption)));
+            return false;
+        }
+    } else if (!selectPlaylist(lastPlaylistName)) {
+        selectPlaylist(playlists.first().name);
+    }
+
+    isRepeatMode = parser.isSet(repeatOption);
+    setShuffleMode(parser.isSet(shuffleOption));
+
+    int startIndex = -1;
+    if (parser.isSet(trackOption)) {
+        bool trackOk = false;
+        startIndex = parser.value(trackOption).toInt(&trackOk) - 1;
+        if (!trackOk || startIndex < 0 || startIndex >= playlists[currentPlaylistIndex].videos.size()) {
+            print("曲目編號超出範圍。");
+            return false;
+        }
+    } else {
+        startIndex = isShuffleMode ? getNextVideoIndex() : 0;
+    }
+
+    if (!parser.isSet(noStdinOption)) {
+        startStdinReader();
+    }
+    playVideo(startIndex);
+    return true;
+}
+
+void HeadlessPlayer::startStdinReader()
+{
+    // 在獨立執行緒上以阻塞方式讀取，每一行交回主執行緒執行；標準輸入關閉後繼續播放
+    stdinThread = QThread::create([this]() {
+        QFile input;
+        if (!input.open(stdin, QIODevice::ReadOnly | QIODevice::Text)) return;
+        while (true) {
+            QByteArray line = input.readLine();
+            if (line.isEmpty()) break;
+            QString command = QString::fromUtf8(line).trimmed();
+            if (command.isEmpty()) continue;
+            QMetaObject::invokeMethod(this, [this, command]() {
+                execute(command);
+            }, Qt::QueuedConnection);
+        }
+    });
+    stdinThread->start();
+}
+
+void HeadlessPlayer::execute(const QString& commandLine)
+{
+    const QString command = commandLine.section(' ', 0, 0, QString::SectionSkipEmpty).toLower();
+    const QString argument = commandLine.section(' ', 1, -1, QString::SectionSkipEmpty).trimmed();
+    const bool hasPlaylist = currentPlaylistIndex >= 0 && currentPlaylistIndex < playlists.size();
+
+    if (command == "play") {
+        if (!argument.isEmpty()) {
+            bool ok = false;
+            int index = argument.toInt(&ok) - 1;
+            if (!ok || !hasPlaylist || index < 0 || index >= playlists[currentPlaylistIndex].videos.size()) {
+                print("曲目編號超出範圍。");
+                return;
+            }
+            playVideo(index);
+        } else if (currentVideoIndex < 0) {
+            playVideo(isShuffleMode ? getNextVideoIndex() : 0);
+        } else {
+            mediaPlayer->play();
+        }
+    } else if (command == "pause") {
+        mediaPlayer->pause();
+    } else if (command == "toggle") {
+        if (mediaPlayer->playbackState() == QMediaPlayer::PlayingState) {
+            mediaPlayer->pause();
+        } else {
+            mediaPlayer->play();
+        }
+    } else if (command == "stop") {
+        mediaPlayer->stop();
+    } else if (command == "next") {
+        int nextIndex = getNextVideoIndex();
+        if (nextIndex >= 0) {
+            playVideo(nextIndex);
+        }
+    } else if (command == "prev" || command == "previous") {
+        int previousIndex = getPreviousVideoIndex();
+        if (previousIndex >= 0) {
+            playVideo(previousIndex);
+        }
+    } else if (command == "seek") {
+        bool ok = false;
+        double seconds = argument.toDouble(&ok);
+        if (!ok || seconds < 0) {
+            print("用法：seek <秒>");
+            return;
+        }
+        mediaPlayer->setPosition(qint64(seconds * 1000));
+    } else if (command == "volume") {
+        bool ok = false;
+        int volume = argument.toInt(&ok);
+        if (!ok || volume < 0 || volume > 100) {
+            print("用法：volume <0-100>");
+            return;
+        }
+        audioOutput->setVolume(volume / 100.0);
+    } else if (command == "shuffle") {
+        setShuffleMode(parseSwitch(argument, isShuffleMode));
+        printStatus();
+    } else if (command == "repeat") {
+        isRepeatMode = parseSwitch(argument, isRepeatMode);
+        printStatus();
+    } else if (command == "playlist") {
+        if (!selectPlaylist(argument)) {
+            print(QString("找不到播放清單：%1").arg(argument));
+            return;
+        }
+        playVideo(isShuffleMode ? getNextVideoIndex() : 0);
+    } else if (command == "playlists") {
+        printPlaylists();
+    } else if (command == "tracks") {
+        printTracks();
+    } else if (command == "status") {
+        printStatus();
+    } else if (command == "stats") {
+        if (argument == "json") {
+            print(QString::fromUtf8(QJsonDocument(trackStartLatency.toJson()).toJson(QJsonDocument::Compact)));
+        } else {
+            print(trackStartLatency.toText());
+        }
+    } else if (command == "help") {
+        print(QString::fromUtf8(kHelpText).trimmed());
+    } else if (command == "quit" || command == "exit") {
+        QCoreApplication::quit();
+    } else {
+        print(QString("未知的指令：%1（輸入 help 查看可用指令）").arg(command));
+    }
+}
+
+bool HeadlessPlayer::selectPlaylist(const QString& name)
+{
+    int index = -1;
+    for (int i = 0; i < playlists.size(); i++) {
+        if (playlists[i].name == name) {
+            index = i;
+            break;
+        }
+    }
+    if (index < 0 || !ensureLoaded(index)) return false;
+
+    // 只保留正在使用的播放清單，維持較小的記憶體用量
+    for (int i = 0; i < playlists.size(); i++) {
+        Playlist& other = playlists[i];
+        if (i == index || !other.loaded) continue;
+        other.videos = QList<VideoInfo>();
+        other.loaded = false;
+        playlistStore->releasePlaylist(other.name);
+    }
+
+    mediaPlayer->stop();
+    currentPlaylistIndex = index;
+    currentVideoIndex = -1;
+    consecutiveErrors = 0;
+    resetShuffle();
+    print(QString("播放清單：%1（%2 首）").arg(playlists[index].name).arg(playlists[index].videos.size()));
+    return true;
+}
+
+bool HeadlessPlayer::ensureLoaded(int index)
+{
+    Playlist& playlist = playlists[index];
+    if (playlist.loaded) return true;
+
+    if (!playlistStore->loadPlaylist(playlist)) {
+        return false;
+    }
+    playlist.loaded = true;
+    return true;
+}
+
+void HeadlessPlayer::playVideo(int index)
+{
+    TRACE_SCOPE("HeadlessPlayer::playVideo");
+    if (currentPlaylistIndex < 0 || currentPlaylistIndex >= playlists.size()) return;
+
+    const Playlist& playlist = playlists[currentPlaylistIndex];
+    if (index < 0 || index >= playlist.videos.size()) {
+        print("播放清單中沒有可播放的曲目。");
+        return;
+    }
+
+    // 沒有瀏覽器可開啟 YouTube 影片：略過，但仍記錄在隨機播放的歷史中
+    int skipped = 0;
+    while (index >= 0 && !playlist.videos[index].isLocalFile()) {
+        currentVideoIndex = index;
+        if (isShuffleMode) {
+            shuffle.select(index);
+        }
+        if (++skipped >= playlist.videos.size()) {
+            index = -1;
+            break;
+        }
+        index = getNextVideoIndex();
+    }
+    if (index < 0) {
+        mediaPlayer->stop();
+        print("播放清單中沒有可播放的本地曲目。");
+        return;
+    }
+
+    currentVideoIndex = index;
+    if (isShuffleMode) {
+        shuffle.select(index);
+    }
+
+    const VideoInfo& video = playlist.videos[index];
+    trackStartTimer.start();
+    mediaPlayer->stop();
+    mediaPlayer->setSource(QUrl::fromLocalFile(video.filePath()));
+    mediaPlayer->play();
+
+    print(QString("▶ [%1/%2] %3 — %4")
+          .arg(index + 1).arg(playlist.videos.size()).arg(video.title(), video.channelTitle()));
+}
+
+int HeadlessPlayer::getNextVideoIndex()
+{
+    // 與 Widget::getNextVideoIndex 相同的規則
+    if (currentPlaylistIndex < 0 || currentPlaylistIndex >= playlists.size()) return -1;
+
+    const Playlist& playlist = playlists[currentPlaylistIndex];
+    if (playlist.videos.isEmpty()) return -1;
+
+    if (isShuffleMode) {
+        if (shuffle.trackCount() != playlist.videos.size()) {
+            resetShuffle();
+        }
+        return shuffle.upcoming(isRepeatMode);
+    }
+
+    int newIndex = currentVideoIndex + 1;
+    if (newIndex >= playlist.videos.size()) {
+        return isRepeatMode ? 0 : -1;
+    }
+    return newIndex;
+}
+
+int HeadlessPlayer::getPreviousVideoIndex()
+{
+    if (currentPlaylistIndex < 0 || currentPlaylistIndex >= playlists.size()) return -1;
+
+    const Playlist& playlist = playlists[currentPlaylistIndex];
+    if (playlist.videos.isEmpty()) return -1;
+
+    if (isShuffleMode) {
+        return shuffle.previous();
+    }
+    int newIndex = currentVideoIndex - 1;
+    return newIndex < 0 ? playlist.videos.size() - 1 : newIndex;
+}
+
+void HeadlessPlayer::setShuffleMode(bool enabled)
+{
+    if (enabled == isShuffleMode) return;
+
+    isShuffleMode = enabled;
+    if (isShuffleMode) {
+        // 與 Widget 相同：設定 LAST_REPORT_SHUFFLE_SEED 可重現同一個隨機序列
+        bool seedOk = false;
+        uint seed = qEnvironmentVariable("LAST_REPORT_SHUFFLE_SEED").toUInt(&seedOk);
+        shuffle.setSeed(seedOk ? seed : QRandomGenerator::global()->generate());
+    }
+    resetShuffle();
+}
+
+void HeadlessPlayer::resetShuffle()
+{
+    if (!isShuffleMode || currentPlaylistIndex < 0 || currentPlaylistIndex >= playlists.size()) {
+        shuffle.clear();
+        return;
+    }
+    shuffle.reset(playlists[currentPlaylistIndex].videos.size(), currentVideoIndex);
+}
+
+void HeadlessPlayer::onMediaStatusChanged(QMediaPlayer::MediaStatus status)
+{
+    if (Trace::isEnabled()) {
+        Trace::instant("mediaStatus", "media", QMetaEnum::fromType<QMediaPlayer::MediaStatus>().valueToKey(status));
+    }
+    if (status == QMediaPlayer::LoadedMedia || status == QMediaPlayer::BufferedMedia) {
+        consecutiveErrors = 0;
+        if (status == QMediaPlayer::BufferedMedia) {
+            recordTrackStart();
+        }
+        return;
+    }
+    if (status != QMediaPlayer::EndOfMedia) return;
+
+    // 播放結束，自動播放下一首
+    int nextIndex = getNextVideoIndex();
+    if (nextIndex >= 0) {
+        playVideo(nextIndex);
+    } else {
+        print("■ 播放清單已播放完畢。");
+    }
+}
+
+void HeadlessPlayer::onPositionChanged(qint64 position)
+{
+    if (position > 0) {
+        recordTrackStart();
+    }
+}
+
+void HeadlessPlayer::recordTrackStart()
+{
+    if (!trackStartTimer.isValid()) return;
+
+    qint64 latencyMs = trackStartTimer.elapsed();
+    trackStartTimer.invalidate();
+    trackStartLatency.record(latencyMs);
+    if (Trace::isEnabled()) {
+        Trace::instant("trackStart", "media", QString("%1 ms").arg(latencyMs));
+    }
+
+    // 這首已經開始發聲，接著預讀下一首
+    int nextIndex = getNextVideoIndex();
+    if (nextIndex >= 0 && playlists[currentPlaylistIndex].videos[nextIndex].isLocalFile()) {
+        prefetcher.prefetch(playlists[currentPlaylistIndex].videos[nextIndex].filePath());
+    }
+}
+
+void HeadlessPlayer::onErrorOccurred(QMediaPlayer::Error error, const QString& errorString)
+{
+    if (error == QMediaPlayer::NoError) return;
+    print(QString("無法播放：%1").arg(errorString));
+
+    // 略過壞掉的檔案；整份清單都無法播放時停止
+    if (currentPlaylistIndex < 0 || ++consecutiveErrors >= playlists[currentPlaylistIndex].videos.size()) {
+        mediaPlayer->stop();
+        return;
+    }
+    int nextIndex = getNextVideoIndex();
+    if (nextIndex >= 0) {
+        playVideo(nextIndex);
+    }
+}
+
+void HeadlessPlayer::printStatus()
+{
+    QString state;
+    switch (mediaPlayer->playbackState()) {
+    case QMediaPlayer::PlayingState: state = "播放中"; break;
+    case QMediaPlayer::PausedState: state = "暫停"; break;
+    default: state = "停止"; break;
+    }
+
+    QString track = "（無）";
+    if (currentPlaylistIndex >= 0 && currentVideoIndex >= 0 &&
+        currentVideoIndex < playlists[currentPlaylistIndex].videos.size()) {
+        const VideoInfo& video = playlists[currentPlaylistIndex].videos[currentVideoIndex];
+        track = QString("[%1] %2 — %3").arg(currentVideoIndex + 1).arg(video.title(), video.channelTitle());
+    }
+
+    print(QString("%1 %2 %3/%4 隨機:%5 循環:%6 音量:%7")
+          .arg(state, track, formatDuration(mediaPlayer->position()), formatDuration(mediaPlayer->duration()))
+          .arg(isShuffleMode ? QString("開（種子 %1）").arg(shuffle.seed()) : QString("關"))
+          .arg(isRepeatMode ? QString("開") : QString("關"))
+          .arg(qRound(audioOutput->volume() * 100)));
+}
+
+void HeadlessPlayer::printPlaylists()
+{
+    for (int i = 0; i < playlists.size(); i++) {
+        const Playlist& playlist = playlists[i];
+        QString size = playlist.loaded ? QString("%1 首").arg(playlist.videos.size()) : QString("未載入");
+        print(QString("%1 %2（%3）").arg(i == currentPlaylistIndex ? QString("*") : QString(" "), playlist.name, size));
+    }
+}
+
+void HeadlessPlayer::printTracks()
+{
+    if (currentPlaylistIndex < 0 || currentPlaylistIndex >= playlists.size()) return;
+
+    const QList<VideoInfo>& videos = playlists[currentPlaylistIndex].videos;
+    for (int i = 0; i < videos.size(); i++) {
+        print(QString("%1%2. %3 — %4%5")
+              .arg(i == currentVideoIndex ? QString("▶ ") : QString("  "))
+              .arg(i + 1)
+              .arg(videos[i].title(), videos[i].channelTitle())
+              .arg(videos[i].isLocalFile() ? QString() : QString("（YouTube）")));
+    }
+}
+
+void HeadlessPlayer::print(const QString& line)
+{
+    const QByteArray utf8 = line.toUtf8();
+    std::fwrite(utf8.constData(), 1, size_t(utf8.size()), stdout);
+    std::fputc('\n', stdout);
+    std::fflush(stdout);
+}
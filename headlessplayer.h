@@ -0,0 +1,72 @@
+#ifndef HEADLESSPLAYER_H
+#define HEADLESSPLAYER_H
+
+#include <QObject>
+#include <QList>
+#include <QString>
+#include <QStringList>
+#include <QMediaPlayer>
+#include <QElapsedTimer>
+#include "playlist.h"
+#include "shuffleengine.h"
+#include "latencyhistogram.h"
+#include "fileprefetcher.h"
+
+class QAudioOutput;
+class QThread;
+class PlaylistStore;
+
+// 無介面播放器：--headless 時取代 Widget，只建立 QCoreApplication、QMediaPlayer 與播放清單儲存
+// 播放清單、隨機/循環與自動下一首的行為與 Widget 相同；以命令列參數與標準輸入的指令控制
+// 只讀取音樂庫，不寫回任何變更
+class HeadlessPlayer : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit HeadlessPlayer(QObject* parent = nullptr);
+    ~HeadlessPlayer();
+
+    // 解析命令列並開始播放；參數錯誤時回傳 false
+    bool start(const QStringList& arguments);
+
+    // 執行一行指令（標準輸入的每一行）
+    void execute(const QString& commandLine);
+
+private:
+    void onMediaStatusChanged(QMediaPlayer::MediaStatus status);
+    void onErrorOccurred(QMediaPlayer::Error error, const QString& errorString);
+    void onPositionChanged(qint64 position);
+    void recordTrackStart();
+    void startStdinReader();
+    bool selectPlaylist(const QString& name);
+    bool ensureLoaded(int index);
+    void playVideo(int index);
+    int getNextVideoIndex();
+    int getPreviousVideoIndex();
+    void setShuffleMode(bool enabled);
+    void resetShuffle();
+    void printStatus();
+    void printPlaylists();
+    void printTracks();
+    static void print(const QString& line);
+
+    QMediaPlayer* mediaPlayer;
+    QAudioOutput* audioOutput;
+    PlaylistStore* playlistStore;
+    QThread* stdinThread;
+
+    QList<Playlist> playlists;
+    QString lastPlaylistName;
+    int currentPlaylistIndex;
+    int currentVideoIndex;
+    bool isShuffleMode;
+    bool isRepeatMode;
+    int consecutiveErrors;     // 連續無法播放的曲目數，避免整份清單都壞掉時無限循環
+    ShuffleEngine shuffle;
+    QElapsedTimer trackStartTimer;       // playVideo() 到 BufferedMedia 或第一個位置更新
+    LatencyHistogram trackStartLatency;
+    FilePrefetcher prefetcher;
+};
+
+#endif // HEADLESSPLAYER_H
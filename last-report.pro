@@ -9,15 +9,75 @@ CONFIG += c++17
 #DEFINES += QT_DISABLE_DEPRECATED_BEFORE=0x060000    # disables all the APIs deprecated before Qt 6.0.0
 
 SOURCES += \
+    audiomixer.cpp \
+    audioringbuffer.cpp \
+    contenthasher.cpp \
+    coverartcache.cpp \
+    crossfadeplayer.cpp \
+    equalizer.cpp \
+    equalizerdialog.cpp \
+    fileprefetcher.cpp \
+    folderimporter.cpp \
+    headlessplayer.cpp \
+    latencyhistogram.cpp \
+    librarysearch.cpp \
+    loudnessanalyzer.cpp \
+    loudnessmeter.cpp \
     main.cpp \
-    widget.cpp
+    metadataextractor.cpp \
+    playlist.cpp \
+    playlistfileio.cpp \
+    playlistmodel.cpp \
+    playliststore.cpp \
+    shuffleengine.cpp \
+    spectrumanalyzer.cpp \
+    spectrumview.cpp \
+    tracing.cpp \
+    waveformcache.cpp \
+    waveformseekbar.cpp \
+    widget.cpp \
+    youtubelink.cpp
 
 HEADERS += \
-    widget.h
+    audiomixer.h \
+    audioringbuffer.h \
+    contenthasher.h \
+    coverartcache.h \
+    crossfadeplayer.h \
+    equalizer.h \
+    equalizerdialog.h \
+    fileprefetcher.h \
+    folderimporter.h \
+    headlessplayer.h \
+    latencyhistogram.h \
+    librarysearch.h \
+    loudnessanalyzer.h \
+    loudnessmeter.h \
+    metadataextractor.h \
+    playlist.h \
+    playlistfileio.h \
+    playlistmodel.h \
+    playliststore.h \
+    shuffleengine.h \
+    spectrumanalyzer.h \
+    spectrumview.h \
+    tracing.h \
+    waveformcache.h \
+    waveformseekbar.h \
+    widget.h \
+    youtubelink.h
 
 FORMS += \
     widget.ui
 
+# SQLite 音樂庫（Qt SQL 可用時啟用）
+qtHaveModule(sql) {
+    QT += sql
+    DEFINES += HAVE_SQLITE_STORE
+    SOURCES += librarystore.cpp
+    HEADERS += librarystore.h
+}
+
 # Default rules for deployment.
 qnx: target.path = /tmp/$${TARGET}/bin
 else: unix:!android: target.path = /opt/$${TARGET}/bin
@@ -0,0 +1,112 @@
+#include "latencyhistogram.h"
+#include <QJsonArray>
+#include <QStringList>
+
+LatencyHistogram::LatencyHistogram()
+{
+    clear();
+}
+
+void LatencyHistogram::clear()
+{
+    buckets.fill(0);
+    total = 0;
+    sumMs = 0;
+    maximum = 0;
+    last = -1;
+}
+
+int LatencyHistogram::bucketFor(qint64 ms)
+{
+    // 區間 0 為 <1 ms，區間 i 為 [2^(i-1), 2^i) ms，最後一個區間沒有上界
+    int bucket = 0;
+    while (ms > 0 && bucket < kBucketCount - 1) {
+        ms >>= 1;
+        bucket++;
+    }
+    return bucket;
+}
+
+qint64 LatencyHistogram::bucketUpperMs(int bucket)
+{
+    return qint64(1) << bucket;
+}
+
+void LatencyHistogram::record(qint64 ms)
+{
+    ms = qMax<qint64>(0, ms);
+    buckets[bucketFor(ms)]++;
+    total++;
+    sumMs += ms;
+    maximum = qMax(maximum, ms);
+    last = ms;
+}
+
+qint64 LatencyHistogram::percentileMs(double percentile) const
+{
+    if (total == 0) return 0;
+
+    const qint64 rank = qMax<qint64>(1, qint64(percentile / 100.0 * total + 0.5));
+    qint64 seen = 0;
+    for (int i = 0; i < kBucketCount; i++) {
+        seen += buckets[i];
+        if (seen >= rank) {
+            return qMin(bucketUpperMs(i), maximum);
+        }
+    }
+    return maximum;
+}
+
+QString LatencyHistogram::summary() const
+{
+    if (total == 0) return "尚無資料";
+    return QString("%1 次，平均 %2 ms，p50 ≤%3 ms，p90 ≤%4 ms，p99 ≤%5 ms，最大 %6 ms")
+        .arg(total)
+        .arg(meanMs(), 0, 'f', 0)
+        .arg(percentileMs(50))
+        .arg(percentileMs(90))
+        .arg(percentileMs(99))
+        .arg(maximum);
+}
+
+QString LatencyHistogram::toText() const
+{
+    QStringList lines;
+    lines << summary();
+    if (total == 0) return lines.join('\n');
+
+    qint64 largest = 0;
+    for (qint64 value : buckets) {
+        largest = qMax(largest, value);
+    }
+    for (int i = 0; i < kBucketCount; i++) {
+        if (buckets[i] == 0) continue;
+        QString range = i == 0 ? QString("<1 ms")
+                      : i == kBucketCount - 1 ? QString("≥%1 ms").arg(bucketUpperMs(i - 1))
+                      : QString("%1-%2 ms").arg(bucketUpperMs(i - 1)).arg(bucketUpperMs(i));
+        int width = int(buckets[i] * 20 / largest);
+        lines << QString("%1 %2 %3").arg(range, 12).arg(QString(qMax(1, width), QChar(0x2588))).arg(buckets[i]);
+    }
+    return lines.join('\n');
+}
+
+QJsonObject LatencyHistogram::toJson() const
+{
+    QJsonArray bucketArray;
+    for (int i = 0; i < kBucketCount; i++) {
+        QJsonObject bucket;
+        bucket["upperMs"] = i == kBucketCount - 1 ? QJsonValue() : QJsonValue(bucketUpperMs(i));
+        bucket["count"] = buckets[i];
+        bucketArray.append(bucket);
+    }
+
+    QJsonObject obj;
+    obj["count"] = total;
+    obj["meanMs"] = meanMs();
+    obj["p50Ms"] = percentileMs(50);
+    obj["p90Ms"] = percentileMs(90);
+    obj["p99Ms"] = percentileMs(99);
+    obj["maxMs"] = maximum;
+    obj["buckets"] = bucketArray;
+    return obj;
+}
@@ -0,0 +1,42 @@
+#ifndef LATENCYHISTOGRAM_H
+#define LATENCYHISTOGRAM_H
+
+#include <QString>
+#include <QJsonObject>
+#include <array>
+
+// 延遲直方圖：區間以 2 的次方毫秒劃分（<1、1-2、2-4 … ≥16384 ms）
+// 記錄是 O(1)，不保存個別樣本；百分位數回傳所在區間的上界
+class LatencyHistogram
+{
+public:
+    static const int kBucketCount = 16;
+
+    LatencyHistogram();
+
+    void record(qint64 ms);
+    void clear();
+
+    qint64 count() const { return total; }
+    qint64 lastMs() const { return last; }
+    qint64 maxMs() const { return maximum; }
+    double meanMs() const { return total > 0 ? double(sumMs) / total : 0.0; }
+    qint64 percentileMs(double percentile) const;
+
+    // 一行摘要與逐區間的文字長條圖（用於工具提示與無介面模式的 stats 指令）
+    QString summary() const;
+    QString toText() const;
+    QJsonObject toJson() const;
+
+private:
+    static int bucketFor(qint64 ms);
+    static qint64 bucketUpperMs(int bucket);
+
+    std::array<qint64, kBucketCount> buckets;
+    qint64 total;
+    qint64 sumMs;
+    qint64 maximum;
+    qint64 last;
+};
+
+#endif // LATENCYHISTOGRAM_H
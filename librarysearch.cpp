@@ -0,0 +1,336 @@
+#include "librarysearch.h"
+#include <QSet>
+#include <algorithm>
+#include <climits>
+#include <utility>
+
+namespace {
+bool isCjk(char32_t c)
+{
+    return (c >= 0x3040 && c <= 0x30FF)      // 平假名、片假名
+        || (c >= 0x3400 && c <= 0x4DBF)      // CJK 擴充 A
+        || (c >= 0x4E00 && c <= 0x9FFF)      // CJK 統一漢字
+        || (c >= 0xAC00 && c <= 0xD7AF)      // 韓文音節
+        || (c >= 0xF900 && c <= 0xFAFF)      // CJK 相容漢字
+        || (c >= 0x20000 && c <= 0x2FFFF);   // CJK 擴充 B 之後
+}
+
+bool isCjkSegment(const QString& segment)
+{
+    if (segment.isEmpty()) return false;
+    char32_t c = segment.at(0).isHighSurrogate() && segment.size() > 1
+        ? QChar::surrogateToUcs4(segment.at(0), segment.at(1))
+        : segment.at(0).unicode();
+    return isCjk(c);
+}
+
+const int kCompactMinDeadDocs = 4096;
+}
+
+LibrarySearch::LibrarySearch()
+    : deadDocs(0)
+    , epoch(0)
+    , generation(0)
+    , lastGeneration(0)
+{
+}
+
+QString LibrarySearch::normalize(const QString& text)
+{
+    const QString folded = text.normalized(QString::NormalizationForm_KC).toCaseFolded();
+
+    // 結果前後與片段之間都有空白：" 片段 片段 "
+    QString result;
+    result.reserve(folded.size() + 2);
+    result += QLatin1Char(' ');
+
+    enum Kind { Separator, Cjk, Word };
+    Kind previous = Separator;
+    const QList<uint> codePoints = folded.toUcs4();
+    for (uint c : codePoints) {
+        Kind kind = isCjk(c) ? Cjk : (QChar::isLetterOrNumber(c) ? Word : Separator);
+        if (kind == Separator) {
+            if (previous != Separator) {
+                result += QLatin1Char(' ');
+            }
+            previous = Separator;
+            continue;
+        }
+        if (previous != Separator && previous != kind) {
+            result += QLatin1Char(' ');
+        }
+        if (QChar::requiresSurrogates(c)) {
+            result += QChar(QChar::highSurrogate(c));
+            result += QChar(QChar::lowSurrogate(c));
+        } else {
+            result += QChar(char16_t(c));
+        }
+        previous = kind;
+    }
+    if (previous != Separator) {
+        result += QLatin1Char(' ');
+    }
+    return result;
+}
+
+quint32 LibrarySearch::addDoc(const QString& playlistName, const QString& key, const VideoInfo& video)
+{
+    const quint32 id = quint32(docs.size());
+
+    Doc doc;
+    doc.playlistName = playlistName;
+    doc.trackKey = key;
+    doc.title = video.title();
+    doc.channelTitle = video.channelTitle();
+    doc.text = normalize(video.title()) + normalize(video.channelTitle());
+    doc.alive = true;
+
+    // 同一份文件中重複的詞只記錄一次
+    QSet<QString> grams;
+    QSet<QString> words;
+    const QStringList segments = doc.text.split(QLatin1Char(' '), Qt::SkipEmptyParts);
+    for (const QString& segment : segments) {
+        if (!isCjkSegment(segment)) {
+            words.insert(segment);
+            continue;
+        }
+        const QList<uint> codePoints = segment.toUcs4();
+        for (int i = 0; i < codePoints.size(); i++) {
+            grams.insert(QString::fromUcs4(reinterpret_cast<const char32_t*>(&codePoints[i]), 1));
+            if (i + 1 < codePoints.size()) {
+                grams.insert(QString::fromUcs4(reinterpret_cast<const char32_t*>(&codePoints[i]), 2));
+            }
+        }
+    }
+    for (const QString& gram : std::as_const(grams)) {
+        gramPostings[gram].append(id);
+    }
+    for (const QString& word : std::as_const(words)) {
+        wordPostings[word].append(id);
+    }
+
+    docs.append(doc);
+    markEpoch.append(0);
+    generation++;
+    return id;
+}
+
+void LibrarySearch::removeDoc(quint32 id)
+{
+    // 只標記刪除；倒排串列中的編號在查詢時略過，累積夠多時再整理
+    Doc& doc = docs[id];
+    if (!doc.alive) return;
+    doc.alive = false;
+    doc.title.clear();
+    doc.channelTitle.clear();
+    doc.text.clear();
+    deadDocs++;
+    generation++;
+}
+
+void LibrarySearch::updatePlaylist(const QString& playlistName, const QList<VideoInfo>& videos)
+{
+    QHash<QString, QList<quint32>> previous = playlistDocs.take(playlistName);
+    QHash<QString, QList<quint32>> current;
+    current.reserve(videos.size());
+
+    for (const VideoInfo& video : videos) {
+        const QString key = trackKey(video);
+        bool reused = false;
+        quint32 id = 0;
+
+        auto it = previous.find(key);
+        if (it != previous.end() && !it->isEmpty()) {
+            id = it->takeLast();
+            const Doc& doc = docs[id];
+            if (doc.title == video.title() && doc.channelTitle == video.channelTitle()) {
+                reused = true;
+            } else {
+                removeDoc(id);
+            }
+        }
+        if (!reused) {
+            id = addDoc(playlistName, key, video);
+        }
+        current[key].append(id);
+    }
+
+    // 剩下的是已從播放清單移除的曲目
+    for (const QList<quint32>& ids : std::as_const(previous)) {
+        for (quint32 id : ids) {
+            removeDoc(id);
+        }
+    }
+    playlistDocs.insert(playlistName, current);
+
+    if (deadDocs > kCompactMinDeadDocs && deadDocs * 2 > docs.size()) {
+        compact();
+    }
+}
+
+void LibrarySearch::removePlaylist(const QString& playlistName)
+{
+    const QHash<QString, QList<quint32>> previous = playlistDocs.take(playlistName);
+    for (const QList<quint32>& ids : previous) {
+        for (quint32 id : ids) {
+            removeDoc(id);
+        }
+    }
+}
+
+bool LibrarySearch::hasPlaylist(const QString& playlistName) const
+{
+    return playlistDocs.contains(playlistName);
+}
+
+void LibrarySearch::compact()
+{
+    // 重新編號存活的文件並重建倒排串列
+    QList<Doc> oldDocs = std::move(docs);
+    docs.clear();
+    gramPostings.clear();
+    wordPostings.clear();
+    markEpoch.clear();
+    deadDocs = 0;
+
+    QList<quint32> remap(oldDocs.size(), UINT_MAX);
+    for (int i = 0; i < oldDocs.size(); i++) {
+        const Doc& doc = oldDocs[i];
+        if (!doc.alive) continue;
+        VideoInfo video;
+        video.setTitle(doc.title);
+        video.setChannelTitle(doc.channelTitle);
+        remap[i] = addDoc(doc.playlistName, doc.trackKey, video);
+    }
+
+    for (auto playlist = playlistDocs.begin(); playlist != playlistDocs.end(); ++playlist) {
+        for (auto entry = playlist->begin(); entry != playlist->end(); ++entry) {
+            for (quint32& id : *entry) {
+                id = remap[id];
+            }
+        }
+    }
+
+    lastQuery.clear();
+    lastResults.clear();
+}
+
+QList<LibrarySearch::Term> LibrarySearch::parseQuery(const QString& normalizedQuery)
+{
+    QList<Term> terms;
+    const QStringList segments = normalizedQuery.split(QLatin1Char(' '), Qt::SkipEmptyParts);
+    for (const QString& segment : segments) {
+        Term term;
+        term.cjk = isCjkSegment(segment);
+        // 一般單字以 " 前綴" 比對文件文字，確保從詞首開始
+        term.text = term.cjk ? segment : QLatin1Char(' ') + segment;
+        terms.append(term);
+    }
+    return terms;
+}
+
+bool LibrarySearch::matches(const Doc& doc, const QList<Term>& terms)
+{
+    if (!doc.alive) return false;
+    for (const Term& term : terms) {
+        if (!doc.text.contains(term.text)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+QList<quint32> LibrarySearch::search(const QString& query)
+{
+    const QString normalized = normalize(query);
+    const QString trimmed = normalized.trimmed();
+    if (trimmed.isEmpty()) {
+        lastQuery.clear();
+        lastResults.clear();
+        return {};
+    }
+
+    const QList<Term> terms = parseQuery(normalized);
+    QList<quint32> results;
+
+    if (!lastQuery.isEmpty() && generation == lastGeneration && trimmed.startsWith(lastQuery)) {
+        // 逐字輸入：新的結果一定是上一次結果的子集合
+        for (quint32 id : std::as_const(lastResults)) {
+            if (matches(docs[id], terms)) {
+                results.append(id);
+            }
+        }
+    } else {
+        // 每個詞對應一組倒排串列（前綴比對時為多組的聯集），取最小的一組作為候選
+        QList<const QList<quint32>*> bestLists;
+        qsizetype bestSize = -1;
+        for (const Term& term : terms) {
+            QList<const QList<quint32>*> lists;
+            qsizetype size = 0;
+            if (term.cjk) {
+                const QList<uint> codePoints = term.text.toUcs4();
+                int gramLength = codePoints.size() == 1 ? 1 : 2;
+                for (int i = 0; i + gramLength <= codePoints.size(); i++) {
+                    QString gram = QString::fromUcs4(reinterpret_cast<const char32_t*>(&codePoints[i]), gramLength);
+                    auto it = gramPostings.constFind(gram);
+                    if (it == gramPostings.constEnd()) {
+                        lists.clear();
+                        size = 0;
+                        break;
+                    }
+                    // 多個 bigram 都必須出現：取其中最短的一個
+                    if (lists.isEmpty() || it->size() < size) {
+                        lists = { &*it };
+                        size = it->size();
+                    }
+                }
+            } else {
+                const QString prefix = term.text.mid(1);
+                for (auto it = std::as_const(wordPostings).lowerBound(prefix);
+                     it != wordPostings.constEnd() && it.key().startsWith(prefix); ++it) {
+                    lists.append(&it.value());
+                    size += it->size();
+                }
+            }
+
+            if (lists.isEmpty()) {
+                lastQuery = trimmed;
+                lastResults.clear();
+                lastGeneration = generation;
+                return {};
+            }
+            if (bestSize < 0 || size < bestSize) {
+                bestLists = lists;
+                bestSize = size;
+            }
+        }
+
+        // 聯集時以世代編號去除重複，再逐一驗證所有詞
+        if (++epoch == 0) {
+            markEpoch.fill(0);
+            epoch = 1;
+        }
+        for (const QList<quint32>* list : std::as_const(bestLists)) {
+            for (quint32 id : *list) {
+                if (markEpoch[id] == epoch) continue;
+                markEpoch[id] = epoch;
+                if (matches(docs[id], terms)) {
+                    results.append(id);
+                }
+            }
+        }
+        std::sort(results.begin(), results.end());
+    }
+
+    lastQuery = trimmed;
+    lastResults = results;
+    lastGeneration = generation;
+    return results;
+}
+
+LibrarySearch::Hit LibrarySearch::hit(quint32 id) const
+{
+    if (id >= quint32(docs.size()) || !docs[id].alive) return Hit();
+    const Doc& doc = docs[id];
+    return Hit{ doc.playlistName, doc.trackKey, doc.title, doc.channelTitle };
+}
@@ -0,0 +1,82 @@
+#ifndef LIBRARYSEARCH_H
+#define LIBRARYSEARCH_H
+
+#include <QString>
+#include <QStringList>
+#include <QList>
+#include <QHash>
+#include <QMap>
+#include "playlist.h"
+
+// 音樂庫搜尋：title 與 channelTitle 的倒排索引，涵蓋所有播放清單
+// - 中日韓文字以單字與相鄰兩字（bigram）建立索引，不需要斷詞
+// - 其他文字以單字建立索引，查詢時以前綴比對，邊打字邊縮小範圍
+// - 以 trackKey 比對差異，只有新增、移除或改名的曲目才會重新建立索引
+class LibrarySearch
+{
+public:
+    struct Hit {
+        QString playlistName;
+        QString trackKey;
+        QString title;
+        QString channelTitle;
+    };
+
+    LibrarySearch();
+
+    // 以播放清單目前的內容更新索引
+    void updatePlaylist(const QString& playlistName, const QList<VideoInfo>& videos);
+    void removePlaylist(const QString& playlistName);
+    bool hasPlaylist(const QString& playlistName) const;
+
+    // 回傳所有符合的文件編號（依加入順序）
+    // 新的查詢以上一次的查詢為前綴時，只過濾上一次的結果
+    // 文件編號只在下一次更新索引前有效（壓縮時會重新編號），需要保留時改存 hit() 的內容
+    QList<quint32> search(const QString& query);
+
+    // 已移除或超出範圍的編號回傳空的 Hit（playlistName 為空）
+    Hit hit(quint32 doc) const;
+    int trackCount() const { return docs.size() - deadDocs; }
+
+    // 正規化：NFKC、大小寫摺疊，文字片段以空白分隔（中日韓連續文字為一個片段）
+    static QString normalize(const QString& text);
+
+private:
+    struct Doc {
+        QString playlistName;
+        QString trackKey;
+        QString title;
+        QString channelTitle;
+        QString text;          // 正規化後的 " title | channel "
+        bool alive;
+    };
+
+    struct Term {
+        QString text;
+        bool cjk;
+    };
+
+    quint32 addDoc(const QString& playlistName, const QString& key, const VideoInfo& video);
+    void removeDoc(quint32 doc);
+    void compact();
+    static QList<Term> parseQuery(const QString& normalizedQuery);
+    static bool matches(const Doc& doc, const QList<Term>& terms);
+
+    QList<Doc> docs;
+    int deadDocs;
+    QHash<QString, QList<quint32>> gramPostings;   // 中日韓單字/雙字 -> 文件
+    QMap<QString, QList<quint32>> wordPostings;    // 其他單字（有序，供前綴查詢）-> 文件
+    QHash<QString, QHash<QString, QList<quint32>>> playlistDocs;  // 播放清單 -> trackKey -> 文件
+
+    // 查詢時的暫存：以世代編號避免每次清空
+    QList<quint32> markEpoch;
+    quint32 epoch;
+
+    // 上一次的查詢，用於逐字縮小
+    QString lastQuery;
+    QList<quint32> lastResults;
+    quint64 generation;
+    quint64 lastGeneration;
+};
+
+#endif // LIBRARYSEARCH_H
@@ -0,0 +1,488 @@
+#include "librarystore.h"
+#include <QSqlQuery>
+#include <QVariant>
+#include <QSet>
+
+LibraryStore::LibraryStore(const QString& databasePath)
+    : databasePath(databasePath)
+    , connectionName(QString("last-report-library-%1").arg(reinterpret_cast<quintptr>(this)))
+{
+}
+
+LibraryStore::~LibraryStore()
+{
+    if (db.isValid()) {
+        db.close();
+        db = QSqlDatabase();
+        QSqlDatabase::removeDatabase(connectionName);
+    }
+}
+
+bool LibraryStore::open()
+{
+    if (isOpen()) return true;
+
+    db = QSqlDatabase::addDatabase("QSQLITE", connectionName);
+    db.setDatabaseName(databasePath);
+    if (!db.open()) {
+        return false;
+    }
+
+    // WAL 模式：寫入不阻塞讀取，且每次提交只追加變更的頁面
+    QSqlQuery pragma(db);
+    pragma.exec("PRAGMA journal_mode=WAL");
+    pragma.exec("PRAGMA synchronous=NORMAL");
+    pragma.exec("PRAGMA foreign_keys=ON");
+
+    return createSchema();
+}
+
+bool LibraryStore::isOpen() const
+{
+    return db.isValid() && db.isOpen();
+}
+
+bool LibraryStore::createSchema()
+{
+    const QStringList statements = {
+        "CREATE TABLE IF NOT EXISTS tracks ("
+        "   id INTEGER PRIMARY KEY,"
+        "   trackKey TEXT NOT NULL UNIQUE,"
+        "   videoId TEXT,"
+        "   filePath TEXT,"
+        "   title TEXT,"
+        "   channelTitle TEXT,"
+        "   thumbnailUrl TEXT,"
+        "   description TEXT,"
+        "   isLocalFile INTEGER NOT NULL DEFAULT 0"
+        ")",
+        "CREATE INDEX IF NOT EXISTS idx_tracks_videoId ON tracks(videoId)",
+        "CREATE INDEX IF NOT EXISTS idx_tracks_filePath ON tracks(filePath)",
+        "CREATE INDEX IF NOT EXISTS idx_tracks_title ON tracks(title)",
+        "CREATE TABLE IF NOT EXISTS playlists ("
+        "   id INTEGER PRIMARY KEY,"
+        "   name TEXT NOT NULL UNIQUE,"
+        "   position INTEGER NOT NULL"
+        ")",
+        "CREATE TABLE IF NOT EXISTS playlist_tracks ("
+        "   playlist_id INTEGER NOT NULL REFERENCES playlists(id) ON DELETE CASCADE,"
+        "   position INTEGER NOT NULL,"
+        "   track_id INTEGER NOT NULL REFERENCES tracks(id),"
+        "   isFavorite INTEGER NOT NULL DEFAULT 0,"
+        "   PRIMARY KEY (playlist_id, position)"
+        ") WITHOUT ROWID",
+        "CREATE INDEX IF NOT EXISTS idx_playlist_tracks_track ON playlist_tracks(track_id)",
+        "CREATE TABLE IF NOT EXISTS meta ("
+        "   key TEXT PRIMARY KEY,"
+        "   value TEXT"
+        ")"
+    };
+
+    QSqlQuery query(db);
+    for (const QString& statement : statements) {
+        if (!query.exec(statement)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool LibraryStore::hasPlaylists()
+{
+    if (!isOpen()) return false;
+
+    QSqlQuery query(db);
+    return query.exec("SELECT 1 FROM playlists LIMIT 1") && query.next();
+}
+
+size_t LibraryStore::fieldsHash(const VideoInfo& video)
+{
+    return qHashMulti(0, video.videoId(), video.filePath(), video.title(), video.channelTitle(),
+                      video.thumbnailUrl(), video.description(), video.isLocalFile());
+}
+
+bool LibraryStore::loadIndex(QList<Playlist>& playlists, QString& lastPlaylistName)
+{
+    if (!isOpen()) return false;
+
+    playlists.clear();
+    trackRows.clear();
+
+    // 只讀取播放清單名稱，曲目等到需要時才由 loadPlaylist() 解碼
+    QStringList names;
+    if (!reloadPlaylistRows(names)) {
+        return false;
+    }
+    for (const QString& name : names) {
+        Playlist playlist;
+        playlist.name = name;
+        playlist.loaded = false;
+        playlists.append(playlist);
+    }
+
+    QSqlQuery query(db);
+    if (query.exec("SELECT value FROM meta WHERE key = 'lastPlaylist'") && query.next()) {
+        storedLastPlaylist = query.value(0).toString();
+    } else {
+        storedLastPlaylist.clear();
+    }
+    lastPlaylistName = storedLastPlaylist;
+    return true;
+}
+
+bool LibraryStore::loadPlaylist(Playlist& playlist)
+{
+    if (!isOpen()) return false;
+
+    auto it = playlistRows.find(playlist.name);
+    if (it == playlistRows.end()) return false;
+
+    QSqlQuery query(db);
+    query.setForwardOnly(true);
+    query.prepare("SELECT pt.isFavorite, t.id, t.trackKey, t.videoId, t.filePath, t.title,"
+                  "       t.channelTitle, t.thumbnailUrl, t.description, t.isLocalFile"
+                  " FROM playlist_tracks pt JOIN tracks t ON t.id = pt.track_id"
+                  " WHERE pt.playlist_id = ? ORDER BY pt.position");
+    query.addBindValue(it->id);
+    if (!query.exec()) {
+        return false;
+    }
+
+    QList<VideoInfo> videos;
+    QList<MemberRow> members;
+    while (query.next()) {
+        VideoInfo video;
+        video.setFavorite(query.value(0).toBool());
+        video.setVideoId(query.value(3).toString());
+        video.setFilePath(query.value(4).toString());
+        video.setTitle(query.value(5).toString());
+        video.setChannelTitle(query.value(6).toString());
+        video.setThumbnailUrl(query.value(7).toString());
+        video.setDescription(query.value(8).toString());
+        video.setLocalFile(query.value(9).toBool());
+
+        qint64 trackId = query.value(1).toLongLong();
+        QString key = query.value(2).toString();
+        if (!trackRows.contains(key)) {
+            trackRows.insert(key, TrackRow{ trackId, fieldsHash(video) });
+        }
+        members.append(MemberRow{ trackId, video.isFavorite() });
+        videos.append(video);
+    }
+
+    it->members = members;
+    it->membersKnown = true;
+    playlist.videos = videos;
+    playlist.loaded = true;
+    return true;
+}
+
+void LibraryStore::releasePlaylist(const QString& playlistName)
+{
+    // 播放清單已從記憶體移出：丟棄成員快照，下次寫入時整批重寫
+    auto it = playlistRows.find(playlistName);
+    if (it != playlistRows.end()) {
+        it->members = QList<MemberRow>();
+        it->membersKnown = false;
+    }
+}
+
+bool LibraryStore::save(const QList<Playlist>& changedPlaylists, const QStringList& playlistOrder,
+                        const QString& lastPlaylistName)
+{
+    if (!isOpen()) return false;
+    if (!db.transaction()) return false;
+
+    bool ok = true;
+
+    // 刪除已不存在的播放清單（成員由 ON DELETE CASCADE 一併刪除）
+    const QSet<QString> names(playlistOrder.cbegin(), playlistOrder.cend());
+    QList<qint64> removedIds;
+    QSqlQuery query(db);
+    if (query.exec("SELECT id, name FROM playlists")) {
+        while (query.next()) {
+            QString name = query.value(1).toString();
+            if (!names.contains(name)) {
+                removedIds.append(query.value(0).toLongLong());
+                playlistRows.remove(name);
+            }
+        }
+    } else {
+        ok = false;
+    }
+    QSet<qint64> releasedTracks;   // 失去成員列的曲目，寫完後檢查是否還屬於任何播放清單
+    query.prepare("DELETE FROM playlists WHERE id = ?");
+    for (qint64 id : removedIds) {
+        if (!ok) break;
+        ok = selectMemberTracks(id, releasedTracks);
+        if (!ok) break;
+        query.addBindValue(id);
+        ok = query.exec();
+    }
+
+    // 變更過的播放清單比對成員；其他播放清單只更新順序
+    QSet<QString> written;
+    for (const Playlist& playlist : changedPlaylists) {
+        if (!ok) break;
+        int position = playlistOrder.indexOf(playlist.name);
+        if (position < 0) continue;
+        ok = writePlaylist(playlist, position, releasedTracks);
+        written.insert(playlist.name);
+    }
+    for (int i = 0; ok && i < playlistOrder.size(); i++) {
+        if (!written.contains(playlistOrder[i])) {
+            ok = writePosition(playlistOrder[i], i);
+        }
+    }
+
+    // 成員都已更新：這次失去成員、且不再屬於任何播放清單的曲目在同一個交易中刪除
+    if (ok) {
+        ok = deleteOrphanTracks(releasedTracks);
+    }
+
+    if (ok && lastPlaylistName != storedLastPlaylist) {
+        ok = writeMeta("lastPlaylist", lastPlaylistName);
+    }
+
+    if (ok && db.commit()) {
+        storedLastPlaylist = lastPlaylistName;
+        return true;
+    }
+
+    // 寫入失敗：回滾並丟棄快照，下次保存時會重新比對資料庫
+    db.rollback();
+    trackRows.clear();
+    QStringList names;
+    reloadPlaylistRows(names);
+    storedLastPlaylist.clear();
+    return false;
+}
+
+bool LibraryStore::reloadPlaylistRows(QStringList& names)
+{
+    playlistRows.clear();
+
+    QSqlQuery query(db);
+    query.setForwardOnly(true);
+    if (!query.exec("SELECT id, name, position FROM playlists ORDER BY position")) {
+        return false;
+    }
+    while (query.next()) {
+        QString name = query.value(1).toString();
+        playlistRows.insert(name, PlaylistRow{ query.value(0).toLongLong(), query.value(2).toInt(), {}, false });
+        names.append(name);
+    }
+    return true;
+}
+
+qint64 LibraryStore::writeTrack(const VideoInfo& video)
+{
+    const QString key = trackKey(video);
+    const size_t hash = fieldsHash(video);
+
+    qint64 id = -1;
+    auto it = trackRows.find(key);
+    if (it != trackRows.end()) {
+        if (it->fieldsHash == hash) {
+            return it->id;
+        }
+        id = it->id;
+    } else {
+        // 快照中沒有，可能是其他播放清單先前寫入的曲目
+        QSqlQuery select(db);
+        select.prepare("SELECT id FROM tracks WHERE trackKey = ?");
+        select.addBindValue(key);
+        if (select.exec() && select.next()) {
+            id = select.value(0).toLongLong();
+        }
+    }
+
+    QSqlQuery query(db);
+    if (id >= 0) {
+        query.prepare("UPDATE tracks SET videoId = ?, filePath = ?, title = ?, channelTitle = ?,"
+                      " thumbnailUrl = ?, description = ?, isLocalFile = ? WHERE id = ?");
+    } else {
+        query.prepare("INSERT INTO tracks (videoId, filePath, title, channelTitle, thumbnailUrl,"
+                      " description, isLocalFile, trackKey) VALUES (?, ?, ?, ?, ?, ?, ?, ?)");
+    }
+    query.addBindValue(video.videoId());
+    query.addBindValue(video.filePath());
+    query.addBindValue(video.title());
+    query.addBindValue(video.channelTitle());
+    query.addBindValue(video.thumbnailUrl());
+    query.addBindValue(video.description());
+    query.addBindValue(video.isLocalFile());
+    if (id >= 0) {
+        query.addBindValue(id);
+    } else {
+        query.addBindValue(key);
+    }
+    if (!query.exec()) {
+        return -1;
+    }
+    if (id < 0) {
+        id = query.lastInsertId().toLongLong();
+    }
+
+    trackRows.insert(key, TrackRow{ id, hash });
+    return id;
+}
+
+bool LibraryStore::selectMemberTracks(qint64 playlistId, QSet<qint64>& trackIds)
+{
+    QSqlQuery query(db);
+    query.setForwardOnly(true);
+    query.prepare("SELECT DISTINCT track_id FROM playlist_tracks WHERE playlist_id = ?");
+    query.addBindValue(playlistId);
+    if (!query.exec()) return false;
+    while (query.next()) {
+        trackIds.insert(query.value(0).toLongLong());
+    }
+    return true;
+}
+
+bool LibraryStore::deleteOrphanTracks(const QSet<qint64>& trackIds)
+{
+    // 只檢查這次失去成員的曲目，以 idx_playlist_tracks_track 查詢，不掃描整個 tracks 表
+    QSqlQuery select(db);
+    select.prepare("SELECT trackKey FROM tracks WHERE id = ?"
+                   " AND NOT EXISTS (SELECT 1 FROM playlist_tracks WHERE track_id = ?)");
+    QSqlQuery remove(db);
+    remove.prepare("DELETE FROM tracks WHERE id = ?");
+    for (qint64 id : trackIds) {
+        select.addBindValue(id);
+        select.addBindValue(id);
+        if (!select.exec()) return false;
+        if (!select.next()) continue;
+        const QString key = select.value(0).toString();
+        select.finish();
+
+        remove.addBindValue(id);
+        if (!remove.exec()) return false;
+        // 快照中其他曲目仍然有效
+        trackRows.remove(key);
+    }
+    return true;
+}
+
+bool LibraryStore::writePlaylist(const Playlist& playlist, int position, QSet<qint64>& releasedTracks)
+{
+    QSqlQuery query(db);
+
+    auto it = playlistRows.find(playlist.name);
+    if (it == playlistRows.end()) {
+        // 快照中沒有：新播放清單，或快照已失效
+        qint64 id = -1;
+        query.prepare("SELECT id FROM playlists WHERE name = ?");
+        query.addBindValue(playlist.name);
+        if (query.exec() && query.next()) {
+            id = query.value(0).toLongLong();
+            query.prepare("UPDATE playlists SET position = ? WHERE id = ?");
+            query.addBindValue(position);
+            query.addBindValue(id);
+            if (!query.exec()) return false;
+        } else {
+            query.prepare("INSERT INTO playlists (name, position) VALUES (?, ?)");
+            query.addBindValue(playlist.name);
+            query.addBindValue(position);
+            if (!query.exec()) return false;
+            id = query.lastInsertId().toLongLong();
+        }
+        it = playlistRows.insert(playlist.name, PlaylistRow{ id, position, {}, false });
+    } else if (it->position != position) {
+        query.prepare("UPDATE playlists SET position = ? WHERE id = ?");
+        query.addBindValue(position);
+        query.addBindValue(it->id);
+        if (!query.exec()) return false;
+        it->position = position;
+    }
+
+    // 成員快照未知時先清空，再整批寫入
+    if (!it->membersKnown) {
+        if (!selectMemberTracks(it->id, releasedTracks)) return false;
+        query.prepare("DELETE FROM playlist_tracks WHERE playlist_id = ?");
+        query.addBindValue(it->id);
+        if (!query.exec()) return false;
+        it->members.clear();
+        it->membersKnown = true;
+    }
+
+    QList<MemberRow> members;
+    members.reserve(playlist.videos.size());
+    for (const VideoInfo& video : playlist.videos) {
+        qint64 trackId = writeTrack(video);
+        if (trackId < 0) return false;
+        members.append(MemberRow{ trackId, video.isFavorite() });
+    }
+
+    // 只寫入有變化的位置
+    const qint64 playlistId = it->id;
+    const QList<MemberRow>& oldMembers = it->members;
+    const int common = qMin(oldMembers.size(), members.size());
+
+    query.prepare("UPDATE playlist_tracks SET track_id = ?, isFavorite = ?"
+                  " WHERE playlist_id = ? AND position = ?");
+    for (int i = 0; i < common; i++) {
+        if (oldMembers[i] == members[i]) continue;
+        if (oldMembers[i].trackId != members[i].trackId) {
+            releasedTracks.insert(oldMembers[i].trackId);
+        }
+        query.addBindValue(members[i].trackId);
+        query.addBindValue(members[i].isFavorite);
+        query.addBindValue(playlistId);
+        query.addBindValue(i);
+        if (!query.exec()) return false;
+    }
+
+    if (members.size() > common) {
+        query.prepare("INSERT INTO playlist_tracks (playlist_id, position, track_id, isFavorite)"
+                      " VALUES (?, ?, ?, ?)");
+        for (int i = common; i < members.size(); i++) {
+            query.addBindValue(playlistId);
+            query.addBindValue(i);
+            query.addBindValue(members[i].trackId);
+            query.addBindValue(members[i].isFavorite);
+            if (!query.exec()) return false;
+        }
+    } else if (oldMembers.size() > common) {
+        for (int i = common; i < oldMembers.size(); i++) {
+            releasedTracks.insert(oldMembers[i].trackId);
+        }
+        query.prepare("DELETE FROM playlist_tracks WHERE playlist_id = ? AND position >= ?");
+        query.addBindValue(playlistId);
+        query.addBindValue(common);
+        if (!query.exec()) return false;
+    }
+
+    it->members = members;
+    return true;
+}
+
+bool LibraryStore::writePosition(const QString& playlistName, int position)
+{
+    auto it = playlistRows.find(playlistName);
+    if (it != playlistRows.end() && it->position == position) {
+        return true;
+    }
+
+    QSqlQuery query(db);
+    query.prepare("UPDATE playlists SET position = ? WHERE name = ?");
+    query.addBindValue(position);
+    query.addBindValue(playlistName);
+    if (!query.exec()) return false;
+
+    if (it != playlistRows.end()) {
+        it->position = position;
+    }
+    return true;
+}
+
+bool LibraryStore::writeMeta(const QString& key, const QString& value)
+{
+    QSqlQuery query(db);
+    query.prepare("INSERT INTO meta (key, value) VALUES (?, ?)"
+                  " ON CONFLICT(key) DO UPDATE SET value = excluded.value");
+    query.addBindValue(key);
+    query.addBindValue(value);
+    return query.exec();
+}
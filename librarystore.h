@@ -0,0 +1,72 @@
+#ifndef LIBRARYSTORE_H
+#define LIBRARYSTORE_H
+
+#include <QString>
+#include <QList>
+#include <QStringList>
+#include <QHash>
+#include <QSet>
+#include <QSqlDatabase>
+#include "playlist.h"
+
+// SQLite 音樂庫儲存（tracks / playlists / playlist_tracks 三張表）
+// 保存時只寫入與上次載入或保存時不同的列
+class LibraryStore
+{
+public:
+    explicit LibraryStore(const QString& databasePath);
+    ~LibraryStore();
+
+    bool open();
+    bool isOpen() const;
+    bool hasPlaylists();
+
+    // 只載入播放清單名稱；曲目由 loadPlaylist() 按需解碼
+    bool loadIndex(QList<Playlist>& playlists, QString& lastPlaylistName);
+    bool loadPlaylist(Playlist& playlist);
+    void releasePlaylist(const QString& playlistName);
+    // 寫入變更過的播放清單，並依 playlistOrder 更新順序、刪除已移除的播放清單
+    bool save(const QList<Playlist>& changedPlaylists, const QStringList& playlistOrder,
+              const QString& lastPlaylistName);
+
+private:
+    // 上次寫入資料庫的狀態，用來計算差異
+    struct TrackRow {
+        qint64 id;
+        size_t fieldsHash;
+    };
+    struct MemberRow {
+        qint64 trackId;
+        bool isFavorite;
+
+        bool operator==(const MemberRow& other) const {
+            return trackId == other.trackId && isFavorite == other.isFavorite;
+        }
+        bool operator!=(const MemberRow& other) const { return !(*this == other); }
+    };
+    struct PlaylistRow {
+        qint64 id;
+        int position;
+        QList<MemberRow> members;
+        bool membersKnown;   // members 是否與資料庫一致
+    };
+
+    bool createSchema();
+    bool reloadPlaylistRows(QStringList& names);
+    qint64 writeTrack(const VideoInfo& video);
+    bool writePlaylist(const Playlist& playlist, int position, QSet<qint64>& releasedTracks);
+    bool selectMemberTracks(qint64 playlistId, QSet<qint64>& trackIds);
+    bool deleteOrphanTracks(const QSet<qint64>& trackIds);
+    bool writePosition(const QString& playlistName, int position);
+    bool writeMeta(const QString& key, const QString& value);
+    static size_t fieldsHash(const VideoInfo& video);
+
+    QString databasePath;
+    QString connectionName;
+    QSqlDatabase db;
+    QHash<QString, TrackRow> trackRows;        // trackKey -> 列
+    QHash<QString, PlaylistRow> playlistRows;  // 播放清單名稱 -> 列
+    QString storedLastPlaylist;
+};
+
+#endif // LIBRARYSTORE_H
@@ -0,0 +1,382 @@
+#include "loudnessanalyzer.h"
+#include <QThread>
+#include <QTimer>
+#include <QFileInfo>
+#include <QFile>
+#include <QSaveFile>
+#include <QDataStream>
+#include <QDateTime>
+#include <QUrl>
+#include <QAudioBuffer>
+#include <QAudioFormat>
+#include <QMutexLocker>
+#include <cmath>
+
+namespace {
+const quint32 kCacheMagic = 0x4C524C4E;   // "LRLN"
+const quint32 kCacheVersion = 1;
+}
+
+// === LoudnessWorker ===
+
+LoudnessWorker::LoudnessWorker(LoudnessAnalyzer* owner)
+    : owner(owner)
+    , decoder(nullptr)
+    , busy(false)
+    , currentSize(0)
+    , currentModified(0)
+    , sampleRate(0)
+    , channels(0)
+{
+}
+
+void LoudnessWorker::wake()
+{
+    // QAudioDecoder 必須在使用它的執行緒上建立
+    if (!decoder) {
+        decoder = new QAudioDecoder(this);
+
+        // 盡量直接取得 float 樣本；後端不支援時仍會照原格式送出，onBufferReady 會轉換
+        QAudioFormat format;
+        format.setSampleFormat(QAudioFormat::Float);
+        decoder->setAudioFormat(format);
+
+        connect(decoder, &QAudioDecoder::bufferReady, this, &LoudnessWorker::onBufferReady);
+        connect(decoder, &QAudioDecoder::finished, this, &LoudnessWorker::onFinished);
+        connect(decoder, QOverload<QAudioDecoder::Error>::of(&QAudioDecoder::error),
+                this, &LoudnessWorker::onError);
+    }
+
+    if (!busy) {
+        processNext();
+    }
+}
+
+void LoudnessWorker::processNext()
+{
+    QString filePath;
+    while (owner->takeJob(filePath)) {
+        // 每個檔案只做一次 stat；快取命中時不需要解碼
+        QFileInfo fileInfo(filePath);
+        if (!fileInfo.exists()) {
+            owner->skipJob();
+            continue;
+        }
+
+        qint64 size = fileInfo.size();
+        qint64 modified = fileInfo.lastModified().toMSecsSinceEpoch();
+        TrackLoudness cached;
+        if (owner->lookupCache(filePath, size, modified, cached)) {
+            owner->deliver(cached, size, modified, true);
+            continue;
+        }
+
+        busy = true;
+        currentPath = filePath;
+        currentSize = size;
+        currentModified = modified;
+        sampleRate = 0;
+        channels = 0;
+        decoder->setSource(QUrl::fromLocalFile(filePath));
+        decoder->start();
+        return;
+    }
+
+    busy = false;
+}
+
+void LoudnessWorker::onBufferReady()
+{
+    if (!busy) return;
+
+    const QAudioBuffer buffer = decoder->read();
+    if (!buffer.isValid()) return;
+
+    const QAudioFormat format = buffer.format();
+    const int frames = int(buffer.frameCount());
+    if (format.channelCount() <= 0 || format.sampleRate() <= 0 || frames <= 0) return;
+
+    // 第一個緩衝區決定濾波器係數；中途格式改變時重新開始量測
+    if (format.sampleRate() != sampleRate || format.channelCount() != channels) {
+        sampleRate = format.sampleRate();
+        channels = format.channelCount();
+        meter.reset(sampleRate, channels);
+    }
+
+    const qsizetype count = qsizetype(frames) * channels;
+    const float* data = nullptr;
+    if (format.sampleFormat() == QAudioFormat::Float) {
+        data = buffer.constData<float>();
+    } else {
+        samples.resize(count);
+        float* out = samples.data();
+        switch (format.sampleFormat()) {
+        case QAudioFormat::UInt8: {
+            const quint8* in = buffer.constData<quint8>();
+            for (qsizetype i = 0; i < count; i++) out[i] = (in[i] - 128) / 128.0f;
+            break;
+        }
+        case QAudioFormat::Int16: {
+            const qint16* in = buffer.constData<qint16>();
+            for (qsizetype i = 0; i < count; i++) out[i] = in[i] / 32768.0f;
+            break;
+        }
+        case QAudioFormat::Int32: {
+            const qint32* in = buffer.constData<qint32>();
+            for (qsizetype i = 0; i < count; i++) out[i] = in[i] / 2147483648.0f;
+            break;
+        }
+        default:
+            finishCurrent(false);
+            return;
+        }
+        data = out;
+    }
+
+    // 超過 kLanes 個聲道時只量測前面幾個
+    if (channels > LoudnessMeter::kLanes) {
+        samples.resize(qsizetype(frames) * LoudnessMeter::kLanes);
+        for (int frame = 0; frame < frames; frame++) {
+            for (int c = 0; c < LoudnessMeter::kLanes; c++) {
+                samples[frame * LoudnessMeter::kLanes + c] = data[frame * channels + c];
+            }
+        }
+        data = samples.constData();
+    }
+    meter.process(data, frames);
+}
+
+void LoudnessWorker::onFinished()
+{
+    finishCurrent(true);
+}
+
+void LoudnessWorker::onError(QAudioDecoder::Error error)
+{
+    Q_UNUSED(error);
+    finishCurrent(false);
+}
+
+void LoudnessWorker::finishCurrent(bool ok)
+{
+    if (!busy) return;
+    busy = false;
+    decoder->stop();
+
+    // 失敗的檔案也記錄下來，之後不再重複解碼
+    TrackLoudness loudness;
+    loudness.filePath = currentPath;
+    double lufs = 0.0;
+    if (ok && sampleRate > 0 && meter.integratedLoudness(lufs)) {
+        loudness.valid = true;
+        loudness.integratedLufs = float(lufs);
+        loudness.samplePeak = meter.samplePeak();
+    }
+    samples.clear();
+
+    owner->deliver(loudness, currentSize, currentModified, false);
+    processNext();
+}
+
+// === LoudnessAnalyzer ===
+
+LoudnessAnalyzer::LoudnessAnalyzer(const QString& cacheDir, QObject* parent)
+    : QObject(parent)
+    , cacheDir(cacheDir)
+    , cacheDirty(false)
+    , activeJobs(0)
+{
+    loadCache();
+
+    flushTimer = new QTimer(this);
+    flushTimer->setInterval(200);
+    connect(flushTimer, &QTimer::timeout, this, &LoudnessAnalyzer::flushResults);
+
+    // 整首解碼很重：最多兩個執行緒，以最低優先權執行，不與播放搶 CPU
+    int workerCount = qBound(1, QThread::idealThreadCount() / 4, 2);
+    for (int i = 0; i < workerCount; i++) {
+        QThread* thread = new QThread(this);
+        LoudnessWorker* worker = new LoudnessWorker(this);
+        worker->moveToThread(thread);
+        connect(thread, &QThread::finished, worker, &QObject::deleteLater);
+        thread->start(QThread::LowestPriority);
+        threads.append(thread);
+        workers.append(worker);
+    }
+}
+
+LoudnessAnalyzer::~LoudnessAnalyzer()
+{
+    {
+        QMutexLocker locker(&mutex);
+        jobs.clear();
+    }
+    for (QThread* thread : std::as_const(threads)) {
+        thread->quit();
+    }
+    for (QThread* thread : std::as_const(threads)) {
+        thread->wait();
+    }
+    if (cacheDirty) {
+        saveCache();
+    }
+}
+
+void LoudnessAnalyzer::request(const QStringList& filePaths, bool urgent)
+{
+    int added = 0;
+    {
+        QMutexLocker locker(&mutex);
+        for (const QString& filePath : filePaths) {
+            if (filePath.isEmpty()) continue;
+            if (requested.contains(filePath)) {
+                // 還在佇列中的檔案可以提前
+                if (urgent && jobs.removeOne(filePath)) {
+                    jobs.prepend(filePath);
+                }
+                continue;
+            }
+            requested.insert(filePath);
+            if (urgent) {
+                jobs.prepend(filePath);
+            } else {
+                jobs.enqueue(filePath);
+            }
+            added++;
+        }
+    }
+    if (added == 0) return;
+
+    for (LoudnessWorker* worker : std::as_const(workers)) {
+        QMetaObject::invokeMethod(worker, [worker]() { worker->wake(); }, Qt::QueuedConnection);
+    }
+    if (!flushTimer->isActive()) {
+        flushTimer->start();
+    }
+}
+
+bool LoudnessAnalyzer::lookup(const QString& filePath, TrackLoudness& loudness)
+{
+    QFileInfo fileInfo(filePath);
+    return lookupCache(filePath, fileInfo.size(), fileInfo.lastModified().toMSecsSinceEpoch(), loudness);
+}
+
+float LoudnessAnalyzer::gainDbFor(const TrackLoudness& loudness, float baseVolume)
+{
+    if (!loudness.valid) return 0.0f;
+
+    float gainDb = qBound(-kMaxGainDb, kTargetLufs - loudness.integratedLufs, kMaxGainDb);
+
+    // 只在放大時限制：輸出音量 × 峰值不超過 1，避免削波
+    if (loudness.samplePeak > 0.0f && baseVolume > 0.0f) {
+        const float headroomDb = -20.0f * std::log10(loudness.samplePeak * baseVolume);
+        gainDb = qMin(gainDb, qMax(0.0f, headroomDb));
+    }
+    return gainDb;
+}
+
+bool LoudnessAnalyzer::takeJob(QString& filePath)
+{
+    QMutexLocker locker(&mutex);
+    if (jobs.isEmpty()) return false;
+
+    filePath = jobs.dequeue();
+    activeJobs++;
+    return true;
+}
+
+void LoudnessAnalyzer::skipJob()
+{
+    QMutexLocker locker(&mutex);
+    activeJobs--;
+}
+
+bool LoudnessAnalyzer::lookupCache(const QString& filePath, qint64 size, qint64 modified,
+                                   TrackLoudness& loudness)
+{
+    QMutexLocker locker(&mutex);
+    auto it = cache.constFind(filePath);
+    if (it == cache.constEnd() || it->size != size || it->modified != modified) {
+        return false;
+    }
+    loudness = it->loudness;
+    loudness.filePath = filePath;
+    return true;
+}
+
+void LoudnessAnalyzer::deliver(const TrackLoudness& loudness, qint64 size, qint64 modified, bool fromCache)
+{
+    QMutexLocker locker(&mutex);
+    activeJobs--;
+    if (!fromCache) {
+        cache.insert(loudness.filePath, CacheEntry{ size, modified, loudness });
+        cacheDirty = true;
+    }
+    pendingResults.append(loudness);
+}
+
+void LoudnessAnalyzer::flushResults()
+{
+    QList<TrackLoudness> results;
+    bool idle = false;
+    bool needsSave = false;
+    {
+        QMutexLocker locker(&mutex);
+        results.swap(pendingResults);
+        idle = jobs.isEmpty() && activeJobs == 0;
+        needsSave = idle && cacheDirty;
+    }
+
+    if (!results.isEmpty()) {
+        emit loudnessReady(results);
+    }
+
+    // 佇列處理完畢：停止輪詢並寫入快取
+    if (idle) {
+        flushTimer->stop();
+        if (needsSave) {
+            saveCache();
+        }
+    }
+}
+
+void LoudnessAnalyzer::loadCache()
+{
+    QFile file(cacheDir + "/loudness_cache.dat");
+    if (!file.open(QIODevice::ReadOnly)) return;
+
+    QDataStream in(&file);
+    in.setVersion(QDataStream::Qt_6_0);
+    quint32 magic = 0;
+    quint32 version = 0;
+    qint32 count = 0;
+    in >> magic >> version >> count;
+    if (magic != kCacheMagic || version != kCacheVersion || count < 0) return;
+
+    cache.reserve(count);
+    for (qint32 i = 0; i < count && in.status() == QDataStream::Ok; i++) {
+        CacheEntry entry;
+        in >> entry.loudness.filePath >> entry.size >> entry.modified
+           >> entry.loudness.valid >> entry.loudness.integratedLufs >> entry.loudness.samplePeak;
+        cache.insert(entry.loudness.filePath, entry);
+    }
+}
+
+void LoudnessAnalyzer::saveCache()
+{
+    QMutexLocker locker(&mutex);
+
+    QSaveFile file(cacheDir + "/loudness_cache.dat");
+    if (!file.open(QIODevice::WriteOnly)) return;
+
+    QDataStream out(&file);
+    out.setVersion(QDataStream::Qt_6_0);
+    out << kCacheMagic << kCacheVersion << qint32(cache.size());
+    for (const CacheEntry& entry : std::as_const(cache)) {
+        out << entry.loudness.filePath << entry.size << entry.modified
+            << entry.loudness.valid << entry.loudness.integratedLufs << entry.loudness.samplePeak;
+    }
+    if (file.commit()) {
+        cacheDirty = false;
+    }
+}
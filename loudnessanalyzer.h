@@ -0,0 +1,116 @@
+#ifndef LOUDNESSANALYZER_H
+#define LOUDNESSANALYZER_H
+
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QList>
+#include <QHash>
+#include <QSet>
+#include <QQueue>
+#include <QMutex>
+#include <QAudioDecoder>
+#include "loudnessmeter.h"
+
+class QThread;
+class QTimer;
+
+// 一個本地檔案的響度分析結果
+struct TrackLoudness {
+    QString filePath;
+    bool valid = false;               // 無法解碼或整首靜音時為 false
+    float integratedLufs = 0.0f;
+    float samplePeak = 0.0f;          // 0..1
+};
+
+class LoudnessAnalyzer;
+
+// 工作執行緒：以 QAudioDecoder 解碼整首歌並送進 LoudnessMeter
+class LoudnessWorker : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit LoudnessWorker(LoudnessAnalyzer* owner);
+
+    // 在工作執行緒上呼叫：若閒置則開始處理佇列
+    void wake();
+
+private:
+    void processNext();
+    void onBufferReady();
+    void onFinished();
+    void onError(QAudioDecoder::Error error);
+    void finishCurrent(bool ok);
+
+    LoudnessAnalyzer* owner;
+    QAudioDecoder* decoder;
+    bool busy;
+    QString currentPath;
+    qint64 currentSize;
+    qint64 currentModified;
+    LoudnessMeter meter;
+    int sampleRate;
+    int channels;
+    QList<float> samples;             // 轉換成 float 的交錯樣本，重複使用
+};
+
+// 背景響度分析（EBU R128）：低優先權的工作執行緒 + 以 路徑/大小/修改時間 為鍵的持久快取
+// 快取檔與標籤快取放在同一個目錄；結果每隔一小段時間成批送回 GUI 執行緒
+class LoudnessAnalyzer : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit LoudnessAnalyzer(const QString& cacheDir, QObject* parent = nullptr);
+    ~LoudnessAnalyzer();
+
+    // 要求分析（同一個路徑在本次執行中只處理一次）；urgent 的檔案排到佇列最前面
+    void request(const QStringList& filePaths, bool urgent = false);
+
+    // GUI 執行緒查詢：快取中有且檔案未變更時回傳 true
+    bool lookup(const QString& filePath, TrackLoudness& loudness);
+
+    // 標準化增益（dB）：拉到目標響度，限制在 ±kMaxGainDb 內，且放大後峰值不超過 1/baseVolume
+    static float gainDbFor(const TrackLoudness& loudness, float baseVolume);
+
+    static constexpr float kTargetLufs = -18.0f;   // 與 ReplayGain 2.0 相同的參考響度
+    static constexpr float kMaxGainDb = 12.0f;
+
+signals:
+    void loudnessReady(const QList<TrackLoudness>& results);
+
+private:
+    friend class LoudnessWorker;
+
+    struct CacheEntry {
+        qint64 size;
+        qint64 modified;
+        TrackLoudness loudness;
+    };
+
+    // 以下函式由工作執行緒呼叫，受 mutex 保護
+    bool takeJob(QString& filePath);
+    void skipJob();
+    bool lookupCache(const QString& filePath, qint64 size, qint64 modified, TrackLoudness& loudness);
+    void deliver(const TrackLoudness& loudness, qint64 size, qint64 modified, bool fromCache);
+
+    void flushResults();
+    void loadCache();
+    void saveCache();
+
+    QString cacheDir;
+    QMutex mutex;
+    QQueue<QString> jobs;
+    QSet<QString> requested;
+    QHash<QString, CacheEntry> cache;
+    QList<TrackLoudness> pendingResults;
+    bool cacheDirty;
+    int activeJobs;
+
+    QList<QThread*> threads;
+    QList<LoudnessWorker*> workers;
+    QTimer* flushTimer;
+};
+
+#endif // LOUDNESSANALYZER_H
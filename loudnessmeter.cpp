@@ -0,0 +1,174 @@
+#include "loudnessmeter.h"
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+
+namespace {
+const double kAbsoluteGateLufs = -70.0;
+const double kRelativeGateLu = -10.0;
+const int kSubBlocksPerBlock = 4;     // 400 ms 區塊，75% 重疊
+
+inline double energyToLufs(double energy)
+{
+    return -0.691 + 10.0 * std::log10(energy);
+}
+}
+
+LoudnessMeter::LoudnessMeter()
+{
+    reset(48000, 2);
+}
+
+void LoudnessMeter::reset(int newSampleRate, int newChannels)
+{
+    sampleRate = qMax(1, newSampleRate);
+    channels = qBound(1, newChannels, kLanes);
+    subBlockFrames = qMax(1, sampleRate / 10);
+    subBlockFill = 0;
+    totalFrames = 0;
+    subBlocks.clear();
+
+    // BS.1770 的 K 加權係數依取樣率重新計算（48 kHz 時與標準表格相同）
+    const double pi = 3.14159265358979323846;
+    {
+        const double f0 = 1681.974450955533;
+        const double gainDb = 3.999843853973347;
+        const double q = 0.7071752369554196;
+        const double k = std::tan(pi * f0 / sampleRate);
+        const double vh = std::pow(10.0, gainDb / 20.0);
+        const double vb = std::pow(vh, 0.4996667741545416);
+        const double a0 = 1.0 + k / q + k * k;
+        shelfB0 = float((vh + vb * k / q + k * k) / a0);
+        shelfB1 = float(2.0 * (k * k - vh) / a0);
+        shelfB2 = float((vh - vb * k / q + k * k) / a0);
+        shelfA1 = float(2.0 * (k * k - 1.0) / a0);
+        shelfA2 = float((1.0 - k / q + k * k) / a0);
+    }
+    {
+        const double f0 = 38.13547087602444;
+        const double q = 0.5003270373238773;
+        const double k = std::tan(pi * f0 / sampleRate);
+        const double a0 = 1.0 + k / q + k * k;
+        passB0 = 1.0f;
+        passB1 = -2.0f;
+        passB2 = 1.0f;
+        passA1 = float(2.0 * (k * k - 1.0) / a0);
+        passA2 = float((1.0 - k / q + k * k) / a0);
+    }
+
+    // 聲道權重：5.0/5.1 的環繞聲道 +1.5 dB，LFE 不計；沒有的聲道權重為 0
+    for (int c = 0; c < kLanes; c++) {
+        float weight = c < channels ? 1.0f : 0.0f;
+        if (channels == 5 && (c == 3 || c == 4)) weight = 1.41f;
+        if (channels == 6 && c == 3) weight = 0.0f;
+        if (channels == 6 && (c == 4 || c == 5)) weight = 1.41f;
+        weights[c] = weight;
+    }
+    std::memset(shelfS1, 0, sizeof(shelfS1));
+    std::memset(shelfS2, 0, sizeof(shelfS2));
+    std::memset(passS1, 0, sizeof(passS1));
+    std::memset(passS2, 0, sizeof(passS2));
+    std::memset(energy, 0, sizeof(energy));
+    std::memset(peak, 0, sizeof(peak));
+}
+
+void LoudnessMeter::process(const float* interleaved, qint64 frames)
+{
+    alignas(32) float x[kLanes] = {};
+    while (frames > 0) {
+        const int chunk = int(std::min<qint64>(frames, subBlockFrames - subBlockFill));
+        for (int frame = 0; frame < chunk; frame++) {
+            for (int c = 0; c < channels; c++) {
+                x[c] = interleaved[c];
+            }
+            interleaved += channels;
+
+            // 固定 kLanes 個通道、沒有分支：一個畫格的所有聲道一起算
+            for (int c = 0; c < kLanes; c++) {
+                const float in = x[c];
+                peak[c] = std::max(peak[c], std::fabs(in));
+
+                const float shelved = shelfB0 * in + shelfS1[c];
+                shelfS1[c] = shelfB1 * in - shelfA1 * shelved + shelfS2[c];
+                shelfS2[c] = shelfB2 * in - shelfA2 * shelved;
+
+                const float weighted = passB0 * shelved + passS1[c];
+                passS1[c] = passB1 * shelved - passA1 * weighted + passS2[c];
+                passS2[c] = passB2 * shelved - passA2 * weighted;
+
+                energy[c] += weighted * weighted;
+            }
+        }
+        frames -= chunk;
+        totalFrames += chunk;
+        subBlockFill += chunk;
+        if (subBlockFill == subBlockFrames) {
+            finishSubBlock();
+        }
+    }
+}
+
+void LoudnessMeter::finishSubBlock()
+{
+    double sum = 0.0;
+    for (int c = 0; c < kLanes; c++) {
+        sum += double(weights[c]) * energy[c];
+        energy[c] = 0.0f;
+
+        // 靜音段落的濾波器狀態會衰減成次正規數，計算非常慢；直接歸零
+        if (std::fabs(shelfS1[c]) < 1e-15f) shelfS1[c] = 0.0f;
+        if (std::fabs(shelfS2[c]) < 1e-15f) shelfS2[c] = 0.0f;
+        if (std::fabs(passS1[c]) < 1e-15f) passS1[c] = 0.0f;
+        if (std::fabs(passS2[c]) < 1e-15f) passS2[c] = 0.0f;
+    }
+    subBlocks.append(sum / subBlockFrames);
+    subBlockFill = 0;
+}
+
+bool LoudnessMeter::integratedLoudness(double& lufs) const
+{
+    // 每個 400 ms 區塊是連續四個 100 ms 子區塊的平均
+    const qsizetype blockCount = subBlocks.size() - kSubBlocksPerBlock + 1;
+    if (blockCount <= 0) return false;
+
+    QList<double> blocks;
+    blocks.reserve(blockCount);
+    double window = 0.0;
+    for (qsizetype i = 0; i < subBlocks.size(); i++) {
+        window += subBlocks[i];
+        if (i >= kSubBlocksPerBlock) window -= subBlocks[i - kSubBlocksPerBlock];
+        if (i >= kSubBlocksPerBlock - 1) blocks.append(qMax(0.0, window / kSubBlocksPerBlock));
+    }
+
+    auto gatedMean = [&](double gateLufs, double& mean) {
+        double sum = 0.0;
+        qsizetype count = 0;
+        for (double block : std::as_const(blocks)) {
+            if (block > 0.0 && energyToLufs(block) > gateLufs) {
+                sum += block;
+                count++;
+            }
+        }
+        if (count == 0) return false;
+        mean = sum / count;
+        return true;
+    };
+
+    double absoluteMean = 0.0;
+    if (!gatedMean(kAbsoluteGateLufs, absoluteMean)) return false;
+    const double relativeGate = energyToLufs(absoluteMean) + kRelativeGateLu;
+
+    double relativeMean = 0.0;
+    if (!gatedMean(qMax(kAbsoluteGateLufs, relativeGate), relativeMean)) return false;
+    lufs = energyToLufs(relativeMean);
+    return true;
+}
+
+float LoudnessMeter::samplePeak() const
+{
+    float result = 0.0f;
+    for (int c = 0; c < kLanes; c++) {
+        result = std::max(result, peak[c]);
+    }
+    return result;
+}
@@ -0,0 +1,53 @@
+#ifndef LOUDNESSMETER_H
+#define LOUDNESSMETER_H
+
+#include <QtGlobal>
+#include <QList>
+
+// EBU R128 / ITU-R BS.1770 整合響度
+// K 加權（高架 + 高通兩級雙二階濾波器）後，以 400 ms 區塊（每 100 ms 一塊）計算均方值，
+// 再經過 -70 LUFS 絕對閘與 -10 LU 相對閘
+// 各聲道放在固定寬度的陣列中同步處理，內層迴圈沒有分支，編譯器可向量化為 SSE/AVX
+class LoudnessMeter
+{
+public:
+    static const int kLanes = 8;      // 最多處理的聲道數
+
+    LoudnessMeter();
+
+    void reset(int sampleRate, int channels);
+
+    // 交錯排列的 float 樣本（-1..1），可分多次送入
+    void process(const float* interleaved, qint64 frames);
+
+    // 整合響度（LUFS）；沒有任何區塊超過絕對閘（靜音或太短）時回傳 false
+    bool integratedLoudness(double& lufs) const;
+    float samplePeak() const;
+    qint64 framesProcessed() const { return totalFrames; }
+
+private:
+    void finishSubBlock();
+
+    int sampleRate;
+    int channels;
+    int subBlockFrames;               // 100 ms
+    int subBlockFill;
+    qint64 totalFrames;
+
+    // 兩級濾波器係數，所有聲道相同
+    float shelfB0, shelfB1, shelfB2, shelfA1, shelfA2;
+    float passB0, passB1, passB2, passA1, passA2;
+
+    // 每個聲道一條通道（lane），轉置直接 II 型的狀態
+    alignas(32) float shelfS1[kLanes];
+    alignas(32) float shelfS2[kLanes];
+    alignas(32) float passS1[kLanes];
+    alignas(32) float passS2[kLanes];
+    alignas(32) float weights[kLanes];
+    alignas(32) float energy[kLanes]; // 目前 100 ms 子區塊的加權平方和
+    alignas(32) float peak[kLanes];
+
+    QList<double> subBlocks;          // 每 100 ms 的加權均方值
+};
+
+#endif // LOUDNESSMETER_H
@@ -1,11 +1,32 @@
 #include "widget.h"
+#include "headlessplayer.h"
+#include "tracing.h"
 
 #include <QApplication>
+#include <QCoreApplication>
 
 int main(int argc, char *argv[])
 {
+    // 設定 LAST_REPORT_TRACE 時記錄啟動與熱點路徑；最後解構，涵蓋視窗關閉時的保存
+    TraceSession traceSession;
+
+    // --headless：不建立任何視窗元件，只以 QCoreApplication 執行播放邏輯
+    for (int i = 1; i < argc; i++) {
+        if (qstrcmp(argv[i], "--headless") == 0) {
+            QCoreApplication app(argc, argv);
+            HeadlessPlayer player;
+            if (!player.start(app.arguments())) {
+                return 2;
+            }
+            return app.exec();
+        }
+    }
+
     QApplication a(argc, argv);
     Widget w;
-    w.show();
+    {
+        TRACE_SCOPE("Widget::show");
+        w.show();
+    }
     return a.exec();
 }
@@ -0,0 +1,323 @@
+#include "metadataextractor.h"
+#include <QThread>
+#include <QTimer>
+#include <QDir>
+#include <QFileInfo>
+#include <QFile>
+#include <QSaveFile>
+#include <QDataStream>
+#include <QDateTime>
+#include <QImage>
+#include <QUrl>
+#include <QMediaMetaData>
+#include <QCryptographicHash>
+#include <QMutexLocker>
+
+namespace {
+const quint32 kCacheMagic = 0x4C524D44;   // "LRMD"
+const quint32 kCacheVersion = 1;
+const int kLoadTimeoutMs = 5000;
+const int kCoverMaxSize = 512;
+}
+
+// === MetadataWorker ===
+
+MetadataWorker::MetadataWorker(MetadataExtractor* owner)
+    : owner(owner)
+    , player(nullptr)
+    , timeoutTimer(nullptr)
+    , busy(false)
+    , currentSize(0)
+    , currentModified(0)
+{
+}
+
+void MetadataWorker::wake()
+{
+    // QMediaPlayer 必須在使用它的執行緒上建立
+    if (!player) {
+        player = new QMediaPlayer(this);
+        connect(player, &QMediaPlayer::mediaStatusChanged, this, &MetadataWorker::onMediaStatusChanged);
+
+        timeoutTimer = new QTimer(this);
+        timeoutTimer->setSingleShot(true);
+        timeoutTimer->setInterval(kLoadTimeoutMs);
+        connect(timeoutTimer, &QTimer::timeout, this, &MetadataWorker::finishCurrent);
+    }
+
+    if (!busy) {
+        processNext();
+    }
+}
+
+void MetadataWorker::processNext()
+{
+    QString filePath;
+    while (owner->takeJob(filePath)) {
+        // 每個檔案只做一次 stat；快取命中時不需要解析
+        QFileInfo fileInfo(filePath);
+        if (!fileInfo.exists()) {
+            owner->skipJob();
+            continue;
+        }
+
+        qint64 size = fileInfo.size();
+        qint64 modified = fileInfo.lastModified().toMSecsSinceEpoch();
+        TrackMetadata cached;
+        if (owner->lookupCache(filePath, size, modified, cached)) {
+            owner->deliver(cached, size, modified, true);
+            continue;
+        }
+
+        busy = true;
+        currentPath = filePath;
+        currentSize = size;
+        currentModified = modified;
+        timeoutTimer->start();
+        player->setSource(QUrl::fromLocalFile(filePath));
+        return;
+    }
+
+    busy = false;
+}
+
+void MetadataWorker::onMediaStatusChanged(QMediaPlayer::MediaStatus status)
+{
+    if (!busy) return;
+
+    if (status == QMediaPlayer::LoadedMedia || status == QMediaPlayer::BufferedMedia ||
+        status == QMediaPlayer::InvalidMedia) {
+        finishCurrent();
+    }
+}
+
+void MetadataWorker::finishCurrent()
+{
+    if (!busy) return;
+    timeoutTimer->stop();
+
+    TrackMetadata metadata;
+    metadata.filePath = currentPath;
+
+    QMediaPlayer::MediaStatus status = player->mediaStatus();
+    if (status == QMediaPlayer::LoadedMedia || status == QMediaPlayer::BufferedMedia) {
+        QMediaMetaData data = player->metaData();
+        metadata.title = data.stringValue(QMediaMetaData::Title);
+        metadata.artist = data.stringValue(QMediaMetaData::ContributingArtist);
+        if (metadata.artist.isEmpty()) {
+            metadata.artist = data.stringValue(QMediaMetaData::AlbumArtist);
+        }
+        metadata.album = data.stringValue(QMediaMetaData::AlbumTitle);
+        metadata.durationMs = data.value(QMediaMetaData::Duration).toLongLong();
+        if (metadata.durationMs <= 0) {
+            metadata.durationMs = player->duration();
+        }
+
+        // 內嵌封面縮小後另存，之後不必再解析檔案
+        QImage cover = data.value(QMediaMetaData::CoverArtImage).value<QImage>();
+        if (cover.isNull()) {
+            cover = data.value(QMediaMetaData::ThumbnailImage).value<QImage>();
+        }
+        if (!cover.isNull()) {
+            if (cover.width() > kCoverMaxSize || cover.height() > kCoverMaxSize) {
+                cover = cover.scaled(kCoverMaxSize, kCoverMaxSize, Qt::KeepAspectRatio, Qt::SmoothTransformation);
+            }
+            // 以圖片內容命名：同一張專輯封面只存一份，縮圖快取也共用；已存在時不再編碼
+            QCryptographicHash hasher(QCryptographicHash::Sha1);
+            hasher.addData(QByteArray::fromRawData(reinterpret_cast<const char*>(cover.constBits()),
+                                                   cover.sizeInBytes()));
+            QString coverPath = owner->coverDir() + "/" + QString::fromLatin1(hasher.result().toHex()) + ".jpg";
+            if (QFileInfo::exists(coverPath)) {
+                metadata.coverPath = coverPath;
+            } else {
+                // 其他工作執行緒可能同時寫入同一張封面：寫完再換名
+                QSaveFile file(coverPath);
+                if (file.open(QIODevice::WriteOnly) && cover.save(&file, "JPG", 90) && file.commit()) {
+                    metadata.coverPath = coverPath;
+                }
+            }
+        }
+    }
+
+    // 先清除狀態再卸載來源，卸載時的狀態信號會被忽略
+    busy = false;
+    player->setSource(QUrl());
+
+    owner->deliver(metadata, currentSize, currentModified, false);
+    processNext();
+}
+
+// === MetadataExtractor ===
+
+MetadataExtractor::MetadataExtractor(const QString& cacheDir, QObject* parent)
+    : QObject(parent)
+    , cacheDir(cacheDir)
+    , cacheDirty(false)
+    , activeJobs(0)
+{
+    QDir().mkpath(coverDir());
+    loadCache();
+
+    flushTimer = new QTimer(this);
+    flushTimer->setInterval(200);
+    connect(flushTimer, &QTimer::timeout, this, &MetadataExtractor::flushResults);
+
+    // 解析媒體檔案較重，使用一半的核心，以低優先權執行
+    int workerCount = qBound(2, QThread::idealThreadCount() / 2, 4);
+    for (int i = 0; i < workerCount; i++) {
+        QThread* thread = new QThread(this);
+        MetadataWorker* worker = new MetadataWorker(this);
+        worker->moveToThread(thread);
+        connect(thread, &QThread::finished, worker, &QObject::deleteLater);
+        thread->start(QThread::LowPriority);
+        threads.append(thread);
+        workers.append(worker);
+    }
+}
+
+MetadataExtractor::~MetadataExtractor()
+{
+    {
+        QMutexLocker locker(&mutex);
+        jobs.clear();
+    }
+    for (QThread* thread : std::as_const(threads)) {
+        thread->quit();
+    }
+    for (QThread* thread : std::as_const(threads)) {
+        thread->wait();
+    }
+    if (cacheDirty) {
+        saveCache();
+    }
+}
+
+void MetadataExtractor::request(const QStringList& filePaths)
+{
+    int added = 0;
+    {
+        QMutexLocker locker(&mutex);
+        for (const QString& filePath : filePaths) {
+            if (filePath.isEmpty() || requested.contains(filePath)) continue;
+            requested.insert(filePath);
+            jobs.enqueue(filePath);
+            added++;
+        }
+    }
+    if (added == 0) return;
+
+    for (MetadataWorker* worker : std::as_const(workers)) {
+        QMetaObject::invokeMethod(worker, [worker]() { worker->wake(); }, Qt::QueuedConnection);
+    }
+    if (!flushTimer->isActive()) {
+        flushTimer->start();
+    }
+}
+
+bool MetadataExtractor::takeJob(QString& filePath)
+{
+    QMutexLocker locker(&mutex);
+    if (jobs.isEmpty()) return false;
+
+    filePath = jobs.dequeue();
+    activeJobs++;
+    return true;
+}
+
+void MetadataExtractor::skipJob()
+{
+    QMutexLocker locker(&mutex);
+    activeJobs--;
+}
+
+bool MetadataExtractor::lookupCache(const QString& filePath, qint64 size, qint64 modified,
+                                    TrackMetadata& metadata)
+{
+    QMutexLocker locker(&mutex);
+    auto it = cache.constFind(filePath);
+    if (it == cache.constEnd() || it->size != size || it->modified != modified) {
+        return false;
+    }
+    metadata = it->metadata;
+    metadata.filePath = filePath;
+    return true;
+}
+
+void MetadataExtractor::deliver(const TrackMetadata& metadata, qint64 size, qint64 modified, bool fromCache)
+{
+    QMutexLocker locker(&mutex);
+    activeJobs--;
+    if (!fromCache) {
+        cache.insert(metadata.filePath, CacheEntry{ size, modified, metadata });
+        cacheDirty = true;
+    }
+    pendingResults.append(metadata);
+}
+
+void MetadataExtractor::flushResults()
+{
+    QList<TrackMetadata> results;
+    bool idle = false;
+    bool needsSave = false;
+    {
+        QMutexLocker locker(&mutex);
+        results.swap(pendingResults);
+        idle = jobs.isEmpty() && activeJobs == 0;
+        needsSave = idle && cacheDirty;
+    }
+
+    if (!results.isEmpty()) {
+        emit metadataReady(results);
+    }
+
+    // 佇列處理完畢：停止輪詢並寫入快取
+    if (idle) {
+        flushTimer->stop();
+        if (needsSave) {
+            saveCache();
+        }
+    }
+}
+
+void MetadataExtractor::loadCache()
+{
+    QFile file(cacheDir + "/metadata_cache.dat");
+    if (!file.open(QIODevice::ReadOnly)) return;
+
+    QDataStream in(&file);
+    in.setVersion(QDataStream::Qt_6_0);
+    quint32 magic = 0;
+    quint32 version = 0;
+    qint32 count = 0;
+    in >> magic >> version >> count;
+    if (magic != kCacheMagic || version != kCacheVersion || count < 0) return;
+
+    cache.reserve(count);
+    for (qint32 i = 0; i < count && in.status() == QDataStream::Ok; i++) {
+        CacheEntry entry;
+        in >> entry.metadata.filePath >> entry.size >> entry.modified
+           >> entry.metadata.title >> entry.metadata.artist >> entry.metadata.album
+           >> entry.metadata.durationMs >> entry.metadata.coverPath;
+        cache.insert(entry.metadata.filePath, entry);
+    }
+}
+
+void MetadataExtractor::saveCache()
+{
+    QMutexLocker locker(&mutex);
+
+    QSaveFile file(cacheDir + "/metadata_cache.dat");
+    if (!file.open(QIODevice::WriteOnly)) return;
+
+    QDataStream out(&file);
+    out.setVersion(QDataStream::Qt_6_0);
+    out << kCacheMagic << kCacheVersion << qint32(cache.size());
+    for (const CacheEntry& entry : std::as_const(cache)) {
+        out << entry.metadata.filePath << entry.size << entry.modified
+            << entry.metadata.title << entry.metadata.artist << entry.metadata.album
+            << entry.metadata.durationMs << entry.metadata.coverPath;
+    }
+    if (file.commit()) {
+        cacheDirty = false;
+    }
+}
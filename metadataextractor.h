@@ -0,0 +1,104 @@
+#ifndef METADATAEXTRACTOR_H
+#define METADATAEXTRACTOR_H
+
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QList>
+#include <QHash>
+#include <QSet>
+#include <QQueue>
+#include <QMutex>
+#include <QMediaPlayer>
+
+class QThread;
+class QTimer;
+
+// 本地檔案的標籤資訊
+struct TrackMetadata {
+    QString filePath;
+    QString title;
+    QString artist;
+    QString album;
+    qint64 durationMs = 0;
+    QString coverPath;        // 內嵌封面另存的圖片檔，沒有封面時為空
+};
+
+class MetadataExtractor;
+
+// 工作執行緒：各自擁有一個不輸出聲音的 QMediaPlayer 來讀取標籤
+class MetadataWorker : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit MetadataWorker(MetadataExtractor* owner);
+
+    // 在工作執行緒上呼叫：若閒置則開始處理佇列
+    void wake();
+
+private:
+    void processNext();
+    void onMediaStatusChanged(QMediaPlayer::MediaStatus status);
+    void finishCurrent();
+
+    MetadataExtractor* owner;
+    QMediaPlayer* player;
+    QTimer* timeoutTimer;
+    bool busy;
+    QString currentPath;
+    qint64 currentSize;
+    qint64 currentModified;
+};
+
+// 背景標籤擷取：多個工作執行緒 + 以 路徑/大小/修改時間 為鍵的持久快取
+// 結果每隔一小段時間成批送回 GUI 執行緒
+class MetadataExtractor : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit MetadataExtractor(const QString& cacheDir, QObject* parent = nullptr);
+    ~MetadataExtractor();
+
+    // 要求擷取（同一個路徑在本次執行中只處理一次）
+    void request(const QStringList& filePaths);
+
+signals:
+    void metadataReady(const QList<TrackMetadata>& results);
+
+private:
+    friend class MetadataWorker;
+
+    struct CacheEntry {
+        qint64 size;
+        qint64 modified;
+        TrackMetadata metadata;
+    };
+
+    // 以下函式由工作執行緒呼叫，受 mutex 保護
+    bool takeJob(QString& filePath);
+    void skipJob();
+    bool lookupCache(const QString& filePath, qint64 size, qint64 modified, TrackMetadata& metadata);
+    void deliver(const TrackMetadata& metadata, qint64 size, qint64 modified, bool fromCache);
+    QString coverDir() const { return cacheDir + "/covers"; }
+
+    void flushResults();
+    void loadCache();
+    void saveCache();
+
+    QString cacheDir;
+    QMutex mutex;
+    QQueue<QString> jobs;
+    QSet<QString> requested;
+    QHash<QString, CacheEntry> cache;
+    QList<TrackMetadata> pendingResults;
+    bool cacheDirty;
+    int activeJobs;
+
+    QList<QThread*> threads;
+    QList<MetadataWorker*> workers;
+    QTimer* flushTimer;
+};
+
+#endif // METADATAEXTRACTOR_H
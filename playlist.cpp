@@ -0,0 +1,106 @@
+#include "playlist.h"
+#include <QSet>
+#include <QMutex>
+#include <QMutexLocker>
+
+namespace {
+QMutex stringPoolMutex;
+QSet<QString> stringPool;
+
+// 所有新項目一開始共用同一份空紀錄，第一次設定欄位時才配置自己的紀錄
+const QSharedDataPointer<TrackData>& emptyTrack()
+{
+    static const QSharedDataPointer<TrackData> empty(new TrackData);
+    return empty;
+}
+}
+
+QString internString(const QString& text)
+{
+    if (text.isEmpty()) return QString();
+
+    QMutexLocker locker(&stringPoolMutex);
+    auto it = stringPool.constFind(text);
+    if (it != stringPool.constEnd()) {
+        return *it;
+    }
+    stringPool.insert(text);
+    return text;
+}
+
+VideoInfo::VideoInfo()
+    : d(emptyTrack())
+    , favorite(false)
+{
+}
+
+void VideoInfo::setVideoId(const QString& videoId)
+{
+    if (d.constData()->videoId == videoId) return;
+    d->videoId = videoId;
+}
+
+void VideoInfo::setFilePath(const QString& filePath)
+{
+    if (d.constData()->filePath == filePath) return;
+    d->filePath = filePath;
+}
+
+void VideoInfo::setTitle(const QString& title)
+{
+    if (d.constData()->title == title) return;
+    d->title = title;
+}
+
+void VideoInfo::setChannelTitle(const QString& channelTitle)
+{
+    if (d.constData()->channelTitle == channelTitle) return;
+    d->channelTitle = internString(channelTitle);
+}
+
+void VideoInfo::setThumbnailUrl(const QString& thumbnailUrl)
+{
+    if (d.constData()->thumbnailUrl == thumbnailUrl) return;
+    d->thumbnailUrl = thumbnailUrl;
+}
+
+void VideoInfo::setDescription(const QString& description)
+{
+    if (d.constData()->description == description) return;
+    d->description = description;
+}
+
+void VideoInfo::setLocalFile(bool isLocalFile)
+{
+    if (d.constData()->isLocalFile == isLocalFile) return;
+    d->isLocalFile = isLocalFile;
+}
+
+bool VideoInfo::shareTrack(const VideoInfo& other)
+{
+    if (d == other.d) return true;
+
+    const TrackData& mine = *d.constData();
+    const TrackData& theirs = *other.d.constData();
+    if (mine.videoId != theirs.videoId || mine.filePath != theirs.filePath ||
+        mine.title != theirs.title || mine.channelTitle != theirs.channelTitle ||
+        mine.thumbnailUrl != theirs.thumbnailUrl || mine.description != theirs.description ||
+        mine.isLocalFile != theirs.isLocalFile) {
+        return false;
+    }
+    d = other.d;
+    return true;
+}
+
+void shareTrackRecords(QList<VideoInfo>& videos, QHash<QString, VideoInfo>& tracks)
+{
+    for (VideoInfo& video : videos) {
+        const QString key = trackKey(video);
+        auto it = tracks.constFind(key);
+        if (it == tracks.constEnd()) {
+            tracks.insert(key, video);
+        } else {
+            video.shareTrack(*it);
+        }
+    }
+}
@@ -0,0 +1,90 @@
+#ifndef PLAYLIST_H
+#define PLAYLIST_H
+
+#include <QString>
+#include <QList>
+#include <QHash>
+#include <QDir>
+#include <QSharedData>
+#include <QSharedDataPointer>
+
+// 曲目紀錄：由各播放清單項目共用，只有在修改時才複製（copy-on-write）
+struct TrackData : public QSharedData
+{
+    QString videoId;          // YouTube 影片 ID (用於 YouTube 連結)
+    QString filePath;         // 本地檔案路徑 (用於本地音樂)
+    QString title;            // 影片/音樂標題
+    QString channelTitle;     // 頻道名稱/藝術家（經過字串池，同一位藝人只有一份）
+    QString thumbnailUrl;     // 縮圖 URL
+    QString description;      // 描述
+    bool isLocalFile = false; // 是否為本地檔案
+};
+
+// 字串池：重複出現的字串只保留一份，之後的副本只增加引用計數；可在任何執行緒呼叫
+QString internString(const QString& text);
+
+// 影片/音樂資訊：播放清單中的一個項目
+// 本身只有一個指向共用曲目紀錄的指標與項目自己的旗標（16 位元組），
+// 複製項目（加入最愛、交給儲存執行緒、建立索引）只增加引用計數，不複製任何字串
+class VideoInfo
+{
+public:
+    VideoInfo();
+
+    const QString& videoId() const { return d->videoId; }
+    const QString& filePath() const { return d->filePath; }
+    const QString& title() const { return d->title; }
+    const QString& channelTitle() const { return d->channelTitle; }
+    const QString& thumbnailUrl() const { return d->thumbnailUrl; }
+    const QString& description() const { return d->description; }
+    bool isLocalFile() const { return d->isLocalFile; }
+    bool isFavorite() const { return favorite; }   // 是否為喜愛的影片/音樂（屬於這個項目，不屬於曲目）
+
+    // 值沒有改變時不會複製共用的紀錄
+    void setVideoId(const QString& videoId);
+    void setFilePath(const QString& filePath);
+    void setTitle(const QString& title);
+    void setChannelTitle(const QString& channelTitle);
+    void setThumbnailUrl(const QString& thumbnailUrl);
+    void setDescription(const QString& description);
+    void setLocalFile(bool isLocalFile);
+    void setFavorite(bool isFavorite) { favorite = isFavorite; }
+
+    // 兩個項目是否共用同一份曲目紀錄
+    bool sharesTrackWith(const VideoInfo& other) const { return d == other.d; }
+    // 內容相同時改為共用 other 的曲目紀錄並釋放自己的一份，回傳是否共用
+    bool shareTrack(const VideoInfo& other);
+
+private:
+    QSharedDataPointer<TrackData> d;
+    bool favorite;
+};
+
+// 曲目的穩定識別：YouTube 影片用 videoId，本地檔案用正規化後的路徑
+// 最愛集合與資料庫的 tracks 表都以此為鍵
+inline QString trackKey(const VideoInfo& video)
+{
+    if (!video.videoId().isEmpty()) {
+        return "yt:" + video.videoId();
+    }
+    QString path = QDir::cleanPath(QDir::fromNativeSeparators(video.filePath()));
+#ifdef Q_OS_WIN
+    path = path.toLower();   // Windows 檔案系統不分大小寫
+#endif
+    return "file:" + path;
+}
+
+// 同一首曲目出現在多個播放清單時（例如「我的最愛」），讓內容相同的項目共用一份紀錄
+// tracks 以 trackKey 記錄已見過的曲目，可跨多次呼叫使用
+void shareTrackRecords(QList<VideoInfo>& videos, QHash<QString, VideoInfo>& tracks);
+
+// 播放清單結構
+struct Playlist {
+    QString name;              // 播放清單名稱
+    QList<VideoInfo> videos;   // 影片列表
+    bool dirty = false;        // 是否有尚未保存的變更
+    bool loaded = true;        // 影片列表是否已載入記憶體
+    quint64 lastUsed = 0;      // 最近使用順序，用於釋放久未使用的播放清單
+};
+
+#endif // PLAYLIST_H
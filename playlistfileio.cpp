@@ -0,0 +1,385 @@
+#include "playlistfileio.h"
+#include "youtubelink.h"
+#include <QIODevice>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QDir>
+#include <QUrl>
+#include <QMap>
+#include <climits>
+
+namespace {
+const QString kLocalArtist = QStringLiteral("本地音樂");
+const QString kYouTubeArtist = QStringLiteral("點擊連結在瀏覽器中觀看");
+const qint64 kProgressBytes = 256 * 1024;
+
+// 播放清單中的一行位置：本地路徑（絕對或相對）、file:// 網址或 YouTube 連結
+bool entryFromLocation(QString location, const QString& baseDir, const QString& title,
+                       const QString& artist, VideoInfo& video)
+{
+    location = location.trimmed();
+    if (location.isEmpty()) return false;
+
+    if (location.startsWith(QLatin1String("file:"), Qt::CaseInsensitive)) {
+        location = QUrl(location).toLocalFile();
+        if (location.isEmpty()) return false;
+    } else if (location.contains(QLatin1String("://"))) {
+        const QString videoId = extractYouTubeVideoId(location);
+        if (videoId.isEmpty()) return false;   // 不支援的串流網址
+        video.setVideoId(videoId);
+        video.setTitle(title.isEmpty() ? QStringLiteral("YouTube 影片") : title);
+        video.setChannelTitle(artist.isEmpty() ? kYouTubeArtist : artist);
+        video.setLocalFile(false);
+        return true;
+    }
+
+    // Windows 工具寫出的播放清單只有反斜線
+    if (!location.contains('/')) {
+        location.replace('\\', '/');
+    }
+    if (QDir::isRelativePath(location)) {
+        location = QDir(baseDir).filePath(location);
+    }
+    location = QDir::cleanPath(location);
+
+    video.setFilePath(location);
+    video.setTitle(title.isEmpty() ? QFileInfo(location).completeBaseName() : title);
+    video.setChannelTitle(artist.isEmpty() ? kLocalArtist : artist);
+    video.setLocalFile(true);
+    return true;
+}
+
+// "#EXTINF:123,Artist - Title" 或 "#EXTINF:-1 tvg-id=\"x\",Title"
+void parseExtInf(const QString& line, QString& title, QString& artist)
+{
+    title.clear();
+    artist.clear();
+    const int comma = line.indexOf(',');
+    if (comma < 0) return;
+
+    const QString text = line.mid(comma + 1).trimmed();
+    const int dash = text.indexOf(QLatin1String(" - "));
+    if (dash > 0) {
+        artist = text.left(dash).trimmed();
+        title = text.mid(dash + 3).trimmed();
+    } else {
+        title = text;
+    }
+}
+
+QString locationFor(const VideoInfo& video, const QDir& baseDir)
+{
+    if (!video.isLocalFile()) {
+        return "https://www.youtube.com/watch?v=" + video.videoId();
+    }
+    const QString relative = baseDir.relativeFilePath(video.filePath());
+    return relative.startsWith(QLatin1String("..")) || QDir::isAbsolutePath(relative)
+               ? video.filePath() : relative;
+}
+
+QString artistFor(const VideoInfo& video)
+{
+    const QString& artist = video.channelTitle();
+    return artist == kLocalArtist || artist == kYouTubeArtist ? QString() : artist;
+}
+}
+
+PlaylistFileIO::PlaylistFileIO(QObject* parent)
+    : QObject(parent)
+    , cancelled(false)
+    , busy(false)
+{
+    pool.setMaxThreadCount(1);
+}
+
+PlaylistFileIO::~PlaylistFileIO()
+{
+    cancelled = true;
+    pool.waitForDone();
+}
+
+bool PlaylistFileIO::formatFor(const QString& fileName, Format& format)
+{
+    const QString suffix = QFileInfo(fileName).suffix().toLower();
+    if (suffix == "m3u" || suffix == "m3u8") {
+        format = M3U;
+        return true;
+    }
+    if (suffix == "pls") {
+        format = PLS;
+        return true;
+    }
+    return false;
+}
+
+QString PlaylistFileIO::fileFilter()
+{
+    return "播放清單 (*.m3u8 *.m3u *.pls);;M3U8 (*.m3u8);;M3U (*.m3u);;PLS (*.pls)";
+}
+
+bool PlaylistFileIO::parse(QIODevice& device, Format format, bool utf8, const QString& baseDir,
+                           const std::atomic<bool>& cancelled, const BatchCallback& onBatch,
+                           const ProgressCallback& onProgress, int* skipped)
+{
+    QList<VideoInfo> batch;
+    batch.reserve(kBatchSize);
+    auto add = [&](const VideoInfo& video) {
+        batch.append(video);
+        if (batch.size() >= kBatchSize) {
+            onBatch(batch);
+            batch.clear();
+        }
+    };
+    int skippedCount = 0;
+
+    // M3U：#EXTINF 描述下一個位置
+    QString title;
+    QString artist;
+
+    // PLS：FileN/TitleN 通常依序出現；看到較大的編號時，之前的項目就不會再有資料
+    struct PlsEntry {
+        QString location;
+        QString title;
+    };
+    QMap<int, PlsEntry> plsEntries;
+    auto flushPls = [&](int belowIndex) {
+        while (!plsEntries.isEmpty() && plsEntries.firstKey() < belowIndex) {
+            const PlsEntry entry = plsEntries.take(plsEntries.firstKey());
+            VideoInfo video;
+            if (entryFromLocation(entry.location, baseDir, entry.title, QString(), video)) {
+                add(video);
+            } else if (!entry.location.isEmpty()) {
+                skippedCount++;
+            }
+        }
+    };
+
+    qint64 bytesRead = 0;
+    qint64 lastReport = 0;
+    bool firstLine = true;
+    while (!device.atEnd()) {
+        if (cancelled) return false;
+
+        const QByteArray raw = device.readLine();
+        if (raw.isEmpty()) break;
+        bytesRead += raw.size();
+        if (onProgress && bytesRead - lastReport >= kProgressBytes) {
+            onProgress(bytesRead);
+            lastReport = bytesRead;
+        }
+
+        // .m3u 沒有規定編碼：不是合法的 UTF-8 時改用系統編碼
+        QString line = QString::fromUtf8(raw).trimmed();
+        if (!utf8 && line.contains(QChar::ReplacementCharacter)) {
+            line = QString::fromLocal8Bit(raw).trimmed();
+        }
+        if (firstLine) {
+            if (line.startsWith(QChar(0xFEFF))) line.remove(0, 1);
+            firstLine = false;
+        }
+        if (line.isEmpty()) continue;
+
+        if (format == M3U) {
+            if (line.startsWith('#')) {
+                if (line.startsWith(QLatin1String("#EXTINF:"), Qt::CaseInsensitive)) {
+                    parseExtInf(line, title, artist);
+                }
+                continue;
+            }
+            VideoInfo video;
+            if (entryFromLocation(line, baseDir, title, artist, video)) {
+                add(video);
+            } else {
+                skippedCount++;
+            }
+            title.clear();
+            artist.clear();
+            continue;
+        }
+
+        const int equals = line.indexOf('=');
+        if (equals <= 0) continue;   // [playlist] 與註解
+        const QString key = line.left(equals).trimmed().toLower();
+        const QString value = line.mid(equals + 1).trimmed();
+        int digits = key.size();
+        while (digits > 0 && key.at(digits - 1).isDigit()) digits--;
+        bool ok = false;
+        const int index = key.mid(digits).toInt(&ok);
+        if (!ok) continue;   // NumberOfEntries、Version
+
+        const QString field = key.left(digits);
+        if (field == "file") {
+            flushPls(index);
+            plsEntries[index].location = value;
+        } else if (field == "title") {
+            plsEntries[index].title = value;
+        }
+    }
+    flushPls(INT_MAX);
+
+    if (!batch.isEmpty()) {
+        onBatch(batch);
+    }
+    if (onProgress) {
+        onProgress(bytesRead);
+    }
+    if (skipped) {
+        *skipped = skippedCount;
+    }
+    return true;
+}
+
+bool PlaylistFileIO::write(QIODevice& device, Format format, const QString& baseDir,
+                           const QList<VideoInfo>& videos, const std::atomic<bool>& cancelled,
+                           const ProgressCallback& onProgress)
+{
+    const QDir dir(baseDir);
+    QByteArray chunk;
+    auto flush = [&]() {
+        const bool ok = device.write(chunk) == chunk.size();
+        chunk.clear();
+        return ok;
+    };
+
+    chunk.append(format == M3U ? "#EXTM3U\n" : "[playlist]\n");
+    for (qsizetype i = 0; i < videos.size(); i++) {
+        const VideoInfo& video = videos.at(i);
+        const QString artist = artistFor(video);
+        const QString title = artist.isEmpty() ? video.title() : artist + " - " + video.title();
+
+        if (format == M3U) {
+            chunk.append("#EXTINF:-1,");
+            chunk.append(title.toUtf8());
+            chunk.append('\n');
+            chunk.append(locationFor(video, dir).toUtf8());
+            chunk.append('\n');
+        } else {
+            const QByteArray number = QByteArray::number(i + 1);
+            chunk.append("File" + number + "=" + locationFor(video, dir).toUtf8() + "\n");
+            chunk.append("Title" + number + "=" + title.toUtf8() + "\n");
+            chunk.append("Length" + number + "=-1\n");
+        }
+
+        // 每一批寫出一次並檢查取消
+        if ((i + 1) % kBatchSize == 0) {
+            if (cancelled || !flush()) return false;
+            if (onProgress) onProgress(i + 1);
+        }
+    }
+    if (format == PLS) {
+        chunk.append("NumberOfEntries=" + QByteArray::number(videos.size()) + "\nVersion=2\n");
+    }
+    if (!flush()) return false;
+    if (onProgress) onProgress(videos.size());
+    return true;
+}
+
+void PlaylistFileIO::startImport(const QString& filePath, const QString& playlistName)
+{
+    if (busy) return;
+    busy = true;
+    cancelled = false;
+    pool.start([this, filePath, playlistName]() {
+        runImport(filePath, playlistName);
+    });
+}
+
+void PlaylistFileIO::startExport(const QString& filePath, const QList<VideoInfo>& videos)
+{
+    if (busy) return;
+    busy = true;
+    cancelled = false;
+    // videos 是隱式共享的快照，GUI 執行緒之後的修改不影響匯出
+    pool.start([this, filePath, videos]() {
+        runExport(filePath, videos);
+    });
+}
+
+void PlaylistFileIO::runImport(const QString& filePath, const QString& playlistName)
+{
+    Format format;
+    QFile file(filePath);
+    if (!formatFor(filePath, format)) {
+        finish(false, "不支援的播放清單格式：" + filePath);
+        return;
+    }
+    if (!file.open(QIODevice::ReadOnly)) {
+        finish(false, "無法開啟檔案：" + file.errorString());
+        return;
+    }
+
+    const qint64 total = file.size();
+    const bool utf8 = filePath.endsWith(QLatin1String(".m3u8"), Qt::CaseInsensitive);
+    int imported = 0;
+    int skipped = 0;
+    auto onBatch = [this, playlistName, &imported](const QList<VideoInfo>& videos) {
+        imported += videos.size();
+        // 取消後仍在佇列中的批次不再加入
+        QMetaObject::invokeMethod(this, [this, playlistName, videos]() {
+            if (!cancelled) {
+                emit tracksImported(playlistName, videos);
+            }
+        }, Qt::QueuedConnection);
+    };
+    auto onProgress = [this, total](qint64 bytesRead) {
+        QMetaObject::invokeMethod(this, [this, bytesRead, total]() {
+            emit progressChanged(bytesRead, total);
+        }, Qt::QueuedConnection);
+    };
+
+    const bool ok = parse(file, format, utf8, QFileInfo(filePath).absolutePath(), cancelled,
+                          onBatch, onProgress, &skipped);
+    if (!ok) {
+        finish(false, "已取消匯入");
+        return;
+    }
+
+    QString message = QString("已匯入 %1 首").arg(imported);
+    if (skipped > 0) {
+        message += QString("，略過 %1 個無法辨識的項目").arg(skipped);
+    }
+    finish(true, message);
+}
+
+void PlaylistFileIO::runExport(const QString& filePath, const QList<VideoInfo>& videos)
+{
+    Format format;
+    if (!formatFor(filePath, format)) {
+        finish(false, "不支援的播放清單格式：" + filePath);
+        return;
+    }
+
+    // 寫入暫存檔後原子替換；取消或失敗時不留下不完整的檔案
+    QSaveFile file(filePath);
+    if (!file.open(QIODevice::WriteOnly)) {
+        finish(false, "無法寫入檔案：" + file.errorString());
+        return;
+    }
+
+    const qint64 total = videos.size();
+    auto onProgress = [this, total](qint64 written) {
+        QMetaObject::invokeMethod(this, [this, written, total]() {
+            emit progressChanged(written, total);
+        }, Qt::QueuedConnection);
+    };
+
+    if (!write(file, format, QFileInfo(filePath).absolutePath(), videos, cancelled, onProgress)) {
+        file.cancelWriting();
+        finish(false, cancelled ? QString("已取消匯出") : "寫入失敗：" + file.errorString());
+        return;
+    }
+    if (!file.commit()) {
+        finish(false, "寫入失敗：" + file.errorString());
+        return;
+    }
+    finish(true, QString("已匯出 %1 首").arg(videos.size()));
+}
+
+void PlaylistFileIO::finish(bool ok, const QString& message)
+{
+    QMetaObject::invokeMethod(this, [this, ok, message]() {
+        busy = false;
+        emit finished(ok, cancelled, message);
+    }, Qt::QueuedConnection);
+}
@@ -0,0 +1,68 @@
+#ifndef PLAYLISTFILEIO_H
+#define PLAYLISTFILEIO_H
+
+#include <QObject>
+#include <QString>
+#include <QList>
+#include <QThreadPool>
+#include <atomic>
+#include <functional>
+#include "playlist.h"
+
+class QIODevice;
+
+// M3U/M3U8/PLS 播放清單的匯入與匯出
+// 在工作執行緒上逐行串流處理，數萬行的檔案也不必整個讀進記憶體；
+// 匯入的曲目每累積一批就送回 GUI 執行緒，可隨時取消
+class PlaylistFileIO : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit PlaylistFileIO(QObject* parent = nullptr);
+    ~PlaylistFileIO();
+
+    enum Format { M3U, PLS };
+
+    // 依副檔名判斷格式；.m3u、.m3u8 與 .pls 以外回傳 false
+    static bool formatFor(const QString& fileName, Format& format);
+    static QString fileFilter();
+
+    using BatchCallback = std::function<void(const QList<VideoInfo>&)>;
+    using ProgressCallback = std::function<void(qint64)>;
+
+    // 串流解析（任何執行緒皆可呼叫）：每 kBatchSize 首呼叫一次 onBatch，onProgress 回報已讀取的位元組
+    // 相對路徑以 baseDir 解析；YouTube 連結與 extractYouTubeVideoId() 的規則相同，其他網址略過
+    static bool parse(QIODevice& device, Format format, bool utf8, const QString& baseDir,
+                      const std::atomic<bool>& cancelled, const BatchCallback& onBatch,
+                      const ProgressCallback& onProgress = ProgressCallback(), int* skipped = nullptr);
+
+    // 串流寫出；baseDir 之下的本地檔案寫成相對路徑，onProgress 回報已寫出的曲目數
+    static bool write(QIODevice& device, Format format, const QString& baseDir,
+                      const QList<VideoInfo>& videos, const std::atomic<bool>& cancelled,
+                      const ProgressCallback& onProgress = ProgressCallback());
+
+    bool isBusy() const { return busy; }
+    void startImport(const QString& filePath, const QString& playlistName);
+    void startExport(const QString& filePath, const QList<VideoInfo>& videos);
+    void cancel() { cancelled = true; }
+
+    static const int kBatchSize = 1000;
+
+signals:
+    // 進度：匯入為位元組，匯出為曲目數
+    void progressChanged(qint64 done, qint64 total);
+    void tracksImported(const QString& playlistName, const QList<VideoInfo>& videos);
+    void finished(bool ok, bool cancelled, const QString& message);
+
+private:
+    void runImport(const QString& filePath, const QString& playlistName);
+    void runExport(const QString& filePath, const QList<VideoInfo>& videos);
+    void finish(bool ok, const QString& message);
+
+    QThreadPool pool;              // 單一執行緒，同一時間只處理一個檔案
+    std::atomic<bool> cancelled;
+    bool busy;
+};
+
+#endif // PLAYLISTFILEIO_H
@@ -0,0 +1,469 @@
+#include "playlistmodel.h"
+#include <QPainter>
+#include <QFontMetrics>
+#include <QColor>
+#include <QMimeData>
+#include <QDataStream>
+#include <QIODevice>
+#include <algorithm>
+#include "shuffleengine.h"
+#include "coverartcache.h"
+
+namespace {
+// 清單內拖曳：播放清單索引與選取的列
+const QString kRowsMimeType = QStringLiteral("application/x-last-report-rows");
+}
+
+PlaylistModel::PlaylistModel(QList<Playlist>* playlists, QObject* parent)
+    : QAbstractListModel(parent)
+    , playlists(playlists)
+    , favoriteKeys(nullptr)
+    , playlistIdx(-1)
+    , currentRowIdx(-1)
+{
+}
+
+const Playlist* PlaylistModel::displayedPlaylist() const
+{
+    if (playlistIdx < 0 || playlistIdx >= playlists->size()) return nullptr;
+    return &playlists->at(playlistIdx);
+}
+
+int PlaylistModel::rowCount(const QModelIndex& parent) const
+{
+    if (parent.isValid()) return 0;
+    const Playlist* playlist = displayedPlaylist();
+    return playlist ? playlist->videos.size() : 0;
+}
+
+QVariant PlaylistModel::data(const QModelIndex& index, int role) const
+{
+    const Playlist* playlist = displayedPlaylist();
+    if (!playlist || !index.isValid() || index.row() >= playlist->videos.size()) {
+        return QVariant();
+    }
+
+    const VideoInfo& video = playlist->videos.at(index.row());
+    switch (role) {
+    case Qt::DisplayRole:
+        return QString("%1. %2\n   %3").arg(index.row() + 1).arg(video.title()).arg(video.channelTitle());
+    case TitleRole:
+        return video.title();
+    case ChannelRole:
+        return video.channelTitle();
+    case IsCurrentRole:
+        return index.row() == currentRowIdx;
+    case IsFavoriteRole:
+        return favoriteKeys ? favoriteKeys->contains(trackKey(video)) : video.isFavorite();
+    case IsLocalFileRole:
+        return video.isLocalFile();
+    case ThumbnailRole:
+        return video.thumbnailUrl();
+    default:
+        return QVariant();
+    }
+}
+
+Qt::ItemFlags PlaylistModel::flags(const QModelIndex& index) const
+{
+    // 只能放在列與列之間，不能放在某一列「上」
+    if (!index.isValid()) {
+        return Qt::ItemIsDropEnabled;
+    }
+    return QAbstractListModel::flags(index) | Qt::ItemIsDragEnabled;
+}
+
+Qt::DropActions PlaylistModel::supportedDropActions() const
+{
+    return Qt::CopyAction | Qt::MoveAction;
+}
+
+Qt::DropActions PlaylistModel::supportedDragActions() const
+{
+    return Qt::MoveAction;
+}
+
+QStringList PlaylistModel::mimeTypes() const
+{
+    return { kRowsMimeType, QStringLiteral("text/uri-list") };
+}
+
+QMimeData* PlaylistModel::mimeData(const QModelIndexList& indexes) const
+{
+    QList<int> rows;
+    rows.reserve(indexes.size());
+    for (const QModelIndex& index : indexes) {
+        if (index.isValid()) rows.append(index.row());
+    }
+    std::sort(rows.begin(), rows.end());
+    rows.erase(std::unique(rows.begin(), rows.end()), rows.end());
+
+    QByteArray encoded;
+    QDataStream out(&encoded, QIODevice::WriteOnly);
+    out << qint32(playlistIdx) << rows;
+
+    QMimeData* data = new QMimeData();
+    data->setData(kRowsMimeType, encoded);
+    return data;
+}
+
+bool PlaylistModel::canDropMimeData(const QMimeData* data, Qt::DropAction action, int row, int column,
+                                    const QModelIndex& parent) const
+{
+    Q_UNUSED(action);
+    Q_UNUSED(row);
+    Q_UNUSED(column);
+    Q_UNUSED(parent);
+    if (!displayedPlaylist()) return false;
+    return data->hasFormat(kRowsMimeType) || data->hasUrls();
+}
+
+bool PlaylistModel::dropMimeData(const QMimeData* data, Qt::DropAction action, int row, int column,
+                                 const QModelIndex& parent)
+{
+    Q_UNUSED(column);
+    if (action == Qt::IgnoreAction) return true;
+    const Playlist* playlist = displayedPlaylist();
+    if (!playlist) return false;
+
+    const int count = playlist->videos.size();
+    int destination = row >= 0 ? row : (parent.isValid() ? parent.row() : count);
+    destination = qBound(0, destination, count);
+
+    if (data->hasFormat(kRowsMimeType)) {
+        QDataStream in(data->data(kRowsMimeType));
+        qint32 sourcePlaylist = -1;
+        QList<int> rows;
+        in >> sourcePlaylist >> rows;
+        // 只接受同一個播放清單內的拖曳（拖曳期間切換清單時忽略）
+        if (in.status() != QDataStream::Ok || sourcePlaylist != playlistIdx) return false;
+        std::sort(rows.begin(), rows.end());
+        rows.erase(std::unique(rows.begin(), rows.end()), rows.end());
+        // 清單內的移動已在這裡完成；檢視不必再移除來源列
+        return moveVideos(playlistIdx, rows, destination);
+    }
+
+    if (data->hasUrls()) {
+        emit urlsDropped(playlistIdx, destination, data->urls());
+        return true;
+    }
+    return false;
+}
+
+void PlaylistModel::setPlaylistIndex(int index)
+{
+    beginResetModel();
+    playlistIdx = index;
+    currentRowIdx = -1;
+    endResetModel();
+}
+
+void PlaylistModel::setCurrentRow(int row)
+{
+    if (row == currentRowIdx) return;
+
+    int oldRow = currentRowIdx;
+    currentRowIdx = row;
+
+    const int count = rowCount();
+    const QList<int> roles = { IsCurrentRole };
+    if (oldRow >= 0 && oldRow < count) {
+        emit dataChanged(index(oldRow), index(oldRow), roles);
+    }
+    if (row >= 0 && row < count) {
+        emit dataChanged(index(row), index(row), roles);
+    }
+}
+
+void PlaylistModel::appendVideo(int playlistIndex, const VideoInfo& video)
+{
+    if (playlistIndex < 0 || playlistIndex >= playlists->size()) return;
+
+    QList<VideoInfo>& videos = (*playlists)[playlistIndex].videos;
+    if (playlistIndex != playlistIdx) {
+        videos.append(video);
+        return;
+    }
+
+    const int row = videos.size();
+    beginInsertRows(QModelIndex(), row, row);
+    videos.append(video);
+    endInsertRows();
+}
+
+void PlaylistModel::appendVideos(int playlistIndex, const QList<VideoInfo>& newVideos)
+{
+    if (playlistIndex < 0 || playlistIndex >= playlists->size() || newVideos.isEmpty()) return;
+
+    QList<VideoInfo>& videos = (*playlists)[playlistIndex].videos;
+    if (playlistIndex != playlistIdx) {
+        videos.append(newVideos);
+        return;
+    }
+
+    const int first = videos.size();
+    beginInsertRows(QModelIndex(), first, first + newVideos.size() - 1);
+    videos.append(newVideos);
+    endInsertRows();
+}
+
+void PlaylistModel::insertVideos(int playlistIndex, int row, const QList<VideoInfo>& newVideos)
+{
+    if (playlistIndex < 0 || playlistIndex >= playlists->size() || newVideos.isEmpty()) return;
+
+    QList<VideoInfo>& videos = (*playlists)[playlistIndex].videos;
+    row = qBound(0, row, int(videos.size()));
+    if (playlistIndex != playlistIdx) {
+        videos.insert(row, newVideos.size(), VideoInfo());
+        std::copy(newVideos.cbegin(), newVideos.cend(), videos.begin() + row);
+        return;
+    }
+
+    // 整批只發出一次 rowsInserted
+    beginInsertRows(QModelIndex(), row, row + newVideos.size() - 1);
+    videos.insert(row, newVideos.size(), VideoInfo());
+    std::copy(newVideos.cbegin(), newVideos.cend(), videos.begin() + row);
+    if (currentRowIdx >= row) {
+        currentRowIdx += newVideos.size();
+    }
+    endInsertRows();
+
+    // 後面各列的編號改變了
+    if (row + newVideos.size() < videos.size()) {
+        emit dataChanged(index(row + newVideos.size()), index(videos.size() - 1), { Qt::DisplayRole });
+    }
+}
+
+bool PlaylistModel::moveVideos(int playlistIndex, const QList<int>& sortedRows, int destination)
+{
+    if (playlistIndex < 0 || playlistIndex >= playlists->size() || sortedRows.isEmpty()) return false;
+
+    QList<VideoInfo>& videos = (*playlists)[playlistIndex].videos;
+    const int count = videos.size();
+    if (destination < 0 || destination > count ||
+        sortedRows.first() < 0 || sortedRows.last() >= count) return false;
+    const bool displayed = playlistIndex == playlistIdx;
+
+    // 連續的列合併成區段（跨過 destination 的區段在該處切開）
+    // destination 之後的區段依序往上移到插入點，之前的區段由後往前移到插入點之上，
+    // 每次移動都不影響尚未處理的區段的列號
+    QList<QPair<int, int>> blocks;   // 起點, 長度
+    for (int i = 0; i < sortedRows.size();) {
+        int j = i;
+        while (j + 1 < sortedRows.size() && sortedRows[j + 1] == sortedRows[j] + 1 &&
+               sortedRows[j + 1] != destination) {
+            j++;
+        }
+        blocks.append({ sortedRows[i], j - i + 1 });
+        i = j + 1;
+    }
+
+    int insertAt = destination;
+    for (const auto& block : std::as_const(blocks)) {
+        if (block.first < destination) continue;
+        moveBlock(videos, block.first, block.second, insertAt, displayed);
+        insertAt += block.second;
+    }
+    int top = destination;
+    for (auto it = blocks.crbegin(); it != blocks.crend(); ++it) {
+        if (it->first >= destination) continue;
+        moveBlock(videos, it->first, it->second, top, displayed);
+        top -= it->second;
+    }
+
+    if (displayed) {
+        currentRowIdx = ShuffleEngine::movedRow(currentRowIdx, sortedRows, destination);
+        // 受影響範圍內各列的編號改變了
+        const int first = std::min(sortedRows.first(), destination);
+        const int last = std::min(std::max(sortedRows.last(), destination), count - 1);
+        emit dataChanged(index(first), index(last), { Qt::DisplayRole });
+    }
+    emit videosMoved(playlistIndex, sortedRows, destination);
+    return true;
+}
+
+void PlaylistModel::moveBlock(QList<VideoInfo>& videos, int first, int count, int destination, bool displayed)
+{
+    // 區段已在插入點上：不必移動
+    if (destination >= first && destination <= first + count) return;
+
+    if (displayed) {
+        beginMoveRows(QModelIndex(), first, first + count - 1, QModelIndex(), destination);
+    }
+    // 只搬動 first 與 destination 之間的項目（每個項目一個指標），不重建清單
+    if (destination > first) {
+        std::rotate(videos.begin() + first, videos.begin() + first + count, videos.begin() + destination);
+    } else {
+        std::rotate(videos.begin() + destination, videos.begin() + first, videos.begin() + first + count);
+    }
+    if (displayed) {
+        endMoveRows();
+    }
+}
+
+void PlaylistModel::removeVideos(int playlistIndex, const QList<int>& sortedRows)
+{
+    if (playlistIndex < 0 || playlistIndex >= playlists->size() || sortedRows.isEmpty()) return;
+
+    QList<VideoInfo>& videos = (*playlists)[playlistIndex].videos;
+    const bool displayed = playlistIndex == playlistIdx;
+
+    // 從後往前移除連續區段，前面的列號不受影響
+    int end = sortedRows.size() - 1;
+    while (end >= 0) {
+        int start = end;
+        while (start > 0 && sortedRows[start - 1] == sortedRows[start] - 1) {
+            start--;
+        }
+        const int first = sortedRows[start];
+        const int last = sortedRows[end];
+        end = start - 1;
+        if (first < 0 || last >= videos.size()) continue;
+
+        if (!displayed) {
+            videos.remove(first, last - first + 1);
+            continue;
+        }
+
+        beginRemoveRows(QModelIndex(), first, last);
+        videos.remove(first, last - first + 1);
+        if (currentRowIdx >= first && currentRowIdx <= last) {
+            currentRowIdx = -1;
+        } else if (currentRowIdx > last) {
+            currentRowIdx -= last - first + 1;
+        }
+        endRemoveRows();
+    }
+
+    // 後面各列的編號改變了
+    if (displayed && sortedRows.first() < videos.size()) {
+        emit dataChanged(index(sortedRows.first()), index(videos.size() - 1), { Qt::DisplayRole });
+    }
+}
+
+void PlaylistModel::removeVideo(int playlistIndex, int row)
+{
+    if (playlistIndex < 0 || playlistIndex >= playlists->size()) return;
+
+    QList<VideoInfo>& videos = (*playlists)[playlistIndex].videos;
+    if (row < 0 || row >= videos.size()) return;
+
+    if (playlistIndex != playlistIdx) {
+        videos.removeAt(row);
+        return;
+    }
+
+    beginRemoveRows(QModelIndex(), row, row);
+    videos.removeAt(row);
+    if (currentRowIdx == row) {
+        currentRowIdx = -1;
+    } else if (currentRowIdx > row) {
+        currentRowIdx--;
+    }
+    endRemoveRows();
+
+    // 後面各列的編號改變了
+    if (row < videos.size()) {
+        emit dataChanged(index(row), index(videos.size() - 1), { Qt::DisplayRole });
+    }
+}
+
+void PlaylistModel::refreshRow(int row)
+{
+    if (row < 0 || row >= rowCount()) return;
+    emit dataChanged(index(row), index(row));
+}
+
+void PlaylistModel::refreshFavorites()
+{
+    if (rowCount() == 0) return;
+    emit dataChanged(index(0), index(rowCount() - 1), { IsFavoriteRole });
+}
+
+// === PlaylistItemDelegate ===
+
+namespace {
+const int kItemPadding = 10;
+const QColor kAccentColor("#1DB954");
+const QColor kHoverColor("#282828");
+const QColor kBorderColor("#282828");
+const QColor kTextColor("#B3B3B3");
+const QColor kHighlightTextColor("#FFFFFF");
+const QColor kArtPlaceholderColor("#333333");
+}
+
+PlaylistItemDelegate::PlaylistItemDelegate(QObject* parent)
+    : QStyledItemDelegate(parent)
+    , coverArt(nullptr)
+{
+}
+
+void PlaylistItemDelegate::paint(QPainter* painter, const QStyleOptionViewItem& option,
+                                 const QModelIndex& index) const
+{
+    const bool isCurrent = index.data(PlaylistModel::IsCurrentRole).toBool();
+    const bool isSelected = option.state & QStyle::State_Selected;
+    const bool isHovered = option.state & QStyle::State_MouseOver;
+
+    painter->save();
+
+    // 背景與分隔線
+    const QRect rect = option.rect;
+    if (isCurrent || isSelected) {
+        painter->fillRect(rect, kAccentColor);
+    } else if (isHovered) {
+        painter->fillRect(rect, kHoverColor);
+    }
+    painter->setPen(kBorderColor);
+    painter->drawLine(rect.bottomLeft(), rect.bottomRight());
+
+    // 文字：第一行為編號與標題，第二行為頻道
+    QFont font = option.font;
+    if (isCurrent) {
+        font.setBold(true);
+    }
+    painter->setFont(font);
+    painter->setPen((isCurrent || isSelected || isHovered) ? kHighlightTextColor : kTextColor);
+
+    const QFontMetrics metrics(font);
+    QRect textRect = rect.adjusted(kItemPadding, kItemPadding, -kItemPadding, -kItemPadding - 1);
+
+    // 封面：與兩行文字同高的方塊；只查記憶體快取，沒有命中時由背景載入後重繪
+    if (coverArt && index.data(PlaylistModel::IsLocalFileRole).toBool()) {
+        const int side = metrics.lineSpacing() * 2;
+        const QRect artRect(textRect.left(), textRect.top(), side, side);
+        const QPixmap cover = coverArt->cover(index.data(PlaylistModel::ThumbnailRole).toString(),
+                                              CoverArtCache::ListSize);
+        if (cover.isNull()) {
+            painter->fillRect(artRect, kArtPlaceholderColor);
+        } else {
+            const QSize size = (cover.size() / cover.devicePixelRatio()).scaled(artRect.size(), Qt::KeepAspectRatio);
+            QRect target(QPoint(0, 0), size);
+            target.moveCenter(artRect.center());
+            painter->setRenderHint(QPainter::SmoothPixmapTransform);
+            painter->drawPixmap(target, cover);
+        }
+        textRect.setLeft(artRect.right() + 1 + kItemPadding);
+    }
+    const QString titleLine = QString("%1. %2").arg(index.row() + 1)
+                                  .arg(index.data(PlaylistModel::TitleRole).toString());
+    const QString channelLine = "   " + index.data(PlaylistModel::ChannelRole).toString();
+
+    const int baseline = textRect.top() + metrics.ascent();
+    painter->drawText(textRect.left(), baseline,
+                      metrics.elidedText(titleLine, Qt::ElideRight, textRect.width()));
+    painter->drawText(textRect.left(), baseline + metrics.lineSpacing(),
+                      metrics.elidedText(channelLine, Qt::ElideRight, textRect.width()));
+
+    painter->restore();
+}
+
+QSize PlaylistItemDelegate::sizeHint(const QStyleOptionViewItem& option,
+                                     const QModelIndex& index) const
+{
+    Q_UNUSED(index);
+
+    // 所有列高度相同，配合 setUniformItemSizes 只需計算一次
+    const QFontMetrics metrics(option.font);
+    return QSize(option.rect.width(), metrics.lineSpacing() * 2 + kItemPadding * 2 + 1);
+}
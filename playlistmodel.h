@@ -0,0 +1,102 @@
+#ifndef PLAYLISTMODEL_H
+#define PLAYLISTMODEL_H
+
+#include <QAbstractListModel>
+#include <QStyledItemDelegate>
+#include <QList>
+#include <QSet>
+#include <QUrl>
+#include "playlist.h"
+
+class CoverArtCache;
+
+// 播放清單模型：直接包裝 Playlist::videos，不複製任何資料
+// 所有對播放清單內容的修改都經過這裡，以便發出精細的 rowsInserted/dataChanged 信號
+class PlaylistModel : public QAbstractListModel
+{
+    Q_OBJECT
+
+public:
+    enum Roles {
+        TitleRole = Qt::UserRole + 1,   // 標題
+        ChannelRole,                    // 頻道/藝術家
+        IsCurrentRole,                  // 是否為當前播放的項目
+        IsFavoriteRole,                 // 是否為最愛
+        IsLocalFileRole,                // 是否為本地檔案
+        ThumbnailRole                   // 封面縮圖的 URL
+    };
+
+    explicit PlaylistModel(QList<Playlist>* playlists, QObject* parent = nullptr);
+
+    int rowCount(const QModelIndex& parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex& index, int role = Qt::DisplayRole) const override;
+
+    // 拖放：清單內拖曳為重新排序，從外部拖入檔案或網址時以 urlsDropped 交給 Widget
+    Qt::ItemFlags flags(const QModelIndex& index) const override;
+    Qt::DropActions supportedDropActions() const override;
+    Qt::DropActions supportedDragActions() const override;
+    QStringList mimeTypes() const override;
+    QMimeData* mimeData(const QModelIndexList& indexes) const override;
+    bool canDropMimeData(const QMimeData* data, Qt::DropAction action, int row, int column,
+                         const QModelIndex& parent) const override;
+    bool dropMimeData(const QMimeData* data, Qt::DropAction action, int row, int column,
+                      const QModelIndex& parent) override;
+
+    // 切換顯示的播放清單（唯一會重置整個模型的操作）
+    void setPlaylistIndex(int index);
+    int playlistIndex() const { return playlistIdx; }
+
+    // 更新當前播放的項目，只重繪新舊兩列
+    void setCurrentRow(int row);
+    int currentRow() const { return currentRowIdx; }
+
+    // 修改任意播放清單；只有正在顯示的播放清單才會發出信號
+    void appendVideo(int playlistIndex, const VideoInfo& video);
+    void removeVideo(int playlistIndex, int row);
+    // 批次版本：整批只發出一次 rowsInserted，移除時每個連續區段一次
+    void appendVideos(int playlistIndex, const QList<VideoInfo>& videos);
+    void removeVideos(int playlistIndex, const QList<int>& sortedRows);
+    void insertVideos(int playlistIndex, int row, const QList<VideoInfo>& videos);
+    // sortedRows 依原順序移到 destination（原編號）之前；每個連續區段一次 rowsMoved，不重置模型
+    bool moveVideos(int playlistIndex, const QList<int>& sortedRows, int destination);
+    void refreshRow(int row);
+
+    // 最愛狀態由共用的 trackKey 集合決定，各播放清單中同一首曲目讀到相同的值
+    void setFavoriteKeys(const QSet<QString>* keys) { favoriteKeys = keys; }
+    void refreshFavorites();
+
+signals:
+    void videosMoved(int playlistIndex, const QList<int>& sortedRows, int destination);
+    void urlsDropped(int playlistIndex, int row, const QList<QUrl>& urls);
+
+private:
+    const Playlist* displayedPlaylist() const;
+    void moveBlock(QList<VideoInfo>& videos, int first, int count, int destination, bool displayed);
+
+    QList<Playlist>* playlists;
+    const QSet<QString>* favoriteKeys;
+    int playlistIdx;
+    int currentRowIdx;
+};
+
+// 播放清單項目繪製器：只繪製可見的列，不為每一列配置 QListWidgetItem
+// 設定封面快取後，本地曲目在左側顯示封面；還沒載入的封面先畫空白方塊，不在繪製時讀檔
+class PlaylistItemDelegate : public QStyledItemDelegate
+{
+    Q_OBJECT
+
+public:
+    explicit PlaylistItemDelegate(QObject* parent = nullptr);
+
+    void setCoverArtCache(CoverArtCache* cache) { coverArt = cache; }
+
+    void paint(QPainter* painter, const QStyleOptionViewItem& option,
+               const QModelIndex& index) const override;
+    QSize sizeHint(const QStyleOptionViewItem& option,
+                   const QModelIndex& index) const override;
+
+private:
+    CoverArtCache* coverArt;
+};
+
+#endif // PLAYLISTMODEL_H
@@ -0,0 +1,340 @@
+#include "playliststore.h"
+#include "tracing.h"
+#ifdef HAVE_SQLITE_STORE
+#include "librarystore.h"
+#endif
+#include <QDir>
+#include <QFile>
+#include <QSaveFile>
+#include <QSet>
+#include <QJsonDocument>
+#include <QJsonArray>
+#include <QCryptographicHash>
+
+QJsonObject videoToJson(const VideoInfo& video)
+{
+    QJsonObject videoObj;
+    videoObj["videoId"] = video.videoId();
+    videoObj["filePath"] = video.filePath();
+    videoObj["title"] = video.title();
+    videoObj["channelTitle"] = video.channelTitle();
+    videoObj["thumbnailUrl"] = video.thumbnailUrl();
+    videoObj["description"] = video.description();
+    videoObj["isFavorite"] = video.isFavorite();
+    videoObj["isLocalFile"] = video.isLocalFile();
+    return videoObj;
+}
+
+VideoInfo videoFromJson(const QJsonObject& videoObj)
+{
+    VideoInfo video;
+    video.setVideoId(videoObj["videoId"].toString());
+    video.setFilePath(videoObj["filePath"].toString());
+    video.setTitle(videoObj["title"].toString());
+    video.setChannelTitle(videoObj["channelTitle"].toString());
+    video.setThumbnailUrl(videoObj["thumbnailUrl"].toString());
+    video.setDescription(videoObj["description"].toString());
+    video.setFavorite(videoObj["isFavorite"].toBool());
+    video.setLocalFile(videoObj["isLocalFile"].toBool());
+    return video;
+}
+
+QJsonObject playlistToJson(const Playlist& playlist)
+{
+    QJsonObject playlistObj;
+    playlistObj["name"] = playlist.name;
+
+    QJsonArray videosArray;
+    for (const VideoInfo& video : playlist.videos) {
+        videosArray.append(videoToJson(video));
+    }
+    playlistObj["videos"] = videosArray;
+    return playlistObj;
+}
+
+Playlist playlistFromJson(const QJsonObject& playlistObj)
+{
+    Playlist playlist;
+    playlist.name = playlistObj["name"].toString();
+
+    const QJsonArray videosArray = playlistObj["videos"].toArray();
+    playlist.videos.reserve(videosArray.size());
+    for (const QJsonValue& videoValue : videosArray) {
+        playlist.videos.append(videoFromJson(videoValue.toObject()));
+    }
+    return playlist;
+}
+
+PlaylistStore::PlaylistStore(const QString& dataDir, QObject* parent)
+    : QObject(parent)
+    , dataDir(dataDir)
+#ifdef HAVE_SQLITE_STORE
+    , libraryStore(nullptr)
+#endif
+{
+}
+
+PlaylistStore::~PlaylistStore()
+{
+#ifdef HAVE_SQLITE_STORE
+    delete libraryStore;
+#endif
+}
+
+QString PlaylistStore::shardsDir() const
+{
+    return dataDir + "/playlists";
+}
+
+QString PlaylistStore::shardFileName(const QString& playlistName)
+{
+    // 以名稱雜湊命名，播放清單名稱可以包含任何字元
+    QByteArray hash = QCryptographicHash::hash(playlistName.toUtf8(), QCryptographicHash::Sha1);
+    return QString::fromLatin1(hash.toHex().left(16)) + ".json";
+}
+
+bool PlaylistStore::load(QList<Playlist>& playlists, QString& lastPlaylistName,
+                         bool& needsFullSave, bool lazy)
+{
+    TRACE_SCOPE("PlaylistStore::load", "storage");
+    needsFullSave = false;
+    QDir().mkpath(dataDir);
+
+    bool indexLoaded = false;
+#ifdef HAVE_SQLITE_STORE
+    libraryStore = new LibraryStore(dataDir + "/library.sqlite");
+    if (libraryStore->open()) {
+        if (libraryStore->hasPlaylists()) {
+            indexLoaded = libraryStore->loadIndex(playlists, lastPlaylistName);
+        } else {
+            // 首次啟動：自動從 JSON 遷移，需要完整載入；資料庫還是空的，分片直接讀檔
+            needsFullSave = true;
+            return (loadShardIndex(playlists, lastPlaylistName) && loadAll(playlists, true))
+                || loadLegacyJson(playlists, lastPlaylistName);
+        }
+    } else {
+        // 無法開啟資料庫時使用 JSON 分片
+        delete libraryStore;
+        libraryStore = nullptr;
+    }
+#endif
+
+    if (!indexLoaded) {
+        indexLoaded = loadShardIndex(playlists, lastPlaylistName);
+    }
+    if (!indexLoaded) {
+        // 只有舊版單一 JSON 檔：載入後全部寫成分片
+        needsFullSave = true;
+        return loadLegacyJson(playlists, lastPlaylistName);
+    }
+
+    if (!lazy) {
+        return loadAll(playlists, false);
+    }
+
+    // 延遲載入：只解碼上次使用的播放清單
+    for (Playlist& playlist : playlists) {
+        if (playlist.name == lastPlaylistName) {
+            return loadPlaylist(playlist);
+        }
+    }
+    return playlists.isEmpty() || loadPlaylist(playlists.first());
+}
+
+bool PlaylistStore::loadAll(QList<Playlist>& playlists, bool fromShards)
+{
+    bool ok = true;
+    QHash<QString, VideoInfo> tracks;
+    for (Playlist& playlist : playlists) {
+        if (!playlist.loaded && !(fromShards ? loadShard(playlist) : loadPlaylist(playlist))) {
+            ok = false;
+        }
+        // 各播放清單中的同一首曲目共用一份紀錄
+        shareTrackRecords(playlist.videos, tracks);
+    }
+    return ok;
+}
+
+bool PlaylistStore::loadPlaylist(Playlist& playlist)
+{
+    TRACE_SCOPE("PlaylistStore::loadPlaylist", "storage");
+#ifdef HAVE_SQLITE_STORE
+    if (libraryStore) {
+        return libraryStore->loadPlaylist(playlist);
+    }
+#endif
+    return loadShard(playlist);
+}
+
+bool PlaylistStore::loadShard(Playlist& playlist)
+{
+    // 分片檔不存在時視為空的播放清單；讀取失敗時維持未載入
+    playlist.videos.clear();
+
+    QFile shardFile(shardsDir() + "/" + shardFileName(playlist.name));
+    if (!shardFile.open(QIODevice::ReadOnly)) {
+        if (shardFile.exists()) return false;
+        playlist.loaded = true;
+        return true;
+    }
+    QJsonDocument shardDoc = QJsonDocument::fromJson(shardFile.readAll());
+    if (!shardDoc.isObject()) {
+        return false;
+    }
+    playlist.videos = playlistFromJson(shardDoc.object()).videos;
+    playlist.loaded = true;
+    return true;
+}
+
+void PlaylistStore::releasePlaylist(const QString& playlistName)
+{
+#ifdef HAVE_SQLITE_STORE
+    if (libraryStore) {
+        libraryStore->releasePlaylist(playlistName);
+    }
+#else
+    Q_UNUSED(playlistName);
+#endif
+}
+
+bool PlaylistStore::loadShardIndex(QList<Playlist>& playlists, QString& lastPlaylistName)
+{
+    QFile indexFile(shardsDir() + "/index.json");
+    if (!indexFile.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+
+    QJsonDocument doc = QJsonDocument::fromJson(indexFile.readAll());
+    if (!doc.isObject()) {
+        return false;
+    }
+
+    QJsonObject rootObj = doc.object();
+    lastPlaylistName = rootObj["lastPlaylist"].toString();
+
+    // 索引只有名稱；分片檔名由名稱決定，需要時再讀取
+    playlists.clear();
+    const QJsonArray entries = rootObj["playlists"].toArray();
+    for (const QJsonValue& value : entries) {
+        Playlist playlist;
+        playlist.name = value.toObject()["name"].toString();
+        playlist.loaded = false;
+        playlists.append(playlist);
+    }
+    return true;
+}
+
+bool PlaylistStore::loadLegacyJson(QList<Playlist>& playlists, QString& lastPlaylistName)
+{
+    QFile file(dataDir + "/youtube_playlists.json");
+    if (!file.exists() || !file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+
+    QByteArray data = file.readAll();
+    file.close();
+
+    QJsonDocument doc = QJsonDocument::fromJson(data);
+    if (!doc.isObject()) {
+        return false;
+    }
+
+    QJsonObject rootObj = doc.object();
+    lastPlaylistName = rootObj["lastPlaylist"].toString();
+
+    QJsonArray playlistsArray = rootObj["playlists"].toArray();
+    playlists.clear();
+    for (const QJsonValue& value : playlistsArray) {
+        playlists.append(playlistFromJson(value.toObject()));
+    }
+    return true;
+}
+
+void PlaylistStore::save(const QList<Playlist>& changedPlaylists, const QStringList& playlistOrder,
+                         const QString& lastPlaylistName)
+{
+    TRACE_SCOPE("PlaylistStore::save", "storage");
+
+    // 合併上次寫入失敗的播放清單，同名時以較新的版本為準
+    QList<Playlist> toWrite = changedPlaylists;
+    if (!failedPlaylists.isEmpty()) {
+        for (const Playlist& playlist : changedPlaylists) {
+            failedPlaylists.remove(playlist.name);
+        }
+        for (const Playlist& playlist : std::as_const(failedPlaylists)) {
+            if (playlistOrder.contains(playlist.name)) {
+                toWrite.append(playlist);
+            }
+        }
+        failedPlaylists.clear();
+    }
+
+#ifdef HAVE_SQLITE_STORE
+    bool ok = libraryStore ? libraryStore->save(toWrite, playlistOrder, lastPlaylistName)
+                           : saveShards(toWrite, playlistOrder, lastPlaylistName);
+#else
+    bool ok = saveShards(toWrite, playlistOrder, lastPlaylistName);
+#endif
+
+    if (!ok) {
+        for (const Playlist& playlist : toWrite) {
+            failedPlaylists.insert(playlist.name, playlist);
+        }
+    }
+}
+
+bool PlaylistStore::saveShards(const QList<Playlist>& changedPlaylists, const QStringList& playlistOrder,
+                               const QString& lastPlaylistName)
+{
+    QDir dir(shardsDir());
+    if (!dir.exists() && !dir.mkpath(".")) {
+        return false;
+    }
+
+    // 每個變更的播放清單寫入自己的分片，QSaveFile 保證要嘛完整替換要嘛不變
+    bool ok = true;
+    for (const Playlist& playlist : changedPlaylists) {
+        QSaveFile file(dir.filePath(shardFileName(playlist.name)));
+        if (!file.open(QIODevice::WriteOnly)) {
+            ok = false;
+            continue;
+        }
+        file.write(QJsonDocument(playlistToJson(playlist)).toJson(QJsonDocument::Compact));
+        if (!file.commit()) {
+            ok = false;
+        }
+    }
+
+    // 索引最後寫入：中途崩潰時舊索引所指向的分片仍然完整
+    QJsonArray entries;
+    QSet<QString> liveFiles;
+    for (const QString& name : playlistOrder) {
+        QJsonObject entryObj;
+        entryObj["name"] = name;
+        entryObj["file"] = shardFileName(name);
+        entries.append(entryObj);
+        liveFiles.insert(shardFileName(name));
+    }
+    QJsonObject rootObj;
+    rootObj["playlists"] = entries;
+    rootObj["lastPlaylist"] = lastPlaylistName;
+
+    QSaveFile indexFile(dir.filePath("index.json"));
+    if (!indexFile.open(QIODevice::WriteOnly)) {
+        return false;
+    }
+    indexFile.write(QJsonDocument(rootObj).toJson());
+    if (!indexFile.commit()) {
+        return false;
+    }
+
+    // 刪除已移除播放清單的分片
+    const QStringList shardFiles = dir.entryList(QStringList() << "*.json", QDir::Files);
+    for (const QString& fileName : shardFiles) {
+        if (fileName != "index.json" && !liveFiles.contains(fileName)) {
+            dir.remove(fileName);
+        }
+    }
+
+    return ok;
+}
@@ -0,0 +1,61 @@
+#ifndef PLAYLISTSTORE_H
+#define PLAYLISTSTORE_H
+
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QList>
+#include <QHash>
+#include <QJsonObject>
+#include "playlist.h"
+
+class LibraryStore;
+
+// 播放清單 JSON 序列化（舊版 youtube_playlists.json 與分片檔共用同一格式）
+QJsonObject videoToJson(const VideoInfo& video);
+VideoInfo videoFromJson(const QJsonObject& videoObj);
+QJsonObject playlistToJson(const Playlist& playlist);
+Playlist playlistFromJson(const QJsonObject& playlistObj);
+
+// 播放清單儲存：在背景執行緒上運作，由 Widget 透過 invokeMethod 呼叫
+// - 有 SQLite 時寫入 library.sqlite
+// - 否則每個播放清單寫入 playlists/ 下各自的分片檔，並以 QSaveFile 原子替換
+class PlaylistStore : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit PlaylistStore(const QString& dataDir, QObject* parent = nullptr);
+    ~PlaylistStore();
+
+    // 載入播放清單索引；lazy 時只解碼上次使用的播放清單，其餘 loaded 為 false
+    // needsFullSave 表示資料來自舊格式，已完整載入且應全部重新寫入
+    bool load(QList<Playlist>& playlists, QString& lastPlaylistName, bool& needsFullSave, bool lazy);
+
+    // 按需解碼單一播放清單，以及在釋放記憶體後通知後端
+    bool loadPlaylist(Playlist& playlist);
+    void releasePlaylist(const QString& playlistName);
+
+    // 寫入變更過的播放清單與清單順序
+    void save(const QList<Playlist>& changedPlaylists, const QStringList& playlistOrder,
+              const QString& lastPlaylistName);
+
+private:
+    bool loadShardIndex(QList<Playlist>& playlists, QString& lastPlaylistName);
+    // fromShards：直接讀取分片檔（遷移到 SQLite 時資料庫還是空的）
+    bool loadAll(QList<Playlist>& playlists, bool fromShards);
+    bool loadShard(Playlist& playlist);
+    bool loadLegacyJson(QList<Playlist>& playlists, QString& lastPlaylistName);
+    bool saveShards(const QList<Playlist>& changedPlaylists, const QStringList& playlistOrder,
+                    const QString& lastPlaylistName);
+    QString shardsDir() const;
+    static QString shardFileName(const QString& playlistName);
+
+    QString dataDir;
+    QHash<QString, Playlist> failedPlaylists;  // 上次寫入失敗、需要重試的播放清單
+#ifdef HAVE_SQLITE_STORE
+    LibraryStore* libraryStore;
+#endif
+};
+
+#endif // PLAYLISTSTORE_H
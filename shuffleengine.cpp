@@ -0,0 +1,256 @@
+#include "shuffleengine.h"
+#include <algorithm>
+#include <utility>
+
+ShuffleEngine::ShuffleEngine()
+    : seedValue(0)
+    , scanPos(0)
+    , historyPos(-1)
+{
+}
+
+void ShuffleEngine::setSeed(quint32 seed)
+{
+    seedValue = seed;
+}
+
+void ShuffleEngine::clear()
+{
+    order.clear();
+    played.clear();
+    history.clear();
+    scanPos = 0;
+    historyPos = -1;
+}
+
+void ShuffleEngine::reset(int trackCount, int currentTrack)
+{
+    rng.seed(seedValue);
+    clear();
+
+    order.resize(trackCount);
+    for (int i = 0; i < trackCount; i++) {
+        order[i] = i;
+    }
+    played.resize(trackCount);
+    shuffleFrom(0);
+
+    if (currentTrack >= 0 && currentTrack < trackCount) {
+        played.setBit(currentTrack);
+        history.append(currentTrack);
+        historyPos = 0;
+    }
+}
+
+void ShuffleEngine::shuffleFrom(int first)
+{
+    // Fisher–Yates：只打亂 [first, n)
+    for (int i = order.size() - 1; i > first; i--) {
+        int j = first + int(rng.bounded(quint32(i - first + 1)));
+        std::swap(order[i], order[j]);
+    }
+}
+
+int ShuffleEngine::nextCandidate()
+{
+    // scanPos 只會往前移動，每一輪最多跨過每個位置一次
+    while (scanPos < order.size() && played.testBit(order[scanPos])) {
+        scanPos++;
+    }
+    return scanPos < order.size() ? order[scanPos] : -1;
+}
+
+int ShuffleEngine::upcoming(bool wrap)
+{
+    if (order.isEmpty()) return -1;
+
+    // 之前按過「上一首」：先沿著歷史往前走
+    if (historyPos + 1 < history.size()) {
+        return history[historyPos + 1];
+    }
+
+    int candidate = nextCandidate();
+    if (candidate >= 0 || !wrap) {
+        return candidate;
+    }
+
+    // 全部播完：開始新的一輪，避免馬上重複剛播完的曲目
+    int current = historyPos >= 0 ? history[historyPos] : -1;
+    played.fill(false);
+    scanPos = 0;
+    shuffleFrom(0);
+    if (order.size() > 1 && order[0] == current) {
+        int j = 1 + int(rng.bounded(quint32(order.size() - 1)));
+        std::swap(order[0], order[j]);
+    }
+    if (current >= 0 && order.size() > 1) {
+        played.setBit(current);
+    }
+    return nextCandidate();
+}
+
+int ShuffleEngine::previous() const
+{
+    return historyPos > 0 ? history[historyPos - 1] : -1;
+}
+
+void ShuffleEngine::select(int track)
+{
+    if (track < 0 || track >= order.size()) return;
+
+    if (historyPos >= 0 && history[historyPos] == track) {
+        return;
+    }
+    if (historyPos + 1 < history.size() && history[historyPos + 1] == track) {
+        historyPos++;
+        return;
+    }
+    if (historyPos > 0 && history[historyPos - 1] == track) {
+        historyPos--;
+        return;
+    }
+
+    // 新的一首：捨棄「上一首」之後的歷史
+    history.resize(historyPos + 1);
+    history.append(track);
+    historyPos++;
+    played.setBit(track);
+}
+
+void ShuffleEngine::insertTracks(int row, int count)
+{
+    if (count <= 0 || row < 0 || row > order.size()) return;
+
+    const int oldCount = order.size();
+    if (row < oldCount) {
+        // 插在中間：之後的曲目編號往後移
+        for (int& track : order) {
+            if (track >= row) track += count;
+        }
+        for (int& track : history) {
+            if (track >= row) track += count;
+        }
+        QBitArray shifted(oldCount + count);
+        for (int i = 0; i < oldCount; i++) {
+            if (played.testBit(i)) {
+                shifted.setBit(i < row ? i : i + count);
+            }
+        }
+        played = shifted;
+    } else {
+        played.resize(oldCount + count);
+    }
+
+    // 每一首新曲目與尚未播放部分中的隨機位置交換，維持均勻分布
+    for (int i = 0; i < count; i++) {
+        order.append(row + i);
+        int last = order.size() - 1;
+        int j = scanPos + int(rng.bounded(quint32(last - scanPos + 1)));
+        std::swap(order[last], order[j]);
+    }
+}
+
+void ShuffleEngine::removeTracks(const QList<int>& sortedRows)
+{
+    if (sortedRows.isEmpty() || order.isEmpty()) return;
+
+    // 舊編號 -> 新編號（被移除的為 -1）
+    const int oldCount = order.size();
+    QList<int> remap(oldCount);
+    int next = 0;
+    int removedIdx = 0;
+    for (int i = 0; i < oldCount; i++) {
+        if (removedIdx < sortedRows.size() && sortedRows[removedIdx] == i) {
+            remap[i] = -1;
+            removedIdx++;
+        } else {
+            remap[i] = next++;
+        }
+    }
+
+    QList<int> newOrder;
+    newOrder.reserve(next);
+    int newScanPos = 0;
+    for (int pos = 0; pos < oldCount; pos++) {
+        int track = remap[order[pos]];
+        if (track < 0) continue;
+        if (pos < scanPos) newScanPos++;
+        newOrder.append(track);
+    }
+
+    QBitArray newPlayed(next);
+    for (int i = 0; i < oldCount; i++) {
+        if (remap[i] >= 0 && played.testBit(i)) {
+            newPlayed.setBit(remap[i]);
+        }
+    }
+
+    QList<int> newHistory;
+    int newHistoryPos = -1;
+    for (int i = 0; i < history.size(); i++) {
+        int track = remap[history[i]];
+        if (track >= 0 && (newHistory.isEmpty() || newHistory.last() != track)) {
+            newHistory.append(track);
+        }
+        if (i == historyPos) {
+            newHistoryPos = newHistory.size() - 1;
+        }
+    }
+
+    order = std::move(newOrder);
+    played = newPlayed;
+    scanPos = newScanPos;
+    history = std::move(newHistory);
+    historyPos = newHistoryPos;
+}
+
+int ShuffleEngine::movedRow(int row, const QList<int>& sortedRows, int destination)
+{
+    if (row < 0 || sortedRows.isEmpty()) return row;
+
+    // 移動後的順序：destination 之前未選取的列、選取的列、其餘未選取的列
+    const int selectedBefore = int(std::lower_bound(sortedRows.cbegin(), sortedRows.cend(), row) - sortedRows.cbegin());
+    const int selectedBeforeDestination = int(std::lower_bound(sortedRows.cbegin(), sortedRows.cend(), destination) - sortedRows.cbegin());
+    const int insertAt = destination - selectedBeforeDestination;
+
+    if (selectedBefore < sortedRows.size() && sortedRows[selectedBefore] == row) {
+        return insertAt + selectedBefore;
+    }
+    const int unselectedBefore = row - selectedBefore;
+    return unselectedBefore < insertAt ? unselectedBefore : unselectedBefore + sortedRows.size();
+}
+
+void ShuffleEngine::moveTracks(const QList<int>& sortedRows, int destination)
+{
+    if (sortedRows.isEmpty() || order.isEmpty()) return;
+
+    // 舊編號 -> 新編號；一次掃描，不必逐列二分搜尋
+    const int count = order.size();
+    const int selectedBeforeDestination = int(std::lower_bound(sortedRows.cbegin(), sortedRows.cend(), destination) - sortedRows.cbegin());
+    const int insertAt = destination - selectedBeforeDestination;
+    QList<int> remap(count);
+    int selected = 0;
+    for (int i = 0; i < count; i++) {
+        if (selected < sortedRows.size() && sortedRows[selected] == i) {
+            remap[i] = insertAt + selected;
+            selected++;
+        } else {
+            const int unselectedBefore = i - selected;
+            remap[i] = unselectedBefore < insertAt ? unselectedBefore : unselectedBefore + sortedRows.size();
+        }
+    }
+
+    for (int& track : order) {
+        track = remap[track];
+    }
+    for (int& track : history) {
+        track = remap[track];
+    }
+    QBitArray newPlayed(count);
+    for (int i = 0; i < count; i++) {
+        if (played.testBit(i)) {
+            newPlayed.setBit(remap[i]);
+        }
+    }
+    played = newPlayed;
+}
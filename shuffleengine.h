@@ -0,0 +1,55 @@
+#ifndef SHUFFLEENGINE_H
+#define SHUFFLEENGINE_H
+
+#include <QList>
+#include <QBitArray>
+#include <QRandomGenerator>
+
+// 隨機播放引擎：預先以 Fisher–Yates 產生整個播放清單的排列
+// - upcoming() / previous() 都是 O(1)（跳過已播放項目為攤銷 O(1)）
+// - 已播放的曲目記錄在位元集合中，不再逐次建立未播放清單
+// - history 保存實際播放順序，「上一首」會回到真正播放過的曲目
+// - 同一個種子與相同的操作順序會產生相同的隨機序列
+class ShuffleEngine
+{
+public:
+    ShuffleEngine();
+
+    void setSeed(quint32 seed);
+    quint32 seed() const { return seedValue; }
+
+    // 以目前的種子重新產生排列；currentTrack 視為已播放並成為歷史的起點
+    void reset(int trackCount, int currentTrack = -1);
+    void clear();
+    int trackCount() const { return order.size(); }
+
+    // 下一首（不改變狀態，除了在全部播完且 wrap 時開始新的一輪）
+    int upcoming(bool wrap);
+    // 歷史中的上一首，沒有時回傳 -1
+    int previous() const;
+    // 記錄開始播放某一首：依歷史前進/後退，或作為新的一首加入歷史
+    void select(int track);
+
+    // 播放清單內容變更時維持排列有效：插入的曲目隨機放入尚未播放的部分
+    void insertTracks(int row, int count);
+    void removeTracks(const QList<int>& sortedRows);
+    // 拖放重新排序：sortedRows 依原順序移到 destination（原編號）之前；排列與歷史只改編號，不重新洗牌
+    void moveTracks(const QList<int>& sortedRows, int destination);
+
+    // 上述移動後 row 的新編號
+    static int movedRow(int row, const QList<int>& sortedRows, int destination);
+
+private:
+    void shuffleFrom(int first);
+    int nextCandidate();
+
+    quint32 seedValue;
+    QRandomGenerator rng;
+    QList<int> order;        // 排列：位置 -> 曲目
+    QBitArray played;        // 曲目 -> 本輪是否已播放
+    int scanPos;             // order 中第一個可能尚未播放的位置
+    QList<int> history;      // 實際播放順序
+    int historyPos;          // 目前播放的曲目在 history 中的位置
+};
+
+#endif // SHUFFLEENGINE_H
@@ -0,0 +1,213 @@
+#include "spectrumanalyzer.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+const int kHalfSize = SpectrumAnalyzer::kFftSize / 2;
+const double kPi = 3.14159265358979323846;
+const float kLowFrequency = 40.0f;
+const float kHighFrequency = 16000.0f;
+const float kFloorDb = -72.0f;         // 長條的底部
+const float kVuFloorDb = -60.0f;
+const float kFallPerSecond = 1.5f;     // 以整個高度為單位
+const float kPeakFallPerSecond = 0.8f;
+const double kPeakHoldSeconds = 0.5;
+
+float toLevel(float amplitude, float floorDb)
+{
+    if (amplitude <= 0.0f) return 0.0f;
+    const float db = 20.0f * std::log10(amplitude);
+    return qBound(0.0f, (db - floorDb) / -floorDb, 1.0f);
+}
+}
+
+SpectrumAnalyzer::SpectrumAnalyzer()
+    : rate(0)
+    , historyPos(0)
+    , levelSquares(0.0)
+    , levelSamples(0)
+    , levelPeak(0.0f)
+    , rmsLevel(0.0f)
+    , peakLevel(0.0f)
+{
+    // 與取樣率無關的表只算一次
+    window.resize(kFftSize);
+    for (int i = 0; i < kFftSize; i++) {
+        window[i] = float(0.5 - 0.5 * std::cos(2.0 * kPi * i / (kFftSize - 1)));
+    }
+
+    int bits = 0;
+    while ((1 << bits) < kHalfSize) bits++;
+    bitReverse.resize(kHalfSize);
+    for (int i = 0; i < kHalfSize; i++) {
+        int reversed = 0;
+        for (int b = 0; b < bits; b++) {
+            if (i & (1 << b)) reversed |= 1 << (bits - 1 - b);
+        }
+        bitReverse[i] = reversed;
+    }
+
+    twiddleRe.resize(kHalfSize);
+    twiddleIm.resize(kHalfSize);
+    for (int k = 0; k < kHalfSize; k++) {
+        twiddleRe[k] = float(std::cos(2.0 * kPi * k / kFftSize));
+        twiddleIm[k] = float(-std::sin(2.0 * kPi * k / kFftSize));
+    }
+
+    history.resize(kFftSize);
+    re.resize(kHalfSize);
+    im.resize(kHalfSize);
+    magnitude.resize(kHalfSize + 1);
+    reset(48000, 48);
+}
+
+void SpectrumAnalyzer::reset(int sampleRate, int barCount)
+{
+    rate = qMax(1, sampleRate);
+    barCount = qMax(1, barCount);
+
+    // 對數間隔的頻帶；低頻處幾個長條可能落在同一個頻率格
+    const float binHz = float(rate) / kFftSize;
+    const float high = std::min(kHighFrequency, rate * 0.45f);
+    const float low = std::min(kLowFrequency, high / 2.0f);
+    barStart.resize(barCount);
+    barEnd.resize(barCount);
+    for (int b = 0; b < barCount; b++) {
+        const float from = low * std::pow(high / low, float(b) / barCount);
+        const float to = low * std::pow(high / low, float(b + 1) / barCount);
+        const int start = qBound(1, int(from / binHz), kHalfSize);
+        barStart[b] = start;
+        barEnd[b] = qBound(start + 1, int(std::ceil(to / binHz)), kHalfSize + 1);
+    }
+
+    barLevels.resize(barCount);
+    peakLevels.resize(barCount);
+    peakHold.resize(barCount);
+    clear();
+}
+
+void SpectrumAnalyzer::clear()
+{
+    std::fill(history.begin(), history.end(), 0.0f);
+    historyPos = 0;
+    levelSquares = 0.0;
+    levelSamples = 0;
+    levelPeak = 0.0f;
+    std::fill(barLevels.begin(), barLevels.end(), 0.0f);
+    std::fill(peakLevels.begin(), peakLevels.end(), 0.0f);
+    std::fill(peakHold.begin(), peakHold.end(), 0.0);
+    rmsLevel = 0.0f;
+    peakLevel = 0.0f;
+}
+
+void SpectrumAnalyzer::push(const float* interleaved, qsizetype frames, int channels)
+{
+    if (channels <= 0 || frames <= 0) return;
+
+    // 只有最後 kFftSize 個畫格會進入歷史，但電平要看全部
+    const float scale = 1.0f / channels;
+    const qsizetype keepFrom = std::max<qsizetype>(0, frames - kFftSize);
+    for (qsizetype frame = 0; frame < frames; frame++) {
+        const float* in = interleaved + frame * channels;
+        float sum = 0.0f;
+        for (int c = 0; c < channels; c++) {
+            const float sample = in[c];
+            sum += sample;
+            levelSquares += double(sample) * sample;
+            levelPeak = std::max(levelPeak, std::fabs(sample));
+        }
+        if (frame >= keepFrom) {
+            history[historyPos] = sum * scale;
+            historyPos = (historyPos + 1) & (kFftSize - 1);
+        }
+    }
+    levelSamples += frames * channels;
+}
+
+void SpectrumAnalyzer::transform()
+{
+    // 偶數樣本放實部、奇數樣本放虛部，依位元反轉順序放入
+    for (int n = 0; n < kHalfSize; n++) {
+        const int even = 2 * n;
+        const int target = bitReverse[n];
+        re[target] = history[(historyPos + even) & (kFftSize - 1)] * window[even];
+        im[target] = history[(historyPos + even + 1) & (kFftSize - 1)] * window[even + 1];
+    }
+
+    // kFftSize / 2 點的 radix-2 蝴蝶運算；長度 N/2 的旋轉因子是 e^{-2πik/N} 取偶數項
+    for (int length = 2; length <= kHalfSize; length <<= 1) {
+        const int half = length / 2;
+        const int step = kFftSize / length;
+        for (int start = 0; start < kHalfSize; start += length) {
+            for (int j = 0; j < half; j++) {
+                const float wr = twiddleRe[j * step];
+                const float wi = twiddleIm[j * step];
+                const int a = start + j;
+                const int b = a + half;
+                const float tr = re[b] * wr - im[b] * wi;
+                const float ti = re[b] * wi + im[b] * wr;
+                re[b] = re[a] - tr;
+                im[b] = im[a] - ti;
+                re[a] += tr;
+                im[a] += ti;
+            }
+        }
+    }
+
+    // 拆成實數序列的頻譜：X[k] = (Z[k] + Z*[M-k]) / 2 - i·W^k·(Z[k] - Z*[M-k]) / 2
+    // 振幅以滿刻度正弦波（Hann 視窗的相干增益 0.5）為 1
+    const float norm = 4.0f / kFftSize;
+    magnitude[0] = std::fabs(re[0] + im[0]) * norm;
+    magnitude[kHalfSize] = std::fabs(re[0] - im[0]) * norm;
+    for (int k = 1; k < kHalfSize; k++) {
+        const float zr = re[k];
+        const float zi = im[k];
+        const float cr = re[kHalfSize - k];
+        const float ci = -im[kHalfSize - k];
+        const float evenRe = (zr + cr) * 0.5f;
+        const float evenIm = (zi + ci) * 0.5f;
+        const float oddRe = (zi - ci) * 0.5f;
+        const float oddIm = -(zr - cr) * 0.5f;
+        const float wr = twiddleRe[k];
+        const float wi = twiddleIm[k];
+        const float xr = evenRe + oddRe * wr - oddIm * wi;
+        const float xi = evenIm + oddRe * wi + oddIm * wr;
+        magnitude[k] = std::sqrt(xr * xr + xi * xi) * norm;
+    }
+}
+
+void SpectrumAnalyzer::analyze(double elapsedSeconds)
+{
+    transform();
+
+    const float fall = float(kFallPerSecond * elapsedSeconds);
+    const float peakFall = float(kPeakFallPerSecond * elapsedSeconds);
+    for (int b = 0; b < barLevels.size(); b++) {
+        float amplitude = 0.0f;
+        for (int k = barStart[b]; k < barEnd[b]; k++) {
+            amplitude = std::max(amplitude, magnitude[k]);
+        }
+        const float level = std::max(toLevel(amplitude, kFloorDb), barLevels[b] - fall);
+        barLevels[b] = level;
+
+        if (level >= peakLevels[b]) {
+            peakLevels[b] = level;
+            peakHold[b] = kPeakHoldSeconds;
+        } else if (peakHold[b] > 0.0) {
+            peakHold[b] -= elapsedSeconds;
+        } else {
+            peakLevels[b] = std::max(level, peakLevels[b] - peakFall);
+        }
+    }
+
+    // 沒有新樣本時電平照樣回落
+    float rms = 0.0f;
+    if (levelSamples > 0) {
+        rms = float(std::sqrt(levelSquares / levelSamples));
+    }
+    rmsLevel = std::max(toLevel(rms, kVuFloorDb), rmsLevel - fall);
+    peakLevel = std::max(toLevel(levelPeak, kVuFloorDb), peakLevel - fall);
+    levelSquares = 0.0;
+    levelSamples = 0;
+    levelPeak = 0.0f;
+}
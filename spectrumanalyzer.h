@@ -0,0 +1,64 @@
+#ifndef SPECTRUMANALYZER_H
+#define SPECTRUMANALYZER_H
+
+#include <QtGlobal>
+#include <QList>
+
+// 即時頻譜與 VU 電平：保留最近 kFftSize 個單聲道樣本，
+// 加 Hann 視窗後做實數 FFT（以一半長度的複數 radix-2 FFT 計算），再對應到對數頻率的長條
+// 長條上升立即反應、下降以固定速度回落，峰值標記停留一下再落下
+class SpectrumAnalyzer
+{
+public:
+    static const int kFftSize = 2048;
+
+    SpectrumAnalyzer();
+
+    void reset(int sampleRate, int barCount);
+
+    // 清除樣本歷史與所有長條（跳轉、換到其他來源時）
+    void clear();
+
+    // 交錯排列的 float 樣本（-1..1），各聲道平均成單聲道
+    void push(const float* interleaved, qsizetype frames, int channels);
+
+    // 以目前的歷史計算一次；elapsedSeconds 是距離上次計算的時間，用於回落速度
+    void analyze(double elapsedSeconds);
+
+    // 0..1；VU 電平為上次計算以來送入樣本的 RMS 與峰值
+    const QList<float>& bars() const { return barLevels; }
+    const QList<float>& peaks() const { return peakLevels; }
+    float rms() const { return rmsLevel; }
+    float peak() const { return peakLevel; }
+    int sampleRate() const { return rate; }
+
+private:
+    void transform();
+
+    int rate;
+    QList<float> history;             // 環狀的單聲道歷史，長度 kFftSize
+    int historyPos;
+    double levelSquares;              // 上次計算以來的平方和、樣本數與峰值
+    qint64 levelSamples;
+    float levelPeak;
+
+    // 預先計算的表
+    QList<float> window;
+    QList<int> bitReverse;            // kFftSize / 2 點複數 FFT 的位元反轉順序
+    QList<float> twiddleRe;           // e^{-2πik/N}，k < N/2
+    QList<float> twiddleIm;
+    QList<int> barStart;              // 每個長條涵蓋的頻率格 [barStart, barEnd)
+    QList<int> barEnd;
+
+    QList<float> re;
+    QList<float> im;
+    QList<float> magnitude;           // kFftSize / 2 + 1 個頻率格
+
+    QList<float> barLevels;
+    QList<float> peakLevels;
+    QList<double> peakHold;           // 峰值標記還要停留的秒數
+    float rmsLevel;
+    float peakLevel;
+};
+
+#endif // SPECTRUMANALYZER_H
@@ -0,0 +1,316 @@
+#include "spectrumview.h"
+#include "crossfadeplayer.h"
+#include <QPainter>
+#include <QPaintEvent>
+#include <QThread>
+#include <QTimer>
+#include <QAudioBuffer>
+#include <QAudioFormat>
+#include <QMediaPlayer>
+
+// QAudioBufferOutput 從 Qt 6.8 開始提供；較舊的版本只有自有管線有頻譜
+#if QT_VERSION >= QT_VERSION_CHECK(6, 8, 0)
+#include <QAudioBufferOutput>
+#define SPECTRUM_BUFFER_OUTPUT 1
+#endif
+
+namespace {
+const int kBarCount = 48;
+const int kTapReadFrames = 4096;       // 每次從管線取樣讀出的畫格數
+const int kVuHeight = 6;
+const int kBarGap = 2;
+const QColor kBackgroundColor("#000000");
+const QColor kBarColor("#1DB954");
+const QColor kPeakColor("#B3B3B3");
+const QColor kVuTrackColor("#282828");
+const QColor kVuPeakColor("#FFFFFF");
+}
+
+// === SpectrumWorker ===
+
+SpectrumWorker::SpectrumWorker(SpectrumView* owner, CrossfadePlayer* pipeline, int intervalMs)
+    : owner(owner)
+    , pipeline(pipeline)
+    , tickTimer(nullptr)
+    , intervalMs(intervalMs)
+    , fromPipeline(false)
+    , running(false)
+{
+}
+
+void SpectrumWorker::start(bool pipelineSource)
+{
+    // 計時器必須在使用它的執行緒上建立
+    if (!tickTimer) {
+        tickTimer = new QTimer(this);
+        tickTimer->setTimerType(Qt::PreciseTimer);
+        tickTimer->setInterval(intervalMs);
+        connect(tickTimer, &QTimer::timeout, this, &SpectrumWorker::tick);
+    }
+
+    if (pipelineSource != fromPipeline) {
+        analyzer.clear();
+    }
+    fromPipeline = pipelineSource;
+
+    // 取樣關閉前留下的舊樣本直接丟棄
+    if (fromPipeline) {
+        if (analyzer.sampleRate() != pipeline->sampleRate()) {
+            analyzer.reset(pipeline->sampleRate(), kBarCount);
+        }
+        samples.resize(qsizetype(kTapReadFrames) * 2);
+        while (pipeline->readAnalysisTap(samples.data(), kTapReadFrames) > 0) {
+        }
+    }
+
+    running = true;
+    clock.start();
+    tickTimer->start();
+}
+
+void SpectrumWorker::stop()
+{
+    running = false;
+    if (tickTimer) {
+        tickTimer->stop();
+    }
+}
+
+void SpectrumWorker::clear()
+{
+    analyzer.clear();
+}
+
+void SpectrumWorker::feed(const QAudioBuffer& buffer)
+{
+    // 停止後還在佇列中的緩衝直接忽略
+    if (!running || fromPipeline || !buffer.isValid()) return;
+
+    const QAudioFormat format = buffer.format();
+    const int channels = format.channelCount();
+    const qsizetype frames = buffer.frameCount();
+    if (channels <= 0 || format.sampleRate() <= 0 || frames <= 0) return;
+    if (format.sampleRate() != analyzer.sampleRate()) {
+        analyzer.reset(format.sampleRate(), kBarCount);
+    }
+
+    const qsizetype count = frames * channels;
+    const float* data = nullptr;
+    if (format.sampleFormat() == QAudioFormat::Float) {
+        data = buffer.constData<float>();
+    } else {
+        samples.resize(count);
+        float* out = samples.data();
+        switch (format.sampleFormat()) {
+        case QAudioFormat::UInt8: {
+            const quint8* in = buffer.constData<quint8>();
+            for (qsizetype i = 0; i < count; i++) out[i] = (in[i] - 128) / 128.0f;
+            break;
+        }
+        case QAudioFormat::Int16: {
+            const qint16* in = buffer.constData<qint16>();
+            for (qsizetype i = 0; i < count; i++) out[i] = in[i] / 32768.0f;
+            break;
+        }
+        case QAudioFormat::Int32: {
+            const qint32* in = buffer.constData<qint32>();
+            for (qsizetype i = 0; i < count; i++) out[i] = in[i] / 2147483648.0f;
+            break;
+        }
+        default:
+            return;
+        }
+        data = out;
+    }
+    analyzer.push(data, frames, channels);
+}
+
+void SpectrumWorker::tick()
+{
+    // 管線的取樣全部取走：頻譜只看最後 kFftSize 個畫格，VU 電平要看這段期間的全部樣本
+    if (fromPipeline) {
+        qsizetype frames = 0;
+        while ((frames = pipeline->readAnalysisTap(samples.data(), kTapReadFrames)) > 0) {
+            analyzer.push(samples.constData(), frames, 2);
+        }
+    }
+
+    // GUI 執行緒還沒畫出上一份結果時跳過，計時繼續累積，下次回落的量不變
+    if (owner->framePending.load(std::memory_order_acquire)) return;
+    analyzer.analyze(clock.restart() / 1000.0);
+
+    SpectrumFrame frame;
+    frame.bars = analyzer.bars();
+    frame.peaks = analyzer.peaks();
+    frame.rms = analyzer.rms();
+    frame.peak = analyzer.peak();
+    owner->framePending.store(true, std::memory_order_release);
+    SpectrumView* view = owner;
+    QMetaObject::invokeMethod(view, [view, frame]() {
+        view->showFrame(frame);
+    });
+}
+
+// === SpectrumView ===
+
+SpectrumView::SpectrumView(CrossfadePlayer* pipeline, int fps, QWidget* parent)
+    : QWidget(parent)
+    , pipeline(pipeline)
+    , intervalMs(fps > 0 ? qMax(1, 1000 / fps) : 0)
+    , running(false)
+    , fromPipeline(false)
+    , attachedPlayer(nullptr)
+    , bufferOutput(nullptr)
+    , framePending(false)
+{
+    setMinimumHeight(96);
+    frame.bars.fill(0.0f, kBarCount);
+    frame.peaks.fill(0.0f, kBarCount);
+
+    if (intervalMs <= 0) {
+        thread = nullptr;
+        worker = nullptr;
+        hide();
+        return;
+    }
+
+    // 分析在自己的執行緒上進行，GUI 執行緒只負責畫
+    thread = new QThread(this);
+    thread->setObjectName("spectrum");
+    worker = new SpectrumWorker(this, pipeline, intervalMs);
+    worker->moveToThread(thread);
+    connect(thread, &QThread::finished, worker, &QObject::deleteLater);
+    thread->start();
+
+#ifdef SPECTRUM_BUFFER_OUTPUT
+    bufferOutput = new QAudioBufferOutput(this);
+    connect(bufferOutput, &QAudioBufferOutput::audioBufferReceived, worker, &SpectrumWorker::feed);
+#endif
+}
+
+SpectrumView::~SpectrumView()
+{
+    attachPlayer(nullptr);
+    if (thread) {
+        pipeline->setAnalysisTapEnabled(false);
+        thread->quit();
+        thread->wait();
+    }
+}
+
+QSize SpectrumView::sizeHint() const
+{
+    return QSize(400, 120);
+}
+
+void SpectrumView::start(QMediaPlayer* player)
+{
+    if (!worker) return;
+
+    const bool pipelineSource = player == nullptr;
+    if (running && pipelineSource == fromPipeline && player == attachedPlayer) return;
+
+    // 沒有 QAudioBufferOutput 時 QMediaPlayer 播放的曲目沒有頻譜
+    if (!pipelineSource && !bufferOutput) {
+        stop(true);
+        return;
+    }
+
+    running = true;
+    fromPipeline = pipelineSource;
+    pipeline->setAnalysisTapEnabled(pipelineSource);
+    attachPlayer(player);
+    QMetaObject::invokeMethod(worker, [worker = worker, pipelineSource]() {
+        worker->start(pipelineSource);
+    });
+}
+
+void SpectrumView::stop(bool clearDisplay)
+{
+    if (!worker) return;
+
+    if (running) {
+        running = false;
+        pipeline->setAnalysisTapEnabled(false);
+        attachPlayer(nullptr);
+        QMetaObject::invokeMethod(worker, [worker = worker]() {
+            worker->stop();
+        });
+    }
+
+    if (clearDisplay) {
+        QMetaObject::invokeMethod(worker, [worker = worker]() {
+            worker->clear();
+        });
+        frame.bars.fill(0.0f, kBarCount);
+        frame.peaks.fill(0.0f, kBarCount);
+        frame.rms = 0.0f;
+        frame.peak = 0.0f;
+        update();
+    }
+}
+
+void SpectrumView::attachPlayer(QMediaPlayer* player)
+{
+    if (player == attachedPlayer) return;
+#ifdef SPECTRUM_BUFFER_OUTPUT
+    // 一個 QAudioBufferOutput 只能接在一個播放器上；沒接上時播放器不會轉換緩衝
+    if (attachedPlayer) {
+        attachedPlayer->setAudioBufferOutput(nullptr);
+    }
+    if (player) {
+        player->setAudioBufferOutput(bufferOutput);
+    }
+#endif
+    attachedPlayer = player;
+}
+
+void SpectrumView::showFrame(const SpectrumFrame& newFrame)
+{
+    framePending.store(false, std::memory_order_release);
+
+    // 已停止後才送到的結果不顯示
+    if (!running) return;
+    frame = newFrame;
+    update();
+}
+
+void SpectrumView::paintEvent(QPaintEvent* event)
+{
+    Q_UNUSED(event);
+    QPainter painter(this);
+    painter.setRenderHint(QPainter::Antialiasing);
+    painter.setPen(Qt::NoPen);
+    painter.setBrush(kBackgroundColor);
+    painter.drawRoundedRect(rect(), 8, 8);
+    painter.setRenderHint(QPainter::Antialiasing, false);
+
+    const QRect area = rect().adjusted(12, 12, -12, -12);
+    const int barsHeight = area.height() - kVuHeight - 8;
+    const int count = frame.bars.size();
+    if (count <= 0 || barsHeight <= 0 || area.width() <= 0) return;
+
+    // 頻譜長條與峰值標記
+    const double slot = double(area.width()) / count;
+    const int barWidth = qMax(1, int(slot) - kBarGap);
+    for (int b = 0; b < count; b++) {
+        const int x = area.left() + int(b * slot);
+        const int height = int(frame.bars[b] * barsHeight);
+        if (height > 0) {
+            painter.fillRect(x, area.top() + barsHeight - height, barWidth, height, kBarColor);
+        }
+        const int peakY = area.top() + barsHeight - int(frame.peaks[b] * barsHeight);
+        if (frame.peaks[b] > 0.0f) {
+            painter.fillRect(x, qMax(area.top(), peakY - 2), barWidth, 2, kPeakColor);
+        }
+    }
+
+    // VU 電平：填滿的是 RMS，白線是峰值
+    const QRect vu(area.left(), area.bottom() - kVuHeight + 1, area.width(), kVuHeight);
+    painter.fillRect(vu, kVuTrackColor);
+    painter.fillRect(vu.left(), vu.top(), int(frame.rms * vu.width()), vu.height(), kBarColor);
+    if (frame.peak > 0.0f) {
+        const int peakX = vu.left() + qMin(vu.width() - 2, int(frame.peak * vu.width()));
+        painter.fillRect(peakX, vu.top(), 2, vu.height(), kVuPeakColor);
+    }
+}
@@ -0,0 +1,96 @@
+#ifndef SPECTRUMVIEW_H
+#define SPECTRUMVIEW_H
+
+#include <QWidget>
+#include <QList>
+#include <QElapsedTimer>
+#include <atomic>
+#include "spectrumanalyzer.h"
+
+class QAudioBuffer;
+class QAudioBufferOutput;
+class QMediaPlayer;
+class QThread;
+class QTimer;
+class CrossfadePlayer;
+
+class SpectrumView;
+
+// 畫一次所需的資料
+struct SpectrumFrame {
+    QList<float> bars;
+    QList<float> peaks;
+    float rms = 0.0f;
+    float peak = 0.0f;
+};
+
+// 分析執行緒：取樣、FFT 與長條計算都在這裡，每個畫面更新週期最多送出一份結果
+class SpectrumWorker : public QObject
+{
+    Q_OBJECT
+
+public:
+    SpectrumWorker(SpectrumView* owner, CrossfadePlayer* pipeline, int intervalMs);
+
+    // 以下都在分析執行緒上呼叫
+    void start(bool fromPipeline);
+    void stop();
+    void clear();
+    void feed(const QAudioBuffer& buffer);
+
+private:
+    void tick();
+
+    SpectrumView* owner;
+    CrossfadePlayer* pipeline;
+    QTimer* tickTimer;
+    int intervalMs;
+    bool fromPipeline;
+    bool running;
+    SpectrumAnalyzer analyzer;
+    QElapsedTimer clock;              // 距離上次計算的時間，決定長條回落的量
+    QList<float> samples;             // 從管線取出或轉換成 float 的交錯樣本，重複使用
+};
+
+// 正在播放的本地曲目的即時頻譜與 VU 電平
+// 樣本來自自有管線的輸出取樣，或 QMediaPlayer 的 QAudioBufferOutput（Qt 6.8 起）；
+// 停止時分析執行緒的計時器、管線的取樣與 QAudioBufferOutput 都關閉，不做任何工作
+class SpectrumView : public QWidget
+{
+    Q_OBJECT
+
+public:
+    // fps：分析與重繪的上限；0 表示不啟用，元件隱藏且 start() 不做任何事
+    SpectrumView(CrossfadePlayer* pipeline, int fps, QWidget* parent = nullptr);
+    ~SpectrumView();
+
+    // 開始分析：player 為 nullptr 時讀取自有管線的輸出，否則取得該播放器解碼後的緩衝
+    void start(QMediaPlayer* player);
+
+    // 停止分析，畫面停在最後一份結果；clearDisplay 時清空（播放停止時）
+    void stop(bool clearDisplay);
+
+    QSize sizeHint() const override;
+
+protected:
+    void paintEvent(QPaintEvent* event) override;
+
+private:
+    friend class SpectrumWorker;
+
+    void attachPlayer(QMediaPlayer* player);
+    void showFrame(const SpectrumFrame& frame);
+
+    CrossfadePlayer* pipeline;
+    int intervalMs;
+    bool running;
+    bool fromPipeline;
+    QMediaPlayer* attachedPlayer;
+    QAudioBufferOutput* bufferOutput;
+    QThread* thread;
+    SpectrumWorker* worker;
+    std::atomic<bool> framePending;   // 上一份結果還沒畫出時分析端不再計算
+    SpectrumFrame frame;
+};
+
+#endif // SPECTRUMVIEW_H
@@ -0,0 +1,173 @@
+// PlaylistStore 的載入與遷移
+
+#include <QtTest>
+#include <QTemporaryDir>
+#include <QDir>
+#include <QFile>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QJsonArray>
+#include <QCryptographicHash>
+
+#include "playlist.h"
+#include "playliststore.h"
+
+namespace {
+
+VideoInfo localTrack(const QString& filePath, const QString& title, bool favorite = false)
+{
+    VideoInfo video;
+    video.setFilePath(filePath);
+    video.setTitle(title);
+    video.setChannelTitle("本地音樂");
+    video.setFavorite(favorite);
+    video.setLocalFile(true);
+    return video;
+}
+
+VideoInfo youtubeTrack(const QString& videoId, const QString& title)
+{
+    VideoInfo video;
+    video.setVideoId(videoId);
+    video.setTitle(title);
+    video.setChannelTitle("頻道");
+    return video;
+}
+
+// 與 PlaylistStore::shardFileName 相同的命名
+QString shardFileName(const QString& playlistName)
+{
+    QByteArray hash = QCryptographicHash::hash(playlistName.toUtf8(), QCryptographicHash::Sha1);
+    return QString::fromLatin1(hash.toHex().left(16)) + ".json";
+}
+
+bool writeJson(const QString& filePath, const QJsonObject& object)
+{
+    QFile file(filePath);
+    return file.open(QIODevice::WriteOnly) && file.write(QJsonDocument(object).toJson()) > 0;
+}
+
+// 只有分片檔的資料目錄（自動儲存改成分片之後、啟用 SQLite 之前的版本）
+bool writeShards(const QString& dataDir, const QList<Playlist>& playlists, const QString& lastPlaylistName)
+{
+    const QString shardsDir = dataDir + "/playlists";
+    if (!QDir().mkpath(shardsDir)) return false;
+
+    QJsonArray entries;
+    for (const Playlist& playlist : playlists) {
+        QJsonObject entry;
+        entry["name"] = playlist.name;
+        entry["file"] = shardFileName(playlist.name);
+        entries.append(entry);
+        if (!writeJson(shardsDir + "/" + shardFileName(playlist.name), playlistToJson(playlist))) {
+            return false;
+        }
+    }
+    QJsonObject root;
+    root["playlists"] = entries;
+    root["lastPlaylist"] = lastPlaylistName;
+    return writeJson(shardsDir + "/index.json", root);
+}
+
+QList<Playlist> sampleLibrary()
+{
+    Playlist favorites;
+    favorites.name = "我的最愛";
+    favorites.videos = { localTrack("/music/a.flac", "A", true), youtubeTrack("dQw4w9WgXcQ", "Y") };
+
+    Playlist road;
+    road.name = "公路 / 旅行";
+    road.videos = { localTrack("/music/b.mp3", "B"), localTrack("/music/a.flac", "A"),
+                    localTrack("/music/c.ogg", "C") };
+
+    Playlist empty;
+    empty.name = "空的";
+
+    return { favorites, road, empty };
+}
+
+void compareTracks(const QList<VideoInfo>& actual, const QList<VideoInfo>& expected)
+{
+    QCOMPARE(actual.size(), expected.size());
+    for (int i = 0; i < expected.size(); i++) {
+        QCOMPARE(actual[i].videoId(), expected[i].videoId());
+        QCOMPARE(actual[i].filePath(), expected[i].filePath());
+        QCOMPARE(actual[i].title(), expected[i].title());
+        QCOMPARE(actual[i].isFavorite(), expected[i].isFavorite());
+        QCOMPARE(actual[i].isLocalFile(), expected[i].isLocalFile());
+    }
+}
+
+QStringList playlistNames(const QList<Playlist>& playlists)
+{
+    QStringList names;
+    for (const Playlist& playlist : playlists) {
+        names.append(playlist.name);
+    }
+    return names;
+}
+
+}
+
+class PlaylistStoreTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void migratesShardOnlyDataDir();
+};
+
+void PlaylistStoreTest::migratesShardOnlyDataDir()
+{
+    QTemporaryDir dataDir;
+    QVERIFY(dataDir.isValid());
+    const QList<Playlist> library = sampleLibrary();
+    QVERIFY(writeShards(dataDir.path(), library, "公路 / 旅行"));
+
+    // 第一次啟動：即使是延遲載入，遷移也要完整解碼每個分片
+    {
+        PlaylistStore store(dataDir.path());
+        QList<Playlist> playlists;
+        QString lastPlaylistName;
+        bool needsFullSave = false;
+        QVERIFY(store.load(playlists, lastPlaylistName, needsFullSave, true));
+        QCOMPARE(lastPlaylistName, QString("公路 / 旅行"));
+        QCOMPARE(playlistNames(playlists), playlistNames(library));
+        for (int i = 0; i < library.size(); i++) {
+            QVERIFY(playlists[i].loaded);
+            compareTracks(playlists[i].videos, library[i].videos);
+        }
+
+#ifdef HAVE_SQLITE_STORE
+        // 分片來自舊格式：全部寫入 SQLite
+        QVERIFY(needsFullSave);
+        QVERIFY(!QFile::exists(dataDir.filePath("youtube_playlists.json")));
+#endif
+        store.save(playlists, playlistNames(playlists), lastPlaylistName);
+    }
+
+    // 分片移開後重新啟動：資料必須完全來自新的儲存
+#ifdef HAVE_SQLITE_STORE
+    QVERIFY(QDir(dataDir.filePath("playlists")).removeRecursively());
+    QVERIFY(QFile::exists(dataDir.filePath("library.sqlite")));
+#endif
+    {
+        PlaylistStore store(dataDir.path());
+        QList<Playlist> playlists;
+        QString lastPlaylistName;
+        bool needsFullSave = false;
+        QVERIFY(store.load(playlists, lastPlaylistName, needsFullSave, true));
+        QVERIFY(!needsFullSave);
+        QCOMPARE(lastPlaylistName, QString("公路 / 旅行"));
+        QCOMPARE(playlistNames(playlists), playlistNames(library));
+        for (int i = 0; i < library.size(); i++) {
+            if (!playlists[i].loaded) {
+                QVERIFY(store.loadPlaylist(playlists[i]));
+            }
+            compareTracks(playlists[i].videos, library[i].videos);
+        }
+    }
+}
+
+QTEST_GUILESS_MAIN(PlaylistStoreTest)
+#include "playliststoretest.moc"
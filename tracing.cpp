@@ -0,0 +1,146 @@
+#include "tracing.h"
+#include <QCoreApplication>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QHash>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QList>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QThread>
+#include <atomic>
+#include <cstdio>
+#include <utility>
+
+namespace {
+struct TraceEvent {
+    const char* name;
+    const char* category;
+    char phase;              // 'X'：範圍，'i'：瞬間事件
+    int tid;
+    qint64 startUs;
+    qint64 durationUs;
+    QString detail;
+};
+
+// 事件數上限，避免長時間執行時無限制地累積
+const int kMaxEvents = 1000000;
+
+QElapsedTimer traceClock;
+QMutex traceMutex;
+QList<TraceEvent> events;
+QHash<int, QString> threadNames;
+int droppedEvents = 0;
+std::atomic<int> nextThreadId{1};
+
+int currentThreadId()
+{
+    // 每個執行緒第一次記錄事件時分配編號，並記下執行緒名稱
+    thread_local int tid = 0;
+    if (tid == 0) {
+        tid = nextThreadId++;
+        QString name = QThread::currentThread()->objectName();
+        if (name.isEmpty()) {
+            name = QString("thread %1").arg(tid);
+        }
+        QMutexLocker locker(&traceMutex);
+        threadNames.insert(tid, name);
+    }
+    return tid;
+}
+
+void record(TraceEvent event)
+{
+    event.tid = currentThreadId();
+    QMutexLocker locker(&traceMutex);
+    if (events.size() >= kMaxEvents) {
+        droppedEvents++;
+        return;
+    }
+    events.append(std::move(event));
+}
+}
+
+qint64 Trace::now()
+{
+    return traceClock.nsecsElapsed() / 1000;
+}
+
+void Trace::complete(const char* name, const char* category, qint64 startUs, qint64 endUs)
+{
+    if (!enabled) return;
+    record(TraceEvent{ name, category, 'X', 0, startUs, endUs - startUs, QString() });
+}
+
+void Trace::instant(const char* name, const char* category, const QString& detail)
+{
+    if (!enabled) return;
+    record(TraceEvent{ name, category, 'i', 0, now(), 0, detail });
+}
+
+TraceSession::TraceSession()
+{
+    const QString value = qEnvironmentVariable("LAST_REPORT_TRACE");
+    if (value.isEmpty() || value == "0") return;
+
+    outputPath = value == "1"
+        ? QDir::tempPath() + QString("/last-report-trace-%1.json").arg(QCoreApplication::applicationPid())
+        : value;
+
+    QThread::currentThread()->setObjectName("main");
+    traceClock.start();
+    Trace::enabled = true;
+}
+
+TraceSession::~TraceSession()
+{
+    if (!Trace::enabled) return;
+
+    QMutexLocker locker(&traceMutex);
+    const qint64 pid = QCoreApplication::applicationPid();
+
+    QJsonArray traceEvents;
+    for (auto it = threadNames.constBegin(); it != threadNames.constEnd(); ++it) {
+        QJsonObject meta;
+        meta["ph"] = "M";
+        meta["name"] = "thread_name";
+        meta["pid"] = pid;
+        meta["tid"] = it.key();
+        meta["args"] = QJsonObject{ { "name", it.value() } };
+        traceEvents.append(meta);
+    }
+    for (const TraceEvent& event : std::as_const(events)) {
+        QJsonObject obj;
+        obj["name"] = QString::fromUtf8(event.name);
+        obj["cat"] = QString::fromUtf8(event.category);
+        obj["ph"] = QString(QLatin1Char(event.phase));
+        obj["pid"] = pid;
+        obj["tid"] = event.tid;
+        obj["ts"] = event.startUs;
+        if (event.phase == 'X') {
+            obj["dur"] = event.durationUs;
+        } else {
+            obj["s"] = "t";   // 瞬間事件只標在所屬的執行緒上
+        }
+        if (!event.detail.isEmpty()) {
+            obj["args"] = QJsonObject{ { "detail", event.detail } };
+        }
+        traceEvents.append(obj);
+    }
+
+    QJsonObject root;
+    root["traceEvents"] = traceEvents;
+    root["displayTimeUnit"] = "ms";
+    root["otherData"] = QJsonObject{ { "droppedEvents", droppedEvents } };
+
+    QFile file(outputPath);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        std::fprintf(stderr, "last-report: cannot write trace file %s\n", qPrintable(outputPath));
+        return;
+    }
+    file.write(QJsonDocument(root).toJson(QJsonDocument::Compact));
+    std::fprintf(stderr, "last-report: trace written to %s\n", qPrintable(outputPath));
+}
@@ -0,0 +1,72 @@
+#ifndef TRACING_H
+#define TRACING_H
+
+#include <QString>
+#include <QtGlobal>
+
+// 效能追蹤：設定 LAST_REPORT_TRACE 時記錄各階段的時間，結束時寫成 Chrome/Perfetto trace-event JSON
+// - LAST_REPORT_TRACE=檔案路徑，或 =1 寫到暫存目錄的 last-report-trace-<pid>.json
+// - 未啟用時 TRACE_SCOPE 只檢查一個布林值，不讀取時間也不配置記憶體
+// - 事件名稱與分類必須是字串常值（只保存指標）
+class Trace
+{
+public:
+    static bool isEnabled() { return enabled; }
+
+    // 自 TraceSession 建立以來的微秒數
+    static qint64 now();
+
+    static void complete(const char* name, const char* category, qint64 startUs, qint64 endUs);
+    static void instant(const char* name, const char* category, const QString& detail = QString());
+
+private:
+    friend class TraceSession;
+    static inline bool enabled = false;   // 只在 TraceSession 建立時設定，之後唯讀
+};
+
+// 記錄一個範圍的開始與結束（Chrome trace 的 "X" 事件）
+class TraceScope
+{
+public:
+    explicit TraceScope(const char* name, const char* category = "app")
+        : name(name)
+        , category(category)
+        , startUs(Trace::isEnabled() ? Trace::now() : -1)
+    {
+    }
+
+    ~TraceScope()
+    {
+        if (startUs >= 0) {
+            Trace::complete(name, category, startUs, Trace::now());
+        }
+    }
+
+    TraceScope(const TraceScope&) = delete;
+    TraceScope& operator=(const TraceScope&) = delete;
+
+private:
+    const char* name;
+    const char* category;
+    qint64 startUs;
+};
+
+#define TRACE_CONCAT_INNER(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_INNER(a, b)
+#define TRACE_SCOPE(...) TraceScope TRACE_CONCAT(traceScope, __LINE__)(__VA_ARGS__)
+
+// 在 main() 開頭建立：讀取環境變數並開始計時，解構時寫出追蹤檔
+class TraceSession
+{
+public:
+    TraceSession();
+    ~TraceSession();
+
+    TraceSession(const TraceSession&) = delete;
+    TraceSession& operator=(const TraceSession&) = delete;
+
+private:
+    QString outputPath;
+};
+
+#endif // TRACING_H
@@ -0,0 +1,287 @@
+#include "waveformcache.h"
+#include <QThread>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QDataStream>
+#include <QDateTime>
+#include <QUrl>
+#include <QAudioBuffer>
+#include <QCryptographicHash>
+#include <QMutexLocker>
+#include <algorithm>
+
+namespace {
+const quint32 kPeaksMagic = 0x4C525746;   // "LRWF"
+const quint32 kPeaksVersion = 1;
+const int kMinLevelBuckets = 64;
+
+inline qint8 toPeak(float sample)
+{
+    return qint8(qBound(-127, int(sample * 127.0f), 127));
+}
+}
+
+// === WaveformWorker ===
+
+WaveformWorker::WaveformWorker(WaveformCache* owner)
+    : owner(owner)
+    , decoder(nullptr)
+    , busy(false)
+    , framesDecoded(0)
+    , sampleRate(0)
+{
+}
+
+void WaveformWorker::wake()
+{
+    // QAudioDecoder 必須在使用它的執行緒上建立
+    if (!decoder) {
+        decoder = new QAudioDecoder(this);
+        connect(decoder, &QAudioDecoder::bufferReady, this, &WaveformWorker::onBufferReady);
+        connect(decoder, &QAudioDecoder::finished, this, &WaveformWorker::onFinished);
+        connect(decoder, QOverload<QAudioDecoder::Error>::of(&QAudioDecoder::error),
+                this, &WaveformWorker::onError);
+    }
+
+    if (busy) {
+        // 有更新的要求：中止目前的解碼
+        busy = false;
+        decoder->stop();
+    }
+    startNext();
+}
+
+void WaveformWorker::startNext()
+{
+    QString filePath;
+    while (owner->takeRequest(filePath)) {
+        QString cacheFile = owner->cacheFileFor(filePath);
+        if (cacheFile.isEmpty()) continue;   // 檔案不存在
+
+        // 快取命中：直接讀取，不必解碼
+        WaveformPeaks peaks;
+        if (WaveformCache::loadPeaks(cacheFile, peaks)) {
+            owner->deliver(filePath, peaks);
+            continue;
+        }
+
+        busy = true;
+        currentPath = filePath;
+        currentCacheFile = cacheFile;
+        framesDecoded = 0;
+        sampleRate = 0;
+        basePeaks.clear();
+        decoder->setSource(QUrl::fromLocalFile(filePath));
+        decoder->start();
+        return;
+    }
+}
+
+void WaveformWorker::onBufferReady()
+{
+    if (!busy) return;
+
+    const QAudioBuffer buffer = decoder->read();
+    if (!buffer.isValid()) return;
+
+    const QAudioFormat format = buffer.format();
+    const int channels = format.channelCount();
+    const int frames = int(buffer.frameCount());
+    if (channels <= 0 || frames <= 0 || format.sampleRate() <= 0) return;
+    sampleRate = format.sampleRate();
+
+    // 每個區段取所有聲道的最小/最大值
+    const qint64 framesPerBucket = qMax<qint64>(1, qint64(sampleRate) * WaveformCache::kBaseBucketMs / 1000);
+    for (int frame = 0; frame < frames; frame++) {
+        float low = 1.0f;
+        float high = -1.0f;
+        for (int channel = 0; channel < channels; channel++) {
+            const int index = frame * channels + channel;
+            float sample = 0.0f;
+            switch (format.sampleFormat()) {
+            case QAudioFormat::UInt8:
+                sample = (buffer.constData<quint8>()[index] - 128) / 128.0f;
+                break;
+            case QAudioFormat::Int16:
+                sample = buffer.constData<qint16>()[index] / 32768.0f;
+                break;
+            case QAudioFormat::Int32:
+                sample = buffer.constData<qint32>()[index] / 2147483648.0f;
+                break;
+            case QAudioFormat::Float:
+                sample = buffer.constData<float>()[index];
+                break;
+            default:
+                return;
+            }
+            low = std::min(low, sample);
+            high = std::max(high, sample);
+        }
+
+        const qsizetype bucket = qsizetype(framesDecoded / framesPerBucket);
+        if (bucket * 2 >= basePeaks.size()) {
+            basePeaks.append(char(toPeak(low)));
+            basePeaks.append(char(toPeak(high)));
+        } else {
+            basePeaks[bucket * 2] = char(std::min(qint8(basePeaks[bucket * 2]), toPeak(low)));
+            basePeaks[bucket * 2 + 1] = char(std::max(qint8(basePeaks[bucket * 2 + 1]), toPeak(high)));
+        }
+        framesDecoded++;
+    }
+}
+
+void WaveformWorker::onFinished()
+{
+    finishCurrent(true);
+}
+
+void WaveformWorker::onError(QAudioDecoder::Error error)
+{
+    Q_UNUSED(error);
+    finishCurrent(false);
+}
+
+void WaveformWorker::finishCurrent(bool ok)
+{
+    if (!busy) return;
+    busy = false;
+    decoder->stop();
+
+    if (ok && sampleRate > 0 && !basePeaks.isEmpty()) {
+        WaveformPeaks peaks = WaveformCache::buildLevels(basePeaks, framesDecoded * 1000 / sampleRate);
+        WaveformCache::savePeaks(currentCacheFile, peaks);
+        owner->deliver(currentPath, peaks);
+    }
+    basePeaks.clear();
+    startNext();
+}
+
+// === WaveformCache ===
+
+WaveformCache::WaveformCache(const QString& cacheDir, QObject* parent)
+    : QObject(parent)
+    , cacheDir(cacheDir + "/waveforms")
+{
+    QDir().mkpath(this->cacheDir);
+
+    // 解碼較重，以低優先權執行，不影響播放
+    thread = new QThread(this);
+    worker = new WaveformWorker(this);
+    worker->moveToThread(thread);
+    connect(thread, &QThread::finished, worker, &QObject::deleteLater);
+    thread->start(QThread::LowPriority);
+}
+
+WaveformCache::~WaveformCache()
+{
+    {
+        QMutexLocker locker(&mutex);
+        pendingPath.clear();
+    }
+    thread->quit();
+    thread->wait();
+}
+
+void WaveformCache::request(const QString& filePath)
+{
+    {
+        QMutexLocker locker(&mutex);
+        pendingPath = filePath;
+    }
+    QMetaObject::invokeMethod(worker, [this]() { worker->wake(); }, Qt::QueuedConnection);
+}
+
+bool WaveformCache::takeRequest(QString& filePath)
+{
+    QMutexLocker locker(&mutex);
+    if (pendingPath.isEmpty()) return false;
+
+    filePath = pendingPath;
+    pendingPath.clear();
+    return true;
+}
+
+void WaveformCache::deliver(const QString& filePath, const WaveformPeaks& peaks)
+{
+    // 回到 GUI 執行緒發出信號
+    QMetaObject::invokeMethod(this, [this, filePath, peaks]() {
+        emit peaksReady(filePath, peaks);
+    }, Qt::QueuedConnection);
+}
+
+QString WaveformCache::cacheFileFor(const QString& filePath) const
+{
+    QFileInfo fileInfo(filePath);
+    if (!fileInfo.exists()) return QString();
+
+    // 檔案改變時名稱也會改變，舊的峰值檔不會被誤用
+    QByteArray key = filePath.toUtf8() + '\n' + QByteArray::number(fileInfo.size()) + '\n'
+                   + QByteArray::number(fileInfo.lastModified().toMSecsSinceEpoch());
+    QByteArray hash = QCryptographicHash::hash(key, QCryptographicHash::Sha1);
+    return cacheDir + "/" + QString::fromLatin1(hash.toHex()) + ".peaks";
+}
+
+WaveformPeaks WaveformCache::buildLevels(const QByteArray& basePeaks, qint64 durationMs)
+{
+    WaveformPeaks peaks;
+    peaks.durationMs = durationMs;
+    peaks.bucketMs = kBaseBucketMs;
+    peaks.levels.append(basePeaks);
+
+    // 每一層把相鄰兩個區段合併，繪製時依寬度選擇最接近的一層
+    while (peaks.levels.last().size() / 2 > kMinLevelBuckets) {
+        const QByteArray& finer = peaks.levels.last();
+        const qsizetype buckets = finer.size() / 2;
+        QByteArray coarser((buckets + 1) / 2 * 2, Qt::Uninitialized);
+        for (qsizetype i = 0; i < buckets; i += 2) {
+            qint8 low = qint8(finer[i * 2]);
+            qint8 high = qint8(finer[i * 2 + 1]);
+            if (i + 1 < buckets) {
+                low = std::min(low, qint8(finer[i * 2 + 2]));
+                high = std::max(high, qint8(finer[i * 2 + 3]));
+            }
+            coarser[i] = char(low);
+            coarser[i + 1] = char(high);
+        }
+        peaks.levels.append(coarser);
+    }
+    return peaks;
+}
+
+bool WaveformCache::loadPeaks(const QString& cacheFile, WaveformPeaks& peaks)
+{
+    QFile file(cacheFile);
+    if (!file.open(QIODevice::ReadOnly)) return false;
+
+    QDataStream in(&file);
+    in.setVersion(QDataStream::Qt_6_0);
+    quint32 magic = 0;
+    quint32 version = 0;
+    qint32 levelCount = 0;
+    in >> magic >> version >> peaks.durationMs >> peaks.bucketMs >> levelCount;
+    if (magic != kPeaksMagic || version != kPeaksVersion || levelCount <= 0) return false;
+
+    peaks.levels.clear();
+    for (qint32 i = 0; i < levelCount && in.status() == QDataStream::Ok; i++) {
+        QByteArray level;
+        in >> level;
+        peaks.levels.append(level);
+    }
+    return in.status() == QDataStream::Ok;
+}
+
+bool WaveformCache::savePeaks(const QString& cacheFile, const WaveformPeaks& peaks)
+{
+    QSaveFile file(cacheFile);
+    if (!file.open(QIODevice::WriteOnly)) return false;
+
+    QDataStream out(&file);
+    out.setVersion(QDataStream::Qt_6_0);
+    out << kPeaksMagic << kPeaksVersion << peaks.durationMs << peaks.bucketMs << qint32(peaks.levels.size());
+    for (const QByteArray& level : peaks.levels) {
+        out << level;
+    }
+    return file.commit();
+}
@@ -0,0 +1,90 @@
+#ifndef WAVEFORMCACHE_H
+#define WAVEFORMCACHE_H
+
+#include <QObject>
+#include <QString>
+#include <QList>
+#include <QByteArray>
+#include <QMutex>
+#include <QAudioDecoder>
+
+class QThread;
+
+// 波形概覽：每個時間區段的最小/最大振幅（-127..127）
+// levels[0] 為最細的解析度，之後每一層把相鄰兩個區段合併，直到足夠小
+struct WaveformPeaks {
+    qint64 durationMs = 0;
+    int bucketMs = 0;                 // levels[0] 每個區段的長度
+    QList<QByteArray> levels;         // 每個區段兩個位元組：min, max
+
+    bool isEmpty() const { return levels.isEmpty(); }
+};
+
+class WaveformCache;
+
+// 工作執行緒：以 QAudioDecoder 解碼並累計峰值
+class WaveformWorker : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit WaveformWorker(WaveformCache* owner);
+
+    // 在工作執行緒上呼叫：取出最新的要求並開始處理
+    void wake();
+
+private:
+    void startNext();
+    void onBufferReady();
+    void onFinished();
+    void onError(QAudioDecoder::Error error);
+    void finishCurrent(bool ok);
+
+    WaveformCache* owner;
+    QAudioDecoder* decoder;
+    bool busy;
+    QString currentPath;
+    QString currentCacheFile;
+    qint64 framesDecoded;
+    int sampleRate;
+    QByteArray basePeaks;             // 正在累計的 levels[0]
+};
+
+// 波形快取：峰值檔以 路徑/大小/修改時間 命名存放在 cacheDir/waveforms/
+// 同一時間只處理最新的要求，切歌時舊的解碼會被中止
+class WaveformCache : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit WaveformCache(const QString& cacheDir, QObject* parent = nullptr);
+    ~WaveformCache();
+
+    void request(const QString& filePath);
+
+    static const int kBaseBucketMs = 20;
+
+signals:
+    void peaksReady(const QString& filePath, const WaveformPeaks& peaks);
+
+private:
+    friend class WaveformWorker;
+
+    // 由工作執行緒呼叫
+    bool takeRequest(QString& filePath);
+    bool hasNewerRequest();
+    void deliver(const QString& filePath, const WaveformPeaks& peaks);
+    QString cacheFileFor(const QString& filePath) const;
+
+    static WaveformPeaks buildLevels(const QByteArray& basePeaks, qint64 durationMs);
+    static bool loadPeaks(const QString& cacheFile, WaveformPeaks& peaks);
+    static bool savePeaks(const QString& cacheFile, const WaveformPeaks& peaks);
+
+    QString cacheDir;
+    QMutex mutex;
+    QString pendingPath;              // 只保留最新的要求
+    QThread* thread;
+    WaveformWorker* worker;
+};
+
+#endif // WAVEFORMCACHE_H
@@ -0,0 +1,221 @@
+#include "waveformseekbar.h"
+#include <QPainter>
+#include <QPaintEvent>
+#include <QMouseEvent>
+#include <QScreen>
+#include <QTimer>
+#include <algorithm>
+
+namespace {
+const QColor kBackgroundColor("#181818");
+const QColor kPlayedColor("#1DB954");
+const QColor kRemainingColor("#535353");
+const QColor kPlayheadColor("#FFFFFF");
+}
+
+WaveformSeekBar::WaveformSeekBar(QWidget* parent)
+    : QWidget(parent)
+    , durationMs(0)
+    , positionMs(0)
+    , dragPositionMs(0)
+    , dragging(false)
+    , paintedX(-1)
+{
+    setMinimumHeight(48);
+    setCursor(Qt::PointingHandCursor);
+    setAttribute(Qt::WA_OpaquePaintEvent);
+
+    repaintTimer = new QTimer(this);
+    repaintTimer->setSingleShot(true);
+    connect(repaintTimer, &QTimer::timeout, this, &WaveformSeekBar::scheduleRepaint);
+}
+
+QSize WaveformSeekBar::sizeHint() const
+{
+    return QSize(400, 48);
+}
+
+void WaveformSeekBar::setPeaks(const WaveformPeaks& newPeaks)
+{
+    peaks = newPeaks;
+    rebuildPixmaps();
+    update();
+}
+
+void WaveformSeekBar::clearPeaks()
+{
+    if (peaks.isEmpty()) return;
+    peaks = WaveformPeaks();
+    rebuildPixmaps();
+    update();
+}
+
+void WaveformSeekBar::setDuration(qint64 newDurationMs)
+{
+    if (durationMs == newDurationMs) return;
+    durationMs = newDurationMs;
+    rebuildPixmaps();
+    update();
+}
+
+void WaveformSeekBar::setPosition(qint64 newPositionMs)
+{
+    positionMs = newPositionMs;
+    if (!dragging) {
+        scheduleRepaint();
+    }
+}
+
+int WaveformSeekBar::positionToX(qint64 position) const
+{
+    if (durationMs <= 0) return 0;
+    return int(qBound<qint64>(0, position, durationMs) * width() / durationMs);
+}
+
+qint64 WaveformSeekBar::xToPosition(int x) const
+{
+    if (width() <= 0) return 0;
+    return qBound(0, x, width()) * durationMs / width();
+}
+
+void WaveformSeekBar::scheduleRepaint()
+{
+    // 位置沒有跨過一個像素時不重繪；重繪頻率不超過螢幕更新率
+    int x = positionToX(dragging ? dragPositionMs : positionMs);
+    if (x == paintedX || repaintTimer->isActive()) return;
+
+    qreal refreshRate = screen() ? screen()->refreshRate() : 60.0;
+    int frameMs = qMax(1, int(1000.0 / (refreshRate > 0 ? refreshRate : 60.0)));
+    qint64 elapsed = lastRepaint.isValid() ? lastRepaint.elapsed() : frameMs;
+    if (elapsed < frameMs) {
+        repaintTimer->start(int(frameMs - elapsed));
+        return;
+    }
+
+    // 只重繪新舊播放位置之間的區域
+    int left = paintedX < 0 ? 0 : std::min(paintedX, x);
+    int right = paintedX < 0 ? width() : std::max(paintedX, x);
+    update(QRect(left - 1, 0, right - left + 3, height()));
+    lastRepaint.restart();
+}
+
+void WaveformSeekBar::rebuildPixmaps()
+{
+    const qreal dpr = devicePixelRatioF();
+    const int w = width();
+    const int h = height();
+    if (w <= 0 || h <= 0) return;
+
+    playedPixmap = QPixmap(QSize(w, h) * dpr);
+    remainingPixmap = QPixmap(QSize(w, h) * dpr);
+    playedPixmap.setDevicePixelRatio(dpr);
+    remainingPixmap.setDevicePixelRatio(dpr);
+    playedPixmap.fill(kBackgroundColor);
+    remainingPixmap.fill(kBackgroundColor);
+
+    QPainter played(&playedPixmap);
+    QPainter remaining(&remainingPixmap);
+    const int mid = h / 2;
+
+    const qint64 timelineMs = durationMs > 0 ? durationMs : peaks.durationMs;
+    if (peaks.isEmpty() || timelineMs <= 0) {
+        // 沒有波形（YouTube 或尚未計算）：畫一條細的進度條
+        played.fillRect(0, mid - 2, w, 4, kPlayedColor);
+        remaining.fillRect(0, mid - 2, w, 4, kRemainingColor);
+        paintedX = -1;
+        return;
+    }
+
+    // 選擇區段數不少於寬度的最粗一層，每個像素只需合併一兩個區段
+    int level = 0;
+    for (int i = peaks.levels.size() - 1; i >= 0; i--) {
+        if (peaks.levels[i].size() / 2 >= w) {
+            level = i;
+            break;
+        }
+    }
+    const QByteArray& data = peaks.levels[level];
+    const qint64 buckets = data.size() / 2;
+    const qint64 levelBucketMs = qint64(peaks.bucketMs) << level;
+    const int halfHeight = qMax(1, h / 2 - 2);
+
+    for (int x = 0; x < w; x++) {
+        qint64 first = qint64(x) * timelineMs / w / levelBucketMs;
+        qint64 last = qMax(first, (qint64(x + 1) * timelineMs / w - 1) / levelBucketMs);
+        if (first >= buckets) break;
+        last = std::min(last, buckets - 1);
+
+        qint8 low = 127;
+        qint8 high = -127;
+        for (qint64 b = first; b <= last; b++) {
+            low = std::min(low, qint8(data[b * 2]));
+            high = std::max(high, qint8(data[b * 2 + 1]));
+        }
+        int top = mid - high * halfHeight / 127;
+        int bottom = mid - low * halfHeight / 127;
+        int barHeight = qMax(1, bottom - top + 1);
+        played.fillRect(x, top, 1, barHeight, kPlayedColor);
+        remaining.fillRect(x, top, 1, barHeight, kRemainingColor);
+    }
+    paintedX = -1;
+}
+
+void WaveformSeekBar::paintEvent(QPaintEvent* event)
+{
+    QPainter painter(this);
+    const QRect dirty = event->rect();
+    const int x = positionToX(dragging ? dragPositionMs : positionMs);
+    const qreal dpr = playedPixmap.devicePixelRatio();
+
+    auto blit = [&](const QPixmap& pixmap, const QRect& area) {
+        QRect target = area.intersected(dirty);
+        if (target.isEmpty()) return;
+        QRectF source(target.topLeft() * dpr, target.size() * dpr);
+        painter.drawPixmap(target, pixmap, source);
+    };
+
+    if (playedPixmap.isNull()) {
+        painter.fillRect(dirty, kBackgroundColor);
+    } else {
+        blit(playedPixmap, QRect(0, 0, x, height()));
+        blit(remainingPixmap, QRect(x, 0, width() - x, height()));
+    }
+
+    if (durationMs > 0) {
+        painter.fillRect(QRect(x, 0, 1, height()).intersected(dirty), kPlayheadColor);
+    }
+    paintedX = x;
+}
+
+void WaveformSeekBar::resizeEvent(QResizeEvent* event)
+{
+    QWidget::resizeEvent(event);
+    rebuildPixmaps();
+}
+
+void WaveformSeekBar::mousePressEvent(QMouseEvent* event)
+{
+    if (event->button() != Qt::LeftButton || durationMs <= 0) return;
+
+    dragging = true;
+    dragPositionMs = xToPosition(event->position().toPoint().x());
+    scheduleRepaint();
+}
+
+void WaveformSeekBar::mouseMoveEvent(QMouseEvent* event)
+{
+    if (!dragging) return;
+
+    dragPositionMs = xToPosition(event->position().toPoint().x());
+    scheduleRepaint();
+}
+
+void WaveformSeekBar::mouseReleaseEvent(QMouseEvent* event)
+{
+    if (!dragging || event->button() != Qt::LeftButton) return;
+
+    dragging = false;
+    positionMs = xToPosition(event->position().toPoint().x());
+    scheduleRepaint();
+    emit seekRequested(positionMs);
+}
@@ -0,0 +1,56 @@
+#ifndef WAVEFORMSEEKBAR_H
+#define WAVEFORMSEEKBAR_H
+
+#include <QWidget>
+#include <QPixmap>
+#include <QElapsedTimer>
+#include "waveformcache.h"
+
+class QTimer;
+
+// 顯示波形概覽的進度條：點擊或拖曳以跳轉
+// 波形預先繪製成兩張圖（已播放/未播放），位置更新時只貼圖，不重新計算
+class WaveformSeekBar : public QWidget
+{
+    Q_OBJECT
+
+public:
+    explicit WaveformSeekBar(QWidget* parent = nullptr);
+
+    void setPeaks(const WaveformPeaks& peaks);
+    void clearPeaks();
+    void setDuration(qint64 durationMs);
+    void setPosition(qint64 positionMs);
+
+    QSize sizeHint() const override;
+
+signals:
+    void seekRequested(qint64 positionMs);
+
+protected:
+    void paintEvent(QPaintEvent* event) override;
+    void resizeEvent(QResizeEvent* event) override;
+    void mousePressEvent(QMouseEvent* event) override;
+    void mouseMoveEvent(QMouseEvent* event) override;
+    void mouseReleaseEvent(QMouseEvent* event) override;
+
+private:
+    void rebuildPixmaps();
+    void scheduleRepaint();
+    int positionToX(qint64 positionMs) const;
+    qint64 xToPosition(int x) const;
+
+    WaveformPeaks peaks;
+    qint64 durationMs;
+    qint64 positionMs;
+    qint64 dragPositionMs;
+    bool dragging;
+
+    QPixmap playedPixmap;
+    QPixmap remainingPixmap;
+    int paintedX;                 // 上次繪製時播放位置的 x 座標
+    QElapsedTimer lastRepaint;
+    QTimer* repaintTimer;         // 兩次重繪間隔不足一個畫面更新週期時延後重繪
+};
+
+#endif // WAVEFORMSEEKBAR_H
@@ -1,5 +1,13 @@
 #include "widget.h"
 #include "ui_widget.h"
+#include "playlistmodel.h"
+#include "playliststore.h"
+#include "folderimporter.h"
+#include "waveformseekbar.h"
+#include "spectrumview.h"
+#include "coverartcache.h"
+#include "youtubelink.h"
+#include "tracing.h"
 #include <QVBoxLayout>
 #include <QHBoxLayout>
 #include <QGridLayout>
@@ -10,24 +18,115 @@
 #include <QRandomGenerator>
 #include <QStandardPaths>
 #include <QSplitter>
-#include <QRegularExpression>
+#include <QMetaEnum>
+#include <QProgressDialog>
+#include <utility>
+#include <cmath>
+
+namespace {
+QString formatDuration(qint64 ms)
+{
+    QString format = ms >= 3600000 ? "h:mm:ss" : "m:ss";
+    return QTime(0, 0).addMSecs(ms).toString(format);
+}
+}
 
 Widget::Widget(QWidget *parent)
     : QWidget(parent)
     , ui(new Ui::Widget)
     , mediaPlayer(new QMediaPlayer(this))
     , audioOutput(new QAudioOutput(this))
+    , standbyPlayer(new QMediaPlayer(this))
+    , standbyOutput(new QAudioOutput(this))
     , currentPlaylistIndex(-1)
     , currentVideoIndex(-1)
     , isShuffleMode(false)
     , isRepeatMode(false)
     , isPlaying(false)
+    , isGaplessMode(false)
+    , isNormalizeMode(false)
+    , isCrossfadeMode(false)
+    , standbyArmAttempted(false)
+    , armedVideoIndex(-1)
+    , lastGapMs(-1)
+    , cachedFavoritesIndex(-1)
+    , libraryLayoutDirty(false)
+    , playlistUseCounter(0)
+    , maxLoadedTracks(200000)
+    , isPipelineEngine(false)
+    , crossfadeMs(6000)
+    , isEqualizerMode(false)
+    , equalizerDialog(nullptr)
+    , duplicateScanBatch(-1)
+    , searchIndexRequested(false)
 {
-    ui->setupUi(this);
+    TRACE_SCOPE("Widget::Widget");
+    {
+        TRACE_SCOPE("ui->setupUi");
+        ui->setupUi(this);
+    }
     
     // 設置媒體播放器
     mediaPlayer->setAudioOutput(audioOutput);
-    audioOutput->setVolume(0.5);
+    audioOutput->setVolume(kBaseVolume);
+    standbyPlayer->setAudioOutput(standbyOutput);
+    standbyOutput->setVolume(kBaseVolume);
+    
+    // 設置背景儲存：變更後經過短暫防抖，在儲存執行緒上寫入
+    storageThread = new QThread(this);
+    storageThread->setObjectName("storage");
+    playlistStore = new PlaylistStore(QStandardPaths::writableLocation(QStandardPaths::AppDataLocation));
+    playlistStore->moveToThread(storageThread);
+    connect(storageThread, &QThread::finished, playlistStore, &QObject::deleteLater);
+    storageThread->start();
+    
+    autoSaveTimer = new QTimer(this);
+    autoSaveTimer->setSingleShot(true);
+    autoSaveTimer->setInterval(1500);
+    
+    searchIndexTimer = new QTimer(this);
+    searchIndexTimer->setSingleShot(true);
+    searchIndexTimer->setInterval(500);
+    
+    // 本地檔案標籤在背景執行緒擷取，結果快取在 CacheLocation
+    metadataExtractor = new MetadataExtractor(QStandardPaths::writableLocation(QStandardPaths::CacheLocation), this);
+    waveformCache = new WaveformCache(QStandardPaths::writableLocation(QStandardPaths::CacheLocation), this);
+    
+    // 封面縮圖的記憶體上限，可用 LAST_REPORT_COVER_CACHE_MB 調整
+    coverArtCache = new CoverArtCache(QStandardPaths::writableLocation(QStandardPaths::CacheLocation), this);
+    bool coverCacheOk = false;
+    int coverCacheMb = qEnvironmentVariableIntValue("LAST_REPORT_COVER_CACHE_MB", &coverCacheOk);
+    if (coverCacheOk && coverCacheMb > 0) {
+        coverArtCache->setMemoryLimit(qint64(coverCacheMb) * 1024 * 1024);
+    }
+    loudnessAnalyzer = new LoudnessAnalyzer(QStandardPaths::writableLocation(QStandardPaths::CacheLocation), this);
+    
+    // 自有管線的輸出延遲，可用 LAST_REPORT_AUDIO_LATENCY_MS 調整；LAST_REPORT_AUDIO_ENGINE=pipeline 時不需開啟交叉淡化也使用
+    bool latencyOk = false;
+    int latencyMs = qEnvironmentVariableIntValue("LAST_REPORT_AUDIO_LATENCY_MS", &latencyOk);
+    crossfadePlayer = new CrossfadePlayer(latencyOk && latencyMs > 0 ? latencyMs : 200, this);
+    isPipelineEngine = qEnvironmentVariable("LAST_REPORT_AUDIO_ENGINE") == "pipeline";
+    
+    folderImporter = new FolderImporter(QStandardPaths::writableLocation(QStandardPaths::AppDataLocation)
+                                        + "/folder_imports.dat", this);
+    playlistFileIO = new PlaylistFileIO(this);
+    transferProgress = nullptr;
+    contentHasher = new ContentHasher(QStandardPaths::writableLocation(QStandardPaths::CacheLocation), this);
+    
+    // 記憶體中保留的曲目上限，可用 LAST_REPORT_PLAYLIST_CACHE_TRACKS 調整
+    bool capOk = false;
+    int cap = qEnvironmentVariableIntValue("LAST_REPORT_PLAYLIST_CACHE_TRACKS", &capOk);
+    if (capOk && cap > 0) {
+        maxLoadedTracks = cap;
+    }
+    
+    // 交叉淡化長度，可用 LAST_REPORT_CROSSFADE_MS 調整，之後在按鈕上按右鍵修改
+    bool fadeOk = false;
+    int fadeMs = qEnvironmentVariableIntValue("LAST_REPORT_CROSSFADE_MS", &fadeOk);
+    if (fadeOk && fadeMs >= 0) {
+        crossfadeMs = fadeMs;
+    }
+    crossfadePlayer->setFadeMs(0);
     
     // 設置窗口
     setWindowTitle("音樂播放器");
@@ -55,12 +154,9 @@ Widget::Widget(QWidget *parent)
         playlistComboBox->addItem(defaultPlaylist.name);
         playlistComboBox->addItem(favoritesPlaylist.name);
         currentPlaylistIndex = 0;
+        markPlaylistDirty(0);
+        markPlaylistDirty(1);
     } else {
-        // 恢復播放清單到ComboBox
-        for (const Playlist& playlist : playlists) {
-            playlistComboBox->addItem(playlist.name);
-        }
-        
         // 恢復上次的播放清單
         int lastIndex = 0;
         for (int i = 0; i < playlists.size(); i++) {
@@ -69,24 +165,52 @@ Widget::Widget(QWidget *parent)
                 break;
             }
         }
-        playlistComboBox->setCurrentIndex(lastIndex);
+        
+        // 恢復播放清單到ComboBox；暫停信號，避免先解碼第一個播放清單
+        {
+            QSignalBlocker blocker(playlistComboBox);
+            for (const Playlist& playlist : playlists) {
+                playlistComboBox->addItem(playlist.name);
+            }
+            playlistComboBox->setCurrentIndex(lastIndex);
+        }
         currentPlaylistIndex = lastIndex;
+        ensurePlaylistLoaded(lastIndex);
         updatePlaylistDisplay();
+        requestMetadata(lastIndex);
+        markSearchStale(lastIndex);
+        
+        // 視窗出現後在背景解碼「我的最愛」，切換或加入最愛時不必等待
+        QTimer::singleShot(0, this, [this]() {
+            loadPlaylistInBackground(favoritesPlaylistIndex());
+        });
     }
     
+    // 最愛清單已載入時（例如上次就停在最愛）立即建立集合，否則等背景載入完成
+    rebuildFavoriteKeys();
+    
+    // 重新監看已匯入的資料夾，只掃描關閉期間有變更的部分
+    folderImporter->restore();
+    
     // 更新按鈕狀態
     updateButtonStates();
 }
 
 Widget::~Widget()
 {
-    // 保存播放清單
+    // 只保存尚未寫入的變更，然後等待儲存執行緒結束
     savePlaylistsToFile();
+    storageThread->quit();
+    storageThread->wait();
+    
+    // 分析執行緒會讀取 crossfadePlayer 的輸出取樣，必須在它之前結束
+    delete spectrumView;
     delete ui;
 }
 
 void Widget::setupUI()
 {
+    TRACE_SCOPE("Widget::setupUI");
     // 主佈局
     QVBoxLayout* mainLayout = new QVBoxLayout(this);
     mainLayout->setSpacing(0);
@@ -109,24 +233,11 @@ void Widget::setupUI()
         "QLineEdit:focus {"
         "   border: 1px solid #1DB954;"
         "}"
-        "QListWidget {"
+        "QListView {"
         "   background-color: #181818;"
         "   border: none;"
         "   outline: none;"
         "}"
-        "QListWidget::item {"
-        "   padding: 10px;"
-        "   border-bottom: 1px solid #282828;"
-        "   color: #B3B3B3;"
-        "}"
-        "QListWidget::item:hover {"
-        "   background-color: #282828;"
-        "   color: #FFFFFF;"
-        "}"
-        "QListWidget::item:selected {"
-        "   background-color: #1DB954;"
-        "   color: #FFFFFF;"
-        "}"
         "QComboBox {"
         "   background-color: #282828;"
         "   border: 1px solid #404040;"
@@ -157,8 +268,15 @@ void Widget::setupUI()
     topLayout->addStretch();
     
     searchEdit = new QLineEdit(topBar);
-    searchEdit->setPlaceholderText("貼上 YouTube 連結...");
+    searchEdit->setPlaceholderText("貼上 YouTube 連結或搜尋音樂庫...");
     searchEdit->setMinimumWidth(400);
+    
+    // 搜尋結果以下拉清單顯示；篩選由 LibrarySearch 完成，QCompleter 只負責顯示
+    searchResultModel = new QStringListModel(this);
+    searchCompleter = new QCompleter(searchResultModel, this);
+    searchCompleter->setCompletionMode(QCompleter::UnfilteredPopupCompletion);
+    searchCompleter->setMaxVisibleItems(12);
+    searchEdit->setCompleter(searchCompleter);
     topLayout->addWidget(searchEdit);
     
     searchButton = new QPushButton("▶ 播放", topBar);
@@ -193,6 +311,40 @@ void Widget::setupUI()
     );
     topLayout->addWidget(loadLocalFileButton);
     
+    importFolderButton = new QPushButton("📂 匯入資料夾", topBar);
+    importFolderButton->setStyleSheet(
+        "QPushButton {"
+        "   background-color: #282828;"
+        "   color: white;"
+        "   border: none;"
+        "   border-radius: 20px;"
+        "   padding: 8px 24px;"
+        "   font-size: 14px;"
+        "   font-weight: bold;"
+        "}"
+        "QPushButton:hover { background-color: #404040; }"
+        "QPushButton:pressed { background-color: #505050; }"
+    );
+    topLayout->addWidget(importFolderButton);
+    
+    findDuplicatesButton = new QPushButton("🔍 重複曲目", topBar);
+    findDuplicatesButton->setToolTip("尋找所有播放清單中內容相同的本地檔案");
+    findDuplicatesButton->setStyleSheet(
+        "QPushButton {"
+        "   background-color: #282828;"
+        "   color: white;"
+        "   border: none;"
+        "   border-radius: 20px;"
+        "   padding: 8px 24px;"
+        "   font-size: 14px;"
+        "   font-weight: bold;"
+        "}"
+        "QPushButton:hover { background-color: #404040; }"
+        "QPushButton:pressed { background-color: #505050; }"
+        "QPushButton:disabled { color: #888888; }"
+    );
+    topLayout->addWidget(findDuplicatesButton);
+    
     mainLayout->addWidget(topBar);
     
     // === 內容區域 ===
@@ -247,8 +399,60 @@ void Widget::setupUI()
     
     leftLayout->addLayout(playlistButtonLayout);
     
-    playlistWidget = new QListWidget(leftPanel);
-    leftLayout->addWidget(playlistWidget);
+    // 與其他工具交換播放清單：M3U/M3U8/PLS
+    QHBoxLayout* playlistFileLayout = new QHBoxLayout();
+    
+    importPlaylistFileButton = new QPushButton("📥 匯入清單", leftPanel);
+    importPlaylistFileButton->setToolTip("把 M3U/M3U8/PLS 播放清單加入目前的播放清單");
+    importPlaylistFileButton->setStyleSheet(
+        "QPushButton {"
+        "   background-color: #282828;"
+        "   color: #B3B3B3;"
+        "   border: none;"
+        "   border-radius: 4px;"
+        "   padding: 6px 12px;"
+        "   font-size: 12px;"
+        "}"
+        "QPushButton:hover { background-color: #404040; color: #FFFFFF; }"
+    );
+    playlistFileLayout->addWidget(importPlaylistFileButton);
+    
+    exportPlaylistFileButton = new QPushButton("📤 匯出清單", leftPanel);
+    exportPlaylistFileButton->setToolTip("把目前的播放清單存成 M3U8 或 PLS 檔");
+    exportPlaylistFileButton->setStyleSheet(
+        "QPushButton {"
+        "   background-color: #282828;"
+        "   color: #B3B3B3;"
+        "   border: none;"
+        "   border-radius: 4px;"
+        "   padding: 6px 12px;"
+        "   font-size: 12px;"
+        "}"
+        "QPushButton:hover { background-color: #404040; color: #FFFFFF; }"
+    );
+    playlistFileLayout->addWidget(exportPlaylistFileButton);
+    
+    leftLayout->addLayout(playlistFileLayout);
+    
+    // 播放清單列表：模型/視圖架構，只繪製可見的列
+    playlistModel = new PlaylistModel(&playlists, this);
+    playlistModel->setFavoriteKeys(&favoriteKeys);
+    playlistView = new QListView(leftPanel);
+    playlistView->setModel(playlistModel);
+    PlaylistItemDelegate* itemDelegate = new PlaylistItemDelegate(playlistView);
+    itemDelegate->setCoverArtCache(coverArtCache);
+    playlistView->setItemDelegate(itemDelegate);
+    playlistView->setUniformItemSizes(true);
+    playlistView->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    playlistView->setMouseTracking(true);
+    // 拖放：清單內拖曳重新排序，也可以拖入檔案、資料夾、播放清單檔或 YouTube 連結
+    playlistView->setSelectionMode(QAbstractItemView::ExtendedSelection);
+    playlistView->setDragEnabled(true);
+    playlistView->setAcceptDrops(true);
+    playlistView->setDropIndicatorShown(true);
+    playlistView->setDragDropMode(QAbstractItemView::DragDrop);
+    playlistView->setDefaultDropAction(Qt::MoveAction);
+    leftLayout->addWidget(playlistView);
     
     contentSplitter->addWidget(leftPanel);
     
@@ -259,15 +463,29 @@ void Widget::setupUI()
     centerLayout->setContentsMargins(16, 16, 16, 16);
     centerLayout->setSpacing(16);
     
-    // 影片資訊
+    // 影片資訊：本地曲目有封面時顯示在標題左側
+    QHBoxLayout* nowPlayingLayout = new QHBoxLayout();
+    nowPlayingLayout->setSpacing(16);
+    const int coverSize = CoverArtCache::logicalSize(CoverArtCache::PanelSize);
+    coverLabel = new QLabel(centerPanel);
+    coverLabel->setFixedSize(coverSize, coverSize);
+    coverLabel->setAlignment(Qt::AlignCenter);
+    coverLabel->setStyleSheet("background-color: #282828; border-radius: 8px;");
+    coverLabel->hide();
+    nowPlayingLayout->addWidget(coverLabel);
+    
+    QVBoxLayout* titleLayout = new QVBoxLayout();
     videoTitleLabel = new QLabel("選擇一首歌曲開始播放", centerPanel);
     videoTitleLabel->setStyleSheet("font-size: 24px; font-weight: bold; color: #FFFFFF;");
     videoTitleLabel->setWordWrap(true);
-    centerLayout->addWidget(videoTitleLabel);
+    titleLayout->addWidget(videoTitleLabel);
     
     channelLabel = new QLabel("", centerPanel);
     channelLabel->setStyleSheet("font-size: 14px; color: #B3B3B3;");
-    centerLayout->addWidget(channelLabel);
+    titleLayout->addWidget(channelLabel);
+    titleLayout->addStretch();
+    nowPlayingLayout->addLayout(titleLayout, 1);
+    centerLayout->addLayout(nowPlayingLayout);
     
     // 影片資訊顯示區域
     videoDisplayLabel = new QLabel("", centerPanel);
@@ -285,6 +503,25 @@ void Widget::setupUI()
     videoDisplayLabel->setOpenExternalLinks(true);
     centerLayout->addWidget(videoDisplayLabel, 1);
     
+    // 即時頻譜：分析與重繪的上限預設 30 fps，可用 LAST_REPORT_VISUALIZER_FPS 調整（0 關閉）
+    bool fpsOk = false;
+    int fps = qEnvironmentVariableIntValue("LAST_REPORT_VISUALIZER_FPS", &fpsOk);
+    spectrumView = new SpectrumView(crossfadePlayer, fpsOk ? qBound(0, fps, 60) : 30, centerPanel);
+    centerLayout->addWidget(spectrumView);
+    
+    // 進度條：波形概覽，點擊或拖曳跳轉
+    QHBoxLayout* seekLayout = new QHBoxLayout();
+    seekLayout->setSpacing(12);
+    positionLabel = new QLabel("0:00", centerPanel);
+    positionLabel->setStyleSheet("font-size: 12px; color: #B3B3B3;");
+    seekLayout->addWidget(positionLabel);
+    seekBar = new WaveformSeekBar(centerPanel);
+    seekLayout->addWidget(seekBar, 1);
+    durationLabel = new QLabel("0:00", centerPanel);
+    durationLabel->setStyleSheet("font-size: 12px; color: #B3B3B3;");
+    seekLayout->addWidget(durationLabel);
+    centerLayout->addLayout(seekLayout);
+    
     // 播放控制區域
     QWidget* controlWidget = new QWidget(centerPanel);
     controlWidget->setStyleSheet("background-color: #181818; border-radius: 8px; padding: 16px;");
@@ -345,6 +582,32 @@ void Widget::setupUI()
     repeatButton->setToolTip("循環播放");
     controlLayout->addWidget(repeatButton);
     
+    gaplessButton = new QPushButton("∞", controlWidget);
+    gaplessButton->setStyleSheet(buttonStyle);
+    gaplessButton->setCheckable(true);
+    gaplessButton->setToolTip("無縫播放");
+    controlLayout->addWidget(gaplessButton);
+    
+    normalizeButton = new QPushButton("🔊", controlWidget);
+    normalizeButton->setStyleSheet(buttonStyle);
+    normalizeButton->setCheckable(true);
+    normalizeButton->setToolTip("響度標準化（EBU R128）");
+    controlLayout->addWidget(normalizeButton);
+    
+    crossfadeButton = new QPushButton("⇄", controlWidget);
+    crossfadeButton->setStyleSheet(buttonStyle);
+    crossfadeButton->setCheckable(true);
+    crossfadeButton->setContextMenuPolicy(Qt::CustomContextMenu);
+    updateCrossfadeToolTip();
+    controlLayout->addWidget(crossfadeButton);
+    
+    equalizerButton = new QPushButton("🎚", controlWidget);
+    equalizerButton->setStyleSheet(buttonStyle);
+    equalizerButton->setCheckable(true);
+    equalizerButton->setContextMenuPolicy(Qt::CustomContextMenu);
+    equalizerButton->setToolTip("等化器（右鍵調整）");
+    controlLayout->addWidget(equalizerButton);
+    
     controlLayout->addStretch();
     
     toggleFavoriteButton = new QPushButton("❤️ 加入最愛", controlWidget);
@@ -376,10 +639,20 @@ void Widget::setupUI()
 
 void Widget::createConnections()
 {
+    TRACE_SCOPE("Widget::createConnections");
     // 搜尋功能
     connect(searchButton, &QPushButton::clicked, this, &Widget::onSearchClicked);
     connect(searchEdit, &QLineEdit::returnPressed, this, &Widget::onSearchClicked);
+    connect(searchEdit, &QLineEdit::textEdited, this, &Widget::onSearchTextEdited);
+    connect(searchCompleter, QOverload<const QModelIndex&>::of(&QCompleter::activated),
+            this, &Widget::onSearchResultActivated);
+    connect(searchIndexTimer, &QTimer::timeout, this, &Widget::flushSearchIndex);
     connect(loadLocalFileButton, &QPushButton::clicked, this, &Widget::onLoadLocalFileClicked);
+    connect(importFolderButton, &QPushButton::clicked, this, &Widget::onImportFolderClicked);
+    connect(folderImporter, &FolderImporter::filesAdded, this, &Widget::onFolderFilesAdded);
+    connect(folderImporter, &FolderImporter::filesRemoved, this, &Widget::onFolderFilesRemoved);
+    connect(findDuplicatesButton, &QPushButton::clicked, this, &Widget::onFindDuplicatesClicked);
+    connect(contentHasher, &ContentHasher::hashesReady, this, &Widget::onContentHashesReady);
     
     // 播放控制按鈕
     connect(playPauseButton, &QPushButton::clicked, this, &Widget::onPlayPauseClicked);
@@ -387,10 +660,21 @@ void Widget::createConnections()
     connect(nextButton, &QPushButton::clicked, this, &Widget::onNextClicked);
     connect(shuffleButton, &QPushButton::clicked, this, &Widget::onShuffleClicked);
     connect(repeatButton, &QPushButton::clicked, this, &Widget::onRepeatClicked);
+    connect(gaplessButton, &QPushButton::clicked, this, &Widget::onGaplessClicked);
+    connect(normalizeButton, &QPushButton::clicked, this, &Widget::onNormalizeClicked);
+    connect(equalizerButton, &QPushButton::clicked, this, &Widget::onEqualizerClicked);
+    connect(equalizerButton, &QPushButton::customContextMenuRequested, this, &Widget::onEqualizerSettingsRequested);
+    connect(loudnessAnalyzer, &LoudnessAnalyzer::loudnessReady, this, &Widget::onLoudnessReady);
+    connect(crossfadeButton, &QPushButton::clicked, this, &Widget::onCrossfadeClicked);
+    connect(crossfadeButton, &QPushButton::customContextMenuRequested, this, &Widget::onCrossfadeLengthRequested);
+    connect(seekBar, &WaveformSeekBar::seekRequested, this, &Widget::onSeekRequested);
+    connect(waveformCache, &WaveformCache::peaksReady, this, &Widget::onWaveformReady);
     
     // 播放清單管理
-    connect(playlistWidget, &QListWidget::itemDoubleClicked, this, &Widget::onVideoDoubleClicked);
-    connect(playlistWidget, &QListWidget::itemSelectionChanged, this, &Widget::updateButtonStates);
+    connect(playlistView, &QListView::doubleClicked, this, &Widget::onVideoDoubleClicked);
+    connect(playlistModel, &PlaylistModel::videosMoved, this, &Widget::onVideosMoved);
+    connect(playlistModel, &PlaylistModel::urlsDropped, this, &Widget::onUrlsDropped);
+    connect(playlistView->selectionModel(), &QItemSelectionModel::selectionChanged, this, &Widget::updateButtonStates);
     
     // 最愛按鈕
     connect(toggleFavoriteButton, &QPushButton::clicked, this, &Widget::onToggleFavoriteClicked);
@@ -399,11 +683,32 @@ void Widget::createConnections()
     connect(newPlaylistButton, &QPushButton::clicked, this, &Widget::onNewPlaylistClicked);
     connect(deletePlaylistButton, &QPushButton::clicked, this, &Widget::onDeletePlaylistClicked);
     connect(playlistComboBox, QOverload<int>::of(&QComboBox::currentIndexChanged), this, &Widget::onPlaylistChanged);
+    connect(importPlaylistFileButton, &QPushButton::clicked, this, &Widget::onImportPlaylistFileClicked);
+    connect(exportPlaylistFileButton, &QPushButton::clicked, this, &Widget::onExportPlaylistFileClicked);
+    connect(playlistFileIO, &PlaylistFileIO::tracksImported, this, &Widget::onPlaylistTracksImported);
+    connect(playlistFileIO, &PlaylistFileIO::progressChanged, this, &Widget::onPlaylistTransferProgress);
+    connect(playlistFileIO, &PlaylistFileIO::finished, this, &Widget::onPlaylistTransferFinished);
+    
+    // 媒體播放器：兩組播放器在無縫播放時會互換，信號都連接，由 sender() 分辨
+    for (QMediaPlayer* player : { mediaPlayer, standbyPlayer }) {
+        connect(player, &QMediaPlayer::playbackStateChanged, this, &Widget::onMediaPlayerStateChanged);
+        connect(player, &QMediaPlayer::mediaStatusChanged, this, &Widget::onMediaPlayerStatusChanged);
+        connect(player, &QMediaPlayer::positionChanged, this, &Widget::onMediaPlayerPositionChanged);
+        connect(player, &QMediaPlayer::durationChanged, this, &Widget::onMediaPlayerDurationChanged);
+    }
     
-    // 媒體播放器
-    connect(mediaPlayer, &QMediaPlayer::playbackStateChanged, this, &Widget::onMediaPlayerStateChanged);
-    connect(mediaPlayer, &QMediaPlayer::positionChanged, this, &Widget::onMediaPlayerPositionChanged);
-    connect(mediaPlayer, &QMediaPlayer::durationChanged, this, &Widget::onMediaPlayerDurationChanged);
+    // 交叉淡化播放器
+    connect(crossfadePlayer, &CrossfadePlayer::stateChanged, this, &Widget::onCrossfadeStateChanged);
+    connect(crossfadePlayer, &CrossfadePlayer::positionChanged, this, &Widget::onCrossfadePositionChanged);
+    connect(crossfadePlayer, &CrossfadePlayer::durationChanged, this, &Widget::onCrossfadeDurationChanged);
+    connect(crossfadePlayer, &CrossfadePlayer::advanced, this, &Widget::onCrossfadeAdvanced);
+    connect(crossfadePlayer, &CrossfadePlayer::endOfMedia, this, &Widget::onCrossfadeEndOfMedia);
+    connect(crossfadePlayer, &CrossfadePlayer::errorOccurred, this, &Widget::onCrossfadeError);
+    
+    // 自動保存
+    connect(autoSaveTimer, &QTimer::timeout, this, &Widget::saveDirtyPlaylists);
+    connect(metadataExtractor, &MetadataExtractor::metadataReady, this, &Widget::onMetadataReady);
+    connect(coverArtCache, &CoverArtCache::coversReady, this, &Widget::onCoversReady);
 }
 
 void Widget::onSearchClicked()
@@ -414,257 +719,1416 @@ void Widget::onSearchClicked()
         return;
     }
     
+    // 不是連結時視為搜尋：播放第一筆結果
+    if (!looksLikeYouTubeLink(link)) {
+        if (searchResults.isEmpty()) {
+            QMessageBox::information(this, "搜尋", "音樂庫中找不到符合的曲目。");
+        } else {
+            playSearchResult(0);
+        }
+        return;
+    }
+    
     playYouTubeLink(link);
 }
 
-void Widget::onLoadLocalFileClicked()
+bool Widget::looksLikeYouTubeLink(const QString& text)
 {
-    QString filePath = QFileDialog::getOpenFileName(this, 
-        "選擇音樂檔案", 
-        QDir::homePath(),
-        "音樂檔案 (*.mp3 *.wav *.flac *.m4a *.ogg *.aac);;所有檔案 (*.*)");
-    
-    if (!filePath.isEmpty()) {
-        playLocalFile(filePath);
-    }
+    return text.contains("youtube.com/") || text.contains("youtu.be/") || text.contains("://");
 }
 
-QString Widget::extractYouTubeVideoId(const QString& url)
+void Widget::onSearchTextEdited(const QString& text)
 {
-    // 支援多種 YouTube URL 格式
-    // https://www.youtube.com/watch?v=VIDEO_ID
-    // https://youtu.be/VIDEO_ID
-    // https://www.youtube.com/embed/VIDEO_ID
-    
-    QString videoId;
-    
-    if (url.contains("youtube.com/watch")) {
-        QRegularExpression rx("v=([a-zA-Z0-9_-]+)");
-        QRegularExpressionMatch match = rx.match(url);
-        if (match.hasMatch()) {
-            videoId = match.captured(1);
-        }
-    } else if (url.contains("youtu.be/")) {
-        QRegularExpression rx("youtu\\.be/([a-zA-Z0-9_-]+)");
-        QRegularExpressionMatch match = rx.match(url);
-        if (match.hasMatch()) {
-            videoId = match.captured(1);
-        }
-    } else if (url.contains("youtube.com/embed/")) {
-        QRegularExpression rx("embed/([a-zA-Z0-9_-]+)");
-        QRegularExpressionMatch match = rx.match(url);
-        if (match.hasMatch()) {
-            videoId = match.captured(1);
-        }
+    if (text.trimmed().isEmpty() || looksLikeYouTubeLink(text)) {
+        searchResults.clear();
+        searchResultModel->setStringList(QStringList());
+        searchEdit->setToolTip(QString());
+        return;
     }
     
-    return videoId;
+    indexAllPlaylists();
+    flushSearchIndex();
+    
+    QElapsedTimer timer;
+    timer.start();
+    const QList<quint32> matches = librarySearch.search(text);
+    double elapsedMs = timer.nsecsElapsed() / 1e6;
+    
+    // 只顯示前面的結果，下拉清單不必處理整個音樂庫
+    // 文件編號在索引壓縮後會改變，下拉清單開著時可能發生，所以立即取出播放清單與 trackKey
+    const QList<quint32> shown = matches.mid(0, kMaxSearchResults);
+    searchResults.clear();
+    searchResults.reserve(shown.size());
+    QStringList rows;
+    rows.reserve(shown.size());
+    for (quint32 doc : shown) {
+        LibrarySearch::Hit hit = librarySearch.hit(doc);
+        rows.append(QString("%1 — %2（%3）").arg(hit.title, hit.channelTitle, hit.playlistName));
+        searchResults.append(hit);
+    }
+    searchResultModel->setStringList(rows);
+    searchEdit->setToolTip(QString("找到 %1 首（%2 ms）").arg(matches.size()).arg(elapsedMs, 0, 'f', 2));
 }
 
-void Widget::playYouTubeLink(const QString& link)
+void Widget::onSearchResultActivated(const QModelIndex& index)
 {
-    QString videoId = extractYouTubeVideoId(link);
+    playSearchResult(index.row());
+}
+
+void Widget::playSearchResult(int row)
+{
+    if (row < 0 || row >= searchResults.size()) return;
     
-    if (videoId.isEmpty()) {
-        QMessageBox::warning(this, "錯誤", "無法識別 YouTube 連結格式！\n\n支援的格式：\n- https://www.youtube.com/watch?v=VIDEO_ID\n- https://youtu.be/VIDEO_ID\n- https://www.youtube.com/embed/VIDEO_ID");
+    const LibrarySearch::Hit hit = searchResults[row];
+    int index = findPlaylist(hit.playlistName);
+    if (index < 0) return;
+    
+    // 切換播放清單會經由 onPlaylistChanged() 載入
+    if (index != currentPlaylistIndex) {
+        playlistComboBox->setCurrentIndex(index);
+    } else if (!ensurePlaylistLoaded(index)) {
         return;
     }
     
-    // 停止當前播放
-    mediaPlayer->stop();
-    
-    // 創建影片資訊
-    VideoInfo video;
-    video.videoId = videoId;
-    video.title = "YouTube 影片";
-    video.channelTitle = "點擊連結在瀏覽器中觀看";
-    video.isFavorite = false;
-    video.isLocalFile = false;
-    video.filePath = "";
-    
-    // 顯示影片資訊
-    videoDisplayLabel->setText(createVideoDisplayHTML(video));
-    videoTitleLabel->setText(video.title);
-    channelLabel->setText(video.channelTitle);
-    
-    // 更新狀態（注意：YouTube 影片在瀏覽器播放，所以不改變播放狀態）
-    updateButtonStates();
+    const QList<VideoInfo>& videos = playlists[index].videos;
+    for (int i = 0; i < videos.size(); i++) {
+        if (trackKey(videos[i]) == hit.trackKey) {
+            playVideo(i);
+            break;
+        }
+    }
     
-    QMessageBox::information(this, "YouTube 連結", 
-        "已取得 YouTube 連結！\n請點擊顯示區域中的連結在瀏覽器中觀看影片。");
+    // QCompleter 會把選取的文字填入輸入框，等它完成後再清空
+    QTimer::singleShot(0, searchEdit, &QLineEdit::clear);
 }
 
-void Widget::playLocalFile(const QString& filePath)
+void Widget::markSearchStale(int index)
 {
-    // 停止當前播放
-    mediaPlayer->stop();
-    
-    // 創建影片資訊
-    VideoInfo video;
-    video.filePath = filePath;
-    video.videoId = "";
-    
-    // 從檔案名提取標題
-    QFileInfo fileInfo(filePath);
-    video.title = fileInfo.baseName();
-    video.channelTitle = "本地音樂";
-    video.isFavorite = false;
-    video.isLocalFile = true;
-    
-    // 設置媒體播放器
-    mediaPlayer->setSource(QUrl::fromLocalFile(filePath));
-    mediaPlayer->play();
-    
-    // 顯示音樂資訊
-    QString displayHTML = QString(
-        "<div style='text-align: center;'>"
-        "<h2 style='color: #1DB954;'>🎵 本地音樂</h2>"
-        "<p style='font-size: 18px; margin: 20px 0;'>%1</p>"
-        "<p style='font-size: 14px; color: #888; margin: 10px 0;'>檔案: %2</p>"
-        "<p style='color: #666; font-size: 12px; margin-top: 30px;'>正在播放本地音樂檔案</p>"
-        "</div>"
-    ).arg(video.title.toHtmlEscaped()).arg(fileInfo.fileName().toHtmlEscaped());
-    
-    videoDisplayLabel->setText(displayHTML);
-    videoTitleLabel->setText(video.title);
-    channelLabel->setText(video.channelTitle);
-    
-    // 更新播放狀態
-    isPlaying = true;
-    playPauseButton->setText("⏸");
-    currentVideoIndex = -1;  // 不屬於播放清單
+    if (index < 0 || index >= playlists.size()) return;
     
-    updateButtonStates();
+    searchStalePlaylists.insert(playlists[index].name);
+    searchIndexTimer->start();
 }
 
-void Widget::onPlayPauseClicked()
+void Widget::flushSearchIndex()
 {
-    if (currentVideoIndex >= 0) {
-        // 有正在播放的影片
-        if (currentPlaylistIndex >= 0 && currentPlaylistIndex < playlists.size()) {
-            const Playlist& playlist = playlists[currentPlaylistIndex];
-            if (currentVideoIndex < playlist.videos.size()) {
-                const VideoInfo& video = playlist.videos[currentVideoIndex];
-                
-                if (video.isLocalFile) {
-                    // 本地檔案，控制媒體播放器
-                    if (mediaPlayer->playbackState() == QMediaPlayer::PlayingState) {
-                        mediaPlayer->pause();
-                        isPlaying = false;
-                        playPauseButton->setText("▶");
-                    } else {
-                        mediaPlayer->play();
-                        isPlaying = true;
-                        playPauseButton->setText("⏸");
-                    }
-                } else {
-                    // YouTube 影片，只是切換狀態顯示
-                    isPlaying = !isPlaying;
-                    playPauseButton->setText(isPlaying ? "⏸" : "▶");
-                }
-            }
-        }
-    } else {
-        // 沒有影片，播放播放清單第一首
-        if (currentPlaylistIndex >= 0 && currentPlaylistIndex < playlists.size()) {
-            Playlist& playlist = playlists[currentPlaylistIndex];
-            if (!playlist.videos.isEmpty()) {
-                playVideo(0);
-            }
+    searchIndexTimer->stop();
+    const QSet<QString> stale = std::exchange(searchStalePlaylists, QSet<QString>());
+    for (const QString& name : stale) {
+        int index = findPlaylist(name);
+        // 已釋放的播放清單保留原本的索引
+        if (index >= 0 && playlists[index].loaded) {
+            librarySearch.updatePlaylist(name, playlists[index].videos);
         }
     }
 }
 
-void Widget::onMediaPlayerStateChanged()
+void Widget::indexAllPlaylists()
 {
-    // 當媒體播放器狀態改變時更新按鈕
-    if (mediaPlayer->playbackState() == QMediaPlayer::PlayingState) {
-        isPlaying = true;
-        playPauseButton->setText("⏸");
-    } else if (mediaPlayer->playbackState() == QMediaPlayer::StoppedState) {
-        isPlaying = false;
-        playPauseButton->setText("▶");
+    if (searchIndexRequested) return;
+    searchIndexRequested = true;
+    
+    // 未載入的播放清單在儲存執行緒上解碼，只用來建立索引，不放進記憶體
+    for (const Playlist& playlist : std::as_const(playlists)) {
+        if (playlist.loaded || librarySearch.hasPlaylist(playlist.name)) continue;
         
-        // 本地檔案播放結束，自動播放下一首（如果有）
-        // 只有當前正在播放本地檔案時才自動播放下一首
-        if (currentVideoIndex >= 0 && currentPlaylistIndex >= 0 && 
-            currentPlaylistIndex < playlists.size()) {
-            const Playlist& playlist = playlists[currentPlaylistIndex];
-            if (currentVideoIndex < playlist.videos.size() &&
-                playlist.videos[currentVideoIndex].isLocalFile) {
-                int nextIndex = getNextVideoIndex();
-                if (nextIndex >= 0) {
-                    playVideo(nextIndex);
+        QString name = playlist.name;
+        QMetaObject::invokeMethod(playlistStore, [this, name]() {
+            Playlist decoded;
+            decoded.name = name;
+            if (!playlistStore->loadPlaylist(decoded)) return;
+            
+            QMetaObject::invokeMethod(this, [this, decoded]() {
+                int index = findPlaylist(decoded.name);
+                if (index >= 0 && !playlists[index].loaded && !librarySearch.hasPlaylist(decoded.name)) {
+                    librarySearch.updatePlaylist(decoded.name, decoded.videos);
                 }
-            }
-        }
+            }, Qt::QueuedConnection);
+        }, Qt::QueuedConnection);
     }
 }
 
-void Widget::onMediaPlayerPositionChanged(qint64 position)
+void Widget::onLoadLocalFileClicked()
 {
-    // 可以在這裡更新進度條（如果需要的話）
+    QString filePath = QFileDialog::getOpenFileName(this, 
+        "選擇音樂檔案", 
+        QDir::homePath(),
+        "音樂檔案 (*.mp3 *.wav *.flac *.m4a *.ogg *.aac);;所有檔案 (*.*)");
+    
+    if (!filePath.isEmpty()) {
+        playLocalFile(filePath);
+    }
 }
 
-void Widget::onMediaPlayerDurationChanged(qint64 duration)
+void Widget::onImportFolderClicked()
 {
-    // 可以在這裡設置進度條的最大值（如果需要的話）
+    if (currentPlaylistIndex < 0 || currentPlaylistIndex >= playlists.size()) return;
+    
+    QString dirPath = QFileDialog::getExistingDirectory(this, "選擇音樂資料夾", QDir::homePath());
+    if (!dirPath.isEmpty()) {
+        // 掃描在背景進行，結果會陸續加入目前的播放清單
+        folderImporter->addRoot(dirPath, playlists[currentPlaylistIndex].name);
+    }
 }
 
-void Widget::onPreviousClicked()
+void Widget::onImportPlaylistFileClicked()
 {
+    if (playlistFileIO->isBusy()) return;
     if (currentPlaylistIndex < 0 || currentPlaylistIndex >= playlists.size()) return;
     
-    Playlist& playlist = playlists[currentPlaylistIndex];
-    if (playlist.videos.isEmpty()) return;
+    QString filePath = QFileDialog::getOpenFileName(this, "匯入播放清單", QDir::homePath(),
+                                                    PlaylistFileIO::fileFilter());
+    if (filePath.isEmpty()) return;
     
-    if (isShuffleMode) {
-        int newIndex = getRandomVideoIndex(true);
-        if (newIndex >= 0) {
-            playVideo(newIndex);
-        }
-    } else {
-        int newIndex = currentVideoIndex - 1;
-        if (newIndex < 0) {
-            newIndex = playlist.videos.size() - 1;
-        }
-        playVideo(newIndex);
-    }
+    // 解析在工作執行緒上進行，曲目成批加入目前的播放清單
+    playlistFileIO->startImport(filePath, playlists[currentPlaylistIndex].name);
+    startPlaylistTransfer("正在匯入播放清單…");
 }
 
-void Widget::onNextClicked()
+void Widget::onExportPlaylistFileClicked()
 {
+    if (playlistFileIO->isBusy()) return;
     if (currentPlaylistIndex < 0 || currentPlaylistIndex >= playlists.size()) return;
+    if (!ensurePlaylistLoaded(currentPlaylistIndex)) return;
     
-    Playlist& playlist = playlists[currentPlaylistIndex];
-    if (playlist.videos.isEmpty()) return;
+    const Playlist& playlist = playlists[currentPlaylistIndex];
+    QString filePath = QFileDialog::getSaveFileName(this, "匯出播放清單",
+                                                    QDir::home().filePath(playlist.name + ".m3u8"),
+                                                    "M3U8 (*.m3u8);;M3U (*.m3u);;PLS (*.pls)");
+    if (filePath.isEmpty()) return;
+    PlaylistFileIO::Format format;
+    if (!PlaylistFileIO::formatFor(filePath, format)) {
+        filePath += ".m3u8";
+    }
     
-    int newIndex = getNextVideoIndex();
-    if (newIndex >= 0) {
-        playVideo(newIndex);
+    // 交給工作執行緒的是隱式共享的快照，不複製曲目
+    playlistFileIO->startExport(filePath, playlist.videos);
+    startPlaylistTransfer("正在匯出播放清單…");
+}
+
+void Widget::startPlaylistTransfer(const QString& label)
+{
+    importPlaylistFileButton->setEnabled(false);
+    exportPlaylistFileButton->setEnabled(false);
+    
+    // 小檔案在對話框出現前就完成；不設為強制回應，匯入期間仍可操作播放器
+    transferProgress = new QProgressDialog(label, "取消", 0, 1000, this);
+    transferProgress->setAttribute(Qt::WA_DeleteOnClose);
+    transferProgress->setMinimumDuration(500);
+    transferProgress->setAutoClose(false);
+    transferProgress->setAutoReset(false);
+    transferProgress->setValue(0);
+    connect(transferProgress, &QProgressDialog::canceled, playlistFileIO, &PlaylistFileIO::cancel);
+}
+
+void Widget::onPlaylistTracksImported(const QString& playlistName, const QList<VideoInfo>& videos)
+{
+    int index = findPlaylist(playlistName);
+    if (index < 0) return;
+    if (!ensurePlaylistLoaded(index)) return;
+    appendVideos(index, videos);
+}
+
+void Widget::onPlaylistTransferProgress(qint64 done, qint64 total)
+{
+    if (transferProgress && total > 0) {
+        transferProgress->setValue(int(qBound<qint64>(0, done * 1000 / total, 1000)));
     }
 }
 
-void Widget::onShuffleClicked()
+void Widget::onPlaylistTransferFinished(bool ok, bool cancelled, const QString& message)
 {
-    isShuffleMode = !isShuffleMode;
-    shuffleButton->setChecked(isShuffleMode);
+    if (transferProgress) {
+        transferProgress->close();
+        transferProgress = nullptr;
+    }
+    importPlaylistFileButton->setEnabled(true);
+    exportPlaylistFileButton->setEnabled(true);
     
-    if (isShuffleMode) {
-        playedVideosInCurrentSession.clear();
-        shuffleButton->setStyleSheet(
-            "QPushButton {"
-            "   background-color: #1DB954;"
-            "   color: white;"
-            "   border: none;"
-            "   border-radius: 20px;"
-            "   padding: 10px 20px;"
-            "   font-size: 14px;"
-            "   min-width: 40px;"
-            "}"
-            "QPushButton:hover { background-color: #1ED760; }"
-        );
+    if (cancelled) return;
+    if (ok) {
+        QMessageBox::information(this, "播放清單", message);
     } else {
+        QMessageBox::warning(this, "播放清單", message);
+    }
+}
+
+void Widget::onFolderFilesAdded(const QString& playlistName, const QStringList& filePaths)
+{
+    int index = findPlaylist(playlistName);
+    if (index < 0 || !ensurePlaylistLoaded(index)) return;
+    
+    QSet<QString> existing;
+    for (const VideoInfo& video : std::as_const(playlists[index].videos)) {
+        if (video.isLocalFile()) {
+            existing.insert(video.filePath());
+        }
+    }
+    
+    QList<VideoInfo> newVideos;
+    QStringList newPaths;
+    for (const QString& filePath : filePaths) {
+        if (existing.contains(filePath)) continue;
+        existing.insert(filePath);
+        
+        VideoInfo video;
+        video.setFilePath(filePath);
+        video.setTitle(QFileInfo(filePath).baseName());
+        video.setChannelTitle("本地音樂");
+        video.setFavorite(false);
+        video.setLocalFile(true);
+        newVideos.append(video);
+        newPaths.append(filePath);
+    }
+    if (newVideos.isEmpty()) return;
+    appendVideos(index, newVideos);
+    
+    // 背景計算內容雜湊：與清單中既有曲目內容相同的新檔案（例如經由符號連結）稍後移除
+    // 已算出或仍在先前批次中計算的檔案不再送出，大量檔案分批加入時每個檔案只計算一次
+    QStringList hashPaths;
+    for (const VideoInfo& video : std::as_const(playlists[index].videos)) {
+        if (!video.isLocalFile()) continue;
+        const QString& filePath = video.filePath();
+        if (!contentHashes.contains(filePath) && !pendingContentHashes.contains(filePath)) {
+            pendingContentHashes.insert(filePath);
+            hashPaths.append(filePath);
+        }
+    }
+    ImportCheck check;
+    check.playlistName = playlistName;
+    check.newPaths = QSet<QString>(newPaths.cbegin(), newPaths.cend());
+    check.hashPaths = hashPaths;
+    importChecks.insert(contentHasher->hashFiles(hashPaths), check);
+}
+
+void Widget::onFolderFilesRemoved(const QString& playlistName, const QStringList& filePaths)
+{
+    int index = findPlaylist(playlistName);
+    if (index < 0 || !ensurePlaylistLoaded(index)) return;
+    
+    const QSet<QString> removedPaths(filePaths.cbegin(), filePaths.cend());
+    QList<int> rows;
+    const QList<VideoInfo>& videos = playlists[index].videos;
+    for (int row = 0; row < videos.size(); row++) {
+        if (videos[row].isLocalFile() && removedPaths.contains(videos[row].filePath())) {
+            rows.append(row);
+        }
+    }
+    removeVideos(index, rows);
+}
+
+void Widget::appendVideos(int index, const QList<VideoInfo>& newVideos)
+{
+    insertVideos(index, playlists[index].videos.size(), newVideos);
+}
+
+void Widget::insertVideos(int index, int row, const QList<VideoInfo>& newVideos)
+{
+    // 載入失敗的播放清單不接受編輯
+    if (newVideos.isEmpty() || !playlists[index].loaded) return;
+    
+    // 插入點之後的列號往後移：當前項目、已預載的下一首與隨機排列跟著調整
+    const int count = playlists[index].videos.size();
+    row = qBound(0, row, count);
+    if (index == currentPlaylistIndex) {
+        if (shuffle.trackCount() == count) {
+            shuffle.insertTracks(row, newVideos.size());
+        }
+        if (currentVideoIndex >= row) {
+            currentVideoIndex += newVideos.size();
+        }
+        if (armedVideoIndex >= row) {
+            armedVideoIndex += newVideos.size();
+        }
+    }
+    playlistModel->insertVideos(index, row, newVideos);
+    if (index == currentPlaylistIndex && armedVideoIndex >= 0 && armedVideoIndex != getNextVideoIndex()) {
+        disarmStandbyPlayer();
+    }
+    markPlaylistDirty(index);
+    if (index == favoritesPlaylistIndex()) {
+        rebuildFavoriteKeys();
+    }
+    
+    QStringList localPaths;
+    for (const VideoInfo& video : newVideos) {
+        if (video.isLocalFile()) {
+            localPaths.append(video.filePath());
+        }
+    }
+    metadataExtractor->request(localPaths);
+    updateButtonStates();
+}
+
+void Widget::onVideosMoved(int playlistIndex, const QList<int>& sortedRows, int destination)
+{
+    // 只改變列號：當前項目、已預載的下一首與隨機排列/歷史都換成新的編號，不必重新洗牌
+    if (playlistIndex == currentPlaylistIndex) {
+        currentVideoIndex = ShuffleEngine::movedRow(currentVideoIndex, sortedRows, destination);
+        armedVideoIndex = ShuffleEngine::movedRow(armedVideoIndex, sortedRows, destination);
+        if (shuffle.trackCount() == playlists[playlistIndex].videos.size()) {
+            shuffle.moveTracks(sortedRows, destination);
+        }
+        // 循序播放時下一首可能變了
+        if (armedVideoIndex >= 0 && armedVideoIndex != getNextVideoIndex()) {
+            disarmStandbyPlayer();
+        }
+    }
+    markPlaylistDirty(playlistIndex);
+    updateButtonStates();
+}
+
+void Widget::onUrlsDropped(int playlistIndex, int row, const QList<QUrl>& urls)
+{
+    if (playlistIndex < 0 || playlistIndex >= playlists.size()) return;
+    const QString playlistName = playlists[playlistIndex].name;
+    
+    // 一般檔案與 YouTube 連結整批插入；資料夾與播放清單檔交給各自的背景匯入
+    QList<VideoInfo> newVideos;
+    newVideos.reserve(urls.size());
+    for (const QUrl& url : urls) {
+        if (!url.isLocalFile()) {
+            QString videoId = extractYouTubeVideoId(url.toString());
+            if (videoId.isEmpty()) continue;
+            
+            VideoInfo video;
+            video.setVideoId(videoId);
+            video.setTitle("YouTube 影片");
+            video.setChannelTitle("點擊連結在瀏覽器中觀看");
+            newVideos.append(video);
+            continue;
+        }
+        
+        const QString filePath = QDir::cleanPath(url.toLocalFile());
+        QFileInfo fileInfo(filePath);
+        PlaylistFileIO::Format format;
+        if (fileInfo.isDir()) {
+            folderImporter->addRoot(filePath, playlistName);
+        } else if (PlaylistFileIO::formatFor(filePath, format)) {
+            if (!playlistFileIO->isBusy()) {
+                playlistFileIO->startImport(filePath, playlistName);
+                startPlaylistTransfer("正在匯入播放清單…");
+            }
+        } else if (FolderImporter::isAudioFile(fileInfo.fileName())) {
+            VideoInfo video;
+            video.setFilePath(filePath);
+            video.setTitle(fileInfo.baseName());
+            video.setChannelTitle("本地音樂");
+            video.setLocalFile(true);
+            newVideos.append(video);
+        }
+    }
+    
+    if (!ensurePlaylistLoaded(playlistIndex)) return;
+    insertVideos(playlistIndex, row, newVideos);
+}
+
+void Widget::removeVideos(int index, const QList<int>& rows)
+{
+    if (rows.isEmpty() || !playlists[index].loaded) return;
+    
+    if (index == currentPlaylistIndex) {
+        // 列號改變：調整當前項目，已預載與已播放的索引不再可靠
+        disarmStandbyPlayer();
+        shuffle.removeTracks(rows);
+        if (currentVideoIndex >= 0) {
+            int before = 0;
+            for (int row : std::as_const(rows)) {
+                if (row == currentVideoIndex) {
+                    before = -1;
+                    break;
+                }
+                if (row > currentVideoIndex) break;
+                before++;
+            }
+            currentVideoIndex = before < 0 ? -1 : currentVideoIndex - before;
+        }
+    }
+    
+    playlistModel->removeVideos(index, rows);
+    markPlaylistDirty(index);
+    if (index == favoritesPlaylistIndex()) {
+        rebuildFavoriteKeys();
+    }
+    updateButtonStates();
+}
+
+void Widget::onContentHashesReady(int batchId, const QHash<QString, quint64>& hashes)
+{
+    for (auto it = hashes.cbegin(); it != hashes.cend(); ++it) {
+        contentHashes.insert(it.key(), it.value());
+    }
+    
+    if (batchId == duplicateScanBatch) {
+        duplicateScanBatch = -1;
+        reportDuplicates(hashes);
+        return;
+    }
+    
+    auto checkIt = importChecks.find(batchId);
+    if (checkIt == importChecks.end()) return;
+    const ImportCheck check = *checkIt;
+    importChecks.erase(checkIt);
+    for (const QString& filePath : check.hashPaths) {
+        pendingContentHashes.remove(filePath);
+    }
+    
+    // 同一個播放清單還有批次在計算時，新檔案留到最後一批完成，那時所有雜湊都已算出
+    importNewPaths[check.playlistName].unite(check.newPaths);
+    for (const ImportCheck& other : std::as_const(importChecks)) {
+        if (other.playlistName == check.playlistName) return;
+    }
+    const QSet<QString> newPaths = importNewPaths.take(check.playlistName);
+    
+    int index = findPlaylist(check.playlistName);
+    if (index < 0 || !ensurePlaylistLoaded(index)) return;
+    
+    // 依清單順序保留每個內容第一次出現的項目，之後內容相同的新檔案移除
+    QHash<quint64, QString> firstPathByHash;
+    QList<int> rows;
+    const QList<VideoInfo>& videos = playlists[index].videos;
+    for (int row = 0; row < videos.size(); row++) {
+        if (!videos[row].isLocalFile()) continue;
+        auto hashIt = contentHashes.constFind(videos[row].filePath());
+        if (hashIt == contentHashes.constEnd()) continue;
+        
+        auto first = firstPathByHash.constFind(*hashIt);
+        if (first == firstPathByHash.constEnd()) {
+            firstPathByHash.insert(*hashIt, videos[row].filePath());
+        } else if (*first != videos[row].filePath() && newPaths.contains(videos[row].filePath())) {
+            rows.append(row);
+        }
+    }
+    if (rows.isEmpty()) return;
+    
+    removeVideos(index, rows);
+    importFolderButton->setToolTip(QString("上次匯入略過 %1 個內容重複的檔案").arg(rows.size()));
+}
+
+void Widget::onFindDuplicatesClicked()
+{
+    if (duplicateScanBatch >= 0) return;
+    findDuplicatesButton->setEnabled(false);
+    findDuplicatesButton->setText("🔍 檢查中…");
+    
+    // 已載入的播放清單直接讀取；其餘在儲存執行緒上解碼，只取出本地檔案路徑
+    QHash<QString, QStringList> owners;
+    QStringList unloaded;
+    for (const Playlist& playlist : std::as_const(playlists)) {
+        if (!playlist.loaded) {
+            unloaded.append(playlist.name);
+            continue;
+        }
+        for (const VideoInfo& video : playlist.videos) {
+            if (video.isLocalFile()) {
+                owners[video.filePath()].append(playlist.name);
+            }
+        }
+    }
+    if (unloaded.isEmpty()) {
+        startDuplicateScan(owners);
+        return;
+    }
+    
+    QMetaObject::invokeMethod(playlistStore, [this, unloaded, owners]() mutable {
+        for (const QString& name : std::as_const(unloaded)) {
+            Playlist decoded;
+            decoded.name = name;
+            if (!playlistStore->loadPlaylist(decoded)) continue;
+            for (const VideoInfo& video : std::as_const(decoded.videos)) {
+                if (video.isLocalFile()) {
+                    owners[video.filePath()].append(name);
+                }
+            }
+        }
+        QMetaObject::invokeMethod(this, [this, owners]() {
+            startDuplicateScan(owners);
+        }, Qt::QueuedConnection);
+    }, Qt::QueuedConnection);
+}
+
+void Widget::startDuplicateScan(const QHash<QString, QStringList>& owners)
+{
+    duplicateScanOwners = owners;
+    duplicateScanBatch = contentHasher->hashFiles(owners.keys());
+}
+
+void Widget::reportDuplicates(const QHash<QString, quint64>& hashes)
+{
+    findDuplicatesButton->setEnabled(true);
+    findDuplicatesButton->setText("🔍 重複曲目");
+    const QHash<QString, QStringList> owners = std::exchange(duplicateScanOwners, QHash<QString, QStringList>());
+    
+    // 同一個路徑出現在多個播放清單（例如「我的最愛」）不算重複，只比較不同路徑
+    QHash<quint64, QStringList> pathsByHash;
+    for (auto it = hashes.cbegin(); it != hashes.cend(); ++it) {
+        pathsByHash[it.value()].append(it.key());
+    }
+    
+    QStringList groups;
+    int duplicateFiles = 0;
+    for (QStringList& paths : pathsByHash) {
+        if (paths.size() < 2) continue;
+        paths.sort();
+        duplicateFiles += paths.size() - 1;
+        
+        QStringList lines;
+        for (const QString& path : std::as_const(paths)) {
+            lines.append(QString("%1  [%2]").arg(path, owners.value(path).join(", ")));
+        }
+        groups.append(lines.join("\n"));
+    }
+    
+    if (groups.isEmpty()) {
+        QMessageBox::information(this, "重複曲目", QString("檢查了 %1 個本地檔案，沒有找到內容重複的曲目。").arg(hashes.size()));
+        return;
+    }
+    
+    groups.sort();
+    QMessageBox box(QMessageBox::Information, "重複曲目",
+                    QString("檢查了 %1 個本地檔案，找到 %2 組內容相同的曲目（共 %3 個多餘的檔案）。\n"
+                            "詳細內容列出每組的路徑與所在的播放清單。")
+                        .arg(hashes.size()).arg(groups.size()).arg(duplicateFiles),
+                    QMessageBox::Ok, this);
+    box.setDetailedText(groups.join("\n\n"));
+    box.exec();
+}
+
+int Widget::findPlaylist(const QString& name) const
+{
+    for (int i = 0; i < playlists.size(); i++) {
+        if (playlists[i].name == name) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+int Widget::favoritesPlaylistIndex()
+{
+    // 播放清單刪除後位置會移動，快取失效時才重新尋找
+    if (cachedFavoritesIndex < 0 || cachedFavoritesIndex >= playlists.size() ||
+        playlists[cachedFavoritesIndex].name != "我的最愛") {
+        cachedFavoritesIndex = findPlaylist("我的最愛");
+    }
+    return cachedFavoritesIndex;
+}
+
+bool Widget::isFavorite(const VideoInfo& video) const
+{
+    return favoriteKeys.contains(trackKey(video));
+}
+
+void Widget::rebuildFavoriteKeys()
+{
+    int index = favoritesPlaylistIndex();
+    if (index >= 0 && !playlists[index].loaded) return;   // 尚未載入（或已釋放）時保留現有集合
+    
+    favoriteKeys.clear();
+    if (index >= 0) {
+        for (const VideoInfo& video : std::as_const(playlists[index].videos)) {
+            favoriteKeys.insert(trackKey(video));
+        }
+    }
+    playlistModel->refreshFavorites();
+    updateFavoriteButton();
+}
+
+void Widget::updateFavoriteButton()
+{
+    bool favorite = currentPlaylistIndex >= 0 && currentPlaylistIndex < playlists.size() &&
+                    currentVideoIndex >= 0 && currentVideoIndex < playlists[currentPlaylistIndex].videos.size() &&
+                    isFavorite(playlists[currentPlaylistIndex].videos[currentVideoIndex]);
+    toggleFavoriteButton->setText(favorite ? "💔 移除最愛" : "❤️ 加入最愛");
+}
+
+void Widget::playYouTubeLink(const QString& link)
+{
+    QString videoId = extractYouTubeVideoId(link);
+    
+    if (videoId.isEmpty()) {
+        QMessageBox::warning(this, "錯誤", "無法識別 YouTube 連結格式！\n\n支援的格式：\n- https://www.youtube.com/watch?v=VIDEO_ID\n- https://youtu.be/VIDEO_ID\n- https://www.youtube.com/embed/VIDEO_ID");
+        return;
+    }
+    
+    // 停止當前播放（不屬於播放清單的檔案不做交叉淡化）
+    mediaPlayer->stop();
+    crossfadePlayer->stop();
+    
+    // 創建影片資訊
+    VideoInfo video;
+    video.setVideoId(videoId);
+    video.setTitle("YouTube 影片");
+    video.setChannelTitle("點擊連結在瀏覽器中觀看");
+    video.setFavorite(false);
+    video.setLocalFile(false);
+    video.setFilePath("");
+    
+    // 顯示影片資訊
+    videoDisplayLabel->setText(createVideoDisplayHTML(video));
+    videoTitleLabel->setText(video.title());
+    channelLabel->setText(video.channelTitle());
+    updateNowPlayingCover(QString());
+    
+    // 更新狀態（注意：YouTube 影片在瀏覽器播放，所以不改變播放狀態）
+    updateButtonStates();
+    
+    QMessageBox::information(this, "YouTube 連結", 
+        "已取得 YouTube 連結！\n請點擊顯示區域中的連結在瀏覽器中觀看影片。");
+}
+
+void Widget::playLocalFile(const QString& filePath)
+{
+    trackStartTimer.start();
+    
+    // 停止當前播放（不屬於播放清單的檔案不做交叉淡化，一律由 QMediaPlayer 播放）
+    // 已預載的下一首屬於原本的播放清單，一併取消
+    mediaPlayer->stop();
+    crossfadePlayer->stop();
+    disarmStandbyPlayer();
+    
+    // 創建影片資訊
+    VideoInfo video;
+    video.setFilePath(filePath);
+    video.setVideoId("");
+    
+    // 從檔案名提取標題
+    QFileInfo fileInfo(filePath);
+    video.setTitle(fileInfo.baseName());
+    video.setChannelTitle("本地音樂");
+    video.setFavorite(false);
+    video.setLocalFile(true);
+    
+    // 設置媒體播放器
+    audioOutput->setVolume(volumeFor(filePath));
+    mediaPlayer->setSource(QUrl::fromLocalFile(filePath));
+    mediaPlayer->play();
+    metadataExtractor->request(QStringList() << filePath);
+    seekBar->clearPeaks();
+    waveformCache->request(filePath);
+    
+    // 顯示音樂資訊
+    QString displayHTML = QString(
+        "<div style='text-align: center;'>"
+        "<h2 style='color: #1DB954;'>🎵 本地音樂</h2>"
+        "<p style='font-size: 18px; margin: 20px 0;'>%1</p>"
+        "<p style='font-size: 14px; color: #888; margin: 10px 0;'>檔案: %2</p>"
+        "<p style='color: #666; font-size: 12px; margin-top: 30px;'>正在播放本地音樂檔案</p>"
+        "</div>"
+    ).arg(video.title().toHtmlEscaped()).arg(fileInfo.fileName().toHtmlEscaped());
+    
+    videoDisplayLabel->setText(displayHTML);
+    videoTitleLabel->setText(video.title());
+    channelLabel->setText(video.channelTitle());
+    updateNowPlayingCover(QString());
+    
+    // 更新播放狀態
+    isPlaying = true;
+    playPauseButton->setText("⏸");
+    currentVideoIndex = -1;  // 不屬於播放清單
+    
+    updateButtonStates();
+}
+
+void Widget::onPlayPauseClicked()
+{
+    if (currentVideoIndex >= 0) {
+        // 有正在播放的影片
+        if (currentPlaylistIndex >= 0 && currentPlaylistIndex < playlists.size()) {
+            const Playlist& playlist = playlists[currentPlaylistIndex];
+            if (currentVideoIndex < playlist.videos.size()) {
+                const VideoInfo& video = playlist.videos[currentVideoIndex];
+                
+                if (video.isLocalFile()) {
+                    // 本地檔案，控制目前使用中的播放引擎
+                    if (localPlaybackPlaying()) {
+                        pauseLocalPlayback();
+                        isPlaying = false;
+                        playPauseButton->setText("▶");
+                    } else {
+                        resumeLocalPlayback();
+                        isPlaying = true;
+                        playPauseButton->setText("⏸");
+                    }
+                } else {
+                    // YouTube 影片，只是切換狀態顯示
+                    isPlaying = !isPlaying;
+                    playPauseButton->setText(isPlaying ? "⏸" : "▶");
+                }
+            }
+        }
+    } else {
+        // 沒有影片，播放播放清單第一首
+        if (currentPlaylistIndex >= 0 && currentPlaylistIndex < playlists.size()) {
+            Playlist& playlist = playlists[currentPlaylistIndex];
+            if (!playlist.videos.isEmpty()) {
+                playVideo(0);
+            }
+        }
+    }
+}
+
+bool Widget::localPlaybackPlaying() const
+{
+    // 本地檔案由自有管線或 QMediaPlayer 播放；暫停與繼續對兩者的行為相同
+    if (crossfadeActive()) {
+        return crossfadePlayer->state() == CrossfadePlayer::PlayingState;
+    }
+    return mediaPlayer->playbackState() == QMediaPlayer::PlayingState;
+}
+
+void Widget::pauseLocalPlayback()
+{
+    if (crossfadeActive()) {
+        crossfadePlayer->pause();
+    } else {
+        mediaPlayer->pause();
+    }
+}
+
+void Widget::resumeLocalPlayback()
+{
+    if (crossfadeActive()) {
+        crossfadePlayer->resume();
+    } else {
+        mediaPlayer->play();
+    }
+}
+
+void Widget::onMediaPlayerStateChanged()
+{
+    // 備用播放器的信號不影響介面
+    if (sender() != mediaPlayer) return;
+    
+    // 當媒體播放器狀態改變時更新按鈕
+    if (mediaPlayer->playbackState() == QMediaPlayer::PlayingState) {
+        isPlaying = true;
+        playPauseButton->setText("⏸");
+    } else if (mediaPlayer->playbackState() == QMediaPlayer::StoppedState) {
+        isPlaying = false;
+        playPauseButton->setText("▶");
+    }
+    updateSpectrum();
+}
+
+void Widget::onMediaPlayerStatusChanged(QMediaPlayer::MediaStatus status)
+{
+    if (sender() != mediaPlayer) return;
+    
+    if (Trace::isEnabled()) {
+        Trace::instant("mediaStatus", "media", QMetaEnum::fromType<QMediaPlayer::MediaStatus>().valueToKey(status));
+    }
+    if (status == QMediaPlayer::BufferedMedia) {
+        recordTrackStart();
+    }
+    if (status != QMediaPlayer::EndOfMedia) return;
+    
+    playNextAfterEnd();
+}
+
+void Widget::playNextAfterEnd()
+{
+    // 本地檔案播放結束，自動播放下一首（如果有）
+    // 只有當前正在播放本地檔案時才自動播放下一首；手動 stop() 不會觸發
+    if (currentVideoIndex < 0 || currentPlaylistIndex < 0 ||
+        currentPlaylistIndex >= playlists.size()) return;
+    const Playlist& playlist = playlists[currentPlaylistIndex];
+    if (currentVideoIndex >= playlist.videos.size() ||
+        !playlist.videos[currentVideoIndex].isLocalFile()) return;
+    
+    // 從這一刻起計時，直到下一首出現第一個位置更新
+    gapTimer.start();
+    
+    if (armedVideoIndex >= 0 && (standbyPlayer->mediaStatus() == QMediaPlayer::LoadedMedia ||
+                                 standbyPlayer->mediaStatus() == QMediaPlayer::BufferedMedia)) {
+        swapToStandbyPlayer();
+        return;
+    }
+    
+    int nextIndex = getNextVideoIndex();
+    if (nextIndex >= 0) {
+        playVideo(nextIndex);
+    } else {
+        gapTimer.invalidate();
+    }
+}
+
+void Widget::onMediaPlayerPositionChanged(qint64 position)
+{
+    if (sender() != mediaPlayer) return;
+    
+    updatePlaybackPosition(position, mediaPlayer->duration());
+}
+
+void Widget::onMediaPlayerDurationChanged(qint64 duration)
+{
+    if (sender() != mediaPlayer) return;
+    
+    updatePlaybackDuration(mediaPlayer->position(), duration);
+}
+
+void Widget::updatePlaybackPosition(qint64 position, qint64 duration)
+{
+    // 換曲後的第一個位置更新：記錄換曲間隔
+    if (gapTimer.isValid() && position > 0) {
+        lastGapMs = gapTimer.elapsed();
+        gapTimer.invalidate();
+        gaplessButton->setToolTip(QString("無縫播放（上次換曲間隔 %1 ms）").arg(lastGapMs));
+    }
+    if (position > 0) {
+        recordTrackStart();
+    }
+    
+    // 進度條自行限制重繪頻率；文字只有秒數改變時才會真的更新
+    seekBar->setPosition(position);
+    positionLabel->setText(formatDuration(position));
+    
+    armStandbyPlayer(position, duration);
+}
+
+void Widget::updatePlaybackDuration(qint64 position, qint64 duration)
+{
+    seekBar->setDuration(duration);
+    durationLabel->setText(formatDuration(duration));
+    
+    armStandbyPlayer(position, duration);
+}
+
+void Widget::onCrossfadeStateChanged(CrossfadePlayer::State state)
+{
+    if (state == CrossfadePlayer::PlayingState) {
+        isPlaying = true;
+        playPauseButton->setText("⏸");
+    } else if (state == CrossfadePlayer::StoppedState) {
+        isPlaying = false;
+        playPauseButton->setText("▶");
+    }
+    updateCrossfadeToolTip();
+    updateSpectrum();
+}
+
+void Widget::onCrossfadePositionChanged(qint64 position)
+{
+    updatePlaybackPosition(position, crossfadePlayer->duration());
+}
+
+void Widget::onCrossfadeDurationChanged(qint64 duration)
+{
+    updatePlaybackDuration(crossfadePlayer->position(), duration);
+}
+
+void Widget::onCrossfadeAdvanced()
+{
+    // 排入的下一首已開始淡入：與無縫換曲相同，只更新介面
+    int nextIndex = armedVideoIndex;
+    armedVideoIndex = -1;
+    standbyArmAttempted = false;
+    if (nextIndex < 0 || currentPlaylistIndex < 0 || currentPlaylistIndex >= playlists.size() ||
+        nextIndex >= playlists[currentPlaylistIndex].videos.size()) return;
+    
+    currentVideoIndex = nextIndex;
+    if (isShuffleMode) {
+        shuffle.select(nextIndex);
+    }
+    trackStartTimer.invalidate();
+    updateNowPlaying(nextIndex);
+    prefetchNextTrack();
+}
+
+void Widget::onCrossfadeEndOfMedia()
+{
+    playNextAfterEnd();
+}
+
+void Widget::onCrossfadeError(const QString& filePath)
+{
+    // 無法解碼或開啟輸出裝置：這一首改由 QMediaPlayer 播放（硬切換）
+    if (currentPlaylistIndex < 0 || currentPlaylistIndex >= playlists.size()) return;
+    const Playlist& playlist = playlists[currentPlaylistIndex];
+    if (currentVideoIndex < 0 || currentVideoIndex >= playlist.videos.size() ||
+        playlist.videos[currentVideoIndex].filePath() != filePath) return;
+    
+    audioOutput->setVolume(volumeFor(filePath));
+    mediaPlayer->setSource(QUrl::fromLocalFile(filePath));
+    mediaPlayer->play();
+}
+
+void Widget::onSeekRequested(qint64 position)
+{
+    // 已預載到備用播放器的下一首不受影響
+    if (crossfadeActive()) {
+        crossfadePlayer->setPosition(position);
+    } else {
+        mediaPlayer->setPosition(position);
+    }
+}
+
+void Widget::onWaveformReady(const QString& filePath, const WaveformPeaks& peaks)
+{
+    // 可能是已經切走的曲目
+    if (mediaPlayer->source() == QUrl::fromLocalFile(filePath) ||
+        (crossfadeActive() && crossfadePlayer->currentFile() == filePath)) {
+        seekBar->setPeaks(peaks);
+    }
+}
+
+void Widget::armStandbyPlayer(qint64 position, qint64 duration)
+{
+    // 每首歌只嘗試一次：在結束前幾秒把下一首載入備用播放器
+    // 由 CrossfadePlayer 播放時改為交給它預先解碼，淡化開始前就要準備好
+    // 交叉淡化關閉時管線以 0 淡化播放，排入的下一首就是無縫換曲
+    const bool pipeline = crossfadeActive() && (isCrossfadeMode || isGaplessMode);
+    if (!(pipeline || isGaplessMode) || standbyArmAttempted || duration <= 0) return;
+    const qint64 preloadMs = pipeline ? kGaplessPreloadMs + crossfadePlayer->fadeMs() : kGaplessPreloadMs;
+    if (duration - position > preloadMs) return;
+    if (currentVideoIndex < 0 || currentPlaylistIndex < 0 ||
+        currentPlaylistIndex >= playlists.size()) return;
+    
+    const Playlist& playlist = playlists[currentPlaylistIndex];
+    if (currentVideoIndex >= playlist.videos.size() ||
+        !playlist.videos[currentVideoIndex].isLocalFile()) return;
+    
+    standbyArmAttempted = true;
+    int nextIndex = getNextVideoIndex();
+    if (nextIndex < 0 || !playlist.videos[nextIndex].isLocalFile()) return;
+    
+    armedVideoIndex = nextIndex;
+    const QString& filePath = playlist.videos[nextIndex].filePath();
+    if (pipeline) {
+        crossfadePlayer->queueNext(filePath, volumeFor(filePath));
+        return;
+    }
+    standbyOutput->setVolume(volumeFor(filePath));
+    standbyPlayer->setSource(QUrl::fromLocalFile(filePath));
+}
+
+void Widget::disarmStandbyPlayer()
+{
+    standbyArmAttempted = false;
+    if (armedVideoIndex >= 0) {
+        armedVideoIndex = -1;
+        standbyPlayer->setSource(QUrl());
+        crossfadePlayer->clearNext();
+    }
+}
+
+void Widget::swapToStandbyPlayer()
+{
+    int nextIndex = armedVideoIndex;
+    
+    // 先讓已預載的播放器開始播放，再交換兩組播放器
+    standbyPlayer->play();
+    std::swap(mediaPlayer, standbyPlayer);
+    std::swap(audioOutput, standbyOutput);
+    
+    // 舊播放器變成備用播放器；它的信號會因 sender() 檢查而被忽略
+    armedVideoIndex = -1;
+    standbyArmAttempted = false;
+    standbyPlayer->stop();
+    standbyPlayer->setSource(QUrl());
+    updateSpectrum();
+    
+    currentVideoIndex = nextIndex;
+    if (isShuffleMode) {
+        shuffle.select(nextIndex);
+    }
+    trackStartTimer.invalidate();
+    updateNowPlaying(nextIndex);
+    prefetchNextTrack();
+}
+
+void Widget::recordTrackStart()
+{
+    if (!trackStartTimer.isValid()) return;
+    
+    qint64 latencyMs = trackStartTimer.elapsed();
+    trackStartTimer.invalidate();
+    trackStartLatency.record(latencyMs);
+    if (Trace::isEnabled()) {
+        Trace::instant("trackStart", "media", QString("%1 ms").arg(latencyMs));
+    }
+    positionLabel->setToolTip(QString("開始播放延遲：%1 ms\n%2").arg(latencyMs).arg(trackStartLatency.toText()));
+    
+    // 這首已經開始發聲，接著預讀下一首，不與目前這首的載入搶頻寬
+    prefetchNextTrack();
+}
+
+void Widget::prefetchNextTrack()
+{
+    int nextIndex = getNextVideoIndex();
+    if (nextIndex < 0) return;
+    
+    const VideoInfo& video = playlists[currentPlaylistIndex].videos[nextIndex];
+    if (video.isLocalFile()) {
+        prefetcher.prefetch(video.filePath());
+        
+        // 下一首還沒分析過：排到分析佇列最前面，通常在這首播完前就有結果
+        if (isNormalizeMode) {
+            loudnessAnalyzer->request(QStringList() << video.filePath(), true);
+        }
+    }
+}
+
+float Widget::volumeFor(const QString& filePath)
+{
+    if (!isNormalizeMode) return kBaseVolume;
+    
+    // 沒有結果時以原本的音量播放，絕不等待分析；同時要求分析，下次播放就會套用
+    TrackLoudness loudness;
+    if (!loudnessAnalyzer->lookup(filePath, loudness)) {
+        loudnessAnalyzer->request(QStringList() << filePath, true);
+        return kBaseVolume;
+    }
+    float gain = std::pow(10.0f, LoudnessAnalyzer::gainDbFor(loudness, kBaseVolume) / 20.0f);
+    return qMin(1.0f, kBaseVolume * gain);
+}
+
+void Widget::onGaplessClicked()
+{
+    isGaplessMode = !isGaplessMode;
+    gaplessButton->setChecked(isGaplessMode);
+    
+    if (isGaplessMode) {
+        // 目前這首已接近結尾時，下一個位置更新就會預載
+        standbyArmAttempted = false;
+        gaplessButton->setStyleSheet(
+            "QPushButton {"
+            "   background-color: #1DB954;"
+            "   color: white;"
+            "   border: none;"
+            "   border-radius: 20px;"
+            "   padding: 10px 20px;"
+            "   font-size: 14px;"
+            "   min-width: 40px;"
+            "}"
+            "QPushButton:hover { background-color: #1ED760; }"
+        );
+    } else {
+        disarmStandbyPlayer();
+        gaplessButton->setStyleSheet(
+            "QPushButton {"
+            "   background-color: #282828;"
+            "   color: #FFFFFF;"
+            "   border: none;"
+            "   border-radius: 20px;"
+            "   padding: 10px 20px;"
+            "   font-size: 14px;"
+            "   min-width: 40px;"
+            "}"
+            "QPushButton:hover { background-color: #404040; }"
+        );
+    }
+}
+
+void Widget::onNormalizeClicked()
+{
+    isNormalizeMode = !isNormalizeMode;
+    normalizeButton->setChecked(isNormalizeMode);
+    
+    const VideoInfo* current = nullptr;
+    if (currentPlaylistIndex >= 0 && currentPlaylistIndex < playlists.size() &&
+        currentVideoIndex >= 0 && currentVideoIndex < playlists[currentPlaylistIndex].videos.size()) {
+        current = &playlists[currentPlaylistIndex].videos[currentVideoIndex];
+    }
+    
+    if (isNormalizeMode) {
+        // 目前播放清單的本地曲目全部排進背景分析，下一首優先
+        if (currentPlaylistIndex >= 0 && currentPlaylistIndex < playlists.size()) {
+            QStringList filePaths;
+            for (const VideoInfo& video : std::as_const(playlists[currentPlaylistIndex].videos)) {
+                if (video.isLocalFile()) {
+                    filePaths.append(video.filePath());
+                }
+            }
+            loudnessAnalyzer->request(filePaths);
+            prefetchNextTrack();
+        }
+        normalizeButton->setStyleSheet(
+            "QPushButton {"
+            "   background-color: #1DB954;"
+            "   color: white;"
+            "   border: none;"
+            "   border-radius: 20px;"
+            "   padding: 10px 20px;"
+            "   font-size: 14px;"
+            "   min-width: 40px;"
+            "}"
+            "QPushButton:hover { background-color: #1ED760; }"
+        );
+    } else {
+        normalizeButton->setToolTip("響度標準化（EBU R128）");
+        normalizeButton->setStyleSheet(
+            "QPushButton {"
+            "   background-color: #282828;"
+            "   color: #FFFFFF;"
+            "   border: none;"
+            "   border-radius: 20px;"
+            "   padding: 10px 20px;"
+            "   font-size: 14px;"
+            "   min-width: 40px;"
+            "}"
+            "QPushButton:hover { background-color: #404040; }"
+        );
+    }
+    
+    // 使用者切換模式時立即套用到目前這首；已預載的下一首也更新
+    if (current && current->isLocalFile()) {
+        audioOutput->setVolume(volumeFor(current->filePath()));
+        crossfadePlayer->setVolume(volumeFor(current->filePath()));
+    }
+    if (armedVideoIndex >= 0) {
+        const QString& filePath = playlists[currentPlaylistIndex].videos[armedVideoIndex].filePath();
+        standbyOutput->setVolume(volumeFor(filePath));
+        if (crossfadePlayer->nextFile() == filePath) {
+            crossfadePlayer->queueNext(filePath, volumeFor(filePath));
+        }
+    }
+}
+
+void Widget::onCrossfadeClicked()
+{
+    isCrossfadeMode = !isCrossfadeMode;
+    crossfadeButton->setChecked(isCrossfadeMode);
+    
+    // 已預載的下一首屬於另一種換曲方式，重新預載；目前這首播完或切歌時才改用新的方式
+    disarmStandbyPlayer();
+    crossfadePlayer->setFadeMs(isCrossfadeMode ? crossfadeMs : 0);
+    
+    if (isCrossfadeMode) {
+        crossfadeButton->setStyleSheet(
+            "QPushButton {"
+            "   background-color: #1DB954;"
+            "   color: white;"
+            "   border: none;"
+            "   border-radius: 20px;"
+            "   padding: 10px 20px;"
+            "   font-size: 14px;"
+            "   min-width: 40px;"
+            "}"
+            "QPushButton:hover { background-color: #1ED760; }"
+        );
+    } else {
+        crossfadeButton->setStyleSheet(
+            "QPushButton {"
+            "   background-color: #282828;"
+            "   color: #FFFFFF;"
+            "   border: none;"
+            "   border-radius: 20px;"
+            "   padding: 10px 20px;"
+            "   font-size: 14px;"
+            "   min-width: 40px;"
+            "}"
+            "QPushButton:hover { background-color: #404040; }"
+        );
+    }
+}
+
+void Widget::onCrossfadeLengthRequested()
+{
+    bool ok = false;
+    double seconds = QInputDialog::getDouble(this, "交叉淡化", "淡化長度（秒）：",
+                                             crossfadeMs / 1000.0, 0.0, 12.0, 1, &ok);
+    if (!ok) return;
+    
+    // 已排入的下一首沿用，新的長度從下一次換曲開始
+    crossfadeMs = int(seconds * 1000);
+    if (isCrossfadeMode) {
+        crossfadePlayer->setFadeMs(crossfadeMs);
+    }
+    updateCrossfadeToolTip();
+}
+
+void Widget::onEqualizerClicked()
+{
+    isEqualizerMode = !isEqualizerMode;
+    equalizerButton->setChecked(isEqualizerMode);
+    
+    // 正在由自有管線播放時立即平滑套用；QMediaPlayer 播放中的曲目要到切歌時才改由管線播放
+    // 備用播放器預載的下一首不會經過等化器，重新預載
+    equalizerSettings.enabled = isEqualizerMode;
+    crossfadePlayer->setEqualizer(equalizerSettings);
+    if (!crossfadeActive()) {
+        disarmStandbyPlayer();
+    }
+    if (equalizerDialog) {
+        equalizerDialog->setSettings(equalizerSettings);
+    }
+    
+    if (isEqualizerMode) {
+        equalizerButton->setStyleSheet(
+            "QPushButton {"
+            "   background-color: #1DB954;"
+            "   color: white;"
+            "   border: none;"
+            "   border-radius: 20px;"
+            "   padding: 10px 20px;"
+            "   font-size: 14px;"
+            "   min-width: 40px;"
+            "}"
+            "QPushButton:hover { background-color: #1ED760; }"
+        );
+    } else {
+        equalizerButton->setStyleSheet(
+            "QPushButton {"
+            "   background-color: #282828;"
+            "   color: #FFFFFF;"
+            "   border: none;"
+            "   border-radius: 20px;"
+            "   padding: 10px 20px;"
+            "   font-size: 14px;"
+            "   min-width: 40px;"
+            "}"
+            "QPushButton:hover { background-color: #404040; }"
+        );
+    }
+}
+
+void Widget::onEqualizerSettingsRequested()
+{
+    // 非強制回應的視窗，只建立一次
+    if (!equalizerDialog) {
+        equalizerDialog = new EqualizerDialog(equalizerSettings, this);
+        connect(equalizerDialog, &EqualizerDialog::settingsChanged, this, &Widget::onEqualizerSettingsChanged);
+    }
+    equalizerDialog->show();
+    equalizerDialog->raise();
+    equalizerDialog->activateWindow();
+}
+
+void Widget::onEqualizerSettingsChanged(const EqualizerSettings& settings)
+{
+    equalizerSettings = settings;
+    equalizerSettings.enabled = isEqualizerMode;
+    crossfadePlayer->setEqualizer(equalizerSettings);
+}
+
+void Widget::updateSpectrum()
+{
+    // 視窗隱藏或最小化、暫停或停止時完全停止分析；停止播放時清空畫面，暫停時保留
+    if (isVisible() && !isMinimized() && localPlaybackPlaying()) {
+        spectrumView->start(crossfadeActive() ? nullptr : mediaPlayer);
+        return;
+    }
+    const bool stopped = !crossfadeActive() && mediaPlayer->playbackState() == QMediaPlayer::StoppedState;
+    spectrumView->stop(stopped);
+}
+
+void Widget::showEvent(QShowEvent* event)
+{
+    QWidget::showEvent(event);
+    updateSpectrum();
+}
+
+void Widget::hideEvent(QHideEvent* event)
+{
+    QWidget::hideEvent(event);
+    updateSpectrum();
+}
+
+void Widget::changeEvent(QEvent* event)
+{
+    QWidget::changeEvent(event);
+    if (event->type() == QEvent::WindowStateChange) {
+        updateSpectrum();
+    }
+}
+
+void Widget::updateCrossfadeToolTip()
+{
+    // 管線的輸出統計：欠載表示解碼端來不及補滿環形緩衝
+    QString tip = QString("交叉淡化 %1 秒（右鍵調整長度）").arg(crossfadeMs / 1000.0, 0, 'f', 1);
+    tip += QString("\n輸出延遲 %1 ms，欠載 %2 次，溢位 %3 次")
+               .arg(crossfadePlayer->latencyMs())
+               .arg(crossfadePlayer->underruns())
+               .arg(crossfadePlayer->overruns());
+    crossfadeButton->setToolTip(tip);
+}
+
+void Widget::onLoudnessReady(const QList<TrackLoudness>& results)
+{
+    // 結果已在分析器的快取中，換曲時才套用；這裡只更新目前這首的說明
+    if (!isNormalizeMode || currentPlaylistIndex < 0 || currentPlaylistIndex >= playlists.size()) return;
+    const Playlist& playlist = playlists[currentPlaylistIndex];
+    if (currentVideoIndex < 0 || currentVideoIndex >= playlist.videos.size()) return;
+    
+    const QString& currentPath = playlist.videos[currentVideoIndex].filePath();
+    for (const TrackLoudness& loudness : results) {
+        if (loudness.filePath != currentPath) continue;
+        
+        if (loudness.valid) {
+            normalizeButton->setToolTip(QString("響度標準化（EBU R128）\n目前曲目：%1 LUFS，增益 %2 dB")
+                                        .arg(loudness.integratedLufs, 0, 'f', 1)
+                                        .arg(LoudnessAnalyzer::gainDbFor(loudness, kBaseVolume), 0, 'f', 1));
+        } else {
+            normalizeButton->setToolTip("響度標準化（EBU R128）\n目前曲目無法分析");
+        }
+        break;
+    }
+}
+
+void Widget::onPreviousClicked()
+{
+    if (currentPlaylistIndex < 0 || currentPlaylistIndex >= playlists.size()) return;
+    
+    Playlist& playlist = playlists[currentPlaylistIndex];
+    if (playlist.videos.isEmpty()) return;
+    
+    if (isShuffleMode) {
+        // 回到真正播放過的上一首
+        int newIndex = shuffle.previous();
+        if (newIndex >= 0) {
+            playVideo(newIndex);
+        }
+    } else {
+        int newIndex = currentVideoIndex - 1;
+        if (newIndex < 0) {
+            newIndex = playlist.videos.size() - 1;
+        }
+        playVideo(newIndex);
+    }
+}
+
+void Widget::onNextClicked()
+{
+    if (currentPlaylistIndex < 0 || currentPlaylistIndex >= playlists.size()) return;
+    
+    Playlist& playlist = playlists[currentPlaylistIndex];
+    if (playlist.videos.isEmpty()) return;
+    
+    int newIndex = getNextVideoIndex();
+    if (newIndex >= 0) {
+        playVideo(newIndex);
+    }
+}
+
+void Widget::onShuffleClicked()
+{
+    isShuffleMode = !isShuffleMode;
+    shuffleButton->setChecked(isShuffleMode);
+    disarmStandbyPlayer();
+    
+    if (isShuffleMode) {
+        // 每次開啟使用新的種子；設定 LAST_REPORT_SHUFFLE_SEED 可重現同一個隨機序列
+        bool seedOk = false;
+        uint seed = qEnvironmentVariable("LAST_REPORT_SHUFFLE_SEED").toUInt(&seedOk);
+        shuffle.setSeed(seedOk ? seed : QRandomGenerator::global()->generate());
+        shuffleButton->setToolTip(QString("隨機播放（種子 %1）").arg(shuffle.seed()));
+        resetShuffle();
+        shuffleButton->setStyleSheet(
+            "QPushButton {"
+            "   background-color: #1DB954;"
+            "   color: white;"
+            "   border: none;"
+            "   border-radius: 20px;"
+            "   padding: 10px 20px;"
+            "   font-size: 14px;"
+            "   min-width: 40px;"
+            "}"
+            "QPushButton:hover { background-color: #1ED760; }"
+        );
+    } else {
+        shuffle.clear();
+        shuffleButton->setToolTip("隨機播放");
         shuffleButton->setStyleSheet(
             "QPushButton {"
             "   background-color: #282828;"
@@ -684,6 +2148,7 @@ void Widget::onRepeatClicked()
 {
     isRepeatMode = !isRepeatMode;
     repeatButton->setChecked(isRepeatMode);
+    disarmStandbyPlayer();
     
     if (isRepeatMode) {
         repeatButton->setStyleSheet(
@@ -714,70 +2179,72 @@ void Widget::onRepeatClicked()
     }
 }
 
-void Widget::onVideoDoubleClicked(QListWidgetItem* item)
+void Widget::onVideoDoubleClicked(const QModelIndex& index)
 {
-    int index = playlistWidget->row(item);
-    playVideo(index);
+    playVideo(index.row());
 }
 
 void Widget::onToggleFavoriteClicked()
 {
     if (currentVideoIndex < 0 || currentPlaylistIndex < 0) return;
     if (currentPlaylistIndex >= playlists.size()) return;
+    if (currentVideoIndex >= playlists[currentPlaylistIndex].videos.size()) return;
     
-    Playlist& currentPlaylist = playlists[currentPlaylistIndex];
-    if (currentVideoIndex >= currentPlaylist.videos.size()) return;
-    
-    VideoInfo& video = currentPlaylist.videos[currentVideoIndex];
-    
-    // 找到 "我的最愛" 播放清單
-    int favoritesIndex = -1;
-    for (int i = 0; i < playlists.size(); i++) {
-        if (playlists[i].name == "我的最愛") {
-            favoritesIndex = i;
-            break;
-        }
-    }
-    
+    int favoritesIndex = favoritesPlaylistIndex();
     if (favoritesIndex < 0) {
         // 創建 "我的最愛" 播放清單
         Playlist favoritesPlaylist;
         favoritesPlaylist.name = "我的最愛";
         playlists.append(favoritesPlaylist);
         playlistComboBox->addItem(favoritesPlaylist.name);
-        favoritesIndex = playlists.size() - 1;
+        favoritesIndex = favoritesPlaylistIndex();
     }
     
-    Playlist& favoritesPlaylist = playlists[favoritesIndex];
+    if (!ensurePlaylistLoaded(favoritesIndex)) return;
+    
+    // 最愛清單的列可能移動，已預載的索引不再可靠
+    disarmStandbyPlayer();
+    
+    // 先複製一份：從正在顯示的最愛清單移除時，原本的列會消失
+    const VideoInfo video = playlists[currentPlaylistIndex].videos[currentVideoIndex];
+    const QString key = trackKey(video);
     
-    // 檢查是否已在最愛中
-    bool isInFavorites = false;
-    int favoriteIndex = -1;
-    for (int i = 0; i < favoritesPlaylist.videos.size(); i++) {
-        if (favoritesPlaylist.videos[i].videoId == video.videoId) {
-            isInFavorites = true;
-            favoriteIndex = i;
+    if (favoriteKeys.contains(key)) {
+        // 從最愛移除；只有這裡需要找出曲目在最愛清單中的位置
+        favoriteKeys.remove(key);
+        const QList<VideoInfo>& favorites = playlists[favoritesIndex].videos;
+        for (int i = 0; i < favorites.size(); i++) {
+            if (trackKey(favorites[i]) != key) continue;
+            
+            playlistModel->removeVideo(favoritesIndex, i);
+            if (favoritesIndex == currentPlaylistIndex) {
+                shuffle.removeTracks({ i });
+                // 正在顯示最愛清單時，移除的可能就是當前項目
+                if (i == currentVideoIndex) {
+                    currentVideoIndex = -1;
+                } else if (i < currentVideoIndex) {
+                    currentVideoIndex--;
+                }
+            }
             break;
         }
-    }
-    
-    if (isInFavorites) {
-        // 從最愛移除
-        favoritesPlaylist.videos.removeAt(favoriteIndex);
-        video.isFavorite = false;
-        toggleFavoriteButton->setText("❤️ 加入最愛");
         QMessageBox::information(this, "我的最愛", "已從最愛中移除！");
     } else {
         // 加入最愛
         VideoInfo favoriteVideo = video;
-        favoriteVideo.isFavorite = true;
-        favoritesPlaylist.videos.append(favoriteVideo);
-        video.isFavorite = true;
-        toggleFavoriteButton->setText("💔 移除最愛");
+        favoriteVideo.setFavorite(true);
+        favoriteKeys.insert(key);
+        if (favoritesIndex == currentPlaylistIndex && shuffle.trackCount() == playlists[favoritesIndex].videos.size()) {
+            shuffle.insertTracks(shuffle.trackCount(), 1);
+        }
+        playlistModel->appendVideo(favoritesIndex, favoriteVideo);
         QMessageBox::information(this, "我的最愛", "已加入最愛！");
     }
     
-    updatePlaylistDisplay();
+    markPlaylistDirty(favoritesIndex);
+    playlistModel->refreshFavorites();
+    updateFavoriteButton();
+    updateButtonStates();
 }
 
 void Widget::onNewPlaylistClicked()
@@ -804,6 +2271,7 @@ void Widget::onNewPlaylistClicked()
         playlistComboBox->setCurrentIndex(newIndex);
         currentPlaylistIndex = newIndex;
         lastPlaylistName = name;
+        markPlaylistDirty(newIndex);
         updatePlaylistDisplay();
         updateButtonStates();
     }
@@ -824,10 +2292,25 @@ void Widget::onDeletePlaylistClicked()
                                     QMessageBox::Yes | QMessageBox::No);
     if (ret == QMessageBox::Yes) {
         videoDisplayLabel->clear();
+        updateNowPlayingCover(QString());
         currentVideoIndex = -1;
         isPlaying = false;
+        disarmStandbyPlayer();
+        // 先讓模型脫離即將刪除的播放清單
+        playlistModel->setPlaylistIndex(-1);
+        folderImporter->removeRootsFor(playlists[currentPlaylistIndex].name);
+        librarySearch.removePlaylist(playlists[currentPlaylistIndex].name);
+        searchStalePlaylists.remove(playlists[currentPlaylistIndex].name);
         playlists.removeAt(currentPlaylistIndex);
         playlistComboBox->removeItem(currentPlaylistIndex);
+
+        // 刪除後 ComboBox 的索引可能不變而不發出信號，這裡主動同步
+        currentPlaylistIndex = playlistComboBox->currentIndex();
+        resetShuffle();
+        markLibraryLayoutDirty();
+        rebuildFavoriteKeys();
+        updatePlaylistDisplay();
+        updateButtonStates();
     }
 }
 
@@ -837,43 +2320,30 @@ void Widget::onPlaylistChanged(int index)
     
     currentPlaylistIndex = index;
     currentVideoIndex = -1;
-    playedVideosInCurrentSession.clear();
+    disarmStandbyPlayer();
+    ensurePlaylistLoaded(index);
+    resetShuffle();
+    markLibraryLayoutDirty();
     updatePlaylistDisplay();
     updateButtonStates();
 }
 
 void Widget::updatePlaylistDisplay()
 {
-    playlistWidget->clear();
-    
-    if (currentPlaylistIndex < 0 || currentPlaylistIndex >= playlists.size()) return;
-    
-    const Playlist& playlist = playlists[currentPlaylistIndex];
-    for (int i = 0; i < playlist.videos.size(); i++) {
-        const VideoInfo& video = playlist.videos[i];
-        QString displayText = QString("%1. %2\n   %3")
-                                .arg(i + 1)
-                                .arg(video.title)
-                                .arg(video.channelTitle);
-        
-        QListWidgetItem* item = new QListWidgetItem(displayText);
-        item->setData(Qt::UserRole, i);
-        
-        // 高亮當前播放的影片
-        if (i == currentVideoIndex) {
-            item->setBackground(QColor("#1DB954"));
-            item->setForeground(QColor("#FFFFFF"));
-            QFont font = item->font();
-            font.setBold(true);
-            item->setFont(font);
-        }
-        
-        playlistWidget->addItem(item);
+    TRACE_SCOPE("Widget::updatePlaylistDisplay");
+    // 切換播放清單時重置模型；視圖只會向模型查詢可見的列
+    if (currentPlaylistIndex < 0 || currentPlaylistIndex >= playlists.size()) {
+        playlistModel->setPlaylistIndex(-1);
+        return;
     }
+    
+    playlistModel->setPlaylistIndex(currentPlaylistIndex);
+    playlistModel->setCurrentRow(currentVideoIndex);
 }
 
 void Widget::playVideo(int index)
 {
+    TRACE_SCOPE("Widget::playVideo");
     if (currentPlaylistIndex < 0 || currentPlaylistIndex >= playlists.size()) return;
     
     Playlist& playlist = playlists[currentPlaylistIndex];
@@ -882,17 +2352,45 @@ void Widget::playVideo(int index)
     currentVideoIndex = index;
     const VideoInfo& video = playlist.videos[index];
     
-    playedVideosInCurrentSession.insert(index);
+    if (isShuffleMode) {
+        shuffle.select(index);
+    }
+    
+    // 手動切換時丟棄已預載的下一首
+    disarmStandbyPlayer();
+    
+    // 從這裡計時，直到開始發聲（YouTube 影片不在播放器中播放）
+    if (video.isLocalFile()) {
+        trackStartTimer.start();
+    } else {
+        trackStartTimer.invalidate();
+    }
     
     // 停止當前播放
     mediaPlayer->stop();
     
-    if (video.isLocalFile) {
-        // 播放本地檔案
-        mediaPlayer->setSource(QUrl::fromLocalFile(video.filePath));
-        mediaPlayer->play();
-        
-        QFileInfo fileInfo(video.filePath);
+    if (video.isLocalFile() && pipelineSelected()) {
+        // 自有管線：正在播放的曲目由 CrossfadePlayer 淡出，新曲目同時淡入（交叉淡化關閉時直接切換）
+        crossfadePlayer->play(video.filePath(), volumeFor(video.filePath()));
+    } else {
+        crossfadePlayer->stop();
+        if (video.isLocalFile()) {
+            // 播放本地檔案；音量在開始前設定，播放中不再改變
+            audioOutput->setVolume(volumeFor(video.filePath()));
+            mediaPlayer->setSource(QUrl::fromLocalFile(video.filePath()));
+            mediaPlayer->play();
+        }
+    }
+    
+    updateNowPlaying(index);
+}
+
+void Widget::updateNowPlaying(int index)
+{
+    const VideoInfo& video = playlists[currentPlaylistIndex].videos[index];
+    
+    if (video.isLocalFile()) {
+        QFileInfo fileInfo(video.filePath());
         QString displayHTML = QString(
             "<div style='text-align: center;'>"
             "<h2 style='color: #1DB954;'>🎵 本地音樂</h2>"
@@ -900,40 +2398,52 @@ void Widget::playVideo(int index)
             "<p style='font-size: 14px; color: #888; margin: 10px 0;'>檔案: %2</p>"
             "<p style='color: #666; font-size: 12px; margin-top: 30px;'>正在播放本地音樂檔案</p>"
             "</div>"
-        ).arg(video.title.toHtmlEscaped()).arg(fileInfo.fileName().toHtmlEscaped());
+        ).arg(video.title().toHtmlEscaped()).arg(fileInfo.fileName().toHtmlEscaped());
         
         videoDisplayLabel->setText(displayHTML);
         isPlaying = true;
         playPauseButton->setText("⏸");
+        
+        // 無縫換曲後新的播放器已經知道長度；一般換曲時稍後由 durationChanged 更新
+        const qint64 duration = crossfadeActive() ? crossfadePlayer->duration() : mediaPlayer->duration();
+        seekBar->clearPeaks();
+        seekBar->setDuration(duration);
+        seekBar->setPosition(crossfadeActive() ? crossfadePlayer->position() : mediaPlayer->position());
+        durationLabel->setText(formatDuration(duration));
+        waveformCache->request(video.filePath());
     } else {
         // 顯示 YouTube 影片資訊（不自動播放）
         videoDisplayLabel->setText(createVideoDisplayHTML(video));
+        seekBar->clearPeaks();
+        seekBar->setDuration(0);
+        positionLabel->setText(formatDuration(0));
+        durationLabel->setText(formatDuration(0));
         isPlaying = false;
         playPauseButton->setText("▶");
     }
     
     // 更新顯示
-    videoTitleLabel->setText(video.title);
-    channelLabel->setText(video.channelTitle);
+    videoTitleLabel->setText(video.title());
+    channelLabel->setText(video.channelTitle());
+    updateNowPlayingCover(video.isLocalFile() ? video.thumbnailUrl() : QString());
     
     // 更新最愛按鈕
-    if (video.isFavorite) {
-        toggleFavoriteButton->setText("💔 移除最愛");
-    } else {
-        toggleFavoriteButton->setText("❤️ 加入最愛");
-    }
+    updateFavoriteButton();
     
-    updatePlaylistDisplay();
-    updateButtonStates();
+    // 只重繪新舊兩列，不重建整個列表
+    playlistModel->setCurrentRow(index);
+    QModelIndex modelIndex = playlistModel->index(index);
+    playlistView->setCurrentIndex(modelIndex);
+    playlistView->scrollTo(modelIndex);
     
-    playlistWidget->setCurrentRow(index);
+    updateButtonStates();
 }
 
 void Widget::updateButtonStates()
 {
     bool hasPlaylist = (currentPlaylistIndex >= 0 && currentPlaylistIndex < playlists.size());
     bool hasVideos = hasPlaylist && !playlists[currentPlaylistIndex].videos.isEmpty();
-    int selectedRow = playlistWidget->currentRow();
+    int selectedRow = playlistView->currentIndex().row();
     bool hasSelection = selectedRow >= 0;
     bool hasMediaPlaying = currentVideoIndex >= 0;
     
@@ -946,99 +2456,302 @@ void Widget::updateButtonStates()
 
 void Widget::savePlaylistsToFile()
 {
-    QString configDir = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation);
-    QDir dir;
-    if (!dir.exists(configDir)) {
-        dir.mkpath(configDir);
+    TRACE_SCOPE("Widget::savePlaylistsToFile");
+    // 同步寫入尚未保存的變更（關閉時使用）；已排入佇列的寫入會先完成
+    autoSaveTimer->stop();
+    
+    QList<Playlist> changedPlaylists;
+    QStringList playlistOrder;
+    QString lastName;
+    if (!takeDirtyPlaylists(changedPlaylists, playlistOrder, lastName)) {
+        return;
     }
     
-    QString configFile = configDir + "/youtube_playlists.json";
-    
-    QJsonObject rootObj;
-    QJsonArray playlistsArray;
+    QMetaObject::invokeMethod(playlistStore, [this, changedPlaylists, playlistOrder, lastName]() {
+        playlistStore->save(changedPlaylists, playlistOrder, lastName);
+    }, Qt::BlockingQueuedConnection);
+}
+
+void Widget::saveDirtyPlaylists()
+{
+    TRACE_SCOPE("Widget::saveDirtyPlaylists");
+    // 防抖計時器到期：把變更過的播放清單交給儲存執行緒
+    QList<Playlist> changedPlaylists;
+    QStringList playlistOrder;
+    QString lastName;
+    if (!takeDirtyPlaylists(changedPlaylists, playlistOrder, lastName)) {
+        return;
+    }
     
-    for (const Playlist& playlist : playlists) {
-        QJsonObject playlistObj;
-        playlistObj["name"] = playlist.name;
-        
-        QJsonArray videosArray;
-        for (const VideoInfo& video : playlist.videos) {
-            QJsonObject videoObj;
-            videoObj["videoId"] = video.videoId;
-            videoObj["filePath"] = video.filePath;
-            videoObj["title"] = video.title;
-            videoObj["channelTitle"] = video.channelTitle;
-            videoObj["thumbnailUrl"] = video.thumbnailUrl;
-            videoObj["description"] = video.description;
-            videoObj["isFavorite"] = video.isFavorite;
-            videoObj["isLocalFile"] = video.isLocalFile;
-            videosArray.append(videoObj);
+    QMetaObject::invokeMethod(playlistStore, [this, changedPlaylists, playlistOrder, lastName]() {
+        playlistStore->save(changedPlaylists, playlistOrder, lastName);
+    }, Qt::QueuedConnection);
+}
+
+bool Widget::takeDirtyPlaylists(QList<Playlist>& changedPlaylists, QStringList& playlistOrder, QString& lastName)
+{
+    // 複製播放清單只增加引用計數，不會複製影片資料
+    for (Playlist& playlist : playlists) {
+        if (playlist.dirty) {
+            playlist.dirty = false;
+            changedPlaylists.append(playlist);
         }
-        playlistObj["videos"] = videosArray;
-        playlistsArray.append(playlistObj);
     }
     
-    rootObj["playlists"] = playlistsArray;
-    if (currentPlaylistIndex >= 0 && currentPlaylistIndex < playlists.size()) {
-        rootObj["lastPlaylist"] = playlists[currentPlaylistIndex].name;
+    if (changedPlaylists.isEmpty() && !libraryLayoutDirty) {
+        return false;
     }
+    libraryLayoutDirty = false;
     
-    QJsonDocument doc(rootObj);
-    QFile file(configFile);
-    if (file.open(QIODevice::WriteOnly)) {
-        file.write(doc.toJson());
-        file.close();
+    for (const Playlist& playlist : playlists) {
+        playlistOrder.append(playlist.name);
+    }
+    if (currentPlaylistIndex >= 0 && currentPlaylistIndex < playlists.size()) {
+        lastName = playlists[currentPlaylistIndex].name;
     }
+    return true;
 }
 
-void Widget::loadPlaylistsFromFile()
+void Widget::markPlaylistDirty(int index)
 {
-    QString configDir = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation);
-    QString configFile = configDir + "/youtube_playlists.json";
+    // 未載入的播放清單沒有完整的曲目，寫入會覆蓋儲存中的資料
+    if (index < 0 || index >= playlists.size() || !playlists[index].loaded) return;
     
-    QFile file(configFile);
-    if (!file.exists() || !file.open(QIODevice::ReadOnly)) {
-        return;
+    playlists[index].dirty = true;
+    autoSaveTimer->start();
+    markSearchStale(index);
+}
+
+void Widget::markLibraryLayoutDirty()
+{
+    libraryLayoutDirty = true;
+    autoSaveTimer->start();
+}
+
+void Widget::loadPlaylistsFromFile()
+{
+    TRACE_SCOPE("Widget::loadPlaylistsFromFile");
+    // 在儲存執行緒上同步載入（SQLite 連線只能在建立它的執行緒上使用）
+    // 預設只讀取播放清單名稱並解碼上次使用的播放清單；LAST_REPORT_LAZY_LOAD=0 時全部載入
+    bool lazy = qEnvironmentVariable("LAST_REPORT_LAZY_LOAD") != "0";
+    bool needsFullSave = false;
+    QMetaObject::invokeMethod(playlistStore, [this, lazy, &needsFullSave]() {
+        playlistStore->load(playlists, lastPlaylistName, needsFullSave, lazy);
+    }, Qt::BlockingQueuedConnection);
+    
+    // 從舊格式遷移：全部寫入新的儲存
+    if (needsFullSave) {
+        for (int i = 0; i < playlists.size(); i++) {
+            markPlaylistDirty(i);
+        }
+    }
+}
+
+bool Widget::ensurePlaylistLoaded(int index)
+{
+    if (index < 0 || index >= playlists.size()) return false;
+    
+    if (!playlists[index].loaded) {
+        TRACE_SCOPE("Widget::ensurePlaylistLoaded");
+        // 同步解碼：儲存執行緒若正在寫入，GUI 執行緒會等它寫完；
+        // 呼叫端需要立即使用曲目，只有背景預載（loadPlaylistInBackground）可以不等
+        Playlist& playlist = playlists[index];
+        bool ok = false;
+        QMetaObject::invokeMethod(playlistStore, [this, &playlist, &ok]() {
+            ok = playlistStore->loadPlaylist(playlist);
+        }, Qt::BlockingQueuedConnection);
+        if (!ok) {
+            // 維持未載入：之後的編輯與儲存都會略過，不會用空的列表覆寫原本的資料
+            playlist.videos.clear();
+            playlist.loaded = false;
+            QMessageBox::warning(this, "播放清單",
+                                 QString("無法載入播放清單「%1」，暫時無法編輯。").arg(playlist.name));
+            return false;
+        }
+        playlist.loaded = true;
+        requestMetadata(index);
+        markSearchStale(index);
+        if (index == favoritesPlaylistIndex()) {
+            rebuildFavoriteKeys();
+        }
     }
     
-    QByteArray data = file.readAll();
-    file.close();
-    
-    QJsonDocument doc = QJsonDocument::fromJson(data);
-    if (!doc.isObject()) {
-        return;
+    playlists[index].lastUsed = ++playlistUseCounter;
+    evictPlaylists(index);
+    return true;
+}
+
+void Widget::loadPlaylistInBackground(int index)
+{
+    if (index < 0 || index >= playlists.size() || playlists[index].loaded) return;
+    
+    // 在儲存執行緒上解碼，完成後回到 GUI 執行緒；若期間已同步載入則丟棄結果
+    QString name = playlists[index].name;
+    QMetaObject::invokeMethod(playlistStore, [this, name]() {
+        Playlist decoded;
+        decoded.name = name;
+        if (!playlistStore->loadPlaylist(decoded)) return;
+        
+        QMetaObject::invokeMethod(this, [this, decoded]() {
+            for (int i = 0; i < playlists.size(); i++) {
+                if (playlists[i].name == decoded.name && !playlists[i].loaded) {
+                    playlists[i].videos = decoded.videos;
+                    playlists[i].loaded = true;
+                    playlists[i].lastUsed = ++playlistUseCounter;
+                    requestMetadata(i);
+                    markSearchStale(i);
+                    if (i == favoritesPlaylistIndex()) {
+                        rebuildFavoriteKeys();
+                    }
+                    evictPlaylists(i);
+                    break;
+                }
+            }
+        }, Qt::QueuedConnection);
+    }, Qt::QueuedConnection);
+}
+
+void Widget::evictPlaylists(int keep)
+{
+    // 已載入的曲目總數超過上限時，釋放最久未使用的播放清單
+    // 當前播放清單、尚未保存的播放清單與剛載入給呼叫端使用的 keep 不會被釋放
+    qsizetype loadedTracks = 0;
+    for (const Playlist& playlist : playlists) {
+        if (playlist.loaded) loadedTracks += playlist.videos.size();
     }
     
-    QJsonObject rootObj = doc.object();
-    lastPlaylistName = rootObj["lastPlaylist"].toString();
+    while (loadedTracks > maxLoadedTracks) {
+        int victim = -1;
+        for (int i = 0; i < playlists.size(); i++) {
+            const Playlist& playlist = playlists[i];
+            if (!playlist.loaded || playlist.dirty || i == currentPlaylistIndex || i == keep) continue;
+            if (victim < 0 || playlist.lastUsed < playlists[victim].lastUsed) {
+                victim = i;
+            }
+        }
+        if (victim < 0) break;
+        
+        Playlist& playlist = playlists[victim];
+        loadedTracks -= playlist.videos.size();
+        playlist.videos = QList<VideoInfo>();
+        playlist.loaded = false;
+        
+        QString name = playlist.name;
+        QMetaObject::invokeMethod(playlistStore, [this, name]() {
+            playlistStore->releasePlaylist(name);
+        }, Qt::QueuedConnection);
+    }
+}
+
+void Widget::requestMetadata(int index)
+{
+    if (index < 0 || index >= playlists.size() || !playlists[index].loaded) return;
     
-    QJsonArray playlistsArray = rootObj["playlists"].toArray();
-    playlists.clear();
+    QStringList filePaths;
+    for (const VideoInfo& video : std::as_const(playlists[index].videos)) {
+        if (video.isLocalFile()) {
+            filePaths.append(video.filePath());
+        }
+    }
+    if (!filePaths.isEmpty()) {
+        metadataExtractor->request(filePaths);
+    }
+}
+
+void Widget::onMetadataReady(const QList<TrackMetadata>& results)
+{
+    QHash<QString, const TrackMetadata*> byPath;
+    byPath.reserve(results.size());
+    for (const TrackMetadata& metadata : results) {
+        byPath.insert(metadata.filePath, &metadata);
+    }
     
-    for (const QJsonValue& value : playlistsArray) {
-        QJsonObject playlistObj = value.toObject();
-        Playlist playlist;
-        playlist.name = playlistObj["name"].toString();
+    // 一批結果只掃描一次已載入的播放清單；沒有變化的列不會複製或重繪
+    for (int i = 0; i < playlists.size(); i++) {
+        if (!playlists[i].loaded) continue;
         
-        QJsonArray videosArray = playlistObj["videos"].toArray();
-        for (const QJsonValue& videoValue : videosArray) {
-            QJsonObject videoObj = videoValue.toObject();
-            VideoInfo video;
-            video.videoId = videoObj["videoId"].toString();
-            video.filePath = videoObj["filePath"].toString();
-            video.title = videoObj["title"].toString();
-            video.channelTitle = videoObj["channelTitle"].toString();
-            video.thumbnailUrl = videoObj["thumbnailUrl"].toString();
-            video.description = videoObj["description"].toString();
-            video.isFavorite = videoObj["isFavorite"].toBool();
-            video.isLocalFile = videoObj["isLocalFile"].toBool();
+        bool changed = false;
+        const QList<VideoInfo>& videos = playlists[i].videos;
+        for (int row = 0; row < videos.size(); row++) {
+            if (!videos[row].isLocalFile()) continue;
+            auto it = byPath.constFind(videos[row].filePath());
+            if (it == byPath.constEnd()) continue;
+            
+            const TrackMetadata& metadata = **it;
+            VideoInfo updated = videos[row];
+            if (!metadata.title.isEmpty()) {
+                updated.setTitle(metadata.title);
+            }
+            if (!metadata.artist.isEmpty()) {
+                updated.setChannelTitle(metadata.artist);
+            }
+            if (!metadata.coverPath.isEmpty()) {
+                updated.setThumbnailUrl(QUrl::fromLocalFile(metadata.coverPath).toString());
+            }
+            QStringList details;
+            if (!metadata.album.isEmpty()) {
+                details << "專輯：" + metadata.album;
+            }
+            if (metadata.durationMs > 0) {
+                details << "時長：" + formatDuration(metadata.durationMs);
+            }
+            if (!details.isEmpty()) {
+                updated.setDescription(details.join(" · "));
+            }
             
-            playlist.videos.append(video);
+            if (updated.title() == videos[row].title() && updated.channelTitle() == videos[row].channelTitle() &&
+                updated.thumbnailUrl() == videos[row].thumbnailUrl() && updated.description() == videos[row].description()) {
+                continue;
+            }
+            
+            playlists[i].videos[row] = updated;
+            changed = true;
+            if (i == currentPlaylistIndex) {
+                playlistModel->refreshRow(row);
+                if (row == currentVideoIndex) {
+                    videoTitleLabel->setText(updated.title());
+                    channelLabel->setText(updated.channelTitle());
+                    updateNowPlayingCover(updated.thumbnailUrl());
+                }
+            }
         }
-        playlists.append(playlist);
+        if (changed) {
+            markPlaylistDirty(i);
+        }
+    }
+    
+    // 不屬於播放清單的本地檔案
+    if (currentVideoIndex < 0) {
+        auto it = byPath.constFind(mediaPlayer->source().toLocalFile());
+        if (it != byPath.constEnd() && !(*it)->title.isEmpty()) {
+            videoTitleLabel->setText((*it)->title);
+            if (!(*it)->artist.isEmpty()) {
+                channelLabel->setText((*it)->artist);
+            }
+        }
+        if (it != byPath.constEnd() && !(*it)->coverPath.isEmpty()) {
+            updateNowPlayingCover(QUrl::fromLocalFile((*it)->coverPath).toString());
+        }
+    }
+}
+
+void Widget::onCoversReady(const QStringList& coverUrls)
+{
+    // 列表只重繪看得到的列，重繪時從記憶體快取取得封面
+    playlistView->viewport()->update();
+    if (!nowPlayingCoverUrl.isEmpty() && coverUrls.contains(nowPlayingCoverUrl)) {
+        updateNowPlayingCover(nowPlayingCoverUrl);
     }
 }
 
+void Widget::updateNowPlayingCover(const QString& coverUrl)
+{
+    // 還沒載入時先顯示空白方塊，載入完成後由 onCoversReady 補上，版面不會跳動
+    nowPlayingCoverUrl = coverUrl;
+    coverLabel->setPixmap(coverArtCache->cover(coverUrl, CoverArtCache::PanelSize));
+    coverLabel->setVisible(!coverUrl.isEmpty());
+}
+
 int Widget::getNextVideoIndex()
 {
     if (currentPlaylistIndex < 0 || currentPlaylistIndex >= playlists.size()) return -1;
@@ -1047,7 +2760,11 @@ int Widget::getNextVideoIndex()
     if (playlist.videos.isEmpty()) return -1;
     
     if (isShuffleMode) {
-        return getRandomVideoIndex(true);
+        // 只查看下一首，實際播放時才由 playVideo() 記錄
+        if (shuffle.trackCount() != playlist.videos.size()) {
+            resetShuffle();
+        }
+        return shuffle.upcoming(isRepeatMode);
     } else {
         int newIndex = currentVideoIndex + 1;
         if (newIndex >= playlist.videos.size()) {
@@ -1061,61 +2778,20 @@ int Widget::getNextVideoIndex()
     }
 }
 
-int Widget::getRandomVideoIndex(bool excludeCurrent)
-{
-    if (currentPlaylistIndex < 0 || currentPlaylistIndex >= playlists.size()) return -1;
-    
-    Playlist& playlist = playlists[currentPlaylistIndex];
-    if (playlist.videos.isEmpty()) return -1;
-    
-    if (playlist.videos.size() == 1) {
-        if (excludeCurrent && currentVideoIndex == 0) {
-            return -1;
-        }
-        return 0;
-    }
-    
-    QList<int> unplayedVideos = getUnplayedVideoIndices(excludeCurrent);
-    
-    if (unplayedVideos.isEmpty() && isRepeatMode) {
-        playedVideosInCurrentSession.clear();
-        unplayedVideos = getUnplayedVideoIndices(excludeCurrent);
-    }
-    
-    if (unplayedVideos.isEmpty()) {
-        return -1;
-    }
-    
-    int randomIndex = QRandomGenerator::global()->bounded(unplayedVideos.size());
-    return unplayedVideos[randomIndex];
-}
-
-QList<int> Widget::getUnplayedVideoIndices(bool excludeCurrent)
+void Widget::resetShuffle()
 {
-    QList<int> unplayedVideos;
-    
-    if (currentPlaylistIndex < 0 || currentPlaylistIndex >= playlists.size()) {
-        return unplayedVideos;
-    }
-    
-    Playlist& playlist = playlists[currentPlaylistIndex];
-    
-    for (int i = 0; i < playlist.videos.size(); i++) {
-        if (!playedVideosInCurrentSession.contains(i)) {
-            if (!excludeCurrent || i != currentVideoIndex) {
-                unplayedVideos.append(i);
-            }
-        }
+    if (!isShuffleMode || currentPlaylistIndex < 0 || currentPlaylistIndex >= playlists.size()) {
+        shuffle.clear();
+        return;
     }
-    
-    return unplayedVideos;
+    shuffle.reset(playlists[currentPlaylistIndex].videos.size(), currentVideoIndex);
 }
 
 QString Widget::createVideoDisplayHTML(const VideoInfo& video)
 {
-    QString watchUrl = QString("https://www.youtube.com/watch?v=%1").arg(video.videoId);
-    QString escapedTitle = video.title.toHtmlEscaped();
-    QString escapedChannel = video.channelTitle.toHtmlEscaped();
+    QString watchUrl = QString("https://www.youtube.com/watch?v=%1").arg(video.videoId());
+    QString escapedTitle = video.title().toHtmlEscaped();
+    QString escapedChannel = video.channelTitle().toHtmlEscaped();
     
     return QString(
         "<div style='text-align: center;'>"
@@ -5,8 +5,7 @@
 #include <QPushButton>
 #include <QLabel>
 #include <QSlider>
-#include <QListWidget>
-#include <QListWidgetItem>
+#include <QListView>
 #include <QComboBox>
 #include <QLineEdit>
 #include <QInputDialog>
@@ -22,29 +21,36 @@
 #include <QJsonDocument>
 #include <QJsonObject>
 #include <QJsonArray>
+#include <QThread>
+#include <QTimer>
+#include <QElapsedTimer>
+#include <QCompleter>
+#include <QStringListModel>
+#include "playlist.h"
+#include "metadataextractor.h"
+#include "shuffleengine.h"
+#include "librarysearch.h"
+#include "waveformcache.h"
+#include "latencyhistogram.h"
+#include "fileprefetcher.h"
+#include "contenthasher.h"
+#include "playlistfileio.h"
+#include "loudnessanalyzer.h"
+#include "crossfadeplayer.h"
+#include "equalizerdialog.h"
 QT_BEGIN_NAMESPACE
 namespace Ui {
 class Widget;
 }
 QT_END_NAMESPACE
 
-// 影片/音樂資訊結構
-struct VideoInfo {
-    QString videoId;          // YouTube 影片 ID (用於 YouTube 連結)
-    QString filePath;         // 本地檔案路徑 (用於本地音樂)
-    QString title;            // 影片/音樂標題
-    QString channelTitle;     // 頻道名稱/藝術家
-    QString thumbnailUrl;     // 縮圖 URL
-    QString description;      // 描述
-    bool isFavorite;          // 是否為喜愛的影片/音樂
-    bool isLocalFile;         // 是否為本地檔案
-};
-
-// 播放清單結構
-struct Playlist {
-    QString name;              // 播放清單名稱
-    QList<VideoInfo> videos;   // 影片列表
-};
+class PlaylistModel;
+class PlaylistStore;
+class FolderImporter;
+class WaveformSeekBar;
+class SpectrumView;
+class CoverArtCache;
+class QProgressDialog;
 
 class Widget : public QWidget
 {
@@ -54,6 +60,11 @@ public:
     Widget(QWidget *parent = nullptr);
     ~Widget();
 
+protected:
+    void showEvent(QShowEvent* event) override;
+    void hideEvent(QHideEvent* event) override;
+    void changeEvent(QEvent* event) override;
+
 private slots:
     // 播放控制
     void onPlayPauseClicked();
@@ -61,39 +72,128 @@ private slots:
     void onNextClicked();
     void onShuffleClicked();
     void onRepeatClicked();
+    void onGaplessClicked();
+    void onNormalizeClicked();
+    void onCrossfadeClicked();
+    void onCrossfadeLengthRequested();
+    void onEqualizerClicked();
+    void onEqualizerSettingsRequested();
+    void onEqualizerSettingsChanged(const EqualizerSettings& settings);
     
     // 搜尋功能
     void onSearchClicked();
+    void onSearchTextEdited(const QString& text);
+    void onSearchResultActivated(const QModelIndex& index);
     void onLoadLocalFileClicked();
+    void onImportFolderClicked();
+    void onFindDuplicatesClicked();
     
     // 播放清單管理
-    void onVideoDoubleClicked(QListWidgetItem* item);
+    void onVideoDoubleClicked(const QModelIndex& index);
+    void onVideosMoved(int playlistIndex, const QList<int>& sortedRows, int destination);
+    void onUrlsDropped(int playlistIndex, int row, const QList<QUrl>& urls);
     void onToggleFavoriteClicked();
     
     // 播放清單選擇
     void onNewPlaylistClicked();
     void onDeletePlaylistClicked();
     void onPlaylistChanged(int index);
+    void onImportPlaylistFileClicked();
+    void onExportPlaylistFileClicked();
+    
+    // M3U/PLS 匯入與匯出
+    void onPlaylistTracksImported(const QString& playlistName, const QList<VideoInfo>& videos);
+    void onPlaylistTransferProgress(qint64 done, qint64 total);
+    void onPlaylistTransferFinished(bool ok, bool cancelled, const QString& message);
     
     // 媒體播放器
     void onMediaPlayerStateChanged();
+    void onMediaPlayerStatusChanged(QMediaPlayer::MediaStatus status);
     void onMediaPlayerPositionChanged(qint64 position);
     void onMediaPlayerDurationChanged(qint64 duration);
+    
+    // 交叉淡化播放器
+    void onCrossfadeStateChanged(CrossfadePlayer::State state);
+    void onCrossfadePositionChanged(qint64 position);
+    void onCrossfadeDurationChanged(qint64 duration);
+    void onCrossfadeAdvanced();
+    void onCrossfadeEndOfMedia();
+    void onCrossfadeError(const QString& filePath);
+    
+    // 自動保存
+    void saveDirtyPlaylists();
+    
+    // 本地檔案標籤
+    void onMetadataReady(const QList<TrackMetadata>& results);
+    void onCoversReady(const QStringList& coverUrls);
+    
+    // 資料夾匯入與監看
+    void onFolderFilesAdded(const QString& playlistName, const QStringList& filePaths);
+    void onFolderFilesRemoved(const QString& playlistName, const QStringList& filePaths);
+    
+    // 內容雜湊：匯入時去除重複、尋找所有播放清單中的重複曲目
+    void onContentHashesReady(int batchId, const QHash<QString, quint64>& hashes);
+    
+    // 波形進度條
+    void onSeekRequested(qint64 position);
+    void onWaveformReady(const QString& filePath, const WaveformPeaks& peaks);
+    
+    // 響度標準化
+    void onLoudnessReady(const QList<TrackLoudness>& results);
 
 private:
     void setupUI();
     void createConnections();
     void updatePlaylistDisplay();
     void playVideo(int index);
+    void updateNowPlaying(int index);
+    void updateNowPlayingCover(const QString& coverUrl);
+    void updatePlaybackPosition(qint64 position, qint64 duration);
+    void updatePlaybackDuration(qint64 position, qint64 duration);
+    void playNextAfterEnd();
+    bool crossfadeActive() const { return crossfadePlayer->state() != CrossfadePlayer::StoppedState; }
+    bool pipelineSelected() const { return isCrossfadeMode || isEqualizerMode || isPipelineEngine; }
+    bool localPlaybackPlaying() const;
+    void pauseLocalPlayback();
+    void resumeLocalPlayback();
+    void updateCrossfadeToolTip();
+    void updateSpectrum();
+    void armStandbyPlayer(qint64 position, qint64 duration);
+    void disarmStandbyPlayer();
+    void swapToStandbyPlayer();
+    void recordTrackStart();
+    void prefetchNextTrack();
+    float volumeFor(const QString& filePath);
     void updateButtonStates();
     void savePlaylistsToFile();
     void loadPlaylistsFromFile();
+    bool takeDirtyPlaylists(QList<Playlist>& changedPlaylists, QStringList& playlistOrder, QString& lastName);
+    void markPlaylistDirty(int index);
+    void markLibraryLayoutDirty();
+    bool ensurePlaylistLoaded(int index);
+    void loadPlaylistInBackground(int index);
+    void evictPlaylists(int keep);
+    void requestMetadata(int index);
+    void appendVideos(int index, const QList<VideoInfo>& newVideos);
+    void insertVideos(int index, int row, const QList<VideoInfo>& newVideos);
+    void removeVideos(int index, const QList<int>& rows);
+    void startPlaylistTransfer(const QString& label);
+    void startDuplicateScan(const QHash<QString, QStringList>& owners);
+    void reportDuplicates(const QHash<QString, quint64>& hashes);
+    int findPlaylist(const QString& name) const;
+    int favoritesPlaylistIndex();
+    bool isFavorite(const VideoInfo& video) const;
+    void rebuildFavoriteKeys();
+    void updateFavoriteButton();
     int getNextVideoIndex();
-    int getRandomVideoIndex(bool excludeCurrent = true);
-    QList<int> getUnplayedVideoIndices(bool excludeCurrent = true);
+    void resetShuffle();
+    void markSearchStale(int index);
+    void flushSearchIndex();
+    void indexAllPlaylists();
+    void playSearchResult(int row);
+    static bool looksLikeYouTubeLink(const QString& text);
     void playYouTubeLink(const QString& link);
     void playLocalFile(const QString& filePath);
-    QString extractYouTubeVideoId(const QString& url);
     QString createVideoDisplayHTML(const VideoInfo& video);
 
     Ui::Widget *ui;
@@ -102,13 +202,21 @@ private:
     QMediaPlayer* mediaPlayer;
     QAudioOutput* audioOutput;
     
+    // 無縫播放：下一首預先載入備用播放器，播完時兩組互換
+    QMediaPlayer* standbyPlayer;
+    QAudioOutput* standbyOutput;
+    
     // 影片資訊顯示區域
     QLabel* videoDisplayLabel;
+    SpectrumView* spectrumView;
     
     // UI 元件
     QLineEdit* searchEdit;
     QPushButton* searchButton;
     QPushButton* loadLocalFileButton;
+    QPushButton* importFolderButton;
+    QPushButton* findDuplicatesButton;
+    QLabel* coverLabel;
     QLabel* videoTitleLabel;
     QLabel* channelLabel;
     QPushButton* playPauseButton;
@@ -116,10 +224,20 @@ private:
     QPushButton* nextButton;
     QPushButton* shuffleButton;
     QPushButton* repeatButton;
+    QPushButton* gaplessButton;
+    QPushButton* normalizeButton;
+    QPushButton* crossfadeButton;
+    QPushButton* equalizerButton;
     QPushButton* toggleFavoriteButton;
     QPushButton* newPlaylistButton;
     QPushButton* deletePlaylistButton;
-    QListWidget* playlistWidget;
+    QPushButton* importPlaylistFileButton;
+    QPushButton* exportPlaylistFileButton;
+    QListView* playlistView;
+    WaveformSeekBar* seekBar;
+    QLabel* positionLabel;
+    QLabel* durationLabel;
+    PlaylistModel* playlistModel;
     QComboBox* playlistComboBox;
     
     // 播放清單數據
@@ -129,8 +247,86 @@ private:
     bool isShuffleMode;
     bool isRepeatMode;
     bool isPlaying;
+    bool isGaplessMode;
+    bool isNormalizeMode;
+    bool isCrossfadeMode;
+    bool standbyArmAttempted;  // 這首歌是否已嘗試預載下一首
+    int armedVideoIndex;       // 已載入備用播放器的下一首，-1 表示沒有
+    QElapsedTimer gapTimer;    // 上一首結束到下一首開始發聲的時間
+    qint64 lastGapMs;
+    QElapsedTimer trackStartTimer;       // playVideo() 到 BufferedMedia 或第一個位置更新
+    LatencyHistogram trackStartLatency;  // 每首歌的開始播放延遲
+    FilePrefetcher prefetcher;           // 播放時預讀下一首的檔案
+    static constexpr qint64 kGaplessPreloadMs = 5000;
     QString lastPlaylistName;
-    QSet<int> playedVideosInCurrentSession;
+    ShuffleEngine shuffle;     // 隨機播放的排列與播放歷史
+    
+    // 最愛：以 trackKey 為鍵的集合，成員檢查與切換都是 O(1)
+    QSet<QString> favoriteKeys;
+    int cachedFavoritesIndex;  // 「我的最愛」在 playlists 中的位置
+    
+    // 背景儲存
+    QThread* storageThread;
+    PlaylistStore* playlistStore;
+    QTimer* autoSaveTimer;
+    bool libraryLayoutDirty;   // 播放清單順序或上次播放清單有變更
+    quint64 playlistUseCounter;
+    qsizetype maxLoadedTracks; // 記憶體中保留的曲目上限
+    
+    // 背景擷取本地檔案的標籤與封面
+    MetadataExtractor* metadataExtractor;
+    
+    // 封面縮圖：記憶體 LRU + 磁碟快取，背景載入
+    CoverArtCache* coverArtCache;
+    QString nowPlayingCoverUrl;
+    
+    // 波形峰值：背景解碼並快取在磁碟上
+    WaveformCache* waveformCache;
+    
+    // 響度標準化：背景量測整合響度，換曲時依快取的結果設定音量，播放中不改變
+    LoudnessAnalyzer* loudnessAnalyzer;
+    static constexpr float kBaseVolume = 0.5f;
+    
+    // 自有的解碼到輸出管線：交叉淡化開啟，或以 LAST_REPORT_AUDIO_ENGINE=pipeline 選用時，本地檔案改由 CrossfadePlayer 播放
+    CrossfadePlayer* crossfadePlayer;
+    bool isPipelineEngine;
+    int crossfadeMs;           // 交叉淡化關閉時管線以 0 淡化（無縫）播放
+    
+    // 等化器：只作用在自有管線上，開啟時本地檔案改由 CrossfadePlayer 播放
+    bool isEqualizerMode;
+    EqualizerSettings equalizerSettings;
+    EqualizerDialog* equalizerDialog;
+    
+    // 匯入的資料夾：背景掃描並監看變更
+    FolderImporter* folderImporter;
+    
+    // M3U/PLS 播放清單檔：在工作執行緒上串流讀寫，進度對話框可取消
+    PlaylistFileIO* playlistFileIO;
+    QProgressDialog* transferProgress;
+    
+    // 本地檔案的內容雜湊：同一首歌經由不同路徑加入時視為重複
+    ContentHasher* contentHasher;
+    struct ImportCheck {
+        QString playlistName;
+        QSet<QString> newPaths;      // 這次匯入加入的檔案，與既有曲目重複時移除
+        QStringList hashPaths;       // 這一批送出計算的檔案
+    };
+    QHash<QString, quint64> contentHashes;         // 本次執行已算出的雜湊：檔案路徑 -> 雜湊
+    QSet<QString> pendingContentHashes;            // 匯入批次中還沒有結果的檔案，不再重複送出
+    QHash<int, ImportCheck> importChecks;          // 批次編號 -> 匯入的檔案
+    QHash<QString, QSet<QString>> importNewPaths;  // 播放清單 -> 等同一清單其他批次完成後再檢查的新檔案
+    int duplicateScanBatch;                        // 尋找重複曲目的批次，-1 表示沒有
+    QHash<QString, QStringList> duplicateScanOwners;  // 檔案路徑 -> 所在的播放清單
+    
+    // 音樂庫搜尋：變更的播放清單在閒置時或查詢前才更新索引
+    LibrarySearch librarySearch;
+    QSet<QString> searchStalePlaylists;
+    QTimer* searchIndexTimer;
+    bool searchIndexRequested;       // 是否已要求為未載入的播放清單建立索引
+    QCompleter* searchCompleter;
+    QStringListModel* searchResultModel;
+    QList<LibrarySearch::Hit> searchResults;  // 下拉清單中各列對應的曲目（查詢當下取出，不受之後重新編號影響）
+    static constexpr int kMaxSearchResults = 200;
 };
 
 #endif // WIDGET_H
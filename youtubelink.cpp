@@ -0,0 +1,24 @@
+#include "youtubelink.h"
+#include <QRegularExpression>
+
+QString extractYouTubeVideoId(const QString& url)
+{
+    // 正則表達式只編譯一次；大量匯入連結時不必每次重新建立
+    static const QRegularExpression watchRx("v=([a-zA-Z0-9_-]+)");
+    static const QRegularExpression shortRx("youtu\\.be/([a-zA-Z0-9_-]+)");
+    static const QRegularExpression embedRx("embed/([a-zA-Z0-9_-]+)");
+
+    const QRegularExpression* rx = nullptr;
+    if (url.contains(QLatin1String("youtube.com/watch"))) {
+        rx = &watchRx;
+    } else if (url.contains(QLatin1String("youtu.be/"))) {
+        rx = &shortRx;
+    } else if (url.contains(QLatin1String("youtube.com/embed/"))) {
+        rx = &embedRx;
+    } else {
+        return QString();
+    }
+
+    QRegularExpressionMatch match = rx->match(url);
+    return match.hasMatch() ? match.captured(1) : QString();
+}
@@ -0,0 +1,13 @@
+#ifndef YOUTUBELINK_H
+#define YOUTUBELINK_H
+
+#include <QString>
+
+// 從 YouTube 連結取出影片 ID，無法識別時回傳空字串
+// 支援多種 YouTube URL 格式
+// https://www.youtube.com/watch?v=VIDEO_ID
+// https://youtu.be/VIDEO_ID
+// https://www.youtube.com/embed/VIDEO_ID
+QString extractYouTubeVideoId(const QString& url);
+
+#endif // YOUTUBELINK_H